@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * CRC-32 and CRC-32C using the ARMv8 CRC32 instructions
+ */
+
+#include <common.h>
+#include <efi_loader.h>
+#include <asm/armv8/cpu.h>
+#include <u-boot/crc.h>
+
+uint32_t crc32_armv8_le(uint32_t crc, const uint8_t *p, size_t len);
+uint32_t crc32c_armv8_le(uint32_t crc, const uint8_t *p, size_t len);
+
+uint32_t __efi_runtime crc32_no_comp(uint32_t crc, const unsigned char *buf,
+				     uint len)
+{
+	if (cpu_has_crc32())
+		return crc32_armv8_le(crc, buf, len);
+
+	return crc32_no_comp_generic(crc, buf, len);
+}
+
+#ifdef CONFIG_CRC32C
+uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
+		    uint32_t *crc32c_table)
+{
+	if (crc32c_table[128] == CRC32C_POLY_LE && cpu_has_crc32())
+		return crc32c_armv8_le(crc, (const uint8_t *)data, length);
+
+	return crc32c_cal_generic(crc, data, length, crc32c_table);
+}
+#endif
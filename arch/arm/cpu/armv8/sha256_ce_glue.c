@@ -0,0 +1,23 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * SHA-256 block transform using the ARMv8 Crypto Extensions
+ */
+
+#include <common.h>
+#include <asm/armv8/cpu.h>
+#include <u-boot/sha256.h>
+
+void sha256_armv8_ce_process(uint32_t state[8], const uint8_t *src,
+			     uint32_t blocks);
+
+void sha256_process(sha256_context *ctx, const unsigned char *data,
+		    unsigned int blocks)
+{
+	if (!blocks)
+		return;
+
+	if (cpu_has_sha2())
+		sha256_armv8_ce_process(ctx->state, data, blocks);
+	else
+		sha256_process_generic(ctx, data, blocks);
+}
@@ -26,8 +26,13 @@
  * that expect bulk OUT requests to be divisible by maxpacket size.
  */
 
-#define RKUSB_BUF_SIZE		EP_BUFFER_SIZE * 2
-#define RKBLOCK_BUF_SIZE		4096
+/*
+ * LBA reads and writes move their data through RKUSB_REQ_COUNT requests of
+ * RKUSB_REQ_BUF_SIZE bytes each, so that the USB transfer of one chunk
+ * overlaps the storage access for the next.
+ */
+#define RKUSB_REQ_COUNT		4
+#define RKUSB_REQ_BUF_SIZE	(64 * 1024)
 
 #define RKUSB_STATUS_IDLE			0
 #define RKUSB_STATUS_CMD			1
@@ -116,21 +121,34 @@ struct f_rockusb {
 	struct usb_function usb_function;
 	struct usb_ep *in_ep, *out_ep;
 	struct usb_request *in_req, *out_req;
+	struct usb_request *rx_req[RKUSB_REQ_COUNT];
+	struct usb_request *tx_req[RKUSB_REQ_COUNT];
+	struct usb_request *pending[RKUSB_REQ_COUNT];
+	int pending_head;
+	int pending_count;
 	char *dev_type;
 	unsigned int dev_index;
 	unsigned int tag;
 	unsigned int lba;
 	unsigned int dl_size;
 	unsigned int dl_bytes;
+	unsigned int dl_queued;
 	unsigned int ul_size;
 	unsigned int ul_bytes;
+	unsigned int ul_sent;
+	u8 status;
 	struct blk_desc *desc;
 	int reboot_flag;
-	void *buf;
-	void *buf_head;
 };
 
 /* init rockusb device, tell rockusb which device you want to read/write*/
 void rockusb_dev_init(char *dev_type, int dev_index);
+
+/*
+ * Do the storage reads and writes of the LBA transfer in progress. Call this
+ * after each usb_gadget_handle_interrupts(), so that they run while the
+ * controller moves the other queued requests.
+ */
+void rockusb_handle_io(void);
 #endif /* _F_ROCKUSB_H_ */
 
@@ -69,6 +69,9 @@ int sandbox_eth_recv_ping_req(struct udevice *dev);
 typedef int sandbox_eth_tx_hand_f(struct udevice *dev, void *pkt,
 				   unsigned int len);
 
+/* Number of receive buffers the mock driver gives to the "hardware" */
+#define SANDBOX_ETH_RX_RING	4
+
 /**
  * struct eth_sandbox_priv - memory for sandbox mock driver
  *
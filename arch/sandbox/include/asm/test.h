@@ -177,4 +177,13 @@ int sandbox_get_beep_frequency(struct udevice *dev);
  */
 int sandbox_get_pch_spi_protect(struct udevice *dev);
 
+/**
+ * sandbox_mmc_get_erase() - Get information about erase commands
+ *
+ * @dev: MMC device to check
+ * @argp: Returns the argument of the last erase command
+ * @return number of erase commands received since the device was bound
+ */
+int sandbox_mmc_get_erase(struct udevice *dev, uint *argp);
+
 #endif
@@ -233,6 +233,7 @@ int do_avb_verify_part(cmd_tbl_t *cmdtp, int flag,
 {
 	AvbSlotVerifyResult slot_result;
 	AvbSlotVerifyData *out_data;
+	AvbSlotVerifyFlags flags;
 	char *cmdline;
 	char *extra_args;
 
@@ -256,11 +257,16 @@ int do_avb_verify_part(cmd_tbl_t *cmdtp, int flag,
 		return CMD_RET_FAILURE;
 	}
 
+	/* Partition contents are not used, only stream them through the hash */
+	flags = AVB_SLOT_VERIFY_FLAGS_HASH_ONLY;
+	if (unlocked)
+		flags |= AVB_SLOT_VERIFY_FLAGS_ALLOW_VERIFICATION_ERROR;
+
 	slot_result =
 		avb_slot_verify(avb_ops,
 				requested_partitions,
 				"",
-				unlocked,
+				flags,
 				AVB_HASHTREE_ERROR_MODE_RESTART_AND_INVALIDATE,
 				&out_data);
 
@@ -17,10 +17,11 @@ static int blkc_show(cmd_tbl_t *cmdtp, int flag,
 
 	printf("hits: %u\n"
 	       "misses: %u\n"
-	       "entries: %u\n"
-	       "max blocks/entry: %u\n"
-	       "max cache entries: %u\n",
-	       stats.hits, stats.misses, stats.entries,
+	       "cached blocks: %u\n"
+	       "dirty blocks: %u\n"
+	       "max blocks/read: %u\n"
+	       "max cached blocks: %u\n",
+	       stats.hits, stats.misses, stats.entries, stats.dirty,
 	       stats.max_blocks_per_entry, stats.max_entries);
 	return 0;
 }
@@ -35,7 +36,7 @@ static int blkc_configure(cmd_tbl_t *cmdtp, int flag,
 	blocks_per_entry = simple_strtoul(argv[1], 0, 0);
 	max_entries = simple_strtoul(argv[2], 0, 0);
 	blkcache_configure(blocks_per_entry, max_entries);
-	printf("changed to max of %u entries of %u blocks each\n",
+	printf("changed to max of %u blocks, caching reads of up to %u blocks\n",
 	       max_entries, blocks_per_entry);
 	return 0;
 }
@@ -82,5 +83,6 @@ U_BOOT_CMD(
 	blkcache, 4, 0, do_blkcache,
 	"block cache diagnostics and control",
 	"show - show and reset statistics\n"
-	"blkcache configure blocks entries\n"
+	"blkcache configure blocks entries - cache reads of up to 'blocks'\n"
+	"    blocks, keeping at most 'entries' blocks in total\n"
 );
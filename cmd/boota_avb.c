@@ -6,33 +6,182 @@
 #include <bootm.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <memalign.h>
+#include <asm/unaligned.h>
+#include <linux/sizes.h>
 #include <android_image.h>
 #include <../lib/libavb/libavb.h>
 
 /* Public key */
 #include "avb_pubkey.h"
 
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Room left below the stack when preloading boot.img */
+#define AVB_PRELOAD_STACK_GUARD		SZ_1M
+
+/* Room kept free past the end of the kernel for its BSS and early data */
+#define AVB_PRELOAD_BSS_GUARD		SZ_16M
+
+/* Room reserved at tags_addr when the header does not give a DTB size */
+#define AVB_PRELOAD_TAGS_SIZE		SZ_1M
+
+/* Per-partition verification statistics */
+#define AVB_STATS_MAX_PARTS	16
+
+struct avb_part_stats {
+	char name[32];
+	u64 bytes;
+	ulong read_us;
+	ulong verify_us;
+};
+
+static struct avb_part_stats avb_stats[AVB_STATS_MAX_PARTS];
+static struct avb_part_stats *avb_stats_last;
+static int avb_stats_count;
+static ulong avb_stats_mark;
+
+static void avb_stats_reset(void)
+{
+	memset(avb_stats, 0, sizeof(avb_stats));
+	avb_stats_count = 0;
+	avb_stats_last = NULL;
+	avb_stats_mark = timer_get_us();
+}
+
+/*
+ * libavb handles one partition at a time: whatever happens between the
+ * last read of a partition and the next read (hashing, signature checks,
+ * descriptor parsing) is work done to verify the partition just read.
+ */
+static void avb_stats_account(ulong now)
+{
+	if (avb_stats_last)
+		avb_stats_last->verify_us += now - avb_stats_mark;
+	avb_stats_mark = now;
+}
+
+static struct avb_part_stats *avb_stats_get(const char *partition)
+{
+	struct avb_part_stats *st;
+	int i;
+
+	for (i = 0; i < avb_stats_count; i++) {
+		if (!strcmp(avb_stats[i].name, partition))
+			return &avb_stats[i];
+	}
+
+	if (avb_stats_count == AVB_STATS_MAX_PARTS)
+		return NULL;
+
+	st = &avb_stats[avb_stats_count++];
+	strlcpy(st->name, partition, sizeof(st->name));
+
+	return st;
+}
+
+/* Charge the time since @start to reading @partition */
+static void avb_stats_read(const char *partition, ulong start, u64 bytes)
+{
+	struct avb_part_stats *st;
+
+	avb_stats_mark = timer_get_us();
+	st = avb_stats_get(partition);
+	if (st) {
+		st->read_us += avb_stats_mark - start;
+		st->bytes += bytes;
+	}
+	avb_stats_last = st;
+}
+
+static void avb_stats_print(void)
+{
+	struct avb_part_stats *st;
+	ulong read_us = 0, verify_us = 0;
+	int i;
+
+	avb_stats_account(timer_get_us());
+
+	for (i = 0; i < avb_stats_count; i++) {
+		st = &avb_stats[i];
+		printf("avb_flow: %-16s %8lluKiB read %6lu.%03lums verify %6lu.%03lums\n",
+			st->name, st->bytes / 1024,
+			st->read_us / 1000, st->read_us % 1000,
+			st->verify_us / 1000, st->verify_us % 1000);
+		read_us += st->read_us;
+		verify_us += st->verify_us;
+	}
+
+	printf("avb_flow: %-16s %11s read %6lu.%03lums verify %6lu.%03lums\n",
+		"total", "", read_us / 1000, read_us % 1000,
+		verify_us / 1000, verify_us % 1000);
+}
+
 /* */
-static AvbIOResult avb_read_from_partition(AvbOps* ops, const char* partition,
-		int64_t offset, size_t num_bytes, void* buffer, size_t* out_num_read)
+static struct blk_desc *avb_get_partition(const char *partition,
+		struct disk_partition *part_info, AvbIOResult *err)
 {
 	struct blk_desc *dev_desc;
-	struct disk_partition part_info;
-	size_t read;
 
 	dev_desc = blk_get_dev("mmc", CONFIG_FASTBOOT_FLASH_MMC_DEV);
 	if (dev_desc == NULL) {
 		pr_err("%s: interface:mmc dev:%d not found.\n",
 			__func__, CONFIG_FASTBOOT_FLASH_MMC_DEV);
-		return AVB_IO_RESULT_ERROR_IO;
+		*err = AVB_IO_RESULT_ERROR_IO;
+		return NULL;
 	}
 
-	if (part_get_info_by_name(dev_desc, partition, &part_info) < 0) {
+	if (part_get_info_by_name(dev_desc, partition, part_info) < 0) {
 		pr_err("%s: mmc:%d - partition '%s' not found.\n",
 			__func__, CONFIG_FASTBOOT_FLASH_MMC_DEV, partition);
-		return AVB_IO_RESULT_ERROR_NO_SUCH_PARTITION;
+		*err = AVB_IO_RESULT_ERROR_NO_SUCH_PARTITION;
+		return NULL;
 	}
 
+	return dev_desc;
+}
+
+/* Bounce buffer for the partial blocks at either end of a read */
+#define AVB_BOUNCE_BLKSZ	4096
+
+DEFINE_CACHE_ALIGN_BUFFER(u8, avb_bounce, AVB_BOUNCE_BLKSZ);
+
+/*
+ * Not every MMC host invalidates the data cache once a DMA read is done
+ * (sdhci only flushes before the transfer), so drop whatever the CPU may
+ * have cached for the destination before anybody looks at it.
+ */
+static int avb_dread(struct blk_desc *dev_desc, lbaint_t start,
+		     lbaint_t blkcnt, void *buffer)
+{
+	if (blk_dread(dev_desc, start, blkcnt, buffer) != blkcnt)
+		return -EIO;
+
+	flush_cache((ulong)buffer, blkcnt * dev_desc->blksz);
+
+	return 0;
+}
+
+/*
+ * Only the partial blocks at the start and the end of the request go
+ * through the bounce buffer. Everything in between is read by the block
+ * driver straight into the caller's buffer.
+ */
+static AvbIOResult avb_read_from_partition_raw(const char* partition,
+		int64_t offset, size_t num_bytes, void* buffer, size_t* out_num_read)
+{
+	struct blk_desc *dev_desc;
+	struct disk_partition part_info;
+	AvbIOResult err;
+	u8 *dst = buffer;
+	size_t left = num_bytes;
+	lbaint_t blk, count;
+	ulong blksz, head;
+
+	dev_desc = avb_get_partition(partition, &part_info, &err);
+	if (!dev_desc)
+		return err;
+
 	int64_t part_size = (part_info.size * part_info.blksz);
 	int64_t offset_bytes = offset;
 
@@ -46,51 +195,331 @@ static AvbIOResult avb_read_from_partition(AvbOps* ops, const char* partition,
 		offset_bytes = (part_size + offset);
 	}
 
-	/* handle non block-aligned reads */
-	if (offset_bytes % part_info.blksz || num_bytes % part_info.blksz)
-	{
-		size_t offset_sectors = part_info.start + (offset_bytes / part_info.blksz);
-		size_t offset_data = (offset_bytes % part_info.blksz);
-		size_t to_read_sectors = ALIGN(num_bytes, part_info.blksz) / part_info.blksz;
+	if (offset_bytes < 0 || offset_bytes + num_bytes > part_size)
+		return AVB_IO_RESULT_ERROR_RANGE_OUTSIDE_PARTITION;
 
-		/* */
-		size_t buf_size = ALIGN(num_bytes, part_info.blksz);
-		char * buf_ptr = malloc(buf_size);
+	blksz = part_info.blksz;
+	if (blksz > AVB_BOUNCE_BLKSZ) {
+		pr_err("%s: unsupported block size %lu\n", __func__, blksz);
+		return AVB_IO_RESULT_ERROR_IO;
+	}
 
-		if (!buf_ptr) {
-			pr_err("%s: failed to allocate %lu bytes\n", __func__, buf_size);
-			return AVB_IO_RESULT_ERROR_OOM;
-		}
+	blk = part_info.start + (offset_bytes / blksz);
+	head = offset_bytes % blksz;
 
-		read = blk_dread(dev_desc, offset_sectors, to_read_sectors, buf_ptr);
-		flush_cache((ulong)buf_ptr, buf_size);
+	/* leading partial block */
+	if (head && left) {
+		size_t n = min_t(size_t, blksz - head, left);
 
-		if (read != to_read_sectors) {
-			pr_err("%s: failed to read %lu blocks\n", __func__, to_read_sectors);
-			free(buf_ptr);
-			return AVB_IO_RESULT_ERROR_IO;
-		}
+		if (avb_dread(dev_desc, blk, 1, avb_bounce))
+			goto err_read;
 
-		memcpy(buffer, buf_ptr + offset_data, num_bytes);
+		memcpy(dst, avb_bounce + head, n);
+		dst += n;
+		left -= n;
+		blk++;
+	}
 
-		*out_num_read = num_bytes;
+	/* whole blocks */
+	count = left / blksz;
+	if (count) {
+		if (avb_dread(dev_desc, blk, count, dst))
+			goto err_read;
+
+		dst += count * blksz;
+		left -= count * blksz;
+		blk += count;
 	}
-	else
-	{
-		ulong offset_sectors = part_info.start + (offset_bytes / part_info.blksz);
-		ulong to_read_sectors = num_bytes / part_info.blksz;
 
-		read = blk_dread(dev_desc, offset_sectors, to_read_sectors, buffer);
-		flush_cache((ulong)buffer, (to_read_sectors * part_info.blksz));
+	/* trailing partial block */
+	if (left) {
+		if (avb_dread(dev_desc, blk, 1, avb_bounce))
+			goto err_read;
+
+		memcpy(dst, avb_bounce, left);
+	}
+
+	*out_num_read = num_bytes;
+	return AVB_IO_RESULT_OK;
+
+err_read:
+	pr_err("%s: failed to read '%s' at block " LBAFU "\n",
+		__func__, partition, blk);
+	return AVB_IO_RESULT_ERROR_IO;
+}
+
+/* */
+static AvbIOResult avb_read_from_partition(AvbOps* ops, const char* partition,
+		int64_t offset, size_t num_bytes, void* buffer, size_t* out_num_read)
+{
+	AvbIOResult ret;
+	ulong start;
+
+	start = timer_get_us();
+	avb_stats_account(start);
+
+	ret = avb_read_from_partition_raw(partition, offset, num_bytes,
+					  buffer, out_num_read);
+
+	avb_stats_read(partition, start,
+		       ret == AVB_IO_RESULT_OK ? *out_num_read : 0);
 
-		if (read != to_read_sectors) {
-			pr_err("%s: failed to read %lu blocks\n", __func__, to_read_sectors);
-			return AVB_IO_RESULT_ERROR_IO;
+	return ret;
+}
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+/*
+ * The read started by avb_start_read_from_partition(). libavb has at most
+ * one of them in flight and hashes the previous chunk meanwhile.
+ */
+static struct avb_async_read {
+	const char *partition;
+	struct blk_desc *dev_desc;
+	struct blk_req req;
+	bool pending;
+	/* trailing partial block, read once the whole blocks are in */
+	lbaint_t tail_blk;
+	u8 *tail_dst;
+	ulong tail;
+	AvbIOResult result;
+	size_t num_read;
+} avb_async;
+
+/*
+ * Whole blocks are queued with blk_submit() so that the controller moves
+ * them while libavb hashes. Reads which do not start on a block boundary
+ * are rare (libavb reads in 1 MiB steps) and are simply done right away.
+ */
+static AvbIOResult avb_start_read_from_partition(AvbOps* ops,
+		const char* partition, int64_t offset, size_t num_bytes,
+		void* buffer)
+{
+	struct avb_async_read *rd = &avb_async;
+	struct disk_partition part_info;
+	AvbIOResult err;
+	ulong blksz, start;
+	lbaint_t count;
+
+	start = timer_get_us();
+	avb_stats_account(start);
+
+	memset(rd, 0, sizeof(*rd));
+	rd->partition = partition;
+
+	rd->dev_desc = avb_get_partition(partition, &part_info, &err);
+	if (!rd->dev_desc)
+		return err;
+
+	blksz = part_info.blksz;
+	count = num_bytes / blksz;
+	if (offset < 0 || offset % blksz || !count ||
+	    offset + num_bytes > (u64)part_info.size * blksz) {
+		rd->result = avb_read_from_partition_raw(partition, offset,
+					num_bytes, buffer, &rd->num_read);
+		avb_stats_read(partition, start, 0);
+		return rd->result;
+	}
+
+	rd->req.start = part_info.start + offset / blksz;
+	rd->req.blkcnt = count;
+	rd->req.buffer = buffer;
+	rd->req.write = false;
+	if (blk_submit(rd->dev_desc, &rd->req)) {
+		pr_err("%s: failed to queue '%s' at block " LBAFU "\n",
+			__func__, partition, rd->req.start);
+		return AVB_IO_RESULT_ERROR_IO;
+	}
+	rd->pending = true;
+	rd->tail = num_bytes % blksz;
+	rd->tail_blk = rd->req.start + count;
+	rd->tail_dst = (u8 *)buffer + count * blksz;
+	rd->num_read = num_bytes;
+
+	avb_stats_read(partition, start, 0);
+
+	return AVB_IO_RESULT_OK;
+}
+
+static AvbIOResult avb_finish_read_from_partition(AvbOps* ops,
+		size_t* out_num_read)
+{
+	struct avb_async_read *rd = &avb_async;
+	struct blk_desc *dev_desc = rd->dev_desc;
+	ulong start;
+
+	start = timer_get_us();
+	avb_stats_account(start);
+
+	if (rd->pending) {
+		rd->pending = false;
+		rd->result = AVB_IO_RESULT_ERROR_IO;
+		if (blk_wait(dev_desc, &rd->req) != rd->req.blkcnt)
+			goto out;
+		flush_cache((ulong)rd->req.buffer,
+			    rd->req.blkcnt * dev_desc->blksz);
+
+		if (rd->tail) {
+			if (avb_dread(dev_desc, rd->tail_blk, 1, avb_bounce))
+				goto out;
+			memcpy(rd->tail_dst, avb_bounce, rd->tail);
 		}
+		rd->result = AVB_IO_RESULT_OK;
+	}
+
+out:
+	if (rd->result != AVB_IO_RESULT_OK)
+		pr_err("%s: failed to read '%s'\n", __func__, rd->partition);
+	*out_num_read = rd->num_read;
+	avb_stats_read(rd->partition, start,
+		       rd->result == AVB_IO_RESULT_OK ? rd->num_read : 0);
+
+	return rd->result;
+}
+#endif
+
+static bool avb_overlaps(ulong start1, ulong size1, ulong start2, ulong size2)
+{
+	return size1 && size2 && start1 < start2 + size2 &&
+	       start2 < start1 + size1;
+}
+
+/*
+ * Once the kernel runs, everything from kernel_addr up to the end of its
+ * BSS is overwritten. With the image preloaded in front of the kernel
+ * that includes the ramdisk and DTB sections of boot.img, so they must be
+ * relocated by bootm rather than used in place, and the addresses the
+ * header asks for them (ramdisk_addr, tags_addr) must be clear of both
+ * the preloaded image and the kernel.
+ */
+static bool avb_preload_layout_ok(const struct andr_img_hdr *hdr,
+				  ulong load_addr, ulong load_size)
+{
+	const struct andr_img_hdr_v2 *v2 = (struct andr_img_hdr_v2 *)hdr;
+	ulong kernel_end, tags_size;
+
+	kernel_end = hdr->kernel_addr + ALIGN(hdr->kernel_size, hdr->page_size) +
+		     AVB_PRELOAD_BSS_GUARD;
+	if (load_addr + load_size > kernel_end)
+		kernel_end = load_addr + load_size;
+
+	if (hdr->ramdisk_size &&
+	    env_get_hex("initrd_high", 0) == ~0UL)
+		return false;
+	if (hdr->header_version >= 2 && v2->dtb_size &&
+	    env_get_hex("fdt_high", 0) == ~0UL)
+		return false;
+
+	tags_size = AVB_PRELOAD_TAGS_SIZE;
+	if (hdr->header_version >= 2 && v2->dtb_size)
+		tags_size = v2->dtb_size;
+
+	if (avb_overlaps(load_addr, kernel_end - load_addr,
+			 hdr->ramdisk_addr, hdr->ramdisk_size) ||
+	    avb_overlaps(load_addr, kernel_end - load_addr,
+			 hdr->tags_addr, tags_size)) {
+		printf("avb_flow: ramdisk/tags overlap the kernel, not preloading\n");
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * Preload the boot partition so that its kernel section lands right at
+ * the kernel load address: the image is read with one block aligned DMA
+ * transfer to (kernel_addr - page_size), libavb verifies it in place and
+ * bootm finds the kernel already where it has to be.
+ *
+ * If the layout does not allow it (compressed kernel, kernel executed in
+ * place, destination outside of usable DRAM, ramdisk or tags within reach
+ * of the kernel) nothing is preloaded and
+ * libavb falls back to read_from_partition().
+ */
+static AvbIOResult avb_get_preloaded_partition(AvbOps* ops,
+		const char* partition, size_t num_bytes, uint8_t** out_pointer,
+		size_t* out_num_bytes_preloaded)
+{
+	const struct andr_img_hdr *hdr = (struct andr_img_hdr *)avb_bounce;
+	struct blk_desc *dev_desc;
+	struct disk_partition part_info;
+	AvbIOResult err;
+	ulong kernel_addr, load_addr, load_size, page_size;
+	ulong low, high, start;
+	lbaint_t count;
+
+	*out_pointer = NULL;
+	*out_num_bytes_preloaded = 0;
+
+	if (strcmp(partition, "boot"))
+		return AVB_IO_RESULT_OK;
+
+	dev_desc = avb_get_partition(partition, &part_info, &err);
+	if (!dev_desc)
+		return err;
+
+	if (part_info.blksz > AVB_BOUNCE_BLKSZ ||
+	    num_bytes > part_info.size * part_info.blksz)
+		return AVB_IO_RESULT_OK;
+
+	if (avb_dread(dev_desc, part_info.start, 1, avb_bounce))
+		return AVB_IO_RESULT_ERROR_IO;
+
+	if (android_image_check_header(hdr) != 0)
+		return AVB_IO_RESULT_OK;
+
+	/*
+	 * bootm runs the kernel in place, wherever the image was read to,
+	 * unless the header names a load address of its own
+	 */
+	page_size = hdr->page_size;
+	kernel_addr = hdr->kernel_addr;
+	if (!page_size || page_size % part_info.blksz ||
+	    kernel_addr < page_size ||
+	    android_image_get_kload(hdr) != kernel_addr)
+		return AVB_IO_RESULT_OK;
+
+	load_addr = kernel_addr - page_size;
+	count = DIV_ROUND_UP(num_bytes, part_info.blksz);
+	load_size = count * part_info.blksz;
+
+	/* stay clear of U-Boot's stack, heap and relocated image */
+	low = env_get_bootm_low();
+	high = min_t(ulong, low + env_get_bootm_size(),
+		     gd->start_addr_sp - AVB_PRELOAD_STACK_GUARD);
+	if (load_addr % ARCH_DMA_MINALIGN || load_addr < low ||
+	    load_addr + load_size > high)
+		return AVB_IO_RESULT_OK;
+
+	if (!avb_preload_layout_ok(hdr, load_addr, load_size))
+		return AVB_IO_RESULT_OK;
+
+	/* the kernel magic is one block past the header page */
+	if (avb_dread(dev_desc, part_info.start + page_size / part_info.blksz,
+		      1, avb_bounce))
+		return AVB_IO_RESULT_ERROR_IO;
 
-		*out_num_read = (to_read_sectors * dev_desc->blksz);
+	/* compressed kernels are unpacked to kernel_addr, don't load there */
+	if (get_unaligned_le32(avb_bounce) == LZ4F_MAGIC ||
+	    get_unaligned_le32(avb_bounce) == ZSTD_FRAME_MAGIC)
+		return AVB_IO_RESULT_OK;
+
+	start = timer_get_us();
+	avb_stats_account(start);
+
+	if (avb_dread(dev_desc, part_info.start, count,
+		      map_sysmem(load_addr, load_size))) {
+		pr_err("%s: failed to read %lu blocks\n", __func__, (ulong)count);
+		return AVB_IO_RESULT_ERROR_IO;
 	}
 
+	avb_stats_read(partition, start, num_bytes);
+
+	printf("avb_flow: Preloaded '%s' partition to 0x%08lx\n",
+		partition, load_addr);
+
+	*out_pointer = map_sysmem(load_addr, load_size);
+	*out_num_bytes_preloaded = num_bytes;
+
 	return AVB_IO_RESULT_OK;
 }
 
@@ -120,19 +549,11 @@ static AvbIOResult avb_get_size_of_partition(AvbOps* ops, const char* partition,
 {
 	struct blk_desc *dev_desc;
 	struct disk_partition part_info;
+	AvbIOResult err;
 
-	dev_desc = blk_get_dev("mmc", CONFIG_FASTBOOT_FLASH_MMC_DEV);
-	if (dev_desc == NULL) {
-		pr_err("%s: interface:mmc dev:%d not found.\n",
-			__func__, CONFIG_FASTBOOT_FLASH_MMC_DEV);
-		return AVB_IO_RESULT_ERROR_IO;
-	}
-
-	if (part_get_info_by_name(dev_desc, partition, &part_info) < 0) {
-		pr_err("%s: mmc:%d - partition '%s' not found.\n",
-			__func__, CONFIG_FASTBOOT_FLASH_MMC_DEV, partition);
-		return AVB_IO_RESULT_ERROR_NO_SUCH_PARTITION;
-	}
+	dev_desc = avb_get_partition(partition, &part_info, &err);
+	if (!dev_desc)
+		return err;
 
 	*out_size_num_bytes = (part_info.size * part_info.blksz);
 	return AVB_IO_RESULT_OK;
@@ -157,19 +578,11 @@ static AvbIOResult avb_get_unique_guid_for_partition(AvbOps* ops,
 	struct blk_desc *dev_desc;
 	struct disk_partition part_info;
 	size_t uuid_size = sizeof(part_info.uuid);
+	AvbIOResult err;
 
-	dev_desc = blk_get_dev("mmc", CONFIG_FASTBOOT_FLASH_MMC_DEV);
-	if (dev_desc == NULL) {
-		pr_err("%s: interface:mmc dev:%d not found.\n",
-			__func__, CONFIG_FASTBOOT_FLASH_MMC_DEV);
-		return AVB_IO_RESULT_ERROR_IO;
-	}
-
-	if (part_get_info_by_name(dev_desc, partition, &part_info) < 0) {
-		pr_err("%s: mmc:%d - partition '%s' not found.\n",
-			__func__, CONFIG_FASTBOOT_FLASH_MMC_DEV, partition);
-		return AVB_IO_RESULT_ERROR_NO_SUCH_PARTITION;
-	}
+	dev_desc = avb_get_partition(partition, &part_info, &err);
+	if (!dev_desc)
+		return err;
 
 	if (uuid_size > guid_buf_size)
 		return AVB_IO_RESULT_ERROR_IO;
@@ -201,7 +614,7 @@ static struct AvbOps avb_ops =
 	.ab_ops                         = NULL,
 	.atx_ops                        = NULL,
 	.read_from_partition            = avb_read_from_partition,
-	.get_preloaded_partition        = NULL,
+	.get_preloaded_partition        = avb_get_preloaded_partition,
 	.write_to_partition             = NULL,
 	.validate_vbmeta_public_key     = avb_validate_vbmeta_public_key,
 	.read_rollback_index            = avb_read_rollback_index,
@@ -211,6 +624,10 @@ static struct AvbOps avb_ops =
 	.get_size_of_partition          = avb_get_size_of_partition,
 	.read_persistent_value          = NULL,
 	.write_persistent_value         = NULL,
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	.start_read_from_partition      = avb_start_read_from_partition,
+	.finish_read_from_partition     = avb_finish_read_from_partition,
+#endif
 };
 
 /* */
@@ -231,9 +648,13 @@ static int do_boot_android_avb(cmd_tbl_t *cmdtp, int flag, int argc, char * cons
 		return CMD_RET_FAILURE;
 	}
 
+	avb_stats_reset();
+
 	slot_result = avb_slot_verify(&avb_ops, avb_partitions, "",
 				unlocked, AVB_HASHTREE_ERROR_MODE_RESTART_AND_INVALIDATE, &out_data);
 
+	avb_stats_print();
+
 	/* Update bootargs */
 	if((cmdline = env_get("bootargs")) == NULL)
 		cmdline = "";
@@ -326,6 +326,30 @@ static lbaint_t mmc_sparse_write(struct sparse_storage *info, lbaint_t blk,
 	return blk_dwrite(dev_desc, blk, blkcnt, buffer);
 }
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+static int mmc_sparse_submit(struct sparse_storage *info, struct blk_req *req)
+{
+	struct blk_desc *dev_desc = info->priv;
+
+	return blk_submit(dev_desc, req);
+}
+
+static long mmc_sparse_wait(struct sparse_storage *info, struct blk_req *req)
+{
+	struct blk_desc *dev_desc = info->priv;
+
+	return blk_wait(dev_desc, req);
+}
+#endif
+
+static lbaint_t mmc_sparse_erase(struct sparse_storage *info, lbaint_t blk,
+				 lbaint_t blkcnt)
+{
+	struct blk_desc *dev_desc = info->priv;
+
+	return mmc_bdiscard(dev_desc, blk, blkcnt);
+}
+
 static lbaint_t mmc_sparse_reserve(struct sparse_storage *info,
 				   lbaint_t blk, lbaint_t blkcnt)
 {
@@ -335,7 +359,7 @@ static lbaint_t mmc_sparse_reserve(struct sparse_storage *info,
 static int do_mmc_sparse_write(cmd_tbl_t *cmdtp, int flag,
 			       int argc, char * const argv[])
 {
-	struct sparse_storage sparse;
+	struct sparse_storage sparse = { 0 };
 	struct blk_desc *dev_desc;
 	struct mmc *mmc;
 	char dest[11];
@@ -373,6 +397,12 @@ static int do_mmc_sparse_write(cmd_tbl_t *cmdtp, int flag,
 	sparse.write = mmc_sparse_write;
 	sparse.reserve = mmc_sparse_reserve;
 	sparse.mssg = NULL;
+	sparse.erase = mmc_sparse_erase;
+	sparse.erase_blks = mmc_erase_zero_blks(mmc);
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	sparse.submit = mmc_sparse_submit;
+	sparse.wait = mmc_sparse_wait;
+#endif
 	sprintf(dest, "0x" LBAF, sparse.start * sparse.blksz);
 
 	if (write_sparse_image(&sparse, dest, addr, NULL))
@@ -56,6 +56,7 @@ static int do_rockusb(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 		if (ctrlc())
 			break;
 		usb_gadget_handle_interrupts(controller_index);
+		rockusb_handle_io();
 	}
 	ret = CMD_RET_SUCCESS;
 
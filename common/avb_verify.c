@@ -404,8 +404,10 @@ static AvbIOResult mmc_byte_io(AvbOps *ops,
 	if (!part)
 		return AVB_IO_RESULT_ERROR_NO_SUCH_PARTITION;
 
-	if (!part->info.blksz)
+	if (!part->info.blksz) {
+		free(part);
 		return AVB_IO_RESULT_ERROR_IO;
+	}
 
 	start_offset = calc_offset(part, offset);
 	while (num_bytes) {
@@ -433,6 +435,7 @@ static AvbIOResult mmc_byte_io(AvbOps *ops,
 				if (ret != 1) {
 					printf("%s: read error (%ld, %lld)\n",
 					       __func__, ret, start_sector);
+					free(part);
 					return AVB_IO_RESULT_ERROR_IO;
 				}
 				/*
@@ -450,6 +453,7 @@ static AvbIOResult mmc_byte_io(AvbOps *ops,
 				if (ret != 1) {
 					printf("%s: read error (%ld, %lld)\n",
 					       __func__, ret, start_sector);
+					free(part);
 					return AVB_IO_RESULT_ERROR_IO;
 				}
 				memcpy((void *)tmp_buf +
@@ -461,6 +465,7 @@ static AvbIOResult mmc_byte_io(AvbOps *ops,
 				if (ret != 1) {
 					printf("%s: write error (%ld, %lld)\n",
 					       __func__, ret, start_sector);
+					free(part);
 					return AVB_IO_RESULT_ERROR_IO;
 				}
 			}
@@ -487,6 +492,7 @@ static AvbIOResult mmc_byte_io(AvbOps *ops,
 
 			if (!ret) {
 				printf("%s: sector read error\n", __func__);
+				free(part);
 				return AVB_IO_RESULT_ERROR_IO;
 			}
 
@@ -501,6 +507,7 @@ static AvbIOResult mmc_byte_io(AvbOps *ops,
 	if (io_type == IO_READ && out_num_read)
 		*out_num_read = io_cnt;
 
+	free(part);
 	return AVB_IO_RESULT_OK;
 }
 
@@ -15,6 +15,7 @@
 #include <mapmem.h>
 #include <asm/io.h>
 #include <linux/lzo.h>
+#include <linux/zstd.h>
 #include <lzma/LzmaTypes.h>
 #include <lzma/LzmaDec.h>
 #include <lzma/LzmaTools.h>
@@ -425,6 +426,38 @@ int bootm_decomp_image(int comp, ulong load, ulong image_start, int type,
 		break;
 	}
 #endif /* CONFIG_LZ4 */
+#ifdef CONFIG_ZSTD
+	case IH_COMP_ZSTD: {
+		size_t wsize = ZSTD_DCtxWorkspaceBound();
+		ZSTD_DCtx *dctx;
+		void *workspace;
+		size_t size;
+
+		workspace = malloc(wsize);
+		if (!workspace) {
+			ret = -ENOMEM;
+			break;
+		}
+
+		/*
+		 * Buffer-to-buffer decompression uses the output as its window
+		 * and walks every frame of multi-frame (e.g. pzstd) images, so
+		 * no streaming copies are needed.
+		 */
+		dctx = ZSTD_initDCtx(workspace, wsize);
+		size = ZSTD_decompressDCtx(dctx, load_buf, unc_len, image_buf,
+					   image_len);
+		free(workspace);
+		if (ZSTD_isError(size)) {
+			ret = ZSTD_getErrorCode(size);
+			if (ret == ZSTD_error_dstSize_tooSmall)
+				image_len = unc_len;
+			break;
+		}
+		image_len = size;
+		break;
+	}
+#endif /* CONFIG_ZSTD */
 	default:
 		printf("Unimplemented compression type %d\n", comp);
 		return BOOTM_ERR_UNIMPLEMENTED;
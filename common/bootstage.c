@@ -202,6 +202,23 @@ uint32_t bootstage_accum(enum bootstage_id id)
 	return duration;
 }
 
+ulong bootstage_count(enum bootstage_id id, const char *name, ulong count)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_record *rec;
+
+	if (!data)
+		return count;
+	rec = ensure_id(data, id);
+	if (rec) {
+		rec->time_us = count;
+		rec->name = name;
+		rec->flags = BOOTSTAGEF_COUNT;
+	}
+
+	return count;
+}
+
 /**
  * Get a record name as a printable string
  *
@@ -292,8 +309,9 @@ static int add_bootstages_devicetree(struct fdt_header *blob)
 				       get_record_name(buf, sizeof(buf), rec)))
 			return -EINVAL;
 
-		/* Check if this is a 'mark' or 'accum' record */
+		/* Check if this is a 'mark', 'accum' or 'count' record */
 		if (fdt_setprop_cell(blob, node,
+				rec->flags & BOOTSTAGEF_COUNT ? "count" :
 				rec->start_us ? "accum" : "mark",
 				rec->time_us))
 			return -EINVAL;
@@ -315,7 +333,9 @@ void bootstage_report(void)
 {
 	struct bootstage_data *data = gd->bootstage;
 	struct bootstage_record *rec = data->record;
+	char buf[20];
 	uint32_t prev;
+	int counts;
 	int i;
 
 	printf("Timer summary in microseconds (%d records):\n",
@@ -328,7 +348,8 @@ void bootstage_report(void)
 	qsort(data->record, data->rec_count, sizeof(*rec), h_compare_record);
 
 	for (i = 1, rec++; i < data->rec_count; i++, rec++) {
-		if (rec->id && !rec->start_us)
+		if (rec->id && !rec->start_us &&
+		    !(rec->flags & BOOTSTAGEF_COUNT))
 			prev = print_time_record(rec, prev);
 	}
 	if (data->rec_count > RECORD_COUNT)
@@ -341,6 +362,16 @@ void bootstage_report(void)
 		if (rec->start_us)
 			prev = print_time_record(rec, -1);
 	}
+
+	for (i = 0, counts = 0, rec = data->record; i < data->rec_count;
+	     i++, rec++) {
+		if (!(rec->flags & BOOTSTAGEF_COUNT))
+			continue;
+		if (!counts++)
+			puts("\nCounts:\n");
+		print_grouped_ull(rec->time_us, BOOTSTAGE_DIGITS);
+		printf("  %s\n", get_record_name(buf, sizeof(buf), rec));
+	}
 }
 
 /**
@@ -143,6 +143,8 @@ ulong android_image_get_kcomp(const struct andr_img_hdr *hdr)
 
 	if (get_unaligned_le32(p) == LZ4F_MAGIC)
 		return IH_COMP_LZ4;
+	else if (get_unaligned_le32(p) == ZSTD_FRAME_MAGIC)
+		return IH_COMP_ZSTD;
 	else
 		return IH_COMP_NONE;
 }
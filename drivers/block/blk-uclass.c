@@ -10,6 +10,7 @@
 #include <dm/device-internal.h>
 #include <dm/lists.h>
 #include <dm/uclass-internal.h>
+#include <watchdog.h>
 
 static const char *if_typename_str[IF_TYPE_COUNT] = {
 	[IF_TYPE_IDE]		= "ide",
@@ -334,15 +335,189 @@ ulong blk_write_devnum(enum if_type if_type, int devnum, lbaint_t start,
 	return blk_dwrite(desc, start, blkcnt, buffer);
 }
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+/**
+ * struct blk_queue - per-device queue of asynchronous requests
+ *
+ * Requests are issued to the driver in order, one at a time.
+ *
+ * @req:	Ring of queued requests
+ * @head:	Index of the oldest request in @req
+ * @count:	Number of queued requests
+ * @started:	true if the oldest request has been passed to the driver's
+ *		submit() method and must be polled
+ * @running:	true while the queue is being advanced, so that a driver
+ *		calling back into the uclass (e.g. to select a hardware
+ *		partition) does not restart the request it is handling
+ */
+struct blk_queue {
+	struct blk_req *req[CONFIG_BLK_ASYNC_QUEUE_DEPTH];
+	int head;
+	int count;
+	bool started;
+	bool running;
+};
+
+/*
+ * Start a request, returning -EINPROGRESS if the driver is transferring it
+ * in the background, else 0 with req->result filled in
+ */
+static int blk_req_start(struct udevice *dev, struct blk_req *req)
+{
+	struct blk_desc *desc = dev_get_uclass_platdata(dev);
+	const struct blk_ops *ops = blk_get_ops(dev);
+	int ret;
+
+	if (req->write) {
+		blkcache_invalidate(desc->if_type, desc->devnum);
+	} else if (blkcache_read(desc->if_type, desc->devnum, req->start,
+				 req->blkcnt, desc->blksz, req->buffer)) {
+		req->result = req->blkcnt;
+		return 0;
+	}
+
+	if (ops->submit) {
+		ret = ops->submit(dev, req);
+		if (!ret)
+			return -EINPROGRESS;
+		if (ret != -ENOSYS) {
+			req->result = ret;
+			return 0;
+		}
+	}
+
+	if (req->write && ops->write)
+		req->result = ops->write(dev, req->start, req->blkcnt,
+					 req->buffer);
+	else if (!req->write && ops->read)
+		req->result = ops->read(dev, req->start, req->blkcnt,
+					req->buffer);
+	else
+		req->result = -ENOSYS;
+
+	return 0;
+}
+
+/*
+ * Complete finished requests at the head of the queue and start the next
+ * one. Returns -EBUSY if a request is still in flight, 0 if the queue is
+ * empty.
+ */
+static int blk_queue_advance(struct udevice *dev)
+{
+	struct blk_desc *desc = dev_get_uclass_platdata(dev);
+	struct blk_queue *q = dev_get_uclass_priv(dev);
+	const struct blk_ops *ops = blk_get_ops(dev);
+	struct blk_req *req;
+	int ret = 0;
+
+	if (q->running)
+		return 0;
+
+	q->running = true;
+	while (q->count) {
+		req = q->req[q->head];
+		if (!q->started) {
+			ret = blk_req_start(dev, req);
+			if (ret == -EINPROGRESS) {
+				q->started = true;
+				ret = -EBUSY;
+				break;
+			}
+		} else {
+			ret = ops->poll(dev, req);
+			if (ret == -EBUSY)
+				break;
+			if (ret)
+				req->result = ret;
+			q->started = false;
+			if (!req->write && req->result == req->blkcnt)
+				blkcache_fill(desc->if_type, desc->devnum,
+					      req->start, req->blkcnt,
+					      desc->blksz, req->buffer);
+		}
+		q->head = (q->head + 1) % CONFIG_BLK_ASYNC_QUEUE_DEPTH;
+		q->count--;
+		ret = 0;
+	}
+	q->running = false;
+
+	return ret;
+}
+
+static void blk_queue_drain(struct udevice *dev)
+{
+	while (blk_queue_advance(dev) == -EBUSY)
+		WATCHDOG_RESET();
+}
+
+int blk_submit(struct blk_desc *block_dev, struct blk_req *req)
+{
+	struct udevice *dev = block_dev->bdev;
+	struct blk_queue *q = dev_get_uclass_priv(dev);
+
+	if (q->count == CONFIG_BLK_ASYNC_QUEUE_DEPTH &&
+	    blk_queue_advance(dev) == -EBUSY &&
+	    q->count == CONFIG_BLK_ASYNC_QUEUE_DEPTH)
+		return -EBUSY;
+
+	req->result = -EINPROGRESS;
+	q->req[(q->head + q->count) % CONFIG_BLK_ASYNC_QUEUE_DEPTH] = req;
+	q->count++;
+	blk_queue_advance(dev);
+
+	return 0;
+}
+
+int blk_poll(struct blk_desc *block_dev, struct blk_req *req)
+{
+	if (req->result == -EINPROGRESS)
+		blk_queue_advance(block_dev->bdev);
+
+	return req->result == -EINPROGRESS ? -EBUSY : 0;
+}
+
+long blk_wait(struct blk_desc *block_dev, struct blk_req *req)
+{
+	while (blk_poll(block_dev, req) == -EBUSY)
+		WATCHDOG_RESET();
+
+	return req->result;
+}
+
+void blk_sync(struct blk_desc *block_dev)
+{
+	blk_queue_drain(block_dev->bdev);
+}
+#else
+static inline void blk_queue_drain(struct udevice *dev) {}
+#endif
+
+static int blk_pre_remove(struct udevice *dev)
+{
+	struct blk_desc *desc = dev_get_uclass_platdata(dev);
+
+	blk_queue_drain(dev);
+	/* write back anything still cached, the device number may be reused */
+	blkcache_invalidate(desc->if_type, desc->devnum);
+
+	return 0;
+}
+
 int blk_select_hwpart(struct udevice *dev, int hwpart)
 {
 	const struct blk_ops *ops = blk_get_ops(dev);
+	struct blk_desc *desc = dev_get_uclass_platdata(dev);
 
 	if (!ops)
 		return -ENOSYS;
 	if (!ops->select_hwpart)
 		return 0;
 
+	blk_queue_drain(dev);
+	/* Cached blocks belong to the partition selected now */
+	if (hwpart != desc->hwpart)
+		blkcache_invalidate(desc->if_type, desc->devnum);
 	return ops->select_hwpart(dev, hwpart);
 }
 
@@ -432,13 +607,30 @@ unsigned long blk_dread(struct blk_desc *block_dev, lbaint_t start,
 	struct udevice *dev = block_dev->bdev;
 	const struct blk_ops *ops = blk_get_ops(dev);
 	ulong blks_read;
+	lbaint_t ra;
+	void *ra_buf;
 
 	if (!ops->read)
 		return -ENOSYS;
 
+	blk_queue_drain(dev);
+
 	if (blkcache_read(block_dev->if_type, block_dev->devnum,
 			  start, blkcnt, block_dev->blksz, buffer))
 		return blkcnt;
+
+	ra = blkcache_readahead(block_dev->if_type, block_dev->devnum,
+				start, blkcnt, block_dev->blksz, &ra_buf);
+	if (start + blkcnt + ra > block_dev->lba)
+		ra = start + blkcnt < block_dev->lba ?
+			block_dev->lba - start - blkcnt : 0;
+	if (ra && ops->read(dev, start, blkcnt + ra, ra_buf) == blkcnt + ra) {
+		memcpy(buffer, ra_buf, blkcnt * block_dev->blksz);
+		blkcache_fill(block_dev->if_type, block_dev->devnum,
+			      start, blkcnt + ra, block_dev->blksz, ra_buf);
+		return blkcnt;
+	}
+
 	blks_read = ops->read(dev, start, blkcnt, buffer);
 	if (blks_read == blkcnt)
 		blkcache_fill(block_dev->if_type, block_dev->devnum,
@@ -452,10 +644,17 @@ unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 {
 	struct udevice *dev = block_dev->bdev;
 	const struct blk_ops *ops = blk_get_ops(dev);
+	int ret;
 
 	if (!ops->write)
 		return -ENOSYS;
 
+	blk_queue_drain(dev);
+	ret = blkcache_write(block_dev->if_type, block_dev->devnum, start,
+			     blkcnt, block_dev->blksz, buffer);
+	if (ret)
+		return ret < 0 ? 0 : blkcnt;
+
 	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
 	return ops->write(dev, start, blkcnt, buffer);
 }
@@ -469,6 +668,7 @@ unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
 	if (!ops->erase)
 		return -ENOSYS;
 
+	blk_queue_drain(dev);
 	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
 	return ops->erase(dev, start, blkcnt);
 }
@@ -652,5 +852,9 @@ UCLASS_DRIVER(blk) = {
 	.id		= UCLASS_BLK,
 	.name		= "blk",
 	.post_probe	= blk_post_probe,
+	.pre_remove	= blk_pre_remove,
 	.per_device_platdata_auto_alloc_size = sizeof(struct blk_desc),
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	.per_device_auto_alloc_size = sizeof(struct blk_queue),
+#endif
 };
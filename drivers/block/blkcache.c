@@ -6,68 +6,356 @@
  */
 #include <config.h>
 #include <common.h>
+#include <blk.h>
+#include <dm.h>
 #include <malloc.h>
 #include <part.h>
 #include <linux/ctype.h>
 #include <linux/list.h>
 
+/*
+ * The cache holds single blocks, so a read is served from it whenever all of
+ * its blocks are present, whichever reads brought them in. Blocks are found
+ * through a hash of their device and block number and are recycled in LRU
+ * order. Nodes, hash table, block data and the read-ahead buffer all live in
+ * one arena, allocated when the cache is first used.
+ *
+ * With write-back enabled for a device, small writes to it only update the
+ * cache and mark the blocks dirty. Dirty blocks are never recycled; they are
+ * written out sorted by block number, with adjacent blocks merged into one
+ * write, when write-back is disabled again, when half the cache is dirty or
+ * before anything else could see the device without them.
+ */
+
+/* Number of devices whose sequential reads are tracked at once */
+#define BLOCK_CACHE_STREAMS	4
+
+/**
+ * struct block_cache_node - a cached block
+ *
+ * @hash:	Link in the hash chain
+ * @lh:		Link in the LRU list, or in the free list
+ * @iftype:	IF_TYPE_x of the device
+ * @devnum:	Device index
+ * @blk:	Block number
+ * @dirty:	Block was written but not yet flushed to the device
+ * @data:	Block contents, in the arena
+ */
 struct block_cache_node {
+	struct hlist_node hash;
 	struct list_head lh;
 	int iftype;
 	int devnum;
-	lbaint_t start;
-	lbaint_t blkcnt;
-	unsigned long blksz;
-	char *cache;
+	lbaint_t blk;
+	bool dirty;
+	char *data;
+};
+
+/**
+ * struct block_cache_stream - sequential reads from one device
+ *
+ * @iftype:	IF_TYPE_x of the device, or IF_TYPE_UNKNOWN if unused
+ * @devnum:	Device index
+ * @next:	Block after the last one read, including read-ahead
+ * @window:	Number of blocks read ahead last time
+ */
+struct block_cache_stream {
+	int iftype;
+	int devnum;
+	lbaint_t next;
+	lbaint_t window;
 };
 
-static LIST_HEAD(block_cache);
+/**
+ * struct block_cache - the block cache
+ *
+ * @arena:	Memory holding everything below
+ * @ra_buf:	Buffer for a read plus its read-ahead
+ * @nodes:	One node per block the cache can hold
+ * @flush:	Dirty nodes being sorted for a flush
+ * @hash:	Hash table heads
+ * @hash_bits:	log2 of the number of hash table heads
+ * @blksz:	Largest block size the arena can hold
+ * @lru:	Nodes in use, most recently used first
+ * @free:	Nodes not in use
+ * @stream:	Sequential reads being tracked
+ * @next_stream: Stream to reuse for the next device
+ * @wb_iftype:	IF_TYPE_x of the device in write-back mode, or IF_TYPE_UNKNOWN
+ * @wb_devnum:	Index of the device in write-back mode
+ */
+static struct block_cache {
+	void *arena;
+	char *ra_buf;
+	struct block_cache_node *nodes;
+	struct block_cache_node **flush;
+	struct hlist_head *hash;
+	uint hash_bits;
+	unsigned long blksz;
+	struct list_head lru;
+	struct list_head free;
+	struct block_cache_stream stream[BLOCK_CACHE_STREAMS];
+	int next_stream;
+	int wb_iftype;
+	int wb_devnum;
+} block_cache = {
+	.lru = LIST_HEAD_INIT(block_cache.lru),
+	.free = LIST_HEAD_INIT(block_cache.free),
+};
 
 static struct block_cache_stats _stats = {
-	.max_blocks_per_entry = 8,
-	.max_entries = 32
+	.max_blocks_per_entry = 32,
+	.max_entries = 512
 };
 
+static uint cache_hash(int iftype, int devnum, lbaint_t blk)
+{
+	u32 key = (u32)blk ^ ((u32)devnum << 20) ^ ((u32)iftype << 26);
+
+	/* Multiplicative hashing, keeping the well-mixed top bits */
+	return (key * 0x9e3779b1) >> (32 - block_cache.hash_bits);
+}
+
+static int cache_flush_all(void);
+
+static void cache_free(void)
+{
+	struct block_cache *c = &block_cache;
+
+	cache_flush_all();
+	free(c->arena);
+	c->arena = NULL;
+	INIT_LIST_HEAD(&c->lru);
+	INIT_LIST_HEAD(&c->free);
+	_stats.entries = 0;
+	_stats.dirty = 0;
+}
+
+/* Set up the arena for blocks of up to @blksz bytes */
+static int cache_alloc(unsigned long blksz)
+{
+	struct block_cache *c = &block_cache;
+	ulong ra_size, data_size, nodes_size, flush_size;
+	uint i;
+
+	if (c->arena && blksz <= c->blksz)
+		return 0;
+
+	cache_free();
+	for (c->hash_bits = 1; (1U << c->hash_bits) < _stats.max_entries;)
+		c->hash_bits++;
+
+	ra_size = ALIGN((_stats.max_blocks_per_entry +
+			 CONFIG_BLOCK_CACHE_READAHEAD) * blksz,
+			ARCH_DMA_MINALIGN);
+	data_size = ALIGN(_stats.max_entries * blksz, sizeof(long));
+	nodes_size = _stats.max_entries * sizeof(struct block_cache_node);
+	flush_size = IS_ENABLED(CONFIG_BLOCK_CACHE_WRITEBACK) ?
+		_stats.max_entries * sizeof(struct block_cache_node *) : 0;
+	c->arena = memalign(ARCH_DMA_MINALIGN, ra_size + data_size +
+			    nodes_size + flush_size +
+			    (sizeof(struct hlist_head) << c->hash_bits));
+	if (!c->arena)
+		return -ENOMEM;
+
+	c->blksz = blksz;
+	c->ra_buf = c->arena;
+	c->nodes = c->arena + ra_size + data_size;
+	c->flush = c->arena + ra_size + data_size + nodes_size;
+	c->hash = c->arena + ra_size + data_size + nodes_size + flush_size;
+	for (i = 0; i < (1U << c->hash_bits); i++)
+		INIT_HLIST_HEAD(&c->hash[i]);
+	for (i = 0; i < _stats.max_entries; i++) {
+		c->nodes[i].data = c->arena + ra_size + i * blksz;
+		c->nodes[i].dirty = false;
+		INIT_HLIST_NODE(&c->nodes[i].hash);
+		list_add_tail(&c->nodes[i].lh, &c->free);
+	}
+
+	return 0;
+}
+
 static struct block_cache_node *cache_find(int iftype, int devnum,
-					   lbaint_t start, lbaint_t blkcnt,
-					   unsigned long blksz)
+					   lbaint_t blk)
 {
 	struct block_cache_node *node;
+	struct hlist_node *pos;
 
-	list_for_each_entry(node, &block_cache, lh)
-		if ((node->iftype == iftype) &&
-		    (node->devnum == devnum) &&
-		    (node->blksz == blksz) &&
-		    (node->start <= start) &&
-		    (node->start + node->blkcnt >= start + blkcnt)) {
-			if (block_cache.next != &node->lh) {
-				/* maintain MRU ordering */
-				list_del(&node->lh);
-				list_add(&node->lh, &block_cache);
-			}
+	hlist_for_each_entry(node, pos,
+			     &block_cache.hash[cache_hash(iftype, devnum, blk)],
+			     hash)
+		if (node->blk == blk && node->devnum == devnum &&
+		    node->iftype == iftype)
 			return node;
+
+	return NULL;
+}
+
+/*
+ * Find a node for a block that is not cached yet, taking a free node or
+ * recycling the least recently used clean one. Returns NULL if every node
+ * is dirty.
+ */
+static struct block_cache_node *cache_get_node(int iftype, int devnum,
+					       lbaint_t blk)
+{
+	struct block_cache *c = &block_cache;
+	struct block_cache_node *node;
+
+	if (!list_empty(&c->free)) {
+		node = list_first_entry(&c->free, struct block_cache_node, lh);
+		_stats.entries++;
+	} else {
+		list_for_each_entry_reverse(node, &c->lru, lh) {
+			if (!node->dirty)
+				break;
 		}
-	return 0;
+		if (&node->lh == &c->lru)
+			return NULL;
+		hlist_del(&node->hash);
+	}
+	node->iftype = iftype;
+	node->devnum = devnum;
+	node->blk = blk;
+	hlist_add_head(&node->hash, &c->hash[cache_hash(iftype, devnum, blk)]);
+	list_move(&node->lh, &c->lru);
+
+	return node;
+}
+
+static int cache_cmp_blk(const void *a, const void *b)
+{
+	const struct block_cache_node *na = *(struct block_cache_node **)a;
+	const struct block_cache_node *nb = *(struct block_cache_node **)b;
+
+	if (na->blk == nb->blk)
+		return 0;
+
+	return na->blk < nb->blk ? -1 : 1;
+}
+
+/* Write out the dirty blocks of a device, merging adjacent ones */
+static int cache_flush(int iftype, int devnum)
+{
+	struct block_cache *c = &block_cache;
+	struct block_cache_node *node;
+	lbaint_t max_run, run, i, j;
+	const struct blk_ops *ops;
+	struct blk_desc *desc;
+	struct udevice *dev;
+	uint count = 0;
+	int ret = 0;
+
+	list_for_each_entry(node, &c->lru, lh)
+		if (node->dirty && node->iftype == iftype &&
+		    node->devnum == devnum)
+			c->flush[count++] = node;
+	if (!count)
+		return 0;
+
+	if (blk_find_device(iftype, devnum, &dev) ||
+	    !blk_get_ops(dev)->write) {
+		ret = -ENODEV;
+		goto drop;
+	}
+	ops = blk_get_ops(dev);
+	desc = dev_get_uclass_platdata(dev);
+
+	qsort(c->flush, count, sizeof(*c->flush), cache_cmp_blk);
+	max_run = _stats.max_blocks_per_entry + CONFIG_BLOCK_CACHE_READAHEAD;
+	for (i = 0; i < count; i += run) {
+		for (run = 1; i + run < count && run < max_run; run++)
+			if (c->flush[i + run]->blk != c->flush[i]->blk + run)
+				break;
+
+		debug("flush: start " LBAF ", count " LBAFU "\n",
+		      c->flush[i]->blk, run);
+		if (run == 1) {
+			if (ops->write(dev, c->flush[i]->blk, 1,
+				       c->flush[i]->data) != 1)
+				ret = -EIO;
+			continue;
+		}
+		for (j = 0; j < run; j++)
+			memcpy(c->ra_buf + j * desc->blksz,
+			       c->flush[i + j]->data, desc->blksz);
+		if (ops->write(dev, c->flush[i]->blk, run, c->ra_buf) != run)
+			ret = -EIO;
+	}
+
+drop:
+	if (ret)
+		printf("blkcache: failed to write back blocks (err=%d)\n",
+		       ret);
+	for (i = 0; i < count; i++) {
+		node = c->flush[i];
+		node->dirty = false;
+		_stats.dirty--;
+		/* Don't keep data that may never have reached the device */
+		if (ret) {
+			hlist_del(&node->hash);
+			list_move(&node->lh, &c->free);
+			_stats.entries--;
+		}
+	}
+
+	return ret;
+}
+
+static int cache_flush_all(void)
+{
+	struct block_cache_node *node;
+	int ret = 0;
+
+	while (_stats.dirty) {
+		list_for_each_entry(node, &block_cache.lru, lh)
+			if (node->dirty)
+				break;
+		ret = cache_flush(node->iftype, node->devnum) ?: ret;
+	}
+
+	return ret;
 }
 
 int blkcache_read(int iftype, int devnum,
 		  lbaint_t start, lbaint_t blkcnt,
 		  unsigned long blksz, void *buffer)
 {
-	struct block_cache_node *node = cache_find(iftype, devnum, start,
-						   blkcnt, blksz);
-	if (node) {
-		const char *src = node->cache + (start - node->start) * blksz;
-		memcpy(buffer, src, blksz * blkcnt);
-		debug("hit: start " LBAF ", count " LBAFU "\n",
-		      start, blkcnt);
-		++_stats.hits;
-		return 1;
+	struct block_cache_node *node;
+	lbaint_t i;
+
+	if (!block_cache.arena || blksz > block_cache.blksz ||
+	    blkcnt > _stats.entries)
+		goto miss;
+
+	for (i = 0; i < blkcnt; i++) {
+		node = cache_find(iftype, devnum, start + i);
+		if (!node)
+			goto miss;
+
+		memcpy(buffer + i * blksz, node->data, blksz);
+		/* maintain MRU ordering */
+		list_move(&node->lh, &block_cache.lru);
 	}
 
+	debug("hit: start " LBAF ", count " LBAFU "\n",
+	      start, blkcnt);
+	++_stats.hits;
+	return 1;
+
+miss:
 	debug("miss: start " LBAF ", count " LBAFU "\n",
 	      start, blkcnt);
 	++_stats.misses;
+
+	/* The caller reads the device next, so it must not be stale */
+	for (i = 0; _stats.dirty && i < blkcnt; i++) {
+		node = cache_find(iftype, devnum, start + i);
+		if (node && node->dirty) {
+			cache_flush(iftype, devnum);
+			break;
+		}
+	}
+
 	return 0;
 }
 
@@ -75,86 +363,185 @@ void blkcache_fill(int iftype, int devnum,
 		   lbaint_t start, lbaint_t blkcnt,
 		   unsigned long blksz, void const *buffer)
 {
-	lbaint_t bytes;
+	struct block_cache *c = &block_cache;
 	struct block_cache_node *node;
+	lbaint_t i;
 
 	/* don't cache big stuff */
-	if (blkcnt > _stats.max_blocks_per_entry)
+	if (blkcnt > _stats.max_blocks_per_entry + CONFIG_BLOCK_CACHE_READAHEAD)
 		return;
 
-	if (_stats.max_entries == 0)
+	if (_stats.max_entries == 0 || cache_alloc(blksz))
 		return;
 
-	bytes = blksz * blkcnt;
-	if (_stats.max_entries <= _stats.entries) {
-		/* pop LRU */
-		node = (struct block_cache_node *)block_cache.prev;
-		list_del(&node->lh);
-		_stats.entries--;
-		debug("drop: start " LBAF ", count " LBAFU "\n",
-		      node->start, node->blkcnt);
-		if (node->blkcnt * node->blksz < bytes) {
-			free(node->cache);
-			node->cache = 0;
-		}
-	} else {
-		node = malloc(sizeof(*node));
+	debug("fill: start " LBAF ", count " LBAFU "\n",
+	      start, blkcnt);
+
+	for (i = 0; i < blkcnt; i++) {
+		node = cache_find(iftype, devnum, start + i);
+		if (!node)
+			node = cache_get_node(iftype, devnum, start + i);
 		if (!node)
 			return;
-		node->cache = 0;
+		/* a dirty block is newer than what the device holds */
+		if (!node->dirty)
+			memcpy(node->data, buffer + i * blksz, blksz);
+		list_move(&node->lh, &c->lru);
 	}
+}
 
-	if (!node->cache) {
-		node->cache = malloc(bytes);
-		if (!node->cache) {
-			free(node);
-			return;
+int blkcache_write(int iftype, int devnum,
+		   lbaint_t start, lbaint_t blkcnt,
+		   unsigned long blksz, void const *buffer)
+{
+	struct block_cache *c = &block_cache;
+	struct block_cache_node *node;
+	lbaint_t i;
+
+	if (c->wb_iftype != iftype || c->wb_devnum != devnum ||
+	    blkcnt > _stats.max_blocks_per_entry || cache_alloc(blksz))
+		return 0;
+
+	debug("write: start " LBAF ", count " LBAFU "\n",
+	      start, blkcnt);
+
+	for (i = 0; i < blkcnt; i++) {
+		node = cache_find(iftype, devnum, start + i);
+		if (!node) {
+			node = cache_get_node(iftype, devnum, start + i);
+			if (!node) {
+				/* everything is dirty, make some room */
+				if (cache_flush_all())
+					return -EIO;
+				node = cache_get_node(iftype, devnum,
+						      start + i);
+			}
+		}
+		memcpy(node->data, buffer + i * blksz, blksz);
+		list_move(&node->lh, &c->lru);
+		if (!node->dirty) {
+			node->dirty = true;
+			_stats.dirty++;
 		}
 	}
 
-	debug("fill: start " LBAF ", count " LBAFU "\n",
-	      start, blkcnt);
+	if (_stats.dirty >= _stats.max_entries / 2 &&
+	    cache_flush(iftype, devnum))
+		return -EIO;
 
-	node->iftype = iftype;
-	node->devnum = devnum;
-	node->start = start;
-	node->blkcnt = blkcnt;
-	node->blksz = blksz;
-	memcpy(node->cache, buffer, bytes);
-	list_add(&node->lh, &block_cache);
-	_stats.entries++;
+	return 1;
+}
+
+int blkcache_writeback(int iftype, int devnum, bool enable)
+{
+	struct block_cache *c = &block_cache;
+	int ret = 0;
+
+	if (enable) {
+		if (!IS_ENABLED(CONFIG_BLOCK_CACHE_WRITEBACK) ||
+		    _stats.max_entries == 0)
+			return 0;
+		if (c->wb_iftype != IF_TYPE_UNKNOWN &&
+		    (c->wb_iftype != iftype || c->wb_devnum != devnum))
+			ret = blkcache_writeback(c->wb_iftype, c->wb_devnum,
+						 false);
+		c->wb_iftype = iftype;
+		c->wb_devnum = devnum;
+		return ret;
+	}
+
+	if (c->wb_iftype == iftype && c->wb_devnum == devnum)
+		c->wb_iftype = IF_TYPE_UNKNOWN;
+
+	return blkcache_flush(iftype, devnum);
+}
+
+int blkcache_flush(int iftype, int devnum)
+{
+	if (!_stats.dirty)
+		return 0;
+
+	return cache_flush(iftype, devnum);
+}
+
+lbaint_t blkcache_readahead(int iftype, int devnum,
+			    lbaint_t start, lbaint_t blkcnt,
+			    unsigned long blksz, void **bufp)
+{
+	struct block_cache *c = &block_cache;
+	struct block_cache_stream *s = NULL;
+	lbaint_t window;
+	int i;
+
+	if (!CONFIG_BLOCK_CACHE_READAHEAD || _stats.max_entries == 0 ||
+	    blkcnt > _stats.max_blocks_per_entry)
+		return 0;
+
+	for (i = 0; i < BLOCK_CACHE_STREAMS; i++) {
+		if (c->stream[i].iftype == iftype &&
+		    c->stream[i].devnum == devnum) {
+			s = &c->stream[i];
+			break;
+		}
+	}
+	if (!s) {
+		s = &c->stream[c->next_stream];
+		c->next_stream = (c->next_stream + 1) % BLOCK_CACHE_STREAMS;
+		s->iftype = iftype;
+		s->devnum = devnum;
+		s->window = 0;
+		s->next = start + blkcnt;
+		return 0;
+	}
+
+	/* Double the window while the reads stay sequential */
+	window = 0;
+	if (start == s->next) {
+		window = min_t(lbaint_t, 2 * max(s->window, blkcnt),
+			       CONFIG_BLOCK_CACHE_READAHEAD);
+		window = min_t(lbaint_t, window, _stats.max_entries / 4);
+	}
+	if (window && cache_alloc(blksz))
+		window = 0;
+
+	s->window = window;
+	s->next = start + blkcnt + window;
+	*bufp = c->ra_buf;
+	if (window)
+		debug("read-ahead: start " LBAF ", count " LBAFU "\n",
+		      start + blkcnt, window);
+
+	return window;
 }
 
 void blkcache_invalidate(int iftype, int devnum)
 {
-	struct list_head *entry, *n;
-	struct block_cache_node *node;
+	struct block_cache *c = &block_cache;
+	struct block_cache_node *node, *n;
+	int i;
 
-	list_for_each_safe(entry, n, &block_cache) {
-		node = (struct block_cache_node *)entry;
+	blkcache_flush(iftype, devnum);
+	list_for_each_entry_safe(node, n, &c->lru, lh) {
 		if ((node->iftype == iftype) &&
 		    (node->devnum == devnum)) {
-			list_del(entry);
-			free(node->cache);
-			free(node);
+			hlist_del(&node->hash);
+			list_move(&node->lh, &c->free);
 			--_stats.entries;
 		}
 	}
+
+	for (i = 0; i < BLOCK_CACHE_STREAMS; i++)
+		if (c->stream[i].iftype == iftype &&
+		    c->stream[i].devnum == devnum)
+			c->stream[i].iftype = IF_TYPE_UNKNOWN;
 }
 
 void blkcache_configure(unsigned blocks, unsigned entries)
 {
-	struct block_cache_node *node;
 	if ((blocks != _stats.max_blocks_per_entry) ||
 	    (entries != _stats.max_entries)) {
 		/* invalidate cache */
-		while (!list_empty(&block_cache)) {
-			node = (struct block_cache_node *)block_cache.next;
-			list_del(&node->lh);
-			free(node->cache);
-			free(node);
-		}
-		_stats.entries = 0;
+		cache_free();
 	}
 
 	_stats.max_blocks_per_entry = blocks;
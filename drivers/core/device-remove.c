@@ -64,6 +64,18 @@ int device_unbind(struct udevice *dev)
 	if (!dev)
 		return -EINVAL;
 
+	/* A probe still in progress is dropped, as the device is going */
+	if (dev->flags & DM_FLAG_PROBE_PENDING) {
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+		list_del_init(&dev->probe_node);
+#endif
+		device_free(dev);
+
+		dev->seq = -1;
+		uclass_index_device(dev);
+		dev->flags &= ~DM_FLAG_PROBE_PENDING;
+	}
+
 	if (dev->flags & DM_FLAG_ACTIVATED)
 		return -EINVAL;
 
@@ -160,6 +172,10 @@ int device_remove(struct udevice *dev, uint flags)
 	if (!dev)
 		return -EINVAL;
 
+	/* A probe still in progress is finished first */
+	if (dev->flags & DM_FLAG_PROBE_PENDING)
+		device_probe(dev);
+
 	if (!(dev->flags & DM_FLAG_ACTIVATED))
 		return 0;
 
@@ -196,6 +212,7 @@ int device_remove(struct udevice *dev, uint flags)
 		device_free(dev);
 
 		dev->seq = -1;
+		uclass_index_device(dev);
 		dev->flags &= ~DM_FLAG_ACTIVATED;
 	}
 
@@ -27,6 +27,7 @@
 #include <linux/err.h>
 #include <linux/list.h>
 #include <power-domain.h>
+#include <watchdog.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -59,6 +60,9 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 	INIT_LIST_HEAD(&dev->uclass_node);
 #ifdef CONFIG_DEVRES
 	INIT_LIST_HEAD(&dev->devres_head);
+#endif
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+	INIT_LIST_HEAD(&dev->probe_node);
 #endif
 	dev->platdata = platdata;
 	dev->driver_data = driver_data;
@@ -163,6 +167,8 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 		if (ret)
 			goto fail_uclass_post_bind;
 	}
+	/* The bind methods may have set req_seq, e.g. from an alias */
+	uclass_index_device(dev);
 
 	if (parent)
 		pr_debug("Bound device %s to %s\n", dev->name, parent->name);
@@ -305,7 +311,97 @@ static void *alloc_priv(int size, uint flags)
 	return priv;
 }
 
-int device_probe(struct udevice *dev)
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+/* Devices whose probe is finished in the background, after relocation */
+static LIST_HEAD(probe_pending);
+#endif
+
+/*
+ * Finish probing a device once its driver has returned @ret from probe(),
+ * or from probe_poll(). On failure the device is left as it was before.
+ */
+static int device_probe_done(struct udevice *dev, int ret)
+{
+	if (ret)
+		goto fail;
+
+	dev->flags |= DM_FLAG_ACTIVATED;
+	ret = uclass_post_probe_device(dev);
+	if (ret)
+		goto fail_uclass;
+
+	if (dev->parent && device_get_uclass_id(dev) == UCLASS_PINCTRL)
+		pinctrl_select_state(dev, "default");
+
+	return 0;
+fail_uclass:
+	if (device_remove(dev, DM_REMOVE_NORMAL)) {
+		dm_warn("%s: Device '%s' failed to remove on error path\n",
+			__func__, dev->name);
+	}
+fail:
+	dev->flags &= ~DM_FLAG_ACTIVATED;
+
+	dev->seq = -1;
+	uclass_index_device(dev);
+	device_free(dev);
+
+	return ret;
+}
+
+/* Call the driver's probe_poll() method; -EINPROGRESS until it is done */
+static int device_probe_step(struct udevice *dev)
+{
+	int ret;
+
+	ret = dev->driver->probe_poll(dev);
+	if (ret == -EINPROGRESS)
+		return ret;
+
+	dev->flags &= ~DM_FLAG_PROBE_PENDING;
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+	list_del_init(&dev->probe_node);
+#endif
+
+	return device_probe_done(dev, ret);
+}
+
+/* Wait for a pending probe, letting the others progress meanwhile */
+static int device_probe_wait(struct udevice *dev)
+{
+	int ret;
+
+	while (1) {
+		ret = device_probe_step(dev);
+		if (ret != -EINPROGRESS)
+			return ret;
+		dm_probe_poll();
+		if (!(dev->flags & DM_FLAG_PROBE_PENDING))
+			return device_active(dev) ? 0 : -EIO;
+		WATCHDOG_RESET();
+	}
+}
+
+void dm_probe_poll(void)
+{
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+	static bool polling;
+	struct udevice *dev, *next;
+
+	if (!(gd->flags & GD_FLG_RELOC) || polling)
+		return;
+
+	polling = true;
+	list_for_each_entry_safe(dev, next, &probe_pending, probe_node) {
+		/* Finishing a probe may probe other devices, so stop here */
+		if (device_probe_step(dev) != -EINPROGRESS)
+			break;
+	}
+	polling = false;
+#endif
+}
+
+static int device_do_probe(struct udevice *dev, bool async)
 {
 	struct power_domain pd;
 	const struct driver *drv;
@@ -316,9 +412,13 @@ int device_probe(struct udevice *dev)
 	if (!dev)
 		return -EINVAL;
 
+	if (dev->flags & DM_FLAG_PROBE_PENDING)
+		return async ? 0 : device_probe_wait(dev);
 	if (dev->flags & DM_FLAG_ACTIVATED)
 		return 0;
 
+	dm_probe_poll();
+
 	drv = dev->driver;
 	assert(drv);
 
@@ -366,6 +466,8 @@ int device_probe(struct udevice *dev)
 		 * (e.g. PCI bridge devices). Test the flags again
 		 * so that we don't mess up the device.
 		 */
+		if (dev->flags & DM_FLAG_PROBE_PENDING)
+			return async ? 0 : device_probe_wait(dev);
 		if (dev->flags & DM_FLAG_ACTIVATED)
 			return 0;
 	}
@@ -376,6 +478,7 @@ int device_probe(struct udevice *dev)
 		goto fail;
 	}
 	dev->seq = seq;
+	uclass_index_device(dev);
 
 	dev->flags |= DM_FLAG_ACTIVATED;
 
@@ -416,32 +519,36 @@ int device_probe(struct udevice *dev)
 
 	if (drv->probe) {
 		ret = drv->probe(dev);
-		if (ret) {
+		if (ret == -EINPROGRESS && drv->probe_poll) {
+			/* Not active until probe_poll() says it is ready */
 			dev->flags &= ~DM_FLAG_ACTIVATED;
-			goto fail;
+			dev->flags |= DM_FLAG_PROBE_PENDING;
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+			if (async && (gd->flags & GD_FLG_RELOC)) {
+				list_add_tail(&dev->probe_node,
+					      &probe_pending);
+				return 0;
+			}
+#endif
+			return device_probe_wait(dev);
 		}
+		if (ret)
+			goto fail;
 	}
 
-	ret = uclass_post_probe_device(dev);
-	if (ret)
-		goto fail_uclass;
-
-	if (dev->parent && device_get_uclass_id(dev) == UCLASS_PINCTRL)
-		pinctrl_select_state(dev, "default");
-
-	return 0;
-fail_uclass:
-	if (device_remove(dev, DM_REMOVE_NORMAL)) {
-		dm_warn("%s: Device '%s' failed to remove on error path\n",
-			__func__, dev->name);
-	}
+	return device_probe_done(dev, 0);
 fail:
-	dev->flags &= ~DM_FLAG_ACTIVATED;
+	return device_probe_done(dev, ret);
+}
 
-	dev->seq = -1;
-	device_free(dev);
+int device_probe(struct udevice *dev)
+{
+	return device_do_probe(dev, false);
+}
 
-	return ret;
+int device_probe_async(struct udevice *dev)
+{
+	return device_do_probe(dev, true);
 }
 
 void *dev_get_platdata(const struct udevice *dev)
@@ -794,6 +901,12 @@ bool device_is_last_sibling(struct udevice *dev)
 	return list_is_last(&dev->sibling_node, &parent->child_head);
 }
 
+void dev_set_ofnode(struct udevice *dev, ofnode node)
+{
+	dev->node = node;
+	uclass_index_device(dev);
+}
+
 void device_set_name_alloced(struct udevice *dev)
 {
 	dev->flags |= DM_FLAG_NAME_ALLOCED;
@@ -15,7 +15,13 @@
 #include <dm/uclass.h>
 #include <dm/util.h>
 #include <fdtdec.h>
+#include <malloc.h>
+#include <u-boot/crc.h>
 #include <linux/compiler.h>
+#include <linux/err.h>
+#include <linux/log2.h>
+
+DECLARE_GLOBAL_DATA_PTR;
 
 struct driver *lists_driver_lookup_name(const char *name)
 {
@@ -122,17 +128,252 @@ static int driver_check_compatible(const struct udevice_id *of_match,
 	return -ENOENT;
 }
 
-int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
-		   bool pre_reloc_only)
+/**
+ * struct driver_compat - First driver matching a compatible string
+ *
+ * @compat:	Compatible string, NULL for an empty slot
+ * @drv:	First driver in the list with this string in its of_match
+ * @id:		Match found in that driver
+ */
+struct driver_compat {
+	const char *compat;
+	struct driver *drv;
+	const struct udevice_id *id;
+};
+
+/* Drivers by compatible string, in a hash table of driver_compat_mask + 1 */
+static struct driver_compat *driver_compat_table;
+static uint driver_compat_mask;
+
+static uint driver_compat_hash(const char *compat)
+{
+	uint hash = 0;
+
+	while (*compat)
+		hash = hash * 31 + *compat++;
+
+	return hash;
+}
+
+static struct driver_compat *driver_compat_slot(const char *compat)
+{
+	uint i = driver_compat_hash(compat) & driver_compat_mask;
+
+	/* The table is never more than half full, so this ends */
+	while (driver_compat_table[i].compat &&
+	       strcmp(driver_compat_table[i].compat, compat))
+		i = (i + 1) & driver_compat_mask;
+
+	return &driver_compat_table[i];
+}
+
+/* Put the compatible strings of all drivers in driver_compat_table */
+static int driver_compat_init(void)
 {
 	struct driver *driver = ll_entry_start(struct driver, driver);
 	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct udevice_id *of_match;
+	struct driver_compat *slot;
+	struct driver *entry;
+	uint count = 0;
+
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (of_match = entry->of_match;
+		     of_match && of_match->compatible; of_match++)
+			count++;
+	}
+
+	driver_compat_mask = roundup_pow_of_two(count * 2 + 1) - 1;
+	driver_compat_table = calloc(driver_compat_mask + 1, sizeof(*slot));
+	if (!driver_compat_table)
+		return -ENOMEM;
+
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (of_match = entry->of_match;
+		     of_match && of_match->compatible; of_match++) {
+			/* As with a linear search, the first driver wins */
+			slot = driver_compat_slot(of_match->compatible);
+			if (slot->compat)
+				continue;
+			slot->compat = of_match->compatible;
+			slot->drv = entry;
+			slot->id = of_match;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * driver_lookup_compatible() - Find the driver for a compatible string
+ *
+ * After relocation this uses a hash table of the drivers' compatible
+ * strings, built the first time. Before that, when memory is short and BSS
+ * may not be usable, the list of drivers is searched.
+ *
+ * @param compat:	The compatible string to search for
+ * @param of_idp:	Returns the match that was found
+ * @return the first driver with a match, or NULL if none
+ */
+static struct driver *driver_lookup_compatible(const char *compat,
+					       const struct udevice_id **of_idp)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	struct driver_compat *slot;
+	struct driver *entry;
+
+	if ((gd->flags & GD_FLG_RELOC) &&
+	    (driver_compat_table || !driver_compat_init())) {
+		slot = driver_compat_slot(compat);
+		if (!slot->compat)
+			return NULL;
+		*of_idp = slot->id;
+
+		return slot->drv;
+	}
+
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		if (!driver_check_compatible(entry->of_match, of_idp, compat))
+			return entry;
+	}
+
+	return NULL;
+}
+
+#if CONFIG_IS_ENABLED(OF_BIND_TABLE)
+int lists_bind_table_init(const void *blob)
+{
+	const struct dm_bind_table *table = &dm_bind_table;
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	struct driver **drivers;
+	struct driver *entry;
+	int lo, hi, mid, cmp;
+
+	gd->bind_drivers = NULL;
+	if (!blob || fdt_totalsize(blob) != table->fdt_size ||
+	    crc32(0, blob, table->fdt_size) != table->fdt_crc) {
+		debug("%s: Table is for another device tree\n", __func__);
+		return -ESTALE;
+	}
+
+	drivers = calloc(table->driver_count, sizeof(*drivers));
+	if (!drivers)
+		return -ENOMEM;
+
+	/* Drivers are sorted by symbol rather than name, so look up each */
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		if (!entry->of_match)
+			continue;
+		for (lo = 0, hi = table->driver_count; lo < hi;) {
+			mid = (lo + hi) / 2;
+			cmp = strcmp(entry->name, table->drivers[mid]);
+			if (!cmp)
+				break;
+			if (cmp < 0)
+				hi = mid;
+			else
+				lo = mid + 1;
+		}
+		if (lo == hi || table->unknown[mid] || drivers[mid]) {
+			debug("%s: Table does not cover driver '%s'\n", __func__,
+			      entry->name);
+			free(drivers);
+			return -EPERM;
+		}
+		drivers[mid] = entry;
+	}
+	gd->bind_drivers = drivers;
+
+	return 0;
+}
+
+/**
+ * bind_table_lookup() - Find the driver for a node in the bind table
+ *
+ * @offset:	Offset of the node
+ * @compat_idx:	Index of the compatible string in the node's list
+ * @compat:	The compatible string
+ * @of_idp:	Returns the match that was found
+ * @return the driver, NULL if there is none, or ERR_PTR(-ENOENT) if the
+ * table does not agree with the driver, which must then be searched for
+ */
+static struct driver *bind_table_lookup(int offset, int compat_idx,
+					const char *compat,
+					const struct udevice_id **of_idp)
+{
+	const struct dm_bind_table *table = &dm_bind_table;
+	const struct dm_bind_entry *ent, *end;
+	const struct udevice_id *of_match;
+	struct driver *drv;
+	int lo, hi, mid, i;
+
+	/* Find the first entry for the compatible string */
+	for (lo = 0, hi = table->entry_count; lo < hi;) {
+		mid = (lo + hi) / 2;
+		ent = &table->entries[mid];
+		if (ent->offset < offset ||
+		    (ent->offset == offset && ent->compat < compat_idx))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	end = table->entries + table->entry_count;
+	for (ent = &table->entries[lo];
+	     ent < end && ent->offset == offset && ent->compat == compat_idx;
+	     ent++) {
+		drv = gd->bind_drivers[ent->driver];
+		if (!drv)
+			continue;
+		for (i = 0, of_match = drv->of_match; i < ent->of_match; i++)
+			if (!of_match[i].compatible)
+				return ERR_PTR(-ENOENT);
+		of_match += ent->of_match;
+		if (!of_match->compatible || strcmp(of_match->compatible, compat))
+			return ERR_PTR(-ENOENT);
+		*of_idp = of_match;
+
+		return drv;
+	}
+
+	return NULL;
+}
+#endif
+
+/*
+ * Find the driver for compatible string @compat_idx of @node, from the bind
+ * table if possible
+ */
+static struct driver *lists_find_driver(ofnode node, int compat_idx,
+					const char *compat,
+					const struct udevice_id **of_idp)
+{
+#if CONFIG_IS_ENABLED(OF_BIND_TABLE)
+	struct driver *drv;
+
+	if (gd->bind_drivers && !ofnode_is_np(node)) {
+		drv = bind_table_lookup(ofnode_to_offset(node), compat_idx,
+					compat, of_idp);
+		if (!IS_ERR(drv))
+			return drv;
+		debug("%s: Bind table is wrong for '%s'\n", __func__, compat);
+	}
+#endif
+
+	return driver_lookup_compatible(compat, of_idp);
+}
+
+int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
+		   bool pre_reloc_only)
+{
 	const struct udevice_id *id;
 	struct driver *entry;
 	struct udevice *dev;
 	bool found = false;
 	const char *name, *compat_list, *compat;
-	int compat_length, i;
+	int compat_length, compat_idx, i;
 	int result = 0;
 	int ret = 0;
 
@@ -158,18 +399,14 @@ int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
 	 * compatible string in order such that we match in order of priority
 	 * from the first string to the last.
 	 */
-	for (i = 0; i < compat_length; i += strlen(compat) + 1) {
+	for (i = 0, compat_idx = 0; i < compat_length;
+	     i += strlen(compat) + 1, compat_idx++) {
 		compat = compat_list + i;
 		pr_debug("   - attempt to match compatible string '%s'\n",
 			 compat);
 
-		for (entry = driver; entry != driver + n_ents; entry++) {
-			ret = driver_check_compatible(entry->of_match, &id,
-						      compat);
-			if (!ret)
-				break;
-		}
-		if (entry == driver + n_ents)
+		entry = lists_find_driver(node, compat_idx, compat, &id);
+		if (!entry)
 			continue;
 
 		if (pre_reloc_only) {
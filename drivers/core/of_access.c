@@ -25,6 +25,7 @@
 #include <linux/ctype.h>
 #include <linux/err.h>
 #include <linux/ioport.h>
+#include <linux/log2.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -43,6 +44,30 @@ static struct device_node *of_stdout;
 /* pointer to options given after the alias (separated by :) or NULL if none */
 static const char *of_stdout_options;
 
+/**
+ * struct of_compat_entry - Compatible string of a node, in the index
+ *
+ * @compat:	One of the strings in the node's "compatible" property
+ * @np:		Node concerned
+ * @next:	Next entry in the same hash bucket, in tree order
+ */
+struct of_compat_entry {
+	const char *compat;
+	struct device_node *np;
+	struct of_compat_entry *next;
+};
+
+/* Tree indexed by of_index_build(), NULL if none */
+static struct device_node *of_index_root;
+
+/* Nodes by phandle, in a hash table of of_phandle_mask + 1 slots */
+static struct device_node **of_phandle_table;
+static uint of_phandle_mask;
+
+/* Compatible strings, in a hash table of of_compat_mask + 1 buckets */
+static struct of_compat_entry **of_compat_table;
+static uint of_compat_mask;
+
 /**
  * struct alias_prop - Alias property in 'aliases' node
  *
@@ -362,11 +387,58 @@ struct device_node *of_find_node_opts_by_path(const char *path,
 	return np;
 }
 
+static bool of_index_active(void)
+{
+	return of_index_root && of_index_root == gd->of_root;
+}
+
+static uint of_compat_hash(const char *compat)
+{
+	uint hash = 0;
+
+	while (*compat)
+		hash = hash * 31 + tolower(*compat++);
+
+	return hash;
+}
+
+/* Find the next node after @from which has the compatible string, or NULL */
+static struct device_node *of_index_find_compatible(struct device_node *from,
+						    const char *type,
+						    const char *compatible)
+{
+	struct of_compat_entry *entry;
+	bool after = !from;
+
+	entry = of_compat_table[of_compat_hash(compatible) & of_compat_mask];
+	for (; entry; entry = entry->next) {
+		if (of_compat_cmp(entry->compat, compatible, 0))
+			continue;
+		if (!after) {
+			after = entry->np == from;
+			continue;
+		}
+		if (entry->np != from &&
+		    of_device_is_compatible(entry->np, compatible, type, NULL))
+			return entry->np;
+	}
+
+	return NULL;
+}
+
 struct device_node *of_find_compatible_node(struct device_node *from,
 		const char *type, const char *compatible)
 {
 	struct device_node *np;
 
+	/* The index only knows where @from is if it has the string too */
+	if (of_index_active() && compatible && compatible[0] &&
+	    (!from || of_device_is_compatible(from, compatible, NULL, NULL))) {
+		np = of_index_find_compatible(from, type, compatible);
+		of_node_put(from);
+		return of_node_get(np);
+	}
+
 	for_each_of_allnodes_from(from, np)
 		if (of_device_is_compatible(np, compatible, type, NULL) &&
 		    of_node_get(np))
@@ -410,6 +482,18 @@ struct device_node *of_find_node_by_phandle(phandle handle)
 	if (!handle)
 		return NULL;
 
+	if (of_index_active()) {
+		uint i;
+
+		for (i = handle & of_phandle_mask; of_phandle_table[i];
+		     i = (i + 1) & of_phandle_mask) {
+			if (of_phandle_table[i]->phandle == handle)
+				return of_node_get(of_phandle_table[i]);
+		}
+
+		return NULL;
+	}
+
 	for_each_of_allnodes(np)
 		if (np->phandle == handle)
 			break;
@@ -834,3 +918,77 @@ struct device_node *of_get_stdout(void)
 {
 	return of_stdout;
 }
+
+int of_index_build(struct device_node *root)
+{
+	struct of_compat_entry *entries, **bucket;
+	struct device_node *np, **slot;
+	struct property *prop;
+	const char *cp;
+	uint phandles = 0, compats = 0;
+	uint i;
+
+	of_index_root = NULL;
+	free(of_phandle_table);
+	free(of_compat_table);
+	of_phandle_table = NULL;
+	of_compat_table = NULL;
+
+	/* The walking functions go through gd->of_root */
+	if (root != gd->of_root)
+		return -EINVAL;
+
+	for_each_of_allnodes(np) {
+		if (np->phandle)
+			phandles++;
+		prop = of_find_property(np, "compatible", NULL);
+		for (cp = of_prop_next_string(prop, NULL); cp;
+		     cp = of_prop_next_string(prop, cp))
+			compats++;
+	}
+
+	/* Keep the phandle table at most half full, so probes stay short */
+	of_phandle_mask = roundup_pow_of_two(phandles * 2 + 1) - 1;
+	of_compat_mask = roundup_pow_of_two(compats + 1) - 1;
+	of_phandle_table = calloc(of_phandle_mask + 1, sizeof(np));
+	of_compat_table = calloc(1, (of_compat_mask + 1) * sizeof(*bucket) +
+				 compats * sizeof(*entries));
+	if (!of_phandle_table || !of_compat_table) {
+		free(of_phandle_table);
+		free(of_compat_table);
+		of_phandle_table = NULL;
+		of_compat_table = NULL;
+		return -ENOMEM;
+	}
+	entries = (void *)(of_compat_table + of_compat_mask + 1);
+
+	i = 0;
+	for_each_of_allnodes(np) {
+		if (np->phandle) {
+			slot = &of_phandle_table[np->phandle & of_phandle_mask];
+			while (*slot) {
+				if (++slot == of_phandle_table +
+					      of_phandle_mask + 1)
+					slot = of_phandle_table;
+			}
+			*slot = np;
+		}
+		prop = of_find_property(np, "compatible", NULL);
+		for (cp = of_prop_next_string(prop, NULL); cp;
+		     cp = of_prop_next_string(prop, cp)) {
+			entries[i].compat = cp;
+			entries[i++].np = np;
+		}
+	}
+
+	/* Add the entries backwards so that each bucket is in tree order */
+	while (i--) {
+		bucket = &of_compat_table[of_compat_hash(entries[i].compat) &
+					  of_compat_mask];
+		entries[i].next = *bucket;
+		*bucket = &entries[i];
+	}
+	of_index_root = root;
+
+	return 0;
+}
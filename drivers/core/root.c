@@ -151,10 +151,10 @@ int dm_init(bool of_live)
 #if CONFIG_IS_ENABLED(OF_CONTROL)
 # if CONFIG_IS_ENABLED(OF_LIVE)
 	if (of_live)
-		DM_ROOT_NON_CONST->node = np_to_ofnode(gd->of_root);
+		dev_set_ofnode(DM_ROOT_NON_CONST, np_to_ofnode(gd->of_root));
 	else
 #endif
-		DM_ROOT_NON_CONST->node = offset_to_ofnode(0);
+		dev_set_ofnode(DM_ROOT_NON_CONST, offset_to_ofnode(0));
 #endif
 	ret = device_probe(DM_ROOT_NON_CONST);
 	if (ret)
@@ -366,6 +366,22 @@ __weak int dm_scan_other(bool pre_reloc_only)
 	return 0;
 }
 
+void dm_probe_async(struct udevice *parent)
+{
+	struct udevice *dev;
+	int ret;
+
+	list_for_each_entry(dev, &parent->child_head, sibling_node) {
+		if (dev->driver->flags & DM_FLAG_PROBE_ASYNC) {
+			ret = device_probe_async(dev);
+			if (ret)
+				debug("%s: Device '%s' failed to probe: %d\n",
+				      __func__, dev->name, ret);
+		}
+		dm_probe_async(dev);
+	}
+}
+
 int dm_init_and_scan(bool pre_reloc_only)
 {
 	int ret;
@@ -382,6 +398,11 @@ int dm_init_and_scan(bool pre_reloc_only)
 	}
 
 	if (CONFIG_IS_ENABLED(OF_CONTROL) && !CONFIG_IS_ENABLED(OF_PLATDATA)) {
+		if (CONFIG_IS_ENABLED(OF_BIND_TABLE)) {
+			ret = lists_bind_table_init(gd->fdt_blob);
+			if (ret)
+				debug("Not using bind table: %d\n", ret);
+		}
 		ret = dm_extended_scan_fdt(gd->fdt_blob, pre_reloc_only);
 		if (ret) {
 			debug("dm_extended_scan_dt() failed: %d\n", ret);
@@ -393,6 +414,9 @@ int dm_init_and_scan(bool pre_reloc_only)
 	if (ret)
 		return ret;
 
+	if (CONFIG_IS_ENABLED(DM_PROBE_ASYNC) && !pre_reloc_only)
+		dm_probe_async(gd->dm_root);
+
 	return 0;
 }
 
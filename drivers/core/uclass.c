@@ -19,6 +19,167 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+/*
+ * Devices of all uclasses by node, seq and req_seq, hashed on the uclass and
+ * the value. These are in BSS so they are only used after relocation;
+ * devices bound before that are never looked up afterwards.
+ */
+#define UCLASS_INDEX_SIZE	256
+
+static struct hlist_head uclass_node_index[UCLASS_INDEX_SIZE];
+static struct hlist_head uclass_seq_index[UCLASS_INDEX_SIZE];
+static struct hlist_head uclass_req_seq_index[UCLASS_INDEX_SIZE];
+
+/* Lookups answered from the tables, and the number last given to bootstage */
+static ulong uclass_index_hits;
+static ulong uclass_index_reported;
+
+static bool uclass_index_active(void)
+{
+	return gd->flags & GD_FLG_RELOC;
+}
+
+static struct hlist_head *uclass_index_bucket(struct hlist_head *table,
+					      struct uclass *uc, ulong key)
+{
+	ulong hash = key ^ ((ulong)uc >> 4);
+
+	hash ^= hash >> 16;
+	hash ^= hash >> 8;
+
+	return &table[hash % UCLASS_INDEX_SIZE];
+}
+
+static void uclass_unindex_device(struct udevice *dev)
+{
+	hlist_del_init(&dev->node_index);
+	hlist_del_init(&dev->seq_index);
+	hlist_del_init(&dev->req_seq_index);
+}
+
+void uclass_index_device(struct udevice *dev)
+{
+	struct uclass *uc = dev->uclass;
+
+	uclass_unindex_device(dev);
+	if (!uclass_index_active())
+		return;
+
+	if (ofnode_valid(dev->node))
+		hlist_add_head(&dev->node_index,
+			       uclass_index_bucket(uclass_node_index, uc,
+						   dev->node.of_offset));
+	if (dev->seq != -1)
+		hlist_add_head(&dev->seq_index,
+			       uclass_index_bucket(uclass_seq_index, uc,
+						   dev->seq));
+	if (dev->req_seq != -1)
+		hlist_add_head(&dev->req_seq_index,
+			       uclass_index_bucket(uclass_req_seq_index, uc,
+						   dev->req_seq));
+}
+
+/*
+ * Find the device in @uc with @node. This returns false if the tables cannot
+ * tell: before relocation, or if two devices have the node, since only the
+ * uclass list says which comes first.
+ */
+static bool uclass_index_find_node(struct uclass *uc, ofnode node,
+				   struct udevice **devp)
+{
+	struct hlist_head *head;
+	struct hlist_node *pos;
+	struct udevice *dev;
+
+	if (!uclass_index_active())
+		return false;
+
+	*devp = NULL;
+	head = uclass_index_bucket(uclass_node_index, uc, node.of_offset);
+	hlist_for_each_entry(dev, pos, head, node_index) {
+		if (dev->uclass != uc || !ofnode_equal(dev->node, node))
+			continue;
+		if (*devp)
+			return false;
+		*devp = dev;
+	}
+	uclass_index_hits++;
+
+	return true;
+}
+
+/*
+ * Find the device in @uc with @seq, like uclass_index_find_node(). A driver
+ * may set req_seq at any time without the tables knowing, so a req_seq which
+ * is not found there is looked for in the list too.
+ */
+static bool uclass_index_find_seq(struct uclass *uc, int seq,
+				  bool find_req_seq, struct udevice **devp)
+{
+	struct hlist_head *head;
+	struct hlist_node *pos;
+	struct udevice *dev;
+
+	if (!uclass_index_active())
+		return false;
+
+	*devp = NULL;
+	head = uclass_index_bucket(find_req_seq ? uclass_req_seq_index :
+				   uclass_seq_index, uc, seq);
+	for (pos = head->first; pos; pos = pos->next) {
+		if (find_req_seq)
+			dev = hlist_entry(pos, struct udevice, req_seq_index);
+		else
+			dev = hlist_entry(pos, struct udevice, seq_index);
+		if (dev->uclass != uc ||
+		    (find_req_seq ? dev->req_seq : dev->seq) != seq)
+			continue;
+		if (*devp)
+			return false;
+		*devp = dev;
+	}
+	if (find_req_seq && !*devp)
+		return false;
+	uclass_index_hits++;
+
+	return true;
+}
+
+static void uclass_index_report(void)
+{
+	if (!uclass_index_active() ||
+	    uclass_index_hits == uclass_index_reported)
+		return;
+
+	bootstage_count(BOOTSTAGE_ID_COUNT_DM_INDEX, "dm_index_lookups",
+			uclass_index_hits);
+	uclass_index_reported = uclass_index_hits;
+}
+#else
+static inline bool uclass_index_active(void)
+{
+	return false;
+}
+
+static inline void uclass_unindex_device(struct udevice *dev) {}
+
+static inline bool uclass_index_find_node(struct uclass *uc, ofnode node,
+					  struct udevice **devp)
+{
+	return false;
+}
+
+static inline bool uclass_index_find_seq(struct uclass *uc, int seq,
+					 bool find_req_seq,
+					 struct udevice **devp)
+{
+	return false;
+}
+
+static inline void uclass_index_report(void) {}
+#endif
+
 struct uclass *uclass_find(enum uclass_id key)
 {
 	struct uclass *uc;
@@ -308,6 +469,11 @@ int uclass_find_device_by_seq(enum uclass_id id, int seq_or_req_seq,
 	if (ret)
 		return ret;
 
+	if (uclass_index_find_seq(uc, seq_or_req_seq, find_req_seq, devp)) {
+		debug("   - %s\n", *devp ? "found" : "not found");
+		return *devp ? 0 : -ENODEV;
+	}
+
 	uclass_foreach_dev(dev, uc) {
 		debug("   - %d %d '%s'\n", dev->req_seq, dev->seq, dev->name);
 		if ((find_req_seq ? dev->req_seq : dev->seq) ==
@@ -361,6 +527,12 @@ int uclass_find_device_by_ofnode(enum uclass_id id, ofnode node,
 	if (ret)
 		return ret;
 
+	if (uclass_index_find_node(uc, node, devp)) {
+		if (!*devp)
+			ret = -ENODEV;
+		goto done;
+	}
+
 	uclass_foreach_dev(dev, uc) {
 		log(LOGC_DM, LOGL_DEBUG_CONTENT, "      - checking %s\n",
 		    dev->name);
@@ -390,6 +562,15 @@ int uclass_find_device_by_phandle(enum uclass_id id, struct udevice *parent,
 	find_phandle = dev_read_u32_default(parent, name, -1);
 	if (find_phandle <= 0)
 		return -ENOENT;
+
+	/*
+	 * With the live tree the node is found straight away, so look for
+	 * that rather than reading the phandle of each device
+	 */
+	if (of_live_active() && uclass_index_active())
+		return uclass_find_device_by_ofnode(id,
+				ofnode_get_by_phandle(find_phandle), devp);
+
 	ret = uclass_get(id, &uc);
 	if (ret)
 		return ret;
@@ -631,6 +812,7 @@ int uclass_bind_device(struct udevice *dev)
 
 	uc = dev->uclass;
 	list_add_tail(&dev->uclass_node, &uc->dev_head);
+	uclass_index_device(dev);
 
 	if (dev->parent) {
 		struct uclass_driver *uc_drv = dev->parent->uclass->uc_drv;
@@ -646,6 +828,7 @@ int uclass_bind_device(struct udevice *dev)
 err:
 	/* There is no need to undo the parent's post_bind call */
 	list_del(&dev->uclass_node);
+	uclass_unindex_device(dev);
 
 	return ret;
 }
@@ -664,6 +847,7 @@ int uclass_unbind_device(struct udevice *dev)
 	}
 
 	list_del(&dev->uclass_node);
+	uclass_unindex_device(dev);
 	return 0;
 }
 #endif
@@ -734,6 +918,8 @@ int uclass_post_probe_device(struct udevice *dev)
 		}
 	}
 
+	uclass_index_report();
+
 	uc_drv = dev->uclass->uc_drv;
 	if (uc_drv->post_probe)
 		return uc_drv->post_probe(dev);
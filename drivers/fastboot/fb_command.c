@@ -26,6 +26,21 @@ static u32 fastboot_bytes_received;
  */
 static u32 fastboot_bytes_expected;
 
+/**
+ * fastboot_stream - where downloads go, see "oem stream"
+ */
+static enum {
+	FASTBOOT_STREAM_OFF,		/* into fastboot_buf_addr */
+	FASTBOOT_STREAM_ARMED,		/* the next one to a partition */
+	FASTBOOT_STREAM_ACTIVE,		/* this one to a partition */
+	FASTBOOT_STREAM_DONE,		/* the last one to a partition */
+} fastboot_stream;
+
+/**
+ * fastboot_stream_err - result of the last download streamed to a partition
+ */
+static int fastboot_stream_err;
+
 static void okay(char *, char *);
 static void getvar(char *, char *);
 static void download(char *, char *);
@@ -37,6 +52,9 @@ static void reboot_bootloader(char *, char *);
 #if CONFIG_IS_ENABLED(FASTBOOT_CMD_OEM_FORMAT)
 static void oem_format(char *, char *);
 #endif
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM)
+static void oem_stream(char *, char *);
+#endif
 
 static const struct {
 	const char *command;
@@ -86,6 +104,12 @@ static const struct {
 		.dispatch = oem_format,
 	},
 #endif
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM)
+	[FASTBOOT_COMMAND_OEM_STREAM] = {
+		.command = "oem stream",
+		.dispatch = oem_stream,
+	},
+#endif
 };
 
 /**
@@ -147,6 +171,22 @@ static void getvar(char *cmd_parameter, char *response)
 	fastboot_getvar(cmd_parameter, response);
 }
 
+/**
+ * fastboot_stream_abort() - Give up a download being streamed to a partition
+ *
+ * The next download is streamed to the same partition again.
+ */
+static void fastboot_stream_abort(void)
+{
+	char response[FASTBOOT_RESPONSE_LEN];
+
+	if (CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM) &&
+	    fastboot_stream == FASTBOOT_STREAM_ACTIVE) {
+		fastboot_mmc_stream_close(response);
+		fastboot_stream = FASTBOOT_STREAM_ARMED;
+	}
+}
+
 /**
  * fastboot_download() - Start a download transfer from the client
  *
@@ -173,15 +213,40 @@ static void download(char *cmd_parameter, char *response)
 	 *
 	 * where cmd_parameter is an 8 digit hexadecimal number
 	 */
-	if (fastboot_bytes_expected > fastboot_buf_size) {
+	if (fastboot_stream == FASTBOOT_STREAM_DONE)
+		fastboot_stream = FASTBOOT_STREAM_OFF;
+	/* A download that was cut short is started again from the beginning */
+	fastboot_stream_abort();
+	if (fastboot_bytes_expected > fastboot_max_download_size()) {
 		fastboot_fail(cmd_parameter, response);
 	} else {
-		printf("Starting download of %d bytes\n",
+		if (CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM) &&
+		    fastboot_stream == FASTBOOT_STREAM_ARMED) {
+			if (fastboot_mmc_stream_start(response))
+				return;
+			fastboot_stream = FASTBOOT_STREAM_ACTIVE;
+		}
+		printf("Starting download of %u bytes\n",
 		       fastboot_bytes_expected);
 		fastboot_response("DATA", response, "%s", cmd_parameter);
 	}
 }
 
+/**
+ * fastboot_max_download_size() - return the largest download accepted
+ *
+ * Return: Size of the download buffer, or the largest size the protocol
+ * allows if the next download is streamed to a partition
+ */
+u32 fastboot_max_download_size(void)
+{
+	if (CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM) &&
+	    fastboot_stream == FASTBOOT_STREAM_ARMED)
+		return U32_MAX;
+
+	return fastboot_buf_size;
+}
+
 /**
  * fastboot_data_remaining() - return bytes remaining in current transfer
  *
@@ -220,9 +285,15 @@ void fastboot_data_download(const void *fastboot_data,
 			      response);
 		return;
 	}
-	/* Download data to fastboot_buf_addr */
-	memcpy(fastboot_buf_addr + fastboot_bytes_received,
-	       fastboot_data, fastboot_data_len);
+	if (CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM) &&
+	    fastboot_stream == FASTBOOT_STREAM_ACTIVE) {
+		/* Write data straight to the partition */
+		fastboot_mmc_stream_write(fastboot_data, fastboot_data_len);
+	} else {
+		/* Download data to fastboot_buf_addr */
+		memcpy(fastboot_buf_addr + fastboot_bytes_received,
+		       fastboot_data, fastboot_data_len);
+	}
 
 	pre_dot_num = fastboot_bytes_received / BYTES_PER_DOT;
 	fastboot_bytes_received += fastboot_data_len;
@@ -252,6 +323,12 @@ void fastboot_data_complete(char *response)
 	env_set_hex("filesize", image_size);
 	fastboot_bytes_expected = 0;
 	fastboot_bytes_received = 0;
+
+	if (CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM) &&
+	    fastboot_stream == FASTBOOT_STREAM_ACTIVE) {
+		fastboot_stream_err = fastboot_mmc_stream_close(response);
+		fastboot_stream = FASTBOOT_STREAM_DONE;
+	}
 }
 
 #if CONFIG_IS_ENABLED(FASTBOOT_FLASH)
@@ -266,6 +343,20 @@ void fastboot_data_complete(char *response)
  */
 static void flash(char *cmd_parameter, char *response)
 {
+	if (CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM) &&
+	    fastboot_stream == FASTBOOT_STREAM_DONE) {
+		/* The image has already been written while downloading */
+		fastboot_stream = FASTBOOT_STREAM_OFF;
+		if (fastboot_stream_err)
+			fastboot_fail("streamed image was not written", response);
+		else if (!fastboot_mmc_stream_match(cmd_parameter))
+			fastboot_fail("image was streamed to another partition",
+				      response);
+		else
+			fastboot_okay(NULL, response);
+		return;
+	}
+
 #if CONFIG_IS_ENABLED(FASTBOOT_FLASH_MMC)
 	fastboot_mmc_flash_write(cmd_parameter, fastboot_buf_addr, image_size,
 				 response);
@@ -333,3 +424,30 @@ static void oem_format(char *cmd_parameter, char *response)
 	}
 }
 #endif
+
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM)
+/**
+ * oem_stream() - Write the next download straight to a partition
+ *
+ * @cmd_parameter: Pointer to partition name
+ * @response: Pointer to fastboot response buffer
+ *
+ * The next download is written to the partition indicated by cmd_parameter
+ * while it is received, so it is not limited by the size of the download
+ * buffer. The "flash" command that follows reports the result.
+ */
+static void oem_stream(char *cmd_parameter, char *response)
+{
+	fastboot_stream_abort();
+	fastboot_stream = FASTBOOT_STREAM_OFF;
+	if (!cmd_parameter) {
+		fastboot_fail("Expected partition name", response);
+		return;
+	}
+
+	if (!fastboot_mmc_stream_open(cmd_parameter, response)) {
+		fastboot_stream = FASTBOOT_STREAM_ARMED;
+		fastboot_okay(NULL, response);
+	}
+}
+#endif
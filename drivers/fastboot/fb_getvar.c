@@ -138,7 +138,8 @@ static void getvar_bootloader_version(char *var_parameter, char *response)
 
 static void getvar_downloadsize(char *var_parameter, char *response)
 {
-	fastboot_response("OKAY", response, "0x%08x", fastboot_buf_size);
+	fastboot_response("OKAY", response, "0x%08x",
+			  fastboot_max_download_size());
 }
 
 static void getvar_serialno(char *var_parameter, char *response)
@@ -90,12 +90,65 @@ static lbaint_t fb_mmc_sparse_write(struct sparse_storage *info,
 	return fb_mmc_blk_write(dev_desc, blk, blkcnt, buffer);
 }
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+static int fb_mmc_sparse_submit(struct sparse_storage *info,
+				struct blk_req *req)
+{
+	struct fb_mmc_sparse *sparse = info->priv;
+
+	if (fastboot_progress_callback)
+		fastboot_progress_callback("writing");
+
+	return blk_submit(sparse->dev_desc, req);
+}
+
+static long fb_mmc_sparse_wait(struct sparse_storage *info,
+			       struct blk_req *req)
+{
+	struct fb_mmc_sparse *sparse = info->priv;
+
+	return blk_wait(sparse->dev_desc, req);
+}
+#endif
+
+static lbaint_t fb_mmc_sparse_erase(struct sparse_storage *info,
+		lbaint_t blk, lbaint_t blkcnt)
+{
+	struct fb_mmc_sparse *sparse = info->priv;
+
+	return mmc_bdiscard(sparse->dev_desc, blk, blkcnt);
+}
+
 static lbaint_t fb_mmc_sparse_reserve(struct sparse_storage *info,
 		lbaint_t blk, lbaint_t blkcnt)
 {
 	return blkcnt;
 }
 
+static void fb_mmc_sparse_init(struct sparse_storage *sparse,
+			       struct fb_mmc_sparse *sparse_priv,
+			       struct blk_desc *dev_desc,
+			       disk_partition_t *info)
+{
+	memset(sparse, 0, sizeof(*sparse));
+	sparse_priv->dev_desc = dev_desc;
+
+	sparse->blksz = info->blksz;
+	sparse->start = info->start;
+	sparse->size = info->size;
+	sparse->write = fb_mmc_sparse_write;
+	sparse->reserve = fb_mmc_sparse_reserve;
+	sparse->mssg = fastboot_fail;
+	sparse->erase = fb_mmc_sparse_erase;
+	sparse->erase_blks = mmc_erase_zero_blks(find_mmc_device(
+						 dev_desc->devnum));
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	sparse->submit = fb_mmc_sparse_submit;
+	sparse->wait = fb_mmc_sparse_wait;
+#endif
+	sparse->priv = sparse_priv;
+}
+
 static void write_raw_image(struct blk_desc *dev_desc, disk_partition_t *info,
 		const char *part_name, void *buffer,
 		u32 download_bytes, char *response)
@@ -406,19 +459,11 @@ void fastboot_mmc_flash_write(const char *cmd, void *download_buffer,
 		struct sparse_storage sparse;
 		int err;
 
-		sparse_priv.dev_desc = dev_desc;
-
-		sparse.blksz = info.blksz;
-		sparse.start = info.start;
-		sparse.size = info.size;
-		sparse.write = fb_mmc_sparse_write;
-		sparse.reserve = fb_mmc_sparse_reserve;
-		sparse.mssg = fastboot_fail;
+		fb_mmc_sparse_init(&sparse, &sparse_priv, dev_desc, &info);
 
 		printf("Flashing sparse image at offset " LBAFU "\n",
 		       sparse.start);
 
-		sparse.priv = &sparse_priv;
 		err = write_sparse_image(&sparse, cmd, download_buffer,
 					 response);
 		if (!err)
@@ -429,6 +474,103 @@ void fastboot_mmc_flash_write(const char *cmd, void *download_buffer,
 	}
 }
 
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM)
+/**
+ * struct fb_mmc_stream - partition that downloads are written to as they
+ * arrive
+ *
+ * @sparse_priv: Private data of @sparse
+ * @sparse:	Storage description of the partition
+ * @stream:	Image being written, or NULL outside a download
+ * @part_name:	Partition name as given by the host
+ * @response:	Failure message of the image being written
+ */
+static struct fb_mmc_stream {
+	struct fb_mmc_sparse sparse_priv;
+	struct sparse_storage sparse;
+	struct sparse_stream *stream;
+	char part_name[PART_NAME_LEN];
+	char response[FASTBOOT_RESPONSE_LEN];
+} fb_mmc_stream;
+
+int fastboot_mmc_stream_open(const char *cmd, char *response)
+{
+	struct fb_mmc_stream *fb = &fb_mmc_stream;
+	struct blk_desc *dev_desc;
+	disk_partition_t info;
+
+	dev_desc = blk_get_dev("mmc", CONFIG_FASTBOOT_FLASH_MMC_DEV);
+	if (!dev_desc || dev_desc->type == DEV_TYPE_UNKNOWN) {
+		pr_err("invalid mmc device\n");
+		fastboot_fail("invalid mmc device", response);
+		return -ENODEV;
+	}
+
+	if (part_get_info_by_name_or_alias(dev_desc, cmd, &info) < 0) {
+		pr_err("cannot find partition: '%s'\n", cmd);
+		fastboot_fail("cannot find partition", response);
+		return -ENOENT;
+	}
+
+	fb_mmc_sparse_init(&fb->sparse, &fb->sparse_priv, dev_desc, &info);
+	strlcpy(fb->part_name, cmd, sizeof(fb->part_name));
+	printf("Streaming next download to '%s' at offset " LBAFU "\n",
+	       fb->part_name, fb->sparse.start);
+
+	return 0;
+}
+
+int fastboot_mmc_stream_start(char *response)
+{
+	struct fb_mmc_stream *fb = &fb_mmc_stream;
+
+	fb->stream = sparse_stream_start(&fb->sparse, fb->part_name);
+	if (!fb->stream) {
+		fastboot_fail("malloc failed", response);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+/*
+ * The host is busy sending the image while it is written, so there is no
+ * need to keep it alive with INFO messages; over UDP they would even break
+ * the download.
+ */
+void fastboot_mmc_stream_write(const void *data, u32 len)
+{
+	struct fb_mmc_stream *fb = &fb_mmc_stream;
+	void (*progress)(const char *msg) = fastboot_progress_callback;
+
+	/* A failure is reported once the download is complete */
+	fastboot_progress_callback = NULL;
+	sparse_stream_write(fb->stream, data, len, fb->response);
+	fastboot_progress_callback = progress;
+}
+
+int fastboot_mmc_stream_close(char *response)
+{
+	struct fb_mmc_stream *fb = &fb_mmc_stream;
+	void (*progress)(const char *msg) = fastboot_progress_callback;
+	int ret;
+
+	fastboot_progress_callback = NULL;
+	ret = sparse_stream_finish(fb->stream, fb->response);
+	fastboot_progress_callback = progress;
+	fb->stream = NULL;
+	if (ret)
+		strlcpy(response, fb->response, FASTBOOT_RESPONSE_LEN);
+
+	return ret;
+}
+
+bool fastboot_mmc_stream_match(const char *cmd)
+{
+	return !strcmp(cmd, fb_mmc_stream.part_name);
+}
+#endif
+
 /**
  * fastboot_mmc_flash_erase() - Erase eMMC for fastboot
  *
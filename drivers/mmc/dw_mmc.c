@@ -233,25 +233,19 @@ static int dwmci_set_transfer_mode(struct dwmci_host *host,
 	return mode;
 }
 
-#ifdef CONFIG_DM_MMC
-static int dwmci_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
-		   struct mmc_data *data)
-{
-	struct mmc *mmc = mmc_get_mmc_dev(dev);
-#else
-static int dwmci_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
-		struct mmc_data *data)
+/*
+ * Send a command and collect its response. For a DMA transfer the IDMAC is
+ * left running with @idmac and @bbstate, see dwmci_idmac_stop().
+ */
+static int dwmci_start_cmd(struct dwmci_host *host, struct mmc_cmd *cmd,
+			   struct mmc_data *data, struct dwmci_idmac *idmac,
+			   struct bounce_buffer *bbstate)
 {
-#endif
-	struct dwmci_host *host = mmc->priv;
-	ALLOC_CACHE_ALIGN_BUFFER(struct dwmci_idmac, cur_idmac,
-				 data ? DIV_ROUND_UP(data->blocks, 8) : 0);
 	int ret = 0, flags = 0, i;
 	unsigned int timeout = 500;
 	u32 retry = 100000;
-	u32 mask, ctrl;
+	u32 mask;
 	ulong start = get_timer(0);
-	struct bounce_buffer bbstate;
 
 	while (dwmci_readl(host, DWMCI_STATUS) & DWMCI_BUSY) {
 		if (get_timer(start) > timeout) {
@@ -270,12 +264,12 @@ static int dwmci_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 			dwmci_wait_reset(host, DWMCI_CTRL_FIFO_RESET);
 		} else {
 			if (data->flags == MMC_DATA_READ) {
-				ret = bounce_buffer_start(&bbstate,
+				ret = bounce_buffer_start(bbstate,
 						(void*)data->dest,
 						data->blocksize *
 						data->blocks, GEN_BB_WRITE);
 			} else {
-				ret = bounce_buffer_start(&bbstate,
+				ret = bounce_buffer_start(bbstate,
 						(void*)data->src,
 						data->blocksize *
 						data->blocks, GEN_BB_READ);
@@ -284,8 +278,8 @@ static int dwmci_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 			if (ret)
 				return ret;
 
-			dwmci_prepare_data(host, data, cur_idmac,
-					   bbstate.bounce_buffer);
+			dwmci_prepare_data(host, data, idmac,
+					   bbstate->bounce_buffer);
 		}
 	}
 
@@ -363,34 +357,132 @@ static int dwmci_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 		}
 	}
 
+	return 0;
+}
+
+static int dwmci_idmac_stop(struct dwmci_host *host, struct mmc_data *data,
+			    struct bounce_buffer *bbstate)
+{
+	u32 mask, ctrl;
+	int ret;
+
+	if (data->flags == MMC_DATA_READ)
+		mask = DWMCI_IDINTEN_RI;
+	else
+		mask = DWMCI_IDINTEN_TI;
+	ret = wait_for_bit_le32(host->ioaddr + DWMCI_IDSTS,
+				mask, true, 1000, false);
+	if (ret)
+		debug("%s: DWMCI_IDINTEN mask 0x%x timeout.\n",
+		      __func__, mask);
+	/* clear interrupts */
+	dwmci_writel(host, DWMCI_IDSTS, DWMCI_IDINTEN_MASK);
+
+	ctrl = dwmci_readl(host, DWMCI_CTRL);
+	ctrl &= ~(DWMCI_DMA_EN);
+	dwmci_writel(host, DWMCI_CTRL, ctrl);
+	bounce_buffer_stop(bbstate);
+
+	return ret;
+}
+
+#ifdef CONFIG_DM_MMC
+static int dwmci_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
+		   struct mmc_data *data)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+#else
+static int dwmci_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
+		struct mmc_data *data)
+{
+#endif
+	struct dwmci_host *host = mmc->priv;
+	ALLOC_CACHE_ALIGN_BUFFER(struct dwmci_idmac, cur_idmac,
+				 data ? DIV_ROUND_UP(data->blocks, 8) : 0);
+	struct bounce_buffer bbstate;
+	int ret;
+
+	ret = dwmci_start_cmd(host, cmd, data, cur_idmac, &bbstate);
+	if (ret)
+		return ret;
+
 	if (data) {
 		ret = dwmci_data_transfer(host, data);
 
 		/* only dma mode need it */
-		if (!host->fifo_mode) {
-			if (data->flags == MMC_DATA_READ)
-				mask = DWMCI_IDINTEN_RI;
-			else
-				mask = DWMCI_IDINTEN_TI;
-			ret = wait_for_bit_le32(host->ioaddr + DWMCI_IDSTS,
-						mask, true, 1000, false);
-			if (ret)
-				debug("%s: DWMCI_IDINTEN mask 0x%x timeout.\n",
-				      __func__, mask);
-			/* clear interrupts */
-			dwmci_writel(host, DWMCI_IDSTS, DWMCI_IDINTEN_MASK);
-
-			ctrl = dwmci_readl(host, DWMCI_CTRL);
-			ctrl &= ~(DWMCI_DMA_EN);
-			dwmci_writel(host, DWMCI_CTRL, ctrl);
-			bounce_buffer_stop(&bbstate);
-		}
+		if (!host->fifo_mode)
+			ret = dwmci_idmac_stop(host, data, &bbstate);
+	}
+
+	udelay(100);
+
+	return ret;
+}
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+static int dwmci_send_cmd_start(struct udevice *dev, struct mmc_cmd *cmd,
+				struct mmc_data *data)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct dwmci_host *host = mmc->priv;
+	struct dwmci_idmac *idmac;
+	int ret;
+
+	if (!data || host->fifo_mode)
+		return -ENOSYS;
+
+	/* The descriptors outlive this call, so keep them off the stack */
+	idmac = memalign(ARCH_DMA_MINALIGN, DIV_ROUND_UP(data->blocks, 8) *
+			 sizeof(struct dwmci_idmac));
+	if (!idmac)
+		return -ENOMEM;
+
+	ret = dwmci_start_cmd(host, cmd, data, idmac, &host->async_bbstate);
+	if (ret) {
+		free(idmac);
+		return ret;
+	}
+
+	host->async_idmac = idmac;
+	host->async_start = get_timer(0);
+	host->async_timeout = dwmci_get_timeout(mmc, data->blocksize *
+						data->blocks);
+
+	return 0;
+}
+
+static int dwmci_send_cmd_poll(struct udevice *dev, struct mmc_cmd *cmd,
+			       struct mmc_data *data)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct dwmci_host *host = mmc->priv;
+	u32 mask;
+	int ret;
+
+	mask = dwmci_readl(host, DWMCI_RINTSTS);
+	if (mask & (DWMCI_DATA_ERR | DWMCI_DATA_TOUT)) {
+		debug("%s: DATA ERROR!\n", __func__);
+		ret = -EINVAL;
+	} else if (mask & DWMCI_INTMSK_DTO) {
+		ret = 0;
+	} else if (get_timer(host->async_start) > host->async_timeout) {
+		debug("%s: Timeout waiting for data!\n", __func__);
+		ret = -ETIMEDOUT;
+	} else {
+		return -EBUSY;
 	}
+	dwmci_writel(host, DWMCI_RINTSTS, mask);
+
+	if (dwmci_idmac_stop(host, data, &host->async_bbstate) && !ret)
+		ret = -ETIMEDOUT;
+	free(host->async_idmac);
+	host->async_idmac = NULL;
 
 	udelay(100);
 
 	return ret;
 }
+#endif
 
 static int dwmci_setup_bus(struct dwmci_host *host, u32 freq)
 {
@@ -551,6 +643,10 @@ int dwmci_probe(struct udevice *dev)
 const struct dm_mmc_ops dm_dwmci_ops = {
 	.send_cmd	= dwmci_send_cmd,
 	.set_ios	= dwmci_set_ios,
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	.send_cmd_start	= dwmci_send_cmd_start,
+	.send_cmd_poll	= dwmci_send_cmd_poll,
+#endif
 };
 
 #else
@@ -18,6 +18,10 @@ int dm_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	struct dm_mmc_ops *ops = mmc_get_ops(dev);
 	int ret;
 
+	/* A background transfer must finish before the next command */
+	if (mmc_async_in_flight(mmc))
+		mmc_async_complete(mmc);
+
 	mmmc_trace_before_send(mmc, cmd);
 	if (ops->send_cmd)
 		ret = ops->send_cmd(dev, cmd, data);
@@ -33,6 +37,28 @@ int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
 	return dm_mmc_send_cmd(mmc->dev, cmd, data);
 }
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+int dm_mmc_send_cmd_start(struct udevice *dev, struct mmc_cmd *cmd,
+			  struct mmc_data *data)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(dev);
+
+	if (!ops->send_cmd_start || !ops->send_cmd_poll)
+		return -ENOSYS;
+	return ops->send_cmd_start(dev, cmd, data);
+}
+
+int dm_mmc_send_cmd_poll(struct udevice *dev, struct mmc_cmd *cmd,
+			 struct mmc_data *data)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(dev);
+
+	if (!ops->send_cmd_poll)
+		return -ENOSYS;
+	return ops->send_cmd_poll(dev, cmd, data);
+}
+#endif
+
 int dm_mmc_set_ios(struct udevice *dev)
 {
 	struct dm_mmc_ops *ops = mmc_get_ops(dev);
@@ -388,6 +414,10 @@ static const struct blk_ops mmc_blk_ops = {
 	.erase	= mmc_berase,
 #endif
 	.select_hwpart	= mmc_select_hwpart,
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	.submit		= mmc_blk_submit,
+	.poll		= mmc_blk_poll,
+#endif
 };
 
 U_BOOT_DRIVER(mmc_blk) = {
@@ -1267,6 +1267,10 @@ retry_scr:
 	if (mmc->scr[0] & SD_DATA_4BIT)
 		mmc->card_caps |= MMC_MODE_4BIT;
 
+#if CONFIG_IS_ENABLED(MMC_WRITE)
+	mmc->erase_zeroes = !(mmc->scr[0] & SD_DATA_STAT_AFTER_ERASE);
+#endif
+
 	/* Version 1.0 doesn't support switching */
 	if (mmc->version == SD_VERSION_1_0)
 		return 0;
@@ -2237,6 +2241,12 @@ static int mmc_startup_v4(struct mmc *mmc)
 
 	mmc->wr_rel_set = ext_csd[EXT_CSD_WR_REL_SET];
 
+#if CONFIG_IS_ENABLED(MMC_WRITE)
+	mmc->trim_supported = !!(ext_csd[EXT_CSD_SEC_FEATURE_SUPPORT] &
+				 EXT_CSD_SEC_GB_CL_EN);
+	mmc->erase_zeroes = !ext_csd[EXT_CSD_ERASED_MEM_CONT];
+#endif
+
 	return 0;
 error:
 	if (mmc->ext_csd) {
@@ -2420,6 +2430,8 @@ static int mmc_startup(struct mmc *mmc)
 	 */
 #if CONFIG_IS_ENABLED(MMC_WRITE)
 	mmc->erase_grp_size = 1;
+	mmc->trim_supported = false;
+	mmc->erase_zeroes = false;
 #endif
 	mmc->part_config = MMCPART_NOAVAILABLE;
 
@@ -0,0 +1,173 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Asynchronous block requests for MMC devices
+ *
+ * A request is split into chunks of at most b_max blocks, like mmc_bread()
+ * and mmc_bwrite() do. Each chunk is started with the host's
+ * send_cmd_start() method and left to the controller; the stop command and
+ * (for writes) the wait for the card to leave the programming state are
+ * handled synchronously once the data has moved.
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <dm.h>
+#include <mmc.h>
+#include "mmc_private.h"
+
+static int mmc_async_start_chunk(struct mmc *mmc)
+{
+	struct mmc_async *async = &mmc->async;
+	struct blk_req *req = async->req;
+	struct mmc_cmd *cmd = &async->cmd;
+	struct mmc_data *data = &async->data;
+	lbaint_t start = req->start + async->done;
+	lbaint_t cur;
+	uint blksz;
+	int ret;
+
+	cur = min(req->blkcnt - async->done, (lbaint_t)mmc->cfg->b_max);
+	if (req->write) {
+		blksz = mmc->write_bl_len;
+		cmd->cmdidx = cur > 1 ? MMC_CMD_WRITE_MULTIPLE_BLOCK :
+			      MMC_CMD_WRITE_SINGLE_BLOCK;
+		data->src = req->buffer + async->done * blksz;
+		data->flags = MMC_DATA_WRITE;
+	} else {
+		blksz = mmc->read_bl_len;
+		cmd->cmdidx = cur > 1 ? MMC_CMD_READ_MULTIPLE_BLOCK :
+			      MMC_CMD_READ_SINGLE_BLOCK;
+		data->dest = req->buffer + async->done * blksz;
+		data->flags = MMC_DATA_READ;
+	}
+	cmd->cmdarg = mmc->high_capacity ? start : start * blksz;
+	cmd->resp_type = MMC_RSP_R1;
+	data->blocks = cur;
+	data->blocksize = blksz;
+
+	mmmc_trace_before_send(mmc, cmd);
+	ret = dm_mmc_send_cmd_start(mmc->dev, cmd, data);
+	if (ret) {
+		mmmc_trace_after_send(mmc, cmd, ret);
+		return ret;
+	}
+	async->in_flight = true;
+
+	return 0;
+}
+
+static void mmc_async_finish(struct mmc *mmc, long result)
+{
+	mmc->async.req->result = result;
+	mmc->async.req = NULL;
+}
+
+/*
+ * Check the chunk in flight and, once it is done, start the next one.
+ * Returns -EBUSY while the request is still in progress.
+ */
+static int mmc_async_poll(struct mmc *mmc)
+{
+	struct mmc_async *async = &mmc->async;
+	struct mmc_cmd *cmd = &async->cmd;
+	struct mmc_cmd stop;
+	lbaint_t cur = async->data.blocks;
+	int ret;
+
+	ret = dm_mmc_send_cmd_poll(mmc->dev, cmd, &async->data);
+	if (ret == -EBUSY)
+		return -EBUSY;
+	async->in_flight = false;
+	mmmc_trace_after_send(mmc, cmd, ret);
+	if (ret)
+		goto err;
+
+	if (cur > 1) {
+		stop.cmdidx = MMC_CMD_STOP_TRANSMISSION;
+		stop.cmdarg = 0;
+		stop.resp_type = MMC_RSP_R1b;
+		ret = mmc_send_cmd(mmc, &stop, NULL);
+		if (ret) {
+			pr_err("mmc fail to send stop cmd\n");
+			goto err;
+		}
+	}
+
+	if (async->req->write) {
+		ret = mmc_send_status(mmc, 1000);
+		if (ret)
+			goto err;
+	}
+
+	async->done += cur;
+	if (async->done == async->req->blkcnt) {
+		mmc_async_finish(mmc, async->done);
+		return 0;
+	}
+
+	/* Alignment is unchanged so the host cannot refuse a later chunk */
+	ret = mmc_async_start_chunk(mmc);
+	if (ret)
+		goto err;
+
+	return -EBUSY;
+
+err:
+	debug("%s: transfer failed at block " LBAF " (err=%d)\n", __func__,
+	      async->req->start + async->done, ret);
+	mmc_async_finish(mmc, ret == -ENOSYS ? -EIO : ret);
+
+	return 0;
+}
+
+void mmc_async_complete(struct mmc *mmc)
+{
+	while (mmc->async.req)
+		mmc_async_poll(mmc);
+}
+
+int mmc_blk_submit(struct udevice *dev, struct blk_req *req)
+{
+	struct blk_desc *desc = dev_get_uclass_platdata(dev);
+	struct mmc *mmc = mmc_get_mmc_dev(dev_get_parent(dev));
+	int ret;
+
+	if (!req->blkcnt || mmc_host_is_spi(mmc))
+		return -ENOSYS;
+	if (req->write && !CONFIG_IS_ENABLED(MMC_WRITE))
+		return -ENOSYS;
+
+	ret = blk_dselect_hwpart(desc, desc->hwpart);
+	if (ret < 0)
+		return ret;
+
+	if (req->start + req->blkcnt > desc->lba) {
+		pr_err("MMC: block number 0x" LBAF " exceeds max(0x" LBAF ")\n",
+		       req->start + req->blkcnt, desc->lba);
+		return -EINVAL;
+	}
+
+	ret = mmc_set_blocklen(mmc, req->write ? mmc->write_bl_len :
+				    mmc->read_bl_len);
+	if (ret)
+		return ret;
+
+	mmc->async.req = req;
+	mmc->async.done = 0;
+	ret = mmc_async_start_chunk(mmc);
+	if (ret)
+		mmc->async.req = NULL;
+
+	return ret;
+}
+
+int mmc_blk_poll(struct udevice *dev, struct blk_req *req)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev_get_parent(dev));
+
+	/* Another command may already have forced the request to finish */
+	if (mmc->async.req != req)
+		return 0;
+
+	return mmc_async_poll(mmc);
+}
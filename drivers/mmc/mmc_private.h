@@ -27,6 +27,33 @@ ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 		void *dst);
 #endif
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC) && CONFIG_IS_ENABLED(DM_MMC)
+int mmc_blk_submit(struct udevice *dev, struct blk_req *req);
+int mmc_blk_poll(struct udevice *dev, struct blk_req *req);
+
+/**
+ * mmc_async_complete() - finish the asynchronous request in progress
+ *
+ * This waits for the remainder of the request started by mmc_blk_submit(),
+ * so that the controller can be used for another command.
+ *
+ * @mmc:	MMC device to wait for
+ */
+void mmc_async_complete(struct mmc *mmc);
+
+static inline bool mmc_async_in_flight(struct mmc *mmc)
+{
+	return mmc->async.in_flight;
+}
+#else
+static inline void mmc_async_complete(struct mmc *mmc) {}
+
+static inline bool mmc_async_in_flight(struct mmc *mmc)
+{
+	return false;
+}
+#endif
+
 #if CONFIG_IS_ENABLED(MMC_WRITE)
 
 #if CONFIG_IS_ENABLED(BLK)
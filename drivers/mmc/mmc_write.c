@@ -14,7 +14,13 @@
 #include <linux/math64.h>
 #include "mmc_private.h"
 
-static ulong mmc_erase_t(struct mmc *mmc, ulong start, lbaint_t blkcnt)
+static bool mmc_can_trim(struct mmc *mmc)
+{
+	return !IS_SD(mmc) && mmc->trim_supported;
+}
+
+static ulong mmc_erase_t(struct mmc *mmc, ulong start, lbaint_t blkcnt,
+			 uint arg)
 {
 	struct mmc_cmd cmd;
 	ulong end;
@@ -51,7 +57,7 @@ static ulong mmc_erase_t(struct mmc *mmc, ulong start, lbaint_t blkcnt)
 		goto err_out;
 
 	cmd.cmdidx = MMC_CMD_ERASE;
-	cmd.cmdarg = MMC_ERASE_ARG;
+	cmd.cmdarg = arg;
 	cmd.resp_type = MMC_RSP_R1b;
 
 	err = mmc_send_cmd(mmc, &cmd, NULL);
@@ -65,15 +71,9 @@ err_out:
 	return err;
 }
 
-#if CONFIG_IS_ENABLED(BLK)
-ulong mmc_berase(struct udevice *dev, lbaint_t start, lbaint_t blkcnt)
-#else
-ulong mmc_berase(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt)
-#endif
+static ulong mmc_erase_blks(struct blk_desc *block_dev, lbaint_t start,
+			    lbaint_t blkcnt, uint arg)
 {
-#if CONFIG_IS_ENABLED(BLK)
-	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
-#endif
 	int dev_num = block_dev->devnum;
 	int err = 0;
 	u32 start_rem, blkcnt_rem;
@@ -96,7 +96,7 @@ ulong mmc_berase(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt)
 	 */
 	err = div_u64_rem(start, mmc->erase_grp_size, &start_rem);
 	err = div_u64_rem(blkcnt, mmc->erase_grp_size, &blkcnt_rem);
-	if (start_rem || blkcnt_rem)
+	if ((start_rem || blkcnt_rem) && arg == MMC_ERASE_ARG)
 		printf("\n\nCaution! Your devices Erase group is 0x%x\n"
 		       "The erase range would be change to "
 		       "0x" LBAF "~0x" LBAF "\n\n",
@@ -112,7 +112,7 @@ ulong mmc_berase(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt)
 			blk_r = ((blkcnt - blk) > mmc->erase_grp_size) ?
 				mmc->erase_grp_size : (blkcnt - blk);
 		}
-		err = mmc_erase_t(mmc, start + blk, blk_r);
+		err = mmc_erase_t(mmc, start + blk, blk_r, arg);
 		if (err)
 			break;
 
@@ -126,6 +126,48 @@ ulong mmc_berase(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt)
 	return blk;
 }
 
+#if CONFIG_IS_ENABLED(BLK)
+ulong mmc_berase(struct udevice *dev, lbaint_t start, lbaint_t blkcnt)
+#else
+ulong mmc_berase(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt)
+#endif
+{
+#if CONFIG_IS_ENABLED(BLK)
+	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
+#endif
+
+	return mmc_erase_blks(block_dev, start, blkcnt, MMC_ERASE_ARG);
+}
+
+ulong mmc_bdiscard(struct blk_desc *block_dev, lbaint_t start,
+		   lbaint_t blkcnt)
+{
+	struct mmc *mmc = find_mmc_device(block_dev->devnum);
+
+	if (!mmc)
+		return -1;
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	blk_sync(block_dev);
+#endif
+	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
+
+	/* TRIM works on write blocks, so needs no erase group alignment */
+	return mmc_erase_blks(block_dev, start, blkcnt,
+			      mmc_can_trim(mmc) ? MMC_TRIM_ARG : MMC_ERASE_ARG);
+}
+
+lbaint_t mmc_erase_zero_blks(struct mmc *mmc)
+{
+	if (!mmc->erase_zeroes)
+		return 0;
+
+	if (IS_SD(mmc) || mmc_can_trim(mmc))
+		return 1;
+
+	return mmc->erase_grp_size;
+}
+
 static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 		lbaint_t blkcnt, const void *src)
 {
@@ -14,6 +14,9 @@
 struct sandbox_mmc_plat {
 	struct mmc_config cfg;
 	struct mmc mmc;
+	bool busy;
+	int erase_count;
+	uint erase_arg;
 };
 
 /**
@@ -25,6 +28,8 @@ struct sandbox_mmc_plat {
 static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 				struct mmc_data *data)
 {
+	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+
 	switch (cmd->cmdidx) {
 	case MMC_CMD_ALL_SEND_CID:
 		break;
@@ -71,6 +76,10 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	case MMC_CMD_SET_BLOCKLEN:
 		debug("block len %d\n", cmd->cmdarg);
 		break;
+	case MMC_CMD_ERASE:
+		plat->erase_count++;
+		plat->erase_arg = cmd->cmdarg;
+		break;
 	case SD_CMD_APP_SEND_SCR: {
 		u32 *scr = (u32 *)data->dest;
 
@@ -85,6 +94,46 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+/*
+ * Emulate a background transfer: the data is moved at once but the first
+ * poll reports that it is still in progress.
+ */
+static int sandbox_mmc_send_cmd_start(struct udevice *dev,
+				      struct mmc_cmd *cmd,
+				      struct mmc_data *data)
+{
+	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+
+	plat->busy = true;
+
+	return sandbox_mmc_send_cmd(dev, cmd, data);
+}
+
+static int sandbox_mmc_send_cmd_poll(struct udevice *dev,
+				     struct mmc_cmd *cmd,
+				     struct mmc_data *data)
+{
+	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+
+	if (plat->busy) {
+		plat->busy = false;
+		return -EBUSY;
+	}
+
+	return 0;
+}
+#endif
+
+int sandbox_mmc_get_erase(struct udevice *dev, uint *argp)
+{
+	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+
+	*argp = plat->erase_arg;
+
+	return plat->erase_count;
+}
+
 static int sandbox_mmc_set_ios(struct udevice *dev)
 {
 	return 0;
@@ -99,6 +148,10 @@ static const struct dm_mmc_ops sandbox_mmc_ops = {
 	.send_cmd = sandbox_mmc_send_cmd,
 	.set_ios = sandbox_mmc_set_ios,
 	.get_cd = sandbox_mmc_get_cd,
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	.send_cmd_start = sandbox_mmc_send_cmd_start,
+	.send_cmd_poll = sandbox_mmc_send_cmd_poll,
+#endif
 };
 
 int sandbox_mmc_probe(struct udevice *dev)
@@ -246,18 +246,41 @@ static int sdhci_transfer_data(struct sdhci_host *host, struct mmc_data *data)
 #define SDHCI_CMD_MAX_TIMEOUT			3200
 #define SDHCI_CMD_DEFAULT_TIMEOUT		100
 #define SDHCI_READ_STATUS_TIMEOUT		1000
+#define SDHCI_DATA_TIMEOUT			10000
 
-#ifdef CONFIG_DM_MMC
-static int sdhci_send_command(struct udevice *dev, struct mmc_cmd *cmd,
-			      struct mmc_data *data)
+static int sdhci_finish_command(struct sdhci_host *host, struct mmc_data *data,
+				int ret, int is_aligned, int trans_bytes)
 {
-	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	unsigned int stat;
 
-#else
-static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
-			      struct mmc_data *data)
+	if (host->quirks & SDHCI_QUIRK_WAIT_SEND_CMD)
+		udelay(1000);
+
+	stat = sdhci_readl(host, SDHCI_INT_STATUS);
+	sdhci_writel(host, SDHCI_INT_ALL_MASK, SDHCI_INT_STATUS);
+	if (!ret) {
+		if ((host->quirks & SDHCI_QUIRK_32BIT_DMA_ADDR) &&
+				!is_aligned && (data->flags == MMC_DATA_READ))
+			memcpy(data->dest, aligned_buffer, trans_bytes);
+		return 0;
+	}
+
+	sdhci_reset(host, SDHCI_RESET_CMD);
+	sdhci_reset(host, SDHCI_RESET_DATA);
+	if (stat & SDHCI_INT_TIMEOUT)
+		return -ETIMEDOUT;
+	else
+		return -ECOMM;
+}
+
+/*
+ * Send a command and, unless @async is set, wait for its data. With @async
+ * the DMA transfer is left running once the command has completed, to be
+ * finished by sdhci_send_cmd_poll().
+ */
+static int sdhci_do_command(struct mmc *mmc, struct mmc_cmd *cmd,
+			    struct mmc_data *data, bool async)
 {
-#endif
 	struct sdhci_host *host = mmc->priv;
 	unsigned int stat = 0;
 	int ret = 0;
@@ -372,29 +395,92 @@ static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 	} else
 		ret = -1;
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	if (!ret && async) {
+		host->async_start = get_timer(0);
+		return 0;
+	}
+#endif
+
 	if (!ret && data)
 		ret = sdhci_transfer_data(host, data);
 
-	if (host->quirks & SDHCI_QUIRK_WAIT_SEND_CMD)
-		udelay(1000);
+	return sdhci_finish_command(host, data, ret, is_aligned, trans_bytes);
+}
 
-	stat = sdhci_readl(host, SDHCI_INT_STATUS);
-	sdhci_writel(host, SDHCI_INT_ALL_MASK, SDHCI_INT_STATUS);
-	if (!ret) {
+#ifdef CONFIG_DM_MMC
+static int sdhci_send_command(struct udevice *dev, struct mmc_cmd *cmd,
+			      struct mmc_data *data)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+
+	return sdhci_do_command(mmc, cmd, data, false);
+}
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+static int sdhci_send_cmd_start(struct udevice *dev, struct mmc_cmd *cmd,
+				struct mmc_data *data)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct sdhci_host *host = mmc->priv;
+
+	if (!data || !(host->flags & USE_DMA))
+		return -ENOSYS;
+
+	/* Transfers through aligned_buffer need a copy once they are done */
+	if (host->flags & USE_SDMA) {
+#if defined(CONFIG_FIXED_SDHCI_ALIGNED_BUFFER)
+		return -ENOSYS;
+#endif
 		if ((host->quirks & SDHCI_QUIRK_32BIT_DMA_ADDR) &&
-				!is_aligned && (data->flags == MMC_DATA_READ))
-			memcpy(data->dest, aligned_buffer, trans_bytes);
-		return 0;
+		    ((ulong)data->src & 0x7))
+			return -ENOSYS;
 	}
 
-	sdhci_reset(host, SDHCI_RESET_CMD);
-	sdhci_reset(host, SDHCI_RESET_DATA);
-	if (stat & SDHCI_INT_TIMEOUT)
-		return -ETIMEDOUT;
-	else
-		return -ECOMM;
+	return sdhci_do_command(mmc, cmd, data, true);
 }
 
+static int sdhci_send_cmd_poll(struct udevice *dev, struct mmc_cmd *cmd,
+			       struct mmc_data *data)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct sdhci_host *host = mmc->priv;
+	unsigned int stat;
+	int ret = 0;
+
+	stat = sdhci_readl(host, SDHCI_INT_STATUS);
+	if (stat & SDHCI_INT_ERROR) {
+		pr_debug("%s: Error detected in status(0x%X)!\n",
+			 __func__, stat);
+		ret = -EIO;
+	} else if (stat & SDHCI_INT_DMA_END) {
+		sdhci_writel(host, SDHCI_INT_DMA_END, SDHCI_INT_STATUS);
+		if (host->flags & USE_SDMA) {
+			host->start_addr &= ~(SDHCI_DEFAULT_BOUNDARY_SIZE - 1);
+			host->start_addr += SDHCI_DEFAULT_BOUNDARY_SIZE;
+			sdhci_writel(host, host->start_addr,
+				     SDHCI_DMA_ADDRESS);
+		}
+	}
+
+	if (!ret && !(stat & SDHCI_INT_DATA_END)) {
+		if (get_timer(host->async_start) < SDHCI_DATA_TIMEOUT)
+			return -EBUSY;
+		printf("%s: Transfer data timeout\n", __func__);
+		ret = -ETIMEDOUT;
+	}
+
+	return sdhci_finish_command(host, data, ret, 1, 0);
+}
+#endif
+#else
+static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
+			      struct mmc_data *data)
+{
+	return sdhci_do_command(mmc, cmd, data, false);
+}
+#endif
+
 #if defined(CONFIG_DM_MMC) && defined(MMC_SUPPORTS_TUNING)
 static int sdhci_execute_tuning(struct udevice *dev, uint opcode)
 {
@@ -646,6 +732,10 @@ const struct dm_mmc_ops sdhci_ops = {
 #ifdef MMC_SUPPORTS_TUNING
 	.execute_tuning	= sdhci_execute_tuning,
 #endif
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	.send_cmd_start	= sdhci_send_cmd_start,
+	.send_cmd_poll	= sdhci_send_cmd_poll,
+#endif
 };
 #else
 static const struct mmc_ops sdhci_ops = {
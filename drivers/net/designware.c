@@ -421,36 +421,76 @@ static int _dw_eth_send(struct dw_eth_dev *priv, void *packet, int length)
 	return 0;
 }
 
+/* Check a receive descriptor whose cache lines are already invalidated */
+static int _dw_eth_recv_desc(struct dw_eth_dev *priv, u32 desc_num,
+			     uchar **packetp)
+{
+	struct dmamacdescr *desc_p = &priv->rx_mac_descrtable[desc_num];
+	u32 status = desc_p->txrx_status;
+	ulong data_start = desc_p->dmamac_addr;
+	ulong data_end;
+	int length;
+
+	/* Check  if the owner is the CPU */
+	if (status & DESC_RXSTS_OWNBYDMA)
+		return -EAGAIN;
+
+	length = (status & DESC_RXSTS_FRMLENMSK) >> DESC_RXSTS_FRMLENSHFT;
+
+	/* Invalidate received data */
+	data_end = data_start + roundup(length, ARCH_DMA_MINALIGN);
+	invalidate_dcache_range(data_start, data_end);
+	*packetp = (uchar *)(ulong)desc_p->dmamac_addr;
+
+	return length;
+}
+
 static int _dw_eth_recv(struct dw_eth_dev *priv, uchar **packetp)
 {
-	u32 status, desc_num = priv->rx_currdescnum;
+	u32 desc_num = priv->rx_currdescnum;
 	struct dmamacdescr *desc_p = &priv->rx_mac_descrtable[desc_num];
-	int length = -EAGAIN;
 	ulong desc_start = (ulong)desc_p;
 	ulong desc_end = desc_start +
 		roundup(sizeof(*desc_p), ARCH_DMA_MINALIGN);
-	ulong data_start = desc_p->dmamac_addr;
-	ulong data_end;
 
 	/* Invalidate entire buffer descriptor */
 	invalidate_dcache_range(desc_start, desc_end);
 
-	status = desc_p->txrx_status;
+	return _dw_eth_recv_desc(priv, desc_num, packetp);
+}
+
+#ifdef CONFIG_DM_ETH
+/*
+ * Take every frame the DMA has finished with, from the current descriptor
+ * on. Each descriptor is given back by _dw_free_pkt() as soon as its frame
+ * has been processed, in the same order.
+ */
+static int _dw_eth_recv_batch(struct dw_eth_dev *priv, uchar **packets,
+			      int *lengths, int budget)
+{
+	ulong desc_start = (ulong)priv->rx_mac_descrtable;
+	ulong desc_end = desc_start + sizeof(priv->rx_mac_descrtable);
+	u32 desc_num = priv->rx_currdescnum;
+	int count;
+	int length;
 
-	/* Check  if the owner is the CPU */
-	if (!(status & DESC_RXSTS_OWNBYDMA)) {
+	/* Invalidate the whole ring at once rather than each descriptor */
+	invalidate_dcache_range(desc_start, desc_end);
 
-		length = (status & DESC_RXSTS_FRMLENMSK) >>
-			 DESC_RXSTS_FRMLENSHFT;
+	budget = min(budget, CONFIG_RX_DESCR_NUM);
+	for (count = 0; count < budget; count++) {
+		length = _dw_eth_recv_desc(priv, desc_num, &packets[count]);
+		if (length < 0)
+			break;
+		lengths[count] = length;
 
-		/* Invalidate received data */
-		data_end = data_start + roundup(length, ARCH_DMA_MINALIGN);
-		invalidate_dcache_range(data_start, data_end);
-		*packetp = (uchar *)(ulong)desc_p->dmamac_addr;
+		if (++desc_num >= CONFIG_RX_DESCR_NUM)
+			desc_num = 0;
 	}
 
-	return length;
+	return count;
 }
+#endif
 
 static int _dw_free_pkt(struct dw_eth_dev *priv)
 {
@@ -633,6 +673,14 @@ int designware_eth_recv(struct udevice *dev, int flags, uchar **packetp)
 	return _dw_eth_recv(priv, packetp);
 }
 
+int designware_eth_recv_batch(struct udevice *dev, int flags, uchar **packets,
+			      int *lengths, int budget)
+{
+	struct dw_eth_dev *priv = dev_get_priv(dev);
+
+	return _dw_eth_recv_batch(priv, packets, lengths, budget);
+}
+
 int designware_eth_free_pkt(struct udevice *dev, uchar *packet, int length)
 {
 	struct dw_eth_dev *priv = dev_get_priv(dev);
@@ -790,6 +838,7 @@ const struct eth_ops designware_eth_ops = {
 	.start			= designware_eth_start,
 	.send			= designware_eth_send,
 	.recv			= designware_eth_recv,
+	.recv_batch		= designware_eth_recv_batch,
 	.free_pkt		= designware_eth_free_pkt,
 	.stop			= designware_eth_stop,
 	.write_hwaddr		= designware_eth_write_hwaddr,
@@ -261,6 +261,8 @@ int designware_eth_init(struct dw_eth_dev *priv, u8 *enetaddr);
 int designware_eth_enable(struct dw_eth_dev *priv);
 int designware_eth_send(struct udevice *dev, void *packet, int length);
 int designware_eth_recv(struct udevice *dev, int flags, uchar **packetp);
+int designware_eth_recv_batch(struct udevice *dev, int flags, uchar **packets,
+			      int *lengths, int budget);
 int designware_eth_free_pkt(struct udevice *dev, uchar *packet,
 				   int length);
 void designware_eth_stop(struct udevice *dev);
@@ -564,6 +564,7 @@ const struct eth_ops gmac_rockchip_eth_ops = {
 	.start			= gmac_rockchip_eth_start,
 	.send			= designware_eth_send,
 	.recv			= designware_eth_recv,
+	.recv_batch		= designware_eth_recv_batch,
 	.free_pkt		= designware_eth_free_pkt,
 	.stop			= designware_eth_stop,
 	.write_hwaddr		= designware_eth_write_hwaddr,
@@ -365,6 +365,31 @@ static int sb_eth_recv(struct udevice *dev, int flags, uchar **packetp)
 	return 0;
 }
 
+/* Hand over as many packets as the emulated receive ring would hold */
+static int sb_eth_recv_batch(struct udevice *dev, int flags, uchar **packets,
+			     int *lengths, int budget)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	int count;
+	int i;
+
+	if (skip_timeout) {
+		timer_test_add_offset(11000UL);
+		skip_timeout = false;
+	}
+
+	count = min(priv->recv_packets, min(budget, SANDBOX_ETH_RX_RING));
+	for (i = 0; i < count; i++) {
+		debug("eth_sandbox: received packet[%d] in batch\n",
+		      priv->recv_packet_length[i]);
+		/* sb_eth_free_pkt() moves each next packet to the first buffer */
+		packets[i] = priv->recv_packet_buffer[0];
+		lengths[i] = priv->recv_packet_length[i];
+	}
+
+	return count;
+}
+
 static int sb_eth_free_pkt(struct udevice *dev, uchar *packet, int length)
 {
 	struct eth_sandbox_priv *priv = dev_get_priv(dev);
@@ -403,6 +428,7 @@ static const struct eth_ops sb_eth_ops = {
 	.start			= sb_eth_start,
 	.send			= sb_eth_send,
 	.recv			= sb_eth_recv,
+	.recv_batch		= sb_eth_recv_batch,
 	.free_pkt		= sb_eth_free_pkt,
 	.stop			= sb_eth_stop,
 	.write_hwaddr		= sb_eth_write_hwaddr,
@@ -36,8 +36,12 @@
 #define USBH_SIM_REG		0x20
 #define USBH_SIM_LADDR		BIT(5)
 
+/* Time for the PHY to come out of reset, waited for in the background */
+#define USBH_RESET_DELAY_MS	100
+
 struct bcm6318_usbh_priv {
 	void __iomem *regs;
+	ulong reset_start;
 };
 
 static int bcm6318_usbh_init(struct phy *phy)
@@ -124,7 +128,17 @@ static int bcm6318_usbh_probe(struct udevice *dev)
 	if (ret < 0)
 		return ret;
 
-	mdelay(100);
+	priv->reset_start = get_timer(0);
+
+	return -EINPROGRESS;
+}
+
+static int bcm6318_usbh_probe_poll(struct udevice *dev)
+{
+	struct bcm6318_usbh_priv *priv = dev_get_priv(dev);
+
+	if (get_timer(priv->reset_start) < USBH_RESET_DELAY_MS)
+		return -EINPROGRESS;
 
 	return 0;
 }
@@ -136,4 +150,6 @@ U_BOOT_DRIVER(bcm6318_usbh) = {
 	.ops = &bcm6318_usbh_ops,
 	.priv_auto_alloc_size = sizeof(struct bcm6318_usbh_priv),
 	.probe = bcm6318_usbh_probe,
+	.probe_poll = bcm6318_usbh_probe_poll,
+	.flags = DM_FLAG_PROBE_ASYNC,
 };
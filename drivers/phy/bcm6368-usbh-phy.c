@@ -33,6 +33,9 @@
 #define USBH_SETUP_IOC		BIT(4)
 #define USBH_SETUP_IPP		BIT(5)
 
+/* Time for the PHY to come out of reset, waited for in the background */
+#define USBH_RESET_DELAY_MS	100
+
 struct bcm6368_usbh_hw {
 	uint32_t setup_clr;
 	uint32_t pll_clr;
@@ -41,6 +44,7 @@ struct bcm6368_usbh_hw {
 struct bcm6368_usbh_priv {
 	const struct bcm6368_usbh_hw *hw;
 	void __iomem *regs;
+	ulong reset_start;
 };
 
 static int bcm6368_usbh_init(struct phy *phy)
@@ -177,7 +181,17 @@ static int bcm6368_usbh_probe(struct udevice *dev)
 			return ret;
 	}
 
-	mdelay(100);
+	priv->reset_start = get_timer(0);
+
+	return -EINPROGRESS;
+}
+
+static int bcm6368_usbh_probe_poll(struct udevice *dev)
+{
+	struct bcm6368_usbh_priv *priv = dev_get_priv(dev);
+
+	if (get_timer(priv->reset_start) < USBH_RESET_DELAY_MS)
+		return -EINPROGRESS;
 
 	return 0;
 }
@@ -189,4 +203,6 @@ U_BOOT_DRIVER(bcm6368_usbh) = {
 	.ops = &bcm6368_usbh_ops,
 	.priv_auto_alloc_size = sizeof(struct bcm6368_usbh_priv),
 	.probe = bcm6368_usbh_probe,
+	.probe_poll = bcm6368_usbh_probe_poll,
+	.flags = DM_FLAG_PROBE_ASYNC,
 };
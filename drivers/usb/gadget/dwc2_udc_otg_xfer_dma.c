@@ -89,6 +89,16 @@ static inline void dwc2_ep0_complete_out(void)
 }
 
 
+/*
+ * Largest transfer a bulk endpoint can be programmed for, in whole packets.
+ * Longer requests are moved in several transfers.
+ */
+static u32 ep_max_xfer(struct dwc2_ep *ep)
+{
+	return DOEPT_SIZ_XFER_SIZE_MAX_EP / ep->ep.maxpacket *
+		ep->ep.maxpacket;
+}
+
 static int setdma_rx(struct dwc2_ep *ep, struct dwc2_request *req)
 {
 	u32 *buf, ctrl;
@@ -97,7 +107,7 @@ static int setdma_rx(struct dwc2_ep *ep, struct dwc2_request *req)
 
 	buf = req->req.buf + req->req.actual;
 	length = min_t(u32, req->req.length - req->req.actual,
-		       ep_num ? DMA_BUFFER_SIZE : ep->ep.maxpacket);
+		       ep_num ? ep_max_xfer(ep) : ep->ep.maxpacket);
 
 	ep->len = length;
 	ep->dma_buf = buf;
@@ -142,6 +152,8 @@ static int setdma_tx(struct dwc2_ep *ep, struct dwc2_request *req)
 
 	if (ep_num == EP0_CON)
 		length = min(length, (u32)ep_maxpacket(ep));
+	else
+		length = min(length, ep_max_xfer(ep));
 
 	ep->len = length;
 	ep->dma_buf = buf;
@@ -189,11 +201,33 @@ static int setdma_tx(struct dwc2_ep *ep, struct dwc2_request *req)
 	return length;
 }
 
+/*
+ * Start the request queued after @req, if any, before @req is completed, so
+ * that the next transfer is under way while the gadget driver handles the
+ * data instead of the host being NAKed. Returns true if one was started.
+ */
+static bool start_next(struct dwc2_ep *ep, struct dwc2_request *req)
+{
+	struct dwc2_request *next;
+
+	if (list_is_last(&req->queue, &ep->queue))
+		return false;
+
+	next = list_entry(req->queue.next, struct dwc2_request, queue);
+	if (ep_is_in(ep))
+		setdma_tx(ep, next);
+	else
+		setdma_rx(ep, next);
+
+	return true;
+}
+
 static void complete_rx(struct dwc2_udc *dev, u8 ep_num)
 {
 	struct dwc2_ep *ep = &dev->ep[ep_num];
 	struct dwc2_request *req = NULL;
 	u32 ep_tsr = 0, xfer_size = 0, is_short = 0;
+	bool started;
 
 	if (list_empty(&ep->queue)) {
 		debug_cond(DEBUG_OUT_EP != 0,
@@ -247,9 +281,15 @@ static void complete_rx(struct dwc2_udc *dev, u8 ep_num)
 			/* packet will be completed in complete_tx() */
 			dev->ep0state = WAIT_FOR_IN_COMPLETE;
 		} else {
+			started = start_next(ep, req);
 			done(ep, req, 0);
 
-			if (!list_empty(&ep->queue)) {
+			/*
+			 * dwc2_queue() does not start requests queued from
+			 * the completion, so start the first one here unless
+			 * start_next() already started the next request
+			 */
+			if (!started && !list_empty(&ep->queue)) {
 				req = list_entry(ep->queue.next,
 					struct dwc2_request, queue);
 				debug_cond(DEBUG_OUT_EP != 0,
@@ -268,6 +308,7 @@ static void complete_tx(struct dwc2_udc *dev, u8 ep_num)
 	struct dwc2_request *req;
 	u32 ep_tsr = 0, xfer_size = 0, is_short = 0;
 	u32 last;
+	bool started = false;
 
 	if (dev->ep0state == WAIT_FOR_NULL_COMPLETE) {
 		dev->ep0state = WAIT_FOR_OUT_COMPLETE;
@@ -327,10 +368,12 @@ static void complete_tx(struct dwc2_udc *dev, u8 ep_num)
 		return;
 	}
 
-	if (req->req.actual == req->req.length)
+	if (req->req.actual == req->req.length) {
+		started = start_next(ep, req);
 		done(ep, req, 0);
+	}
 
-	if (!list_empty(&ep->queue)) {
+	if (!started && !list_empty(&ep->queue)) {
 		req = list_entry(ep->queue.next, struct dwc2_request, queue);
 		debug_cond(DEBUG_IN_EP,
 			"%s: Next Tx request start...\n", __func__);
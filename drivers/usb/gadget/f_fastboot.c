@@ -347,11 +347,11 @@ static void compl_do_reset(struct usb_ep *ep, struct usb_request *req)
 
 static unsigned int rx_bytes_expected(struct usb_ep *ep)
 {
-	int rx_remain = fastboot_data_remaining();
+	u32 rx_remain = fastboot_data_remaining();
 	unsigned int rem;
 	unsigned int maxpacket = ep->maxpacket;
 
-	if (rx_remain <= 0)
+	if (!rx_remain)
 		return 0;
 	else if (rx_remain > EP_BUFFER_SIZE)
 		return EP_BUFFER_SIZE;
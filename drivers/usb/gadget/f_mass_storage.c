@@ -299,6 +299,17 @@ struct fsg_common {
 	struct fsg_buffhd	*next_buffhd_to_fill;
 	struct fsg_buffhd	*next_buffhd_to_drain;
 	struct fsg_buffhd	buffhds[FSG_NUM_BUFFERS];
+	void			*buffers;	/* Backing store of buffhds */
+
+#ifdef CONFIG_USB_FUNCTION_MASS_STORAGE_READAHEAD
+	/* Sequential read-ahead, see do_read() */
+	void			*ra_buf;
+	struct blk_req		ra_req;
+	unsigned int		ra_lun;
+	unsigned int		ra_pending:1;
+	unsigned int		read_lun;
+	u32			read_next;	/* LBA after the last READ */
+#endif
 
 	int			cmnd_size;
 	u8			cmnd[MAX_COMMAND_SIZE];
@@ -680,6 +691,88 @@ static int sleep_thread(struct fsg_common *common)
 
 /*-------------------------------------------------------------------------*/
 
+#ifdef CONFIG_USB_FUNCTION_MASS_STORAGE_READAHEAD
+/*
+ * Wait for the read-ahead in flight, if any, and return the number of
+ * sectors it read into ra_buf.
+ */
+static long ra_finish(struct fsg_common *common)
+{
+	long ret;
+
+	if (!common->ra_pending)
+		return 0;
+	common->ra_pending = 0;
+	ret = blk_wait(&ums[common->ra_lun].block_dev, &common->ra_req);
+
+	return ret < 0 ? 0 : ret;
+}
+
+/*
+ * Use the read-ahead for the first buffer of a READ if it covers it. The
+ * data is copied rather than the buffers swapped, since do_write() relies
+ * on the ring buffers staying back to back.
+ * Returns the number of bytes now in bh, or 0 on a miss.
+ */
+static unsigned int ra_take(struct fsg_common *common, struct fsg_buffhd *bh,
+			    u32 lba, unsigned int amount)
+{
+	struct blk_req *req = &common->ra_req;
+	lbaint_t start = ums[common->lun].start_sector + lba;
+
+	if (!common->ra_pending)
+		return 0;
+	if (common->ra_lun != common->lun || req->start != start ||
+	    ra_finish(common) < amount / SECTOR_SIZE)
+		return 0;
+
+	memcpy(bh->buf, common->ra_buf, amount);
+
+	return amount;
+}
+
+/* Queue the read of the chunk a sequential READ is expected to want next */
+static void ra_start(struct fsg_common *common, u32 lba)
+{
+	struct fsg_lun *curlun = &common->luns[common->lun];
+	struct ums *ums_dev = &ums[common->lun];
+	struct blk_req *req = &common->ra_req;
+	unsigned int amount, partial_page;
+
+	ra_finish(common);
+	if (lba >= curlun->num_sectors)
+		return;
+	amount = min(common->data_size_from_cmnd, FSG_BUFLEN);
+	amount = min_t(u64, amount,
+		       (u64)(curlun->num_sectors - lba) * SECTOR_SIZE);
+	partial_page = (lba * SECTOR_SIZE) & (PAGE_CACHE_SIZE - 1);
+	if (partial_page > 0)
+		amount = min(amount, (unsigned int)PAGE_CACHE_SIZE -
+				     partial_page);
+
+	req->start = ums_dev->start_sector + lba;
+	req->blkcnt = amount / SECTOR_SIZE;
+	req->buffer = common->ra_buf;
+	req->write = false;
+	if (!blk_submit(&ums_dev->block_dev, req)) {
+		common->ra_lun = common->lun;
+		common->ra_pending = 1;
+	}
+}
+#else
+static inline long ra_finish(struct fsg_common *common)
+{
+	return 0;
+}
+
+static inline unsigned int ra_take(struct fsg_common *common,
+				   struct fsg_buffhd *bh, u32 lba,
+				   unsigned int amount)
+{
+	return 0;
+}
+#endif
+
 static int do_read(struct fsg_common *common)
 {
 	struct fsg_lun		*curlun = &common->luns[common->lun];
@@ -753,15 +846,18 @@ static int do_read(struct fsg_common *common)
 			break;
 		}
 
-		/* Perform the read */
-		rc = ums[common->lun].read_sector(&ums[common->lun],
-				      file_offset / SECTOR_SIZE,
-				      amount / SECTOR_SIZE,
-				      (char __user *)bh->buf);
-		if (!rc)
-			return -EIO;
+		/* Perform the read, unless it was read ahead */
+		nread = ra_take(common, bh, file_offset / SECTOR_SIZE, amount);
+		if (!nread) {
+			rc = ums[common->lun].read_sector(&ums[common->lun],
+					      file_offset / SECTOR_SIZE,
+					      amount / SECTOR_SIZE,
+					      (char __user *)bh->buf);
+			if (!rc)
+				return -EIO;
 
-		nread = rc * SECTOR_SIZE;
+			nread = rc * SECTOR_SIZE;
+		}
 
 		VLDBG(curlun, "file read %u @ %llu -> %d\n", amount,
 				(unsigned long long) file_offset,
@@ -789,8 +885,20 @@ static int do_read(struct fsg_common *common)
 			break;
 		}
 
-		if (amount_left == 0)
+		if (amount_left == 0) {
+#ifdef CONFIG_USB_FUNCTION_MASS_STORAGE_READAHEAD
+			/*
+			 * The host reads the device sequentially: fetch what
+			 * comes next while this buffer goes out
+			 */
+			if (common->read_lun == common->lun &&
+			    common->read_next == lba)
+				ra_start(common, file_offset / SECTOR_SIZE);
+			common->read_lun = common->lun;
+			common->read_next = file_offset / SECTOR_SIZE;
+#endif
 			break;		/* No more left to read */
+		}
 
 		/* Send this buffer and go read some more */
 		bh->inreq->zero = 0;
@@ -807,11 +915,32 @@ static int do_read(struct fsg_common *common)
 
 /*-------------------------------------------------------------------------*/
 
+/*
+ * Find how many of the received buffers starting at bh can go to the medium
+ * in one write: each but the last must be full and directly followed in
+ * memory by the next one, and all must have arrived without error.
+ * Returns the last buffer of the run and its length in *amount.
+ */
+static struct fsg_buffhd *write_run(struct fsg_buffhd *bh,
+				    unsigned int *amount)
+{
+	*amount = bh->outreq->actual;
+	while (bh->outreq->actual == FSG_BUFLEN &&
+	       bh->next->state == BUF_STATE_FULL &&
+	       bh->next->buf == bh->buf + FSG_BUFLEN &&
+	       bh->next->outreq->status == 0) {
+		bh = bh->next;
+		*amount += bh->outreq->actual;
+	}
+
+	return bh;
+}
+
 static int do_write(struct fsg_common *common)
 {
 	struct fsg_lun		*curlun = &common->luns[common->lun];
 	u32			lba;
-	struct fsg_buffhd	*bh;
+	struct fsg_buffhd	*bh, *last, *next;
 	int			get_some_more;
 	u32			amount_left_to_req, amount_left_to_write;
 	loff_t			usb_offset, file_offset;
@@ -846,6 +975,9 @@ static int do_write(struct fsg_common *common)
 		return -EINVAL;
 	}
 
+	/* Whatever was read ahead may be about to change */
+	ra_finish(common);
+
 	/* Carry out the file writes */
 	get_some_more = 1;
 	file_offset = usb_offset = ((loff_t) lba) << 9;
@@ -915,17 +1047,21 @@ static int do_write(struct fsg_common *common)
 		if (bh->state == BUF_STATE_EMPTY && !get_some_more)
 			break;			/* We stopped early */
 		if (bh->state == BUF_STATE_FULL) {
-			common->next_buffhd_to_drain = bh->next;
-			bh->state = BUF_STATE_EMPTY;
-
 			/* Did something go wrong with the transfer? */
 			if (bh->outreq->status != 0) {
+				common->next_buffhd_to_drain = bh->next;
+				bh->state = BUF_STATE_EMPTY;
 				curlun->sense_data = SS_COMMUNICATION_FAILURE;
 				curlun->info_valid = 1;
 				break;
 			}
 
-			amount = bh->outreq->actual;
+			/* Take every buffer that can go out with this one */
+			last = write_run(bh, &amount);
+			common->next_buffhd_to_drain = last->next;
+			for (next = bh; next != last; next = next->next)
+				next->state = BUF_STATE_EMPTY;
+			last->state = BUF_STATE_EMPTY;
 
 			/* Perform the write */
 			rc = ums[common->lun].write_sector(&ums[common->lun],
@@ -964,7 +1100,7 @@ static int do_write(struct fsg_common *common)
 			}
 
 			/* Did the host decide to stop early? */
-			if (bh->outreq->actual != bh->outreq->length) {
+			if (last->outreq->actual != last->outreq->length) {
 				common->short_packet_received = 1;
 				break;
 			}
@@ -2489,7 +2625,23 @@ static struct fsg_common *fsg_common_init(struct fsg_common *common,
 	}
 	common->lun = 0;
 
-	/* Data buffers cyclic list */
+	/*
+	 * Data buffers cyclic list. The buffers are laid out back to back so
+	 * that do_write() can write several of them at once.
+	 */
+	i = FSG_NUM_BUFFERS;
+#ifdef CONFIG_USB_FUNCTION_MASS_STORAGE_READAHEAD
+	i++;
+#endif
+	common->buffers = memalign(CONFIG_SYS_CACHELINE_SIZE, i * FSG_BUFLEN);
+	if (unlikely(!common->buffers)) {
+		rc = -ENOMEM;
+		goto error_release;
+	}
+#ifdef CONFIG_USB_FUNCTION_MASS_STORAGE_READAHEAD
+	common->ra_buf = common->buffers + FSG_NUM_BUFFERS * FSG_BUFLEN;
+#endif
+
 	bh = common->buffhds;
 
 	i = FSG_NUM_BUFFERS;
@@ -2500,11 +2652,7 @@ static struct fsg_common *fsg_common_init(struct fsg_common *common,
 buffhds_first_it:
 		bh->inreq_busy = 0;
 		bh->outreq_busy = 0;
-		bh->buf = memalign(CONFIG_SYS_CACHELINE_SIZE, FSG_BUFLEN);
-		if (unlikely(!bh->buf)) {
-			rc = -ENOMEM;
-			goto error_release;
-		}
+		bh->buf = common->buffers + (bh - common->buffhds) * FSG_BUFLEN;
 	} while (--i);
 	bh->next = common->buffhds;
 
@@ -2566,13 +2714,9 @@ static void fsg_common_release(struct kref *ref)
 		kfree(common->luns);
 	}
 
-	{
-		struct fsg_buffhd *bh = common->buffhds;
-		unsigned i = FSG_NUM_BUFFERS;
-		do {
-			kfree(bh->buf);
-		} while (++bh, --i);
-	}
+	/* A read-ahead may still be filling one of the buffers */
+	ra_finish(common);
+	kfree(common->buffers);
 
 	if (common->free_storage_on_release)
 		kfree(common);
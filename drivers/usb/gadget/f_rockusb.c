@@ -97,6 +97,8 @@ static struct usb_gadget_strings *rkusb_strings[] = {
 
 static struct f_rockusb *rockusb_func;
 static void rx_handler_command(struct usb_ep *ep, struct usb_request *req);
+static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req);
+static void tx_handler_ul_image(struct usb_ep *ep, struct usb_request *req);
 static int rockusb_tx_write_csw(u32 tag, int residue, u8 status, int size);
 
 struct f_rockusb *get_rkusb(void)
@@ -112,15 +114,6 @@ struct f_rockusb *get_rkusb(void)
 		memset(f_rkusb, 0, sizeof(*f_rkusb));
 	}
 
-	if (!f_rkusb->buf_head) {
-		f_rkusb->buf_head = memalign(CONFIG_SYS_CACHELINE_SIZE,
-					     RKUSB_BUF_SIZE);
-		if (!f_rkusb->buf_head)
-			return 0;
-
-		f_rkusb->buf = f_rkusb->buf_head;
-		memset(f_rkusb->buf_head, 0, RKUSB_BUF_SIZE);
-	}
 	return f_rkusb;
 }
 
@@ -194,31 +187,36 @@ static void rockusb_unbind(struct usb_configuration *c, struct usb_function *f)
 	memset(rockusb_func, 0, sizeof(*rockusb_func));
 }
 
+static void rockusb_free_req(struct usb_ep *ep, struct usb_request **reqp)
+{
+	if (*reqp) {
+		free((*reqp)->buf);
+		usb_ep_free_request(ep, *reqp);
+		*reqp = NULL;
+	}
+}
+
 static void rockusb_disable(struct usb_function *f)
 {
 	struct f_rockusb *f_rkusb = func_to_rockusb(f);
+	int i;
 
 	usb_ep_disable(f_rkusb->out_ep);
 	usb_ep_disable(f_rkusb->in_ep);
 
-	if (f_rkusb->out_req) {
-		free(f_rkusb->out_req->buf);
-		usb_ep_free_request(f_rkusb->out_ep, f_rkusb->out_req);
-		f_rkusb->out_req = NULL;
-	}
-	if (f_rkusb->in_req) {
-		free(f_rkusb->in_req->buf);
-		usb_ep_free_request(f_rkusb->in_ep, f_rkusb->in_req);
-		f_rkusb->in_req = NULL;
-	}
-	if (f_rkusb->buf_head) {
-		free(f_rkusb->buf_head);
-		f_rkusb->buf_head = NULL;
-		f_rkusb->buf = NULL;
+	rockusb_free_req(f_rkusb->out_ep, &f_rkusb->out_req);
+	rockusb_free_req(f_rkusb->in_ep, &f_rkusb->in_req);
+	for (i = 0; i < RKUSB_REQ_COUNT; i++) {
+		rockusb_free_req(f_rkusb->out_ep, &f_rkusb->rx_req[i]);
+		rockusb_free_req(f_rkusb->in_ep, &f_rkusb->tx_req[i]);
 	}
+	f_rkusb->pending_count = 0;
+	f_rkusb->dl_size = 0;
+	f_rkusb->ul_size = 0;
 }
 
-static struct usb_request *rockusb_start_ep(struct usb_ep *ep)
+static struct usb_request *rockusb_start_ep(struct usb_ep *ep,
+					    unsigned int size)
 {
 	struct usb_request *req;
 
@@ -226,8 +224,8 @@ static struct usb_request *rockusb_start_ep(struct usb_ep *ep)
 	if (!req)
 		return NULL;
 
-	req->length = EP_BUFFER_SIZE;
-	req->buf = memalign(CONFIG_SYS_CACHELINE_SIZE, EP_BUFFER_SIZE);
+	req->length = size;
+	req->buf = memalign(CONFIG_SYS_CACHELINE_SIZE, size);
 	if (!req->buf) {
 		usb_ep_free_request(ep, req);
 		return NULL;
@@ -240,7 +238,7 @@ static struct usb_request *rockusb_start_ep(struct usb_ep *ep)
 static int rockusb_set_alt(struct usb_function *f, unsigned int interface,
 			   unsigned int alt)
 {
-	int ret;
+	int ret, i;
 	struct usb_composite_dev *cdev = f->config->cdev;
 	struct usb_gadget *gadget = cdev->gadget;
 	struct f_rockusb *f_rkusb = func_to_rockusb(f);
@@ -256,7 +254,7 @@ static int rockusb_set_alt(struct usb_function *f, unsigned int interface,
 		return ret;
 	}
 
-	f_rkusb->out_req = rockusb_start_ep(f_rkusb->out_ep);
+	f_rkusb->out_req = rockusb_start_ep(f_rkusb->out_ep, EP_BUFFER_SIZE);
 	if (!f_rkusb->out_req) {
 		printf("failed to alloc out req\n");
 		ret = -EINVAL;
@@ -271,7 +269,7 @@ static int rockusb_set_alt(struct usb_function *f, unsigned int interface,
 		goto err;
 	}
 
-	f_rkusb->in_req = rockusb_start_ep(f_rkusb->in_ep);
+	f_rkusb->in_req = rockusb_start_ep(f_rkusb->in_ep, EP_BUFFER_SIZE);
 	if (!f_rkusb->in_req) {
 		printf("failed alloc req in\n");
 		ret = -EINVAL;
@@ -279,6 +277,20 @@ static int rockusb_set_alt(struct usb_function *f, unsigned int interface,
 	}
 	f_rkusb->in_req->complete = rockusb_complete;
 
+	for (i = 0; i < RKUSB_REQ_COUNT; i++) {
+		f_rkusb->rx_req[i] = rockusb_start_ep(f_rkusb->out_ep,
+						      RKUSB_REQ_BUF_SIZE);
+		f_rkusb->tx_req[i] = rockusb_start_ep(f_rkusb->in_ep,
+						      RKUSB_REQ_BUF_SIZE);
+		if (!f_rkusb->rx_req[i] || !f_rkusb->tx_req[i]) {
+			printf("failed to alloc data reqs\n");
+			ret = -ENOMEM;
+			goto err;
+		}
+		f_rkusb->rx_req[i]->complete = rx_handler_dl_image;
+		f_rkusb->tx_req[i]->complete = tx_handler_ul_image;
+	}
+
 	ret = usb_ep_queue(f_rkusb->out_ep, f_rkusb->out_req, 0);
 	if (ret)
 		goto err;
@@ -406,14 +418,14 @@ static void tx_handler_send_csw(struct usb_ep *ep, struct usb_request *req)
 static unsigned int rx_bytes_expected(struct usb_ep *ep)
 {
 	struct f_rockusb *f_rkusb = get_rkusb();
-	int rx_remain = f_rkusb->dl_size - f_rkusb->dl_bytes;
+	int rx_remain = f_rkusb->dl_size - f_rkusb->dl_queued;
 	unsigned int rem;
 	unsigned int maxpacket = ep->maxpacket;
 
 	if (rx_remain <= 0)
 		return 0;
-	else if (rx_remain > EP_BUFFER_SIZE)
-		return EP_BUFFER_SIZE;
+	else if (rx_remain > RKUSB_REQ_BUF_SIZE)
+		return RKUSB_REQ_BUF_SIZE;
 
 	rem = rx_remain % maxpacket;
 	if (rem > 0)
@@ -422,124 +434,189 @@ static unsigned int rx_bytes_expected(struct usb_ep *ep)
 	return rx_remain;
 }
 
+/*
+ * Completed data requests wait here until rockusb_handle_io() has written
+ * their data to storage (download) or refilled them (upload).
+ */
+static void rockusb_put_pending(struct f_rockusb *f_rkusb,
+				struct usb_request *req)
+{
+	int i = (f_rkusb->pending_head + f_rkusb->pending_count) %
+		RKUSB_REQ_COUNT;
+
+	f_rkusb->pending[i] = req;
+	f_rkusb->pending_count++;
+}
+
+static struct usb_request *rockusb_get_pending(struct f_rockusb *f_rkusb)
+{
+	struct usb_request *req;
+
+	if (!f_rkusb->pending_count)
+		return NULL;
+
+	req = f_rkusb->pending[f_rkusb->pending_head];
+	f_rkusb->pending_head = (f_rkusb->pending_head + 1) % RKUSB_REQ_COUNT;
+	f_rkusb->pending_count--;
+
+	return req;
+}
+
+static void rockusb_queue_rx(struct f_rockusb *f_rkusb,
+			     struct usb_request *req)
+{
+	int ret;
+
+	req->length = rx_bytes_expected(f_rkusb->out_ep);
+	req->actual = 0;
+	f_rkusb->dl_queued += min(req->length,
+				  f_rkusb->dl_size - f_rkusb->dl_queued);
+	ret = usb_ep_queue(f_rkusb->out_ep, req, 0);
+	if (ret)
+		printf("Error %d on queue\n", ret);
+}
+
 /* usb_request complete call back to handle upload image */
 static void tx_handler_ul_image(struct usb_ep *ep, struct usb_request *req)
 {
-	ALLOC_CACHE_ALIGN_BUFFER(char, rbuffer, RKBLOCK_BUF_SIZE);
 	struct f_rockusb *f_rkusb = get_rkusb();
-	struct usb_request *in_req = rockusb_func->in_req;
-	int ret;
 
 	/* Print error status of previous transfer */
 	if (req->status)
 		debug("status: %d ep '%s' trans: %d len %d\n", req->status,
 		      ep->name, req->actual, req->length);
 
-	/* On transfer complete reset in_req and feedback host with CSW_GOOD */
-	if (f_rkusb->ul_bytes >= f_rkusb->ul_size) {
-		in_req->length = 0;
-		in_req->complete = rockusb_complete;
+	if (!f_rkusb->ul_size)
+		return;
 
+	/* On transfer complete feedback host with CSW_GOOD */
+	f_rkusb->ul_sent += req->length;
+	if (f_rkusb->ul_sent >= f_rkusb->ul_size) {
+		f_rkusb->ul_size = 0;
 		rockusb_tx_write_csw(f_rkusb->tag, 0, CSW_GOOD,
 				     USB_BULK_CS_WRAP_LEN);
 		return;
 	}
 
-	/* Proceed with current chunk */
-	unsigned int transfer_size = f_rkusb->ul_size - f_rkusb->ul_bytes;
+	rockusb_put_pending(f_rkusb, req);
+}
+
+/* Read the next chunks from storage into the free IN requests */
+static void rockusb_ul_image(struct f_rockusb *f_rkusb)
+{
+	struct usb_request *req;
+	unsigned int transfer_size, blkcount;
+	int blks, ret;
 
-	if (transfer_size > RKBLOCK_BUF_SIZE)
-		transfer_size = RKBLOCK_BUF_SIZE;
-	/* Read at least one block */
-	unsigned int blkcount = (transfer_size + f_rkusb->desc->blksz - 1) /
-				f_rkusb->desc->blksz;
+	while (f_rkusb->ul_bytes < f_rkusb->ul_size) {
+		req = rockusb_get_pending(f_rkusb);
+		if (!req)
+			return;
 
-	debug("ul %x bytes, %x blks, read lba %x, ul_size:%x, ul_bytes:%x, ",
-	      transfer_size, blkcount, f_rkusb->lba,
-	      f_rkusb->ul_size, f_rkusb->ul_bytes);
+		transfer_size = min_t(unsigned int, RKUSB_REQ_BUF_SIZE,
+				      f_rkusb->ul_size - f_rkusb->ul_bytes);
+		blkcount = transfer_size / f_rkusb->desc->blksz;
 
-	int blks = blk_dread(f_rkusb->desc, f_rkusb->lba, blkcount, rbuffer);
+		debug("ul %x bytes, %x blks, read lba %x, ul_size:%x, ul_bytes:%x, ",
+		      transfer_size, blkcount, f_rkusb->lba,
+		      f_rkusb->ul_size, f_rkusb->ul_bytes);
 
-	if (blks != blkcount) {
-		printf("failed reading from device %s: %d\n",
-		       f_rkusb->dev_type, f_rkusb->dev_index);
-		rockusb_tx_write_csw(f_rkusb->tag, 0, CSW_FAIL,
-				     USB_BULK_CS_WRAP_LEN);
-		return;
+		blks = blk_dread(f_rkusb->desc, f_rkusb->lba, blkcount,
+				 req->buf);
+		if (blks != blkcount) {
+			printf("failed reading from device %s: %d\n",
+			       f_rkusb->dev_type, f_rkusb->dev_index);
+			f_rkusb->ul_size = 0;
+			rockusb_tx_write_csw(f_rkusb->tag, 0, CSW_FAIL,
+					     USB_BULK_CS_WRAP_LEN);
+			return;
+		}
+		f_rkusb->lba += blkcount;
+		f_rkusb->ul_bytes += transfer_size;
+
+		/* Proceed with USB request */
+		req->length = transfer_size;
+		debug("Uploading 0x%x bytes\n", transfer_size);
+		ret = usb_ep_queue(f_rkusb->in_ep, req, 0);
+		if (ret)
+			printf("Error %d on queue\n", ret);
 	}
-	f_rkusb->lba += blkcount;
-	f_rkusb->ul_bytes += transfer_size;
-
-	/* Proceed with USB request */
-	memcpy(in_req->buf, rbuffer, transfer_size);
-	in_req->length = transfer_size;
-	in_req->complete = tx_handler_ul_image;
-	debug("Uploading 0x%x bytes\n", transfer_size);
-	usb_ep_dequeue(rockusb_func->in_ep, in_req);
-	ret = usb_ep_queue(rockusb_func->in_ep, in_req, 0);
-	if (ret)
-		printf("Error %d on queue\n", ret);
 }
 
 /* usb_request complete call back to handle down load image */
 static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 {
 	struct f_rockusb *f_rkusb = get_rkusb();
-	unsigned int transfer_size = 0;
-	const unsigned char *buffer = req->buf;
-	unsigned int buffer_size = req->actual;
 
-	transfer_size = f_rkusb->dl_size - f_rkusb->dl_bytes;
+	if (!f_rkusb->dl_size)
+		return;
 
 	if (req->status != 0) {
 		printf("Bad status: %d\n", req->status);
+		f_rkusb->dl_size = 0;
 		rockusb_tx_write_csw(f_rkusb->tag, 0, CSW_FAIL,
 				     USB_BULK_CS_WRAP_LEN);
 		return;
 	}
 
-	if (buffer_size < transfer_size)
-		transfer_size = buffer_size;
+	rockusb_put_pending(f_rkusb, req);
+}
 
-	memcpy((void *)f_rkusb->buf, buffer, transfer_size);
-	f_rkusb->dl_bytes += transfer_size;
-	int blks = 0, blkcnt = transfer_size  / f_rkusb->desc->blksz;
+/* Write the received chunks to storage and queue their requests again */
+static void rockusb_dl_image(struct f_rockusb *f_rkusb)
+{
+	struct usb_request *req;
+	unsigned int transfer_size;
+	int blks, blkcnt;
+
+	while ((req = rockusb_get_pending(f_rkusb))) {
+		transfer_size = min(req->actual,
+				    f_rkusb->dl_size - f_rkusb->dl_bytes);
+		blkcnt = transfer_size / f_rkusb->desc->blksz;
+
+		debug("dl %x bytes, %x blks, write lba %x, dl_size:%x, dl_bytes:%x, ",
+		      transfer_size, blkcnt, f_rkusb->lba, f_rkusb->dl_size,
+		      f_rkusb->dl_bytes);
+
+		/* After a failure keep draining the data, then report it */
+		if (f_rkusb->status == CSW_GOOD) {
+			blks = blk_dwrite(f_rkusb->desc, f_rkusb->lba, blkcnt,
+					  req->buf);
+			if (blks != blkcnt) {
+				printf("failed writing to device %s: %d\n",
+				       f_rkusb->dev_type, f_rkusb->dev_index);
+				f_rkusb->status = CSW_FAIL;
+			}
+		}
+		f_rkusb->lba += blkcnt;
+		f_rkusb->dl_bytes += transfer_size;
+
+		/* Check if transfer is done */
+		if (f_rkusb->dl_bytes >= f_rkusb->dl_size) {
+			debug("transfer 0x%x bytes done\n", f_rkusb->dl_size);
+			f_rkusb->dl_size = 0;
+			usb_ep_queue(f_rkusb->out_ep, f_rkusb->out_req, 0);
+			rockusb_tx_write_csw(f_rkusb->tag, 0, f_rkusb->status,
+					     USB_BULK_CS_WRAP_LEN);
+			return;
+		}
 
-	debug("dl %x bytes, %x blks, write lba %x, dl_size:%x, dl_bytes:%x, ",
-	      transfer_size, blkcnt, f_rkusb->lba, f_rkusb->dl_size,
-	      f_rkusb->dl_bytes);
-	blks = blk_dwrite(f_rkusb->desc, f_rkusb->lba, blkcnt, f_rkusb->buf);
-	if (blks != blkcnt) {
-		printf("failed writing to device %s: %d\n", f_rkusb->dev_type,
-		       f_rkusb->dev_index);
-		rockusb_tx_write_csw(f_rkusb->tag, 0, CSW_FAIL,
-				     USB_BULK_CS_WRAP_LEN);
-		return;
-	}
-	f_rkusb->lba += blkcnt;
-
-	/* Check if transfer is done */
-	if (f_rkusb->dl_bytes >= f_rkusb->dl_size) {
-		req->complete = rx_handler_command;
-		req->length = EP_BUFFER_SIZE;
-		f_rkusb->buf = f_rkusb->buf_head;
-		debug("transfer 0x%x bytes done\n", f_rkusb->dl_size);
-		f_rkusb->dl_size = 0;
-		rockusb_tx_write_csw(f_rkusb->tag, 0, CSW_GOOD,
-				     USB_BULK_CS_WRAP_LEN);
-	} else {
-		req->length = rx_bytes_expected(ep);
-		if (f_rkusb->buf == f_rkusb->buf_head)
-			f_rkusb->buf = f_rkusb->buf_head + EP_BUFFER_SIZE;
-		else
-			f_rkusb->buf = f_rkusb->buf_head;
-
-		debug("remain %x bytes, %lx sectors\n", req->length,
-		      req->length / f_rkusb->desc->blksz);
+		if (f_rkusb->dl_queued < f_rkusb->dl_size)
+			rockusb_queue_rx(f_rkusb, req);
 	}
+}
 
-	req->actual = 0;
-	usb_ep_queue(ep, req, 0);
+void rockusb_handle_io(void)
+{
+	struct f_rockusb *f_rkusb = rockusb_func;
+
+	if (!f_rkusb)
+		return;
+
+	if (f_rkusb->dl_size)
+		rockusb_dl_image(f_rkusb);
+	else if (f_rkusb->ul_size)
+		rockusb_ul_image(f_rkusb);
 }
 
 static void cb_test_unit_ready(struct usb_ep *ep, struct usb_request *req)
@@ -617,7 +694,7 @@ static void cb_read_lba(struct usb_ep *ep, struct usb_request *req)
 	ALLOC_CACHE_ALIGN_BUFFER(struct fsg_bulk_cb_wrap, cbw,
 				 sizeof(struct fsg_bulk_cb_wrap));
 	struct f_rockusb *f_rkusb = get_rkusb();
-	int sector_count;
+	int sector_count, i;
 
 	memcpy((char *)cbw, req->buf, USB_BULK_CB_WRAP_LEN);
 	sector_count = (int)get_unaligned_be16(&cbw->CDB[7]);
@@ -640,6 +717,7 @@ static void cb_read_lba(struct usb_ep *ep, struct usb_request *req)
 	f_rkusb->lba = get_unaligned_be32(&cbw->CDB[2]);
 	f_rkusb->ul_size = sector_count * f_rkusb->desc->blksz;
 	f_rkusb->ul_bytes = 0;
+	f_rkusb->ul_sent = 0;
 
 	debug("require read %x bytes, %x sectors from lba %x\n",
 	      f_rkusb->ul_size, sector_count, f_rkusb->lba);
@@ -650,8 +728,11 @@ static void cb_read_lba(struct usb_ep *ep, struct usb_request *req)
 		return;
 	}
 
-	/* Start right now sending first chunk */
-	tx_handler_ul_image(ep, req);
+	/* All IN requests are free, rockusb_handle_io() fills them */
+	f_rkusb->pending_head = 0;
+	f_rkusb->pending_count = 0;
+	for (i = 0; i < RKUSB_REQ_COUNT; i++)
+		rockusb_put_pending(f_rkusb, f_rkusb->tx_req[i]);
 }
 
 static void cb_write_lba(struct usb_ep *ep, struct usb_request *req)
@@ -659,7 +740,7 @@ static void cb_write_lba(struct usb_ep *ep, struct usb_request *req)
 	ALLOC_CACHE_ALIGN_BUFFER(struct fsg_bulk_cb_wrap, cbw,
 				 sizeof(struct fsg_bulk_cb_wrap));
 	struct f_rockusb *f_rkusb = get_rkusb();
-	int sector_count;
+	int sector_count, i;
 
 	memcpy((char *)cbw, req->buf, USB_BULK_CB_WRAP_LEN);
 	sector_count = (int)get_unaligned_be16(&cbw->CDB[7]);
@@ -682,6 +763,8 @@ static void cb_write_lba(struct usb_ep *ep, struct usb_request *req)
 	f_rkusb->lba = get_unaligned_be32(&cbw->CDB[2]);
 	f_rkusb->dl_size = sector_count * f_rkusb->desc->blksz;
 	f_rkusb->dl_bytes = 0;
+	f_rkusb->dl_queued = 0;
+	f_rkusb->status = CSW_GOOD;
 
 	debug("require write %x bytes, %x sectors to lba %x\n",
 	      f_rkusb->dl_size, sector_count, f_rkusb->lba);
@@ -689,10 +772,18 @@ static void cb_write_lba(struct usb_ep *ep, struct usb_request *req)
 	if (f_rkusb->dl_size == 0)  {
 		rockusb_tx_write_csw(cbw->tag, cbw->data_transfer_length,
 				     CSW_FAIL, USB_BULK_CS_WRAP_LEN);
-	} else {
-		req->complete = rx_handler_dl_image;
-		req->length = rx_bytes_expected(ep);
+		return;
 	}
+
+	/*
+	 * Keep several OUT requests queued so the host can send the next
+	 * chunk while rockusb_handle_io() writes the last one
+	 */
+	f_rkusb->pending_head = 0;
+	f_rkusb->pending_count = 0;
+	for (i = 0; i < RKUSB_REQ_COUNT; i++)
+		if (f_rkusb->dl_queued < f_rkusb->dl_size)
+			rockusb_queue_rx(f_rkusb, f_rkusb->rx_req[i]);
 }
 
 static void cb_erase_lba(struct usb_ep *ep, struct usb_request *req)
@@ -925,5 +1016,7 @@ static void rx_handler_command(struct usb_ep *ep, struct usb_request *req)
 
 	*cmdbuf = '\0';
 	req->actual = 0;
-	usb_ep_queue(ep, req, 0);
+	/* During a download the OUT endpoint belongs to the data requests */
+	if (!rockusb_func->dl_size)
+		usb_ep_queue(ep, req, 0);
 }
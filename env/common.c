@@ -79,9 +79,14 @@ void set_default_env(const char *s, int flags)
 		debug("Using default environment\n");
 	}
 
+#if CONFIG_IS_ENABLED(ENV_DEFAULT_TABLE)
+	if (himport_base_r(&env_htab, env_default_table, env_default_count,
+			   flags) == 0)
+#else
 	if (himport_r(&env_htab, (char *)default_environment,
 			sizeof(default_environment), '\0', flags, 0,
 			0, NULL) == 0)
+#endif
 		pr_err("## Error: Environment import failed: errno = %d\n",
 		       errno);
 
@@ -103,6 +108,24 @@ int set_default_vars(int nvars, char * const vars[], int flags)
 				flags, 0, nvars, vars);
 }
 
+/* Import '\0'-separated variables, replacing the whole environment */
+static int env_import_data(const char *data, size_t size)
+{
+#if CONFIG_IS_ENABLED(ENV_DEFAULT_TABLE)
+	/*
+	 * Start with the default environment hidden, so that variables which
+	 * still have their default value are shown from it, not copied
+	 */
+	if (himport_base_r(&env_htab, env_default_table, env_default_count,
+			   H_HIDE_BASE) == 0)
+		return 0;
+
+	return himport_r(&env_htab, data, size, '\0', H_NOCLEAR, 0, 0, NULL);
+#else
+	return himport_r(&env_htab, data, size, '\0', 0, 0, 0, NULL);
+#endif
+}
+
 /*
  * Check if CRC is valid and (if yes) import the environment.
  * Note that "buf" may or may not be aligned.
@@ -122,8 +145,7 @@ int env_import(const char *buf, int check)
 		}
 	}
 
-	if (himport_r(&env_htab, (char *)ep->data, ENV_SIZE, '\0', 0, 0,
-			0, NULL)) {
+	if (env_import_data((char *)ep->data, ENV_SIZE)) {
 		gd->flags |= GD_FLG_ENV_READY;
 		return 0;
 	}
@@ -16,7 +16,7 @@ void btrfs_hash_init(void)
 	static int inited = 0;
 
 	if (!inited) {
-		crc32c_init(btrfs_crc32c_table, 0x82F63B78);
+		crc32c_init(btrfs_crc32c_table, CRC32C_POLY_LE);
 		inited = 1;
 	}
 }
@@ -14,6 +14,7 @@
  */
 
 #include <common.h>
+#include <blk.h>
 #include <ext4fs.h>
 #include <malloc.h>
 #include <ext_common.h>
@@ -656,6 +657,11 @@ void ext4fs_update_journal(void)
 		put_ext4((uint64_t) ((uint64_t)blknr * (uint64_t)fs->blksz),
 			 journal_ptr[i]->buf, fs->blksz);
 	}
+	/* The commit block must not reach the device before the others */
+	if (blkcache_flush(fs->dev_desc->if_type, fs->dev_desc->devnum)) {
+		printf("error: writing back the journal\n");
+		return;
+	}
 	blknr = read_allocated_block(&inode_journal, jrnl_blk_idx++, NULL);
 	update_commit_block(blknr);
 	printf("update journal finished\n");
@@ -22,6 +22,7 @@
 
 
 #include <common.h>
+#include <blk.h>
 #include <memalign.h>
 #include <linux/stat.h>
 #include <div64.h>
@@ -70,6 +71,16 @@ static void ext4fs_update(void)
 	struct ext_filesystem *fs = get_fs();
 	struct ext2_block_group *bgd = NULL;
 
+	/*
+	 * The write-back cache writes blocks in order of block number, so
+	 * the journal must be written out before the blocks it covers are
+	 * overwritten in place
+	 */
+	if (blkcache_flush(fs->dev_desc->if_type, fs->dev_desc->devnum)) {
+		printf("error: writing back the journal\n");
+		goto out;
+	}
+
 	/* update  super block */
 	put_ext4((uint64_t)(SUPERBLOCK_SIZE),
 		 (struct ext2_sblock *)fs->sb, (uint32_t)SUPERBLOCK_SIZE);
@@ -98,6 +109,7 @@ static void ext4fs_update(void)
 
 	ext4fs_dump_metadata();
 
+out:
 	gindex = 0;
 	gd_index = 0;
 }
@@ -606,6 +618,10 @@ int ext4fs_init(void)
 	fs->sb = zalloc(SUPERBLOCK_SIZE);
 	if (!fs->sb)
 		return -ENOMEM;
+
+	/* hold back small writes until ext4fs_deinit() */
+	blkcache_writeback(fs->dev_desc->if_type, fs->dev_desc->devnum, true);
+
 	if (!ext4_read_superblock((char *)fs->sb))
 		goto fail;
 
@@ -754,6 +770,10 @@ void ext4fs_deinit(void)
 	fs->first_pass_bbmap = 0;
 	fs->curr_inode_no = 0;
 	fs->curr_blkno = 0;
+
+	if (blkcache_writeback(fs->dev_desc->if_type, fs->dev_desc->devnum,
+			       false))
+		printf("error: writing back cached blocks\n");
 }
 
 /*
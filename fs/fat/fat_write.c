@@ -6,6 +6,7 @@
  */
 
 #include <common.h>
+#include <blk.h>
 #include <command.h>
 #include <config.h>
 #include <fat.h>
@@ -47,6 +48,28 @@ static int disk_write(__u32 block, __u32 nr_blocks, void *buf)
 	return ret;
 }
 
+/*
+ * Let the block cache hold back the many small writes of one filesystem
+ * update and write them out, sorted and merged, once it is done.
+ */
+static void disk_writeback_start(void)
+{
+	if (cur_dev)
+		blkcache_writeback(cur_dev->if_type, cur_dev->devnum, true);
+}
+
+static int disk_writeback_end(int ret)
+{
+	if (cur_dev &&
+	    blkcache_writeback(cur_dev->if_type, cur_dev->devnum, false) &&
+	    !ret) {
+		printf("Error: writing back cached blocks\n");
+		return -EIO;
+	}
+
+	return ret;
+}
+
 /*
  * Set short name in directory entry
  */
@@ -1086,6 +1109,7 @@ int file_fat_write_at(const char *filename, loff_t pos, void *buffer,
 	if (!filename_copy)
 		return -ENOMEM;
 
+	disk_writeback_start();
 	split_filename(filename_copy, &parent, &basename);
 	if (!strlen(basename)) {
 		ret = -EINVAL;
@@ -1205,7 +1229,7 @@ exit:
 	free(filename_copy);
 	free(mydata->fatbuf);
 	free(itr);
-	return ret;
+	return disk_writeback_end(ret);
 }
 
 int file_fat_write(const char *filename, void *buffer, loff_t offset,
@@ -1287,6 +1311,7 @@ int fat_unlink(const char *filename)
 	int n_entries, ret;
 	char *filename_copy, *dirname, *basename;
 
+	disk_writeback_start();
 	filename_copy = strdup(filename);
 	if (!filename_copy) {
 		printf("Error: allocating memory\n");
@@ -1348,7 +1373,7 @@ exit:
 	free(itr);
 	free(filename_copy);
 
-	return ret;
+	return disk_writeback_end(ret);
 }
 
 int fat_mkdir(const char *new_dirname)
@@ -1364,6 +1389,7 @@ int fat_mkdir(const char *new_dirname)
 	unsigned int bytesperclust;
 	dir_entry *dotdent = NULL;
 
+	disk_writeback_start();
 	dirname_copy = strdup(new_dirname);
 	if (!dirname_copy)
 		goto exit;
@@ -1483,5 +1509,5 @@ exit:
 	free(mydata->fatbuf);
 	free(itr);
 	free(dotdent);
-	return ret;
+	return disk_writeback_end(ret);
 }
@@ -116,6 +116,8 @@ struct blk_desc {
 /**
  * blkcache_read() - attempt to read a set of blocks from cache
  *
+ * The read is served from the cache only if every block in it is cached.
+ *
  * @param iftype - IF_TYPE_x for type of device
  * @param dev - device index of particular type
  * @param start - starting block number
@@ -145,9 +147,81 @@ void blkcache_fill(int iftype, int dev,
 		   lbaint_t start, lbaint_t blkcnt,
 		   unsigned long blksz, void const *buffer);
 
+/**
+ * blkcache_readahead() - decide how far to read beyond a cache miss
+ *
+ * Reads that follow on from the previous read of the same device are
+ * extended by a read-ahead window that doubles each time, up to
+ * CONFIG_BLOCK_CACHE_READAHEAD blocks. The caller should read the
+ * requested blocks and the read-ahead into *bufp in one go, then pass the
+ * lot to blkcache_fill().
+ *
+ * @param iftype - IF_TYPE_x for type of device
+ * @param dev - device index of particular type
+ * @param start - starting block number of the missed read
+ * @param blkcnt - number of blocks in the missed read
+ * @param blksz - size in bytes of each block
+ * @param bufp - returns a buffer owned by the cache, large enough for
+ *		 blkcnt blocks plus the read-ahead
+ *
+ * @return - number of blocks to read ahead, 0 for none
+ */
+lbaint_t blkcache_readahead(int iftype, int dev,
+			    lbaint_t start, lbaint_t blkcnt,
+			    unsigned long blksz, void **bufp);
+
+/**
+ * blkcache_write() - write a set of blocks into the cache
+ *
+ * If write-back is enabled for the device, the blocks are only copied into
+ * the cache and marked dirty; they reach the device on the next flush.
+ *
+ * @param iftype - IF_TYPE_x for type of device
+ * @param dev - device index of particular type
+ * @param start - starting block number
+ * @param blkcnt - number of blocks to write
+ * @param blksz - size in bytes of each block
+ * @param buffer - data to write
+ *
+ * @return - '1' if the cache took the write, '0' if the caller must write
+ * to the device itself, -ve if making room in the cache failed
+ */
+int blkcache_write(int iftype, int dev,
+		   lbaint_t start, lbaint_t blkcnt,
+		   unsigned long blksz, void const *buffer);
+
+/**
+ * blkcache_writeback() - enable or disable write-back caching for a device
+ *
+ * Only one device at a time is in write-back mode; enabling it for another
+ * device flushes the previous one. Disabling it flushes the device. This is
+ * meant to bracket a burst of small writes, such as a filesystem update.
+ *
+ * @param iftype - IF_TYPE_x for type of device
+ * @param dev - device index of particular type
+ * @param enable - true to enable write-back, false to disable it
+ *
+ * @return - 0 if OK, -ve if writing back dirty blocks failed
+ */
+int blkcache_writeback(int iftype, int dev, bool enable);
+
+/**
+ * blkcache_flush() - write back the dirty blocks of a device
+ *
+ * Blocks are written in order of block number, adjacent ones in a single
+ * write.
+ *
+ * @param iftype - IF_TYPE_x for type of device
+ * @param dev - device index of particular type
+ *
+ * @return - 0 if OK, -ve on error
+ */
+int blkcache_flush(int iftype, int dev);
+
 /**
  * blkcache_invalidate() - discard the cache for a set of blocks
- * because of a write or device (re)initialization.
+ * because of a write or device (re)initialization. Dirty blocks are
+ * written back first.
  *
  * @param iftype - IF_TYPE_x for type of device
  * @param dev - device index of particular type
@@ -157,8 +231,8 @@ void blkcache_invalidate(int iftype, int dev);
 /**
  * blkcache_configure() - configure block cache
  *
- * @param blocks - maximum blocks per entry
- * @param entries - maximum entries in cache
+ * @param blocks - largest read, in blocks, that is cached
+ * @param entries - maximum number of blocks in the cache
  */
 void blkcache_configure(unsigned blocks, unsigned entries);
 
@@ -168,9 +242,10 @@ void blkcache_configure(unsigned blocks, unsigned entries);
 struct block_cache_stats {
 	unsigned hits;
 	unsigned misses;
-	unsigned entries; /* current entry count */
-	unsigned max_blocks_per_entry;
-	unsigned max_entries;
+	unsigned entries; /* current number of cached blocks */
+	unsigned dirty; /* cached blocks not yet written back */
+	unsigned max_blocks_per_entry; /* largest read that is cached */
+	unsigned max_entries; /* maximum number of cached blocks */
 };
 
 /**
@@ -193,6 +268,30 @@ static inline void blkcache_fill(int iftype, int dev,
 				 lbaint_t start, lbaint_t blkcnt,
 				 unsigned long blksz, void const *buffer) {}
 
+static inline lbaint_t blkcache_readahead(int iftype, int dev,
+					  lbaint_t start, lbaint_t blkcnt,
+					  unsigned long blksz, void **bufp)
+{
+	return 0;
+}
+
+static inline int blkcache_write(int iftype, int dev,
+				 lbaint_t start, lbaint_t blkcnt,
+				 unsigned long blksz, void const *buffer)
+{
+	return 0;
+}
+
+static inline int blkcache_writeback(int iftype, int dev, bool enable)
+{
+	return 0;
+}
+
+static inline int blkcache_flush(int iftype, int dev)
+{
+	return 0;
+}
+
 static inline void blkcache_invalidate(int iftype, int dev) {}
 
 #endif
@@ -200,6 +299,24 @@ static inline void blkcache_invalidate(int iftype, int dev) {}
 #if CONFIG_IS_ENABLED(BLK)
 struct udevice;
 
+/**
+ * struct blk_req - an asynchronous block read or write
+ *
+ * @start:	Start block number (0=first)
+ * @blkcnt:	Number of blocks to transfer
+ * @buffer:	Data buffer, which must stay valid until the request completes
+ * @write:	true to write @buffer to the device, false to read into it
+ * @result:	-EINPROGRESS while the request is queued or in flight, then
+ *		the number of blocks transferred or a -ve error number
+ */
+struct blk_req {
+	lbaint_t start;
+	lbaint_t blkcnt;
+	void *buffer;
+	bool write;
+	long result;
+};
+
 /* Operations on block devices */
 struct blk_ops {
 	/**
@@ -258,6 +375,32 @@ struct blk_ops {
 	 * @return 0 if OK, -ve on error
 	 */
 	int (*select_hwpart)(struct udevice *dev, int hwpart);
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	/**
+	 * submit() - start a read or write without waiting for it
+	 *
+	 * The uclass only calls this when no other request is in flight on
+	 * the device, so a driver needs to track a single request at most.
+	 *
+	 * @dev:	Device to access
+	 * @req:	Request to start
+	 * @return 0 if the transfer was started, -ENOSYS if it cannot be
+	 * started asynchronously (the uclass then performs it with read() or
+	 * write()), other -ve error number on failure
+	 */
+	int (*submit)(struct udevice *dev, struct blk_req *req);
+
+	/**
+	 * poll() - check whether a submitted request has completed
+	 *
+	 * @dev:	Device to check
+	 * @req:	Request previously passed to submit()
+	 * @return -EBUSY if the transfer is still in flight, 0 once it has
+	 * finished, with @req->result updated
+	 */
+	int (*poll)(struct udevice *dev, struct blk_req *req);
+#endif
 };
 
 #define blk_get_ops(dev)	((struct blk_ops *)(dev)->driver->ops)
@@ -275,6 +418,51 @@ unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
 			 lbaint_t blkcnt);
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+/**
+ * blk_submit() - queue a block read or write
+ *
+ * Up to CONFIG_BLK_ASYNC_QUEUE_DEPTH requests can be queued on each device.
+ * They are issued to the device in order, one at a time, so that the caller
+ * can prepare the next buffer while the controller moves data. If the driver
+ * cannot transfer asynchronously the request is completed before this
+ * function returns.
+ *
+ * blk_dread(), blk_dwrite() and blk_derase() complete all queued requests
+ * before doing anything else.
+ *
+ * @block_dev:	Block device to access
+ * @req:	Request to queue; @req->result is set to -EINPROGRESS
+ * @return 0 if queued, -EBUSY if the queue is full, other -ve on error
+ */
+int blk_submit(struct blk_desc *block_dev, struct blk_req *req);
+
+/**
+ * blk_poll() - advance the queue and check whether a request has completed
+ *
+ * @block_dev:	Block device the request was submitted to
+ * @req:	Request to check
+ * @return 0 if @req has completed (see @req->result), -EBUSY if not
+ */
+int blk_poll(struct blk_desc *block_dev, struct blk_req *req);
+
+/**
+ * blk_wait() - wait for a request to complete
+ *
+ * @block_dev:	Block device the request was submitted to
+ * @req:	Request to wait for
+ * @return @req->result, i.e. number of blocks transferred or -ve error
+ */
+long blk_wait(struct blk_desc *block_dev, struct blk_req *req);
+
+/**
+ * blk_sync() - wait for all queued requests on a device to complete
+ *
+ * @block_dev:	Block device to drain
+ */
+void blk_sync(struct blk_desc *block_dev);
+#endif
+
 /**
  * blk_find_device() - Find a block device
  *
@@ -15,6 +15,7 @@
 enum bootstage_flags {
 	BOOTSTAGEF_ERROR	= 1 << 0,	/* Error record */
 	BOOTSTAGEF_ALLOC	= 1 << 1,	/* Allocate an id */
+	BOOTSTAGEF_COUNT	= 1 << 2,	/* Count rather than a time */
 };
 
 /* bootstate sub-IDs used for kernel and ramdisk ranges */
@@ -201,6 +202,8 @@ enum bootstage_id {
 	BOOTSTATE_ID_ACCUM_DM_F,
 	BOOTSTATE_ID_ACCUM_DM_R,
 
+	BOOTSTAGE_ID_COUNT_DM_INDEX,
+
 	/* a few spare for the user, from here */
 	BOOTSTAGE_ID_USER,
 	BOOTSTAGE_ID_ALLOC,
@@ -305,6 +308,19 @@ uint32_t bootstage_start(enum bootstage_id id, const char *name);
  */
 uint32_t bootstage_accum(enum bootstage_id id);
 
+/**
+ * bootstage_count() - Record how many times something happened
+ *
+ * The record holds @count in place of a time, replacing any earlier count
+ * for the same id. It is shown separately in the report.
+ *
+ * @param id	Bootstage id to record this count against
+ * @param name	Textual name to display for this id in the report
+ * @param count	Number to record
+ * @return @count
+ */
+ulong bootstage_count(enum bootstage_id id, const char *name, ulong count);
+
 /* Print a report about boot time */
 void bootstage_report(void);
 
@@ -404,6 +420,12 @@ static inline uint32_t bootstage_accum(enum bootstage_id id)
 	return 0;
 }
 
+static inline ulong bootstage_count(enum bootstage_id id, const char *name,
+				    ulong count)
+{
+	return count;
+}
+
 static inline int bootstage_stash(void *base, int size)
 {
 	return 0;	/* Pretend to succeed */
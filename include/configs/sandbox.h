@@ -72,6 +72,9 @@
 #define CONFIG_BOOTP_SEND_HOSTNAME
 #define CONFIG_BOOTP_SERVERIP
 
+/* Room for a whole TFTP window, see dm_test_eth_tftp_window() */
+#define CONFIG_SYS_RX_ETH_BUFFER	8
+
 #ifndef SANDBOX_NO_SDL
 #define CONFIG_SANDBOX_SDL
 #endif
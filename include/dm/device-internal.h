@@ -94,6 +94,27 @@ int device_bind_by_name(struct udevice *parent, bool pre_reloc_only,
  */
 int device_probe(struct udevice *dev);
 
+/**
+ * device_probe_async() - Start probing a device
+ *
+ * This is like device_probe() except that a driver which returns
+ * -EINPROGRESS from its probe() method is left to finish in the background,
+ * through dm_probe_poll(). A later device_probe() waits for it. Without
+ * CONFIG_DM_PROBE_ASYNC, or before relocation, this waits as well.
+ *
+ * @dev: Pointer to device to probe
+ * @return 0 if probed or still being probed, -ve on error
+ */
+int device_probe_async(struct udevice *dev);
+
+/**
+ * dm_probe_poll() - Let devices being probed in the background progress
+ *
+ * This calls the probe_poll() method of the devices whose probe is pending.
+ * It is called each time a device is probed.
+ */
+void dm_probe_poll(void);
+
 /**
  * device_remove() - Remove a device, de-activating it
  *
@@ -61,6 +61,19 @@ struct driver_info;
  */
 #define DM_FLAG_OS_PREPARE		(1 << 10)
 
+/*
+ * Start probing the device in the background once driver model is set up
+ * after relocation. The driver's probe() method can return -EINPROGRESS to
+ * have probe_poll() called until the device is ready.
+ */
+#define DM_FLAG_PROBE_ASYNC		(1 << 11)
+
+/*
+ * Device is being probed: probe_poll() has not yet returned a result. The
+ * device keeps its sequence number meanwhile but is not active.
+ */
+#define DM_FLAG_PROBE_PENDING		(1 << 12)
+
 /*
  * One or multiple of these flags are passed to device_remove() so that
  * a selective device removal as specified by the remove-stage and the
@@ -119,6 +132,10 @@ enum {
  * @req_seq: Requested sequence number for this device (-1 = any)
  * @seq: Allocated sequence number for this device (-1 = none). This is set up
  * when the device is probed and will be unique within the device's uclass.
+ * @node_index: Used by uclass to find the device by its node
+ * @seq_index: Used by uclass to find the device by @seq
+ * @req_seq_index: Used by uclass to find the device by @req_seq
+ * @probe_node: Used to link devices whose probe is pending
  * @devres_head: List of memory allocations associated with this device.
  *		When CONFIG_DEVRES is enabled, devm_kmalloc() and friends will
  *		add to this list. Memory so-allocated will be freed
@@ -143,6 +160,14 @@ struct udevice {
 	uint32_t flags;
 	int req_seq;
 	int seq;
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	struct hlist_node node_index;
+	struct hlist_node seq_index;
+	struct hlist_node req_seq_index;
+#endif
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+	struct list_head probe_node;
+#endif
 #ifdef CONFIG_DEVRES
 	struct list_head devres_head;
 #endif
@@ -162,9 +187,17 @@ static inline int dev_of_offset(const struct udevice *dev)
 	return ofnode_to_offset(dev->node);
 }
 
+/**
+ * dev_set_ofnode() - Set the device-tree node of a bound device
+ *
+ * @dev:	Device to update
+ * @node:	New node for the device
+ */
+void dev_set_ofnode(struct udevice *dev, ofnode node);
+
 static inline void dev_set_of_offset(struct udevice *dev, int of_offset)
 {
-	dev->node = offset_to_ofnode(of_offset);
+	dev_set_ofnode(dev, offset_to_ofnode(of_offset));
 }
 
 static inline bool dev_has_of_node(struct udevice *dev)
@@ -206,7 +239,11 @@ struct udevice_id {
  * @of_match: List of compatible strings to match, and any identifying data
  * for each.
  * @bind: Called to bind a device to its driver
- * @probe: Called to probe a device, i.e. activate it
+ * @probe: Called to probe a device, i.e. activate it. This may return
+ * -EINPROGRESS if @probe_poll is provided, to finish the work later
+ * @probe_poll: Called to continue a probe which returned -EINPROGRESS. This
+ * must not wait: it returns -EINPROGRESS while the device is not yet ready,
+ * otherwise the result of the probe
  * @remove: Called to remove a device, i.e. de-activate it
  * @unbind: Called to unbind a device from its driver
  * @ofdata_to_platdata: Called before probe to decode device tree data
@@ -240,6 +277,7 @@ struct driver {
 	const struct udevice_id *of_match;
 	int (*bind)(struct udevice *dev);
 	int (*probe)(struct udevice *dev);
+	int (*probe_poll)(struct udevice *dev);
 	int (*remove)(struct udevice *dev);
 	int (*unbind)(struct udevice *dev);
 	int (*ofdata_to_platdata)(struct udevice *dev);
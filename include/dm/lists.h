@@ -61,6 +61,65 @@ int lists_bind_drivers(struct udevice *parent, bool pre_reloc_only);
 int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
 		   bool pre_reloc_only);
 
+/**
+ * struct dm_bind_entry - A driver which matches a device-tree node
+ *
+ * @offset: Offset of the node in the device tree
+ * @compat: Index of the node's compatible string which the driver matches
+ * @of_match: Index of that string in the driver's of_match table
+ * @driver: Index of the driver in dm_bind_table.drivers
+ */
+struct dm_bind_entry {
+	int offset;
+	u8 compat;
+	u8 of_match;
+	u16 driver;
+};
+
+/**
+ * struct dm_bind_table - Drivers for the nodes of a device tree
+ *
+ * This is generated by dtoc from the device tree and the driver sources when
+ * CONFIG_OF_BIND_TABLE is enabled, so that lists_bind_fdt() need not search
+ * the drivers. Since not all drivers are built, each compatible string can
+ * have several entries; the first driver that is built is used, as with a
+ * search.
+ *
+ * @fdt_size: Size of the device tree the table was generated from
+ * @fdt_crc: CRC32 of that device tree
+ * @drivers: Names of all drivers with an of_match table, sorted
+ * @unknown: For each driver, true if its compatible strings are not known
+ * @driver_count: Number of drivers
+ * @entries: Entries sorted by node offset, then compatible string, then the
+ *	order in which drivers are searched
+ * @entry_count: Number of entries
+ */
+struct dm_bind_table {
+	u32 fdt_size;
+	u32 fdt_crc;
+	const char *const *drivers;
+	const bool *unknown;
+	int driver_count;
+	const struct dm_bind_entry *entries;
+	int entry_count;
+};
+
+extern const struct dm_bind_table dm_bind_table;
+
+/**
+ * lists_bind_table_init() - Set up use of the bind table
+ *
+ * This checks that the table generated by dtoc matches the device tree and
+ * the drivers which are built in, and finds the drivers it names. If not,
+ * lists_bind_fdt() searches the drivers as usual.
+ *
+ * @blob: Device tree which is to be scanned
+ * @return 0 if the table can be used, -ESTALE if it was generated from
+ * another device tree, -EPERM if a driver it does not cover is built in,
+ * -ENOMEM if out of memory
+ */
+int lists_bind_table_init(const void *blob);
+
 /**
  * device_bind_driver() - bind a device to a driver
  *
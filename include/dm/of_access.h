@@ -412,6 +412,21 @@ int of_count_phandle_with_args(const struct device_node *np,
  */
 int of_alias_scan(void);
 
+/**
+ * of_index_build() - Index the phandles and compatible strings of a tree
+ *
+ * This builds a hash table of the nodes by phandle and another of the
+ * compatible strings of all nodes, so that of_find_node_by_phandle() and
+ * of_find_compatible_node() need not walk the whole tree. The index is used
+ * as long as @root is the live tree in use. Changes to the "phandle" or
+ * "compatible" properties made after this are not seen by those functions.
+ *
+ * @root:	Root of the tree, which must be gd->of_root
+ * @return 0 if OK, -ENOMEM if not enough memory, -EINVAL if @root is not
+ * the tree in use
+ */
+int of_index_build(struct device_node *root);
+
 /**
  * of_alias_get_id - Get alias id for the given device_node
  *
@@ -95,6 +95,17 @@ int dm_scan_other(bool pre_reloc_only);
  */
 int dm_init_and_scan(bool pre_reloc_only);
 
+/**
+ * dm_probe_async() - Start probing devices which can finish in the background
+ *
+ * This calls device_probe_async() for each device below @parent whose driver
+ * has the DM_FLAG_PROBE_ASYNC flag. It is called by dm_init_and_scan() after
+ * relocation. A device which fails to probe is skipped.
+ *
+ * @parent: Device whose descendants are probed
+ */
+void dm_probe_async(struct udevice *parent);
+
 /**
  * dm_init() - Initialise Driver Model structures
  *
@@ -61,6 +61,9 @@ enum {
 /* The number added to the ping total on each probe */
 #define DM_TEST_START_TOTAL	5
 
+/* Number of calls to probe_poll() needed to probe test_async_drv */
+#define DM_TEST_ASYNC_STEPS	3
+
 /**
  * struct dm_test_priv - private data for the test devices
  */
@@ -70,6 +73,7 @@ struct dm_test_priv {
 	int uclass_flag;
 	int uclass_total;
 	int uclass_postp;
+	int probe_steps;
 };
 
 /**
@@ -196,6 +196,20 @@ int uclass_unbind_device(struct udevice *dev);
 static inline int uclass_unbind_device(struct udevice *dev) { return 0; }
 #endif
 
+/**
+ * uclass_index_device() - Update the lookup tables for a device
+ *
+ * This must be called when the node or sequence numbers of a device bound
+ * to a uclass change, so that it can still be found by them.
+ *
+ * @dev:	Pointer to the device
+ */
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+void uclass_index_device(struct udevice *dev);
+#else
+static inline void uclass_index_device(struct udevice *dev) {}
+#endif
+
 /**
  * uclass_pre_probe_device() - Deal with a device that is about to be probed
  *
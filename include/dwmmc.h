@@ -8,6 +8,7 @@
 #define __DWMMC_HW_H
 
 #include <asm/io.h>
+#include <bouncebuf.h>
 #include <mmc.h>
 
 #define DWMCI_CTRL		0x000
@@ -195,6 +196,14 @@ struct dwmci_host {
 
 	/* use fifo mode to read and write data */
 	bool fifo_mode;
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	/* DMA transfer left running by send_cmd_start() */
+	struct bounce_buffer async_bbstate;
+	struct dwmci_idmac *async_idmac;
+	ulong async_start;
+	unsigned int async_timeout;
+#endif
 };
 
 struct dwmci_idmac {
@@ -255,6 +255,10 @@ struct env_driver {
 
 extern struct hsearch_data env_htab;
 
+/* The default environment sorted by name, see CONFIG_ENV_DEFAULT_TABLE */
+extern const struct hsearch_base env_default_table[];
+extern const unsigned int env_default_count;
+
 /* Function that updates CRC of the enironment */
 void env_crc_update(void);
 
@@ -33,4 +33,12 @@ extern void (*fastboot_progress_callback)(const char *msg);
  */
 void fastboot_getvar(char *cmd_parameter, char *response);
 
+/**
+ * fastboot_max_download_size() - return the largest download accepted
+ *
+ * Return: Size of the download buffer, or the largest size the protocol
+ * allows if the next download is streamed to a partition
+ */
+u32 fastboot_max_download_size(void);
+
 #endif
@@ -35,4 +35,47 @@ void fastboot_mmc_flash_write(const char *cmd, void *download_buffer,
  * @response: Pointer to fastboot response buffer
  */
 void fastboot_mmc_erase(const char *cmd, char *response);
+
+/**
+ * fastboot_mmc_stream_open() - Select the partition to stream downloads to
+ *
+ * @cmd: Named partition to write downloads to
+ * @response: Pointer to fastboot response buffer, written on failure
+ * @return 0 if OK, -ve on error
+ */
+int fastboot_mmc_stream_open(const char *cmd, char *response);
+
+/**
+ * fastboot_mmc_stream_start() - Start writing a download to the partition
+ *
+ * @response: Pointer to fastboot response buffer, written on failure
+ * @return 0 if OK, -ve on error
+ */
+int fastboot_mmc_stream_start(char *response);
+
+/**
+ * fastboot_mmc_stream_write() - Write the next piece of the download
+ *
+ * Errors are held back until fastboot_mmc_stream_close().
+ *
+ * @data: Pointer to received data, which is not used after returning
+ * @len: Length of received data
+ */
+void fastboot_mmc_stream_write(const void *data, u32 len);
+
+/**
+ * fastboot_mmc_stream_close() - Complete writing the download
+ *
+ * @response: Pointer to fastboot response buffer, written on failure
+ * @return 0 if the whole image was written, -ve on error
+ */
+int fastboot_mmc_stream_close(char *response);
+
+/**
+ * fastboot_mmc_stream_match() - Check the partition being streamed to
+ *
+ * @cmd: Partition name to compare with
+ * @return true if downloads are streamed to @cmd
+ */
+bool fastboot_mmc_stream_match(const char *cmd);
 #endif
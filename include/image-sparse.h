@@ -24,6 +24,30 @@ struct sparse_storage {
 				 lbaint_t blkcnt);
 
 	void		(*mssg)(const char *str, char *response);
+
+	/*
+	 * Optional: erase blocks so that they read back as zero. Requests
+	 * are aligned to @erase_blks, which is 0 if this is not possible.
+	 * Returns the number of blocks erased.
+	 */
+	lbaint_t	erase_blks;
+	lbaint_t	(*erase)(struct sparse_storage *info,
+				 lbaint_t blk,
+				 lbaint_t blkcnt);
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	/*
+	 * Optional: queue a write described by @req and return at once.
+	 * When both are provided, write_sparse_image() keeps several writes
+	 * in flight and gathers small chunks into larger transfers.
+	 */
+	int		(*submit)(struct sparse_storage *info,
+				  struct blk_req *req);
+
+	/* Wait for a queued write; returns the number of blocks written */
+	long		(*wait)(struct sparse_storage *info,
+				struct blk_req *req);
+#endif
 };
 
 static inline int is_sparse_image(void *buf)
@@ -39,3 +63,42 @@ static inline int is_sparse_image(void *buf)
 
 int write_sparse_image(struct sparse_storage *info, const char *part_name,
 		       void *data, char *response);
+
+struct sparse_stream;
+
+/**
+ * sparse_stream_start() - Start writing an image that arrives in pieces
+ *
+ * The image may be sparse or raw, which is decided from its first bytes.
+ * @info and @part_name must remain valid until sparse_stream_finish().
+ *
+ * @info:	Storage to write to
+ * @part_name:	Name of the partition, for messages
+ * @return stream state, or NULL if out of memory
+ */
+struct sparse_stream *sparse_stream_start(struct sparse_storage *info,
+					  const char *part_name);
+
+/**
+ * sparse_stream_write() - Write the next piece of the image
+ *
+ * The data is copied, so @data may be reused as soon as this returns.
+ * Once an error has been reported further pieces are ignored.
+ *
+ * @s:		Stream state
+ * @data:	Next piece of the image
+ * @len:	Size of the piece in bytes, which can be anything
+ * @response:	Buffer for the message passed to info->mssg() on error
+ * @return 0 if OK, -ve on error
+ */
+int sparse_stream_write(struct sparse_stream *s, const void *data,
+			size_t len, char *response);
+
+/**
+ * sparse_stream_finish() - Complete the image and free the stream state
+ *
+ * @s:		Stream state
+ * @response:	Buffer for the message passed to info->mssg() on error
+ * @return 0 if the whole image was written, -ve on error
+ */
+int sparse_stream_finish(struct sparse_stream *s, char *response);
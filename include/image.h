@@ -301,11 +301,13 @@ enum {
 	IH_COMP_LZMA,			/* lzma  Compression Used	*/
 	IH_COMP_LZO,			/* lzo   Compression Used	*/
 	IH_COMP_LZ4,			/* lz4   Compression Used	*/
+	IH_COMP_ZSTD,			/* zstd  Compression Used	*/
 
 	IH_COMP_COUNT,
 };
 
 #define LZ4F_MAGIC	0x184D2204	/* LZ4 Magic Number		*/
+#define ZSTD_FRAME_MAGIC 0xFD2FB528	/* Zstandard Magic Number	*/
 #define IH_MAGIC	0x27051956	/* Image Magic Number		*/
 #define IH_NMLEN		32	/* Image Name Length		*/
 
@@ -73,6 +73,7 @@
 
 
 #define SD_DATA_4BIT	0x00040000
+#define SD_DATA_STAT_AFTER_ERASE	0x00800000
 
 #define IS_SD(x)	((x)->version & SD_VERSION_SD)
 #define IS_MMC(x)	((x)->version & MMC_VERSION_MMC)
@@ -218,6 +219,7 @@ static inline bool mmc_is_tuning_cmd(uint cmdidx)
 #define EXT_CSD_ERASE_GROUP_DEF		175	/* R/W */
 #define EXT_CSD_BOOT_BUS_WIDTH		177
 #define EXT_CSD_PART_CONF		179	/* R/W */
+#define EXT_CSD_ERASED_MEM_CONT		181	/* RO */
 #define EXT_CSD_BUS_WIDTH		183	/* R/W */
 #define EXT_CSD_HS_TIMING		185	/* R/W */
 #define EXT_CSD_REV			192	/* RO */
@@ -226,6 +228,7 @@ static inline bool mmc_is_tuning_cmd(uint cmdidx)
 #define EXT_CSD_HC_WP_GRP_SIZE		221	/* RO */
 #define EXT_CSD_HC_ERASE_GRP_SIZE	224	/* RO */
 #define EXT_CSD_BOOT_MULT		226	/* RO */
+#define EXT_CSD_SEC_FEATURE_SUPPORT	231	/* RO */
 #define EXT_CSD_BKOPS_SUPPORT		502	/* RO */
 
 /*
@@ -290,6 +293,8 @@ static inline bool mmc_is_tuning_cmd(uint cmdidx)
 
 #define EXT_CSD_HS_CTRL_REL	(1 << 0)	/* host controlled WR_REL_SET */
 
+#define EXT_CSD_SEC_GB_CL_EN	BIT(4)		/* TRIM is supported */
+
 #define EXT_CSD_WR_DATA_REL_USR		(1 << 0)	/* user data area WR_REL */
 #define EXT_CSD_WR_DATA_REL_GP(x)	(1 << ((x)+1))	/* GP part (x+1) WR_REL */
 
@@ -461,6 +466,37 @@ struct dm_mmc_ops {
 	 */
 	int (*wait_dat0)(struct udevice *dev, int state, int timeout);
 #endif
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	/**
+	 * send_cmd_start() - Send a data command without waiting for the data
+	 *
+	 * This sends the command and collects its response, then leaves the
+	 * controller moving the data by DMA. The transfer must be finished
+	 * with send_cmd_poll() before any other command is sent.
+	 *
+	 * @dev:	Device to receive the command
+	 * @cmd:	Command to send
+	 * @data:	Data to send/receive
+	 * @return 0 if the data transfer is running, -ENOSYS if this
+	 * transfer cannot be done in the background (the caller must use
+	 * send_cmd() instead), other -ve on error
+	 */
+	int (*send_cmd_start)(struct udevice *dev, struct mmc_cmd *cmd,
+			      struct mmc_data *data);
+
+	/**
+	 * send_cmd_poll() - Check whether a data transfer has finished
+	 *
+	 * @dev:	Device to check
+	 * @cmd:	Command passed to send_cmd_start()
+	 * @data:	Data passed to send_cmd_start()
+	 * @return -EBUSY if the transfer is still running, 0 once it has
+	 * completed successfully, other -ve on error
+	 */
+	int (*send_cmd_poll)(struct udevice *dev, struct mmc_cmd *cmd,
+			     struct mmc_data *data);
+#endif
 };
 
 #define mmc_get_ops(dev)        ((struct dm_mmc_ops *)(dev)->driver->ops)
@@ -473,6 +509,10 @@ int dm_mmc_get_cd(struct udevice *dev);
 int dm_mmc_get_wp(struct udevice *dev);
 int dm_mmc_execute_tuning(struct udevice *dev, uint opcode);
 int dm_mmc_wait_dat0(struct udevice *dev, int state, int timeout);
+int dm_mmc_send_cmd_start(struct udevice *dev, struct mmc_cmd *cmd,
+			  struct mmc_data *data);
+int dm_mmc_send_cmd_poll(struct udevice *dev, struct mmc_cmd *cmd,
+			 struct mmc_data *data);
 
 /* Transition functions for compatibility */
 int mmc_set_ios(struct mmc *mmc);
@@ -561,6 +601,23 @@ static inline bool supports_uhs(uint caps)
 #endif
 }
 
+/**
+ * struct mmc_async - state of an asynchronous block request
+ *
+ * @req:	Request being transferred, NULL if none
+ * @cmd:	Read/write command for the current chunk
+ * @data:	Data descriptor for the current chunk
+ * @done:	Number of blocks of @req already transferred
+ * @in_flight:	true while the controller is transferring the current chunk
+ */
+struct mmc_async {
+	struct blk_req *req;
+	struct mmc_cmd cmd;
+	struct mmc_data data;
+	lbaint_t done;
+	bool in_flight;
+};
+
 /*
  * With CONFIG_DM_MMC enabled, struct mmc can be accessed from the MMC device
  * with mmc_get_mmc_dev().
@@ -599,6 +656,8 @@ struct mmc {
 #if CONFIG_IS_ENABLED(MMC_WRITE)
 	uint write_bl_len;
 	uint erase_grp_size;	/* in 512-byte sectors */
+	bool trim_supported;	/* eMMC supports TRIM */
+	bool erase_zeroes;	/* erased blocks read back as zero */
 #endif
 #if CONFIG_IS_ENABLED(MMC_HW_PARTITIONING)
 	uint hc_wp_grp_size;	/* in 512-byte sectors */
@@ -639,6 +698,9 @@ struct mmc {
 				  * accessing the boot partitions
 				  */
 	u32 quirks;
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	struct mmc_async async;	/* request being handled by mmc_blk_submit() */
+#endif
 };
 
 struct mmc_hwpart_conf {
@@ -788,6 +850,45 @@ int mmc_rpmb_route_frames(struct mmc *mmc, void *req, unsigned long reqlen,
 int mmc_set_bkops_enable(struct mmc *mmc);
 #endif
 
+/**
+ * mmc_erase_zero_blks() - check whether discarding can be used to zero blocks
+ *
+ * @mmc:	MMC device
+ * @return the alignment, in blocks, that mmc_bdiscard() requests must have
+ * for the discarded blocks to read back as zero, or 0 if the card does not
+ * guarantee that
+ */
+#if CONFIG_IS_ENABLED(MMC_WRITE)
+lbaint_t mmc_erase_zero_blks(struct mmc *mmc);
+#else
+static inline lbaint_t mmc_erase_zero_blks(struct mmc *mmc)
+{
+	return 0;
+}
+#endif
+
+/**
+ * mmc_bdiscard() - discard blocks whose contents are no longer needed
+ *
+ * Unlike blk_derase(), which always erases whole erase groups, this uses
+ * TRIM on eMMC parts that support it.
+ *
+ * @block_dev:	MMC block device
+ * @start:	First block to discard
+ * @blkcnt:	Number of blocks to discard
+ * @return number of blocks discarded, or -1 on error
+ */
+#if CONFIG_IS_ENABLED(MMC_WRITE)
+ulong mmc_bdiscard(struct blk_desc *block_dev, lbaint_t start,
+		   lbaint_t blkcnt);
+#else
+static inline ulong mmc_bdiscard(struct blk_desc *block_dev, lbaint_t start,
+				 lbaint_t blkcnt)
+{
+	return -1;
+}
+#endif
+
 /**
  * Start device initialization and return immediately; it does not block on
  * polling OCR (operation condition register) status. Useful for checking
@@ -110,6 +110,9 @@ enum eth_recv_flags {
 	ETH_RECV_CHECK_DEVICE		= 1 << 0,
 };
 
+/* Largest number of packets eth_rx() processes at one time */
+#define ETH_RX_BUDGET	32
+
 /**
  * struct eth_ops - functions of Ethernet MAC controllers
  *
@@ -120,6 +123,11 @@ enum eth_recv_flags {
  *	 indicate that the hardware receive FIFO is empty. If 0 is returned, the
  *	 network stack will not process the empty packet, but free_pkt() will be
  *	 called if supplied
+ * recv_batch: Hand over up to "budget" received packets at once, setting
+ *	       their buffers and lengths in the packets and lengths arrays, and
+ *	       return how many there are. The stack processes them in order,
+ *	       calling free_pkt() for each one as soon as it is done with it.
+ *	       Used instead of recv when supplied - optional
  * free_pkt: Give the driver an opportunity to manage its packet buffer memory
  *	     when the network stack is finished processing it. This will only be
  *	     called when no error was returned from recv - optional
@@ -140,6 +148,8 @@ struct eth_ops {
 	int (*start)(struct udevice *dev);
 	int (*send)(struct udevice *dev, void *packet, int length);
 	int (*recv)(struct udevice *dev, int flags, uchar **packetp);
+	int (*recv_batch)(struct udevice *dev, int flags, uchar **packets,
+			  int *lengths, int budget);
 	int (*free_pkt)(struct udevice *dev, uchar *packet, int length);
 	void (*stop)(struct udevice *dev);
 	int (*mcast)(struct udevice *dev, const u8 *enetaddr, int join);
@@ -281,7 +291,7 @@ int eth_send(void *packet, int length);	   /* Send a packet */
 int eth_receive(void *packet, int length); /* Receive a packet*/
 extern void (*push_packet)(void *packet, int length);
 #endif
-int eth_rx(void);			/* Check for received packets */
+int eth_rx(void);			/* Process received packets */
 void eth_halt(void);			/* stop SCC */
 const char *eth_get_name(void);		/* get name of current device */
 int eth_mcast_join(struct in_addr mcast_addr, int join);
@@ -345,6 +355,7 @@ struct vlan_ethernet_hdr {
 #define PROT_PPP_SES	0x8864		/* PPPoE session messages	*/
 
 #define IPPROTO_ICMP	 1	/* Internet Control Message Protocol	*/
+#define IPPROTO_TCP	 6	/* Transmission Control Protocol	*/
 #define IPPROTO_UDP	17	/* User Datagram Protocol		*/
 
 /*
@@ -530,7 +541,7 @@ extern int		net_restart_wrap;	/* Tried all network devices */
 
 enum proto_t {
 	BOOTP, RARP, ARP, TFTPGET, DHCP, PING, DNS, NFS, CDP, NETCONS, SNTP,
-	TFTPSRV, TFTPPUT, LINKLOCAL, FASTBOOT, WOL
+	TFTPSRV, TFTPPUT, LINKLOCAL, FASTBOOT, WOL, WGET
 };
 
 extern char	net_boot_file_name[1024];/* Boot File name */
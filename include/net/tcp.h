@@ -0,0 +1,151 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Minimal TCP client
+ *
+ * One connection at a time, enough to fetch a file from a web server: the
+ * data we send must fit in one segment, received data is handed over in
+ * order as it arrives.
+ */
+
+#ifndef __TCP_H__
+#define __TCP_H__
+
+#include <net.h>
+
+/*
+ *	Internet Protocol (IP) + TCP header, without options.
+ */
+struct ip_tcp_hdr {
+	u8		ip_hl_v;	/* header length and version	*/
+	u8		ip_tos;		/* type of service		*/
+	u16		ip_len;		/* total length			*/
+	u16		ip_id;		/* identification		*/
+	u16		ip_off;		/* fragment offset field	*/
+	u8		ip_ttl;		/* time to live			*/
+	u8		ip_p;		/* protocol			*/
+	u16		ip_sum;		/* checksum			*/
+	struct in_addr	ip_src;		/* Source IP address		*/
+	struct in_addr	ip_dst;		/* Destination IP address	*/
+	u16		tcp_src;	/* TCP source port		*/
+	u16		tcp_dst;	/* TCP destination port		*/
+	u32		tcp_seq;	/* Sequence number		*/
+	u32		tcp_ack;	/* Acknowledgment number	*/
+	u8		tcp_hlen;	/* Header length in words << 4	*/
+	u8		tcp_flags;	/* TCP_FIN, TCP_SYN, ...	*/
+	u16		tcp_win;	/* Receive window		*/
+	u16		tcp_xsum;	/* Checksum			*/
+	u16		tcp_urg;	/* Urgent pointer		*/
+} __attribute__((packed));
+
+#define IP_TCP_HDR_SIZE		(sizeof(struct ip_tcp_hdr))
+#define TCP_HDR_SIZE		(IP_TCP_HDR_SIZE - IP_HDR_SIZE)
+
+#define TCP_FIN		0x01
+#define TCP_SYN		0x02
+#define TCP_RST		0x04
+#define TCP_PUSH	0x08
+#define TCP_ACK		0x10
+
+/* Largest segment we accept, for a 1500-byte Ethernet MTU */
+#define TCP_MSS		1460
+
+enum tcp_event {
+	TCP_CONNECTED,		/* Handshake done, tcp_send() may be used */
+	TCP_PEER_CLOSED,	/* All the peer's data has been received */
+	TCP_RESET,		/* The peer reset the connection */
+	TCP_TIMEDOUT,		/* The peer stopped acknowledging our data */
+};
+
+/**
+ * tcp_rx_hand_f - handle data received in sequence
+ *
+ * @data:	Received bytes
+ * @offset:	Position of @data in the stream, 0 for the first byte
+ * @len:	Number of bytes at @data
+ */
+typedef void tcp_rx_hand_f(uchar *data, unsigned int offset, unsigned int len);
+
+/**
+ * tcp_event_hand_f - handle a change in the state of the connection
+ *
+ * @event:	What happened
+ */
+typedef void tcp_event_hand_f(enum tcp_event event);
+
+/**
+ * tcp_connect() - open a connection
+ *
+ * The handshake is carried on from net_loop(). Any previous connection is
+ * dropped.
+ *
+ * @dest:	Address of the peer
+ * @dport:	Port to connect to
+ * @rx:		Called with the data received
+ * @event:	Called when the connection changes state
+ */
+void tcp_connect(struct in_addr dest, int dport, tcp_rx_hand_f *rx,
+		 tcp_event_hand_f *event);
+
+/**
+ * tcp_send() - send data on an established connection
+ *
+ * The data is kept and sent again until the peer acknowledges it.
+ *
+ * @data:	Data to send
+ * @len:	Number of bytes, at most TCP_MSS
+ * @return 0 if sent, -ENOTCONN if not connected, -EBUSY if earlier data is
+ * still unacknowledged, -E2BIG if @len is too large
+ */
+int tcp_send(const void *data, int len);
+
+/**
+ * tcp_close() - close our side of the connection
+ *
+ * A FIN is sent and the connection is forgotten: the peer is not waited for.
+ */
+void tcp_close(void);
+
+/**
+ * tcp_abort() - forget the connection without telling the peer
+ *
+ * This is called when net_loop() finishes, so that nothing is sent for a
+ * connection that is no longer in use.
+ */
+void tcp_abort(void);
+
+/**
+ * tcp_set_tcp_header() - fill in the IP and TCP headers of a segment
+ *
+ * This is called by net_send_ip_packet() for IPPROTO_TCP. Any data must
+ * already be in place after an IP_TCP_HDR_SIZE header.
+ *
+ * @pkt:	Start of the IP header
+ * @dest:	Destination address
+ * @dport:	Destination port
+ * @sport:	Source port
+ * @payload_len: Number of data bytes
+ * @action:	TCP flags
+ * @tcp_seq_num: Sequence number
+ * @tcp_ack_num: Acknowledgment number, used with TCP_ACK
+ * @return size of the IP and TCP headers
+ */
+int tcp_set_tcp_header(uchar *pkt, struct in_addr dest, int dport, int sport,
+		       int payload_len, u8 action, u32 tcp_seq_num,
+		       u32 tcp_ack_num);
+
+/**
+ * tcp_receive() - process a received TCP segment
+ *
+ * @ip:		IP header of the segment
+ * @len:	Length of the IP packet
+ */
+void tcp_receive(struct ip_tcp_hdr *ip, int len);
+
+/**
+ * tcp_poll() - send delayed acknowledgments and retransmit
+ *
+ * This is called from net_loop() after each batch of received packets.
+ */
+void tcp_poll(void);
+
+#endif /* __TCP_H__ */
@@ -0,0 +1,12 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * HTTP download over TCP
+ */
+
+#ifndef __WGET_H__
+#define __WGET_H__
+
+/* wget.c */
+void wget_start(void);	/* Begin HTTP GET of net_boot_file_name */
+
+#endif /* __WGET_H__ */
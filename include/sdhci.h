@@ -319,6 +319,9 @@ struct sdhci_host {
 	struct sdhci_adma_desc *adma_desc_table;
 	uint desc_slot;
 #endif
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	ulong async_start;	/* get_timer() value when DMA was started */
+#endif
 };
 
 #ifdef CONFIG_MMC_SDHCI_IO_ACCESSORS
@@ -41,6 +41,12 @@ typedef struct entry {
 /* Opaque type for internal use.  */
 struct _ENTRY;
 
+/* Read-only entry of a base table, see himport_base_r() */
+struct hsearch_base {
+	const char *key;
+	const char *data;
+};
+
 /*
  * Family of hash table handling functions.  The functions also
  * have reentrant counterparts ending with _r.  The non-reentrant
@@ -61,6 +67,18 @@ struct hsearch_data {
  */
 	int (*change_ok)(const ENTRY *__item, const char *newval, enum env_op,
 		int flag);
+/*
+ * Optional read-only table, sorted by key, whose entries are found as if
+ * they were in the hash table. An entry is only copied into the hash table
+ * when its data is changed; base_hidden[] marks the entries which have been
+ * copied or deleted.
+ */
+	const struct hsearch_base *base;
+	unsigned int base_count;
+	char *base_hidden;
+	ENTRY base_entry;	/* returned when a base entry is found */
+	/* searches in progress; the table is not resized while one is */
+	unsigned int busy;
 };
 
 /* Create a new hash table which will contain at most "__nel" elements.  */
@@ -74,6 +92,9 @@ extern void hdestroy_r(struct hsearch_data *__htab);
  * ACTION is `FIND' return found entry or signal error by returning
  * NULL.  If ACTION is `ENTER' replace existing data (if any) with
  * __item.data.
+ *
+ * An entry found in the base table is returned in __htab->base_entry,
+ * which is only valid until the next search and has no callback or flags.
  * */
 extern int hsearch_r(ENTRY __item, ACTION __action, ENTRY ** __retval,
 		     struct hsearch_data *__htab, int __flag);
@@ -102,6 +123,17 @@ extern int himport_r(struct hsearch_data *__htab,
 		     int __flag, int __crlf_is_lf, int nvars,
 		     char * const vars[]);
 
+/*
+ * Import a read-only table of __count entries sorted by key, which are
+ * looked up in place until they are changed. Any existing entries are
+ * removed. With H_HIDE_BASE, the base entries are hidden until an entry
+ * with the same key and data is entered, e.g. by himport_r() with
+ * H_NOCLEAR, so that only entries with other data are copied.
+ */
+extern int himport_base_r(struct hsearch_data *__htab,
+			  const struct hsearch_base *__base,
+			  unsigned int __count, int __flag);
+
 /* Walk the whole table calling the callback on each element */
 extern int hwalk_r(struct hsearch_data *__htab, int (*callback)(ENTRY *));
 
@@ -119,5 +151,6 @@ extern int hwalk_r(struct hsearch_data *__htab, int (*callback)(ENTRY *));
 #define H_MATCH_METHOD	(H_MATCH_IDENT | H_MATCH_SUBSTR | H_MATCH_REGEX)
 #define H_PROGRAMMATIC	(1 << 9) /* indicate that an import is from env_set() */
 #define H_ORIGIN_FLAGS	(H_INTERACTIVE | H_PROGRAMMATIC)
+#define H_HIDE_BASE	(1 << 10) /* himport_base_r(): start with all hidden */
 
 #endif /* _SEARCH_H_ */
@@ -29,6 +29,7 @@ void crc16_ccitt_wd_buf(const uint8_t *in, uint len,
 uint32_t crc32 (uint32_t, const unsigned char *, uint);
 uint32_t crc32_wd (uint32_t, const unsigned char *, uint, uint);
 uint32_t crc32_no_comp (uint32_t, const unsigned char *, uint);
+uint32_t crc32_no_comp_generic(uint32_t, const unsigned char *, uint);
 
 /**
  * crc32_wd_buf - Perform CRC32 on a buffer and return result in buffer
@@ -44,5 +45,9 @@ void crc32_wd_buf(const unsigned char *input, uint ilen,
 /* lib/crc32c.c */
 void crc32c_init(uint32_t *, uint32_t);
 uint32_t crc32c_cal(uint32_t, const char *, int, uint32_t *);
+uint32_t crc32c_cal_generic(uint32_t, const char *, int, uint32_t *);
+
+/* Bit-reflected CRC32C (Castagnoli) polynomial */
+#define CRC32C_POLY_LE	0x82F63B78
 
 #endif /* _UBOOT_CRC_H */
@@ -94,6 +94,18 @@ void sha1_hmac(const unsigned char *key, int keylen,
 		const unsigned char *input, unsigned int ilen,
 		unsigned char *output);
 
+/**
+ * \brief	   Hash whole 64-byte blocks into the SHA-1 state
+ *
+ * \param ctx	   SHA-1 context
+ * \param data	   buffer holding the data
+ * \param blocks   number of 64-byte blocks in the buffer
+ */
+void sha1_process(sha1_context *ctx, const unsigned char *data,
+		  unsigned int blocks);
+void sha1_process_generic(sha1_context *ctx, const unsigned char *data,
+			  unsigned int blocks);
+
 /**
  * \brief	   Checkup routine
  *
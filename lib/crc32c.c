@@ -12,9 +12,10 @@
 
 #include <common.h>
 #include <compiler.h>
+#include <u-boot/crc.h>
 
-uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
-		    uint32_t *crc32c_table)
+uint32_t crc32c_cal_generic(uint32_t crc, const char *data, int length,
+			    uint32_t *crc32c_table)
 {
 	while (length--)
 		crc = crc32c_table[(u8)(crc ^ *data++)] ^ (crc >> 8);
@@ -22,6 +23,16 @@ uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
 	return crc;
 }
 
+/*
+ * Architectures with CRC32C instructions provide their own version of this.
+ * They can tell a CRC32C table from the polynomial in crc32c_table[128].
+ */
+__weak uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
+			   uint32_t *crc32c_table)
+{
+	return crc32c_cal_generic(crc, data, length, crc32c_table);
+}
+
 void crc32c_init(uint32_t *crc32c_table, uint32_t pol)
 {
 	int i, j;
@@ -69,14 +69,41 @@ int gzip_parse_header(const unsigned char *src, unsigned long len)
 	return i;
 }
 
+static int __zunzip(void *dst, int dstlen, unsigned char *src,
+		    unsigned long *lenp, int stoponerr, int offset,
+		    unsigned long *usedp);
+
+/*
+ * A gzip file may hold several members (e.g. from 'cat a.gz b.gz' or
+ * 'pigz --independent'). They are uncompressed one after the other, each
+ * right after the output of the previous one.
+ */
 int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
 {
-	int offset = gzip_parse_header(src, *lenp);
-
-	if (offset < 0)
-		return offset;
-
-	return zunzip(dst, dstlen, src, lenp, 1, offset);
+	unsigned long srclen = *lenp, outlen = 0, len, used;
+	int offset, ret;
+
+	while (1) {
+		offset = gzip_parse_header(src, srclen);
+		if (offset < 0)
+			return offset;
+
+		len = srclen;
+		ret = __zunzip(dst + outlen, dstlen - outlen, src, &len, 1,
+			       offset, &used);
+		outlen += len;
+		*lenp = outlen;
+		if (ret)
+			return ret;
+
+		/* skip the CRC32 and ISIZE trailer */
+		used += 8;
+		if (used + 10 > srclen || src[used] != (u8)HEADER0 ||
+		    src[used + 1] != (u8)HEADER1)
+			return 0;
+		src += used;
+		srclen -= used;
+	}
 }
 
 #ifdef CONFIG_CMD_UNZIP
@@ -274,6 +301,14 @@ out:
  */
 int zunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
 						int stoponerr, int offset)
+{
+	return __zunzip(dst, dstlen, src, lenp, stoponerr, offset, NULL);
+}
+
+/* As zunzip(), also returning the number of input bytes used in @usedp */
+static int __zunzip(void *dst, int dstlen, unsigned char *src,
+		    unsigned long *lenp, int stoponerr, int offset,
+		    unsigned long *usedp)
 {
 	z_stream s;
 	int err = 0;
@@ -301,6 +336,8 @@ int zunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
 		}
 	} while (r == Z_BUF_ERROR);
 	*lenp = s.next_out - (unsigned char *) dst;
+	if (usedp)
+		*usedp = s.next_in - src;
 	inflateEnd(&s);
 
 	return err;
@@ -68,6 +68,33 @@ typedef struct _ENTRY {
 static void _hdelete(const char *key, struct hsearch_data *htab, ENTRY *ep,
 	int idx);
 
+/*
+ * Compute the first index to try for a key. This is also stored in the
+ * used field of the entry, see hsearch_r().
+ */
+static unsigned int hhash(const char *key, unsigned int size)
+{
+	unsigned int len = strlen(key);
+	unsigned int hval = len;
+	unsigned int count = len;
+
+	/* Compute an value for the given string. Perhaps use a better method. */
+	while (count-- > 0) {
+		hval <<= 4;
+		hval += key[count];
+	}
+
+	/*
+	 * First hash function:
+	 * simply take the modul but prevent zero.
+	 */
+	hval %= size;
+	if (hval == 0)
+		++hval;
+
+	return hval;
+}
+
 /*
  * hcreate()
  */
@@ -161,6 +188,186 @@ void hdestroy_r(struct hsearch_data *htab)
 
 	/* the sign for an existing table is an value != NULL in htable */
 	htab->table = NULL;
+
+	/* drop the base table too */
+	free(htab->base_hidden);
+	htab->base = NULL;
+	htab->base_count = 0;
+	htab->base_hidden = NULL;
+}
+
+/*
+ * Move the entries into a new table for at least nel elements, leaving
+ * out the deleted slots. This is done when the table gets too full for
+ * the double hashing to find free slots quickly.
+ */
+static int hresize(struct hsearch_data *htab, unsigned int nel)
+{
+	_ENTRY *table;
+	unsigned int i;
+
+	nel |= 1;		/* make odd */
+	while (!isprime(nel))
+		nel += 2;
+
+	table = calloc(nel + 1, sizeof(_ENTRY));
+	if (table == NULL)
+		return 0;
+
+	debug("hresize: table %p, %d -> %d entries\n", htab, htab->size, nel);
+	for (i = 1; i <= htab->size; ++i) {
+		unsigned int hval, hval2, idx;
+
+		if (htab->table[i].used <= 0)
+			continue;
+
+		hval = hhash(htab->table[i].entry.key, nel);
+		hval2 = 1 + hval % (nel - 2);
+		for (idx = hval; table[idx].used;) {
+			if (idx <= hval2)
+				idx = nel + idx - hval2;
+			else
+				idx -= hval2;
+		}
+		table[idx].used = hval;
+		table[idx].entry = htab->table[i].entry;
+	}
+	free(htab->table);
+	htab->table = table;
+	htab->size = nel;
+
+	return 1;
+}
+
+/*
+ * Base table
+ */
+
+/*
+ * The base table holds read-only entries which are found in place, e.g. the
+ * default environment built into the image. When the data of a base entry
+ * is changed, the entry is copied into the hash table and hidden in the
+ * base table, so a key is never found in both. Deleting a base entry just
+ * hides it.
+ */
+
+/* Return the index of a key in the base table, or -1 if it is not there */
+static int hbase_find(struct hsearch_data *htab, const char *key)
+{
+	int lo = 0;
+	int hi = htab->base_count;
+
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		int cmp = strcmp(key, htab->base[mid].key);
+
+		if (cmp == 0)
+			return mid;
+		if (cmp < 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	return -1;
+}
+
+/* Fill in an ENTRY for base entry i, with its callback and flags */
+static void hbase_init_entry(struct hsearch_data *htab, int i, ENTRY *ep)
+{
+	ep->key = htab->base[i].key;
+	ep->data = (char *)htab->base[i].data;
+	ep->callback = NULL;
+	ep->flags = 0;
+	env_callback_init(ep);
+	env_flags_init(ep);
+}
+
+/* Return base entry i as found by hsearch_r(), valid until the next search */
+static ENTRY *hbase_entry(struct hsearch_data *htab, int i)
+{
+	ENTRY *ep = &htab->base_entry;
+
+	ep->key = htab->base[i].key;
+	ep->data = (char *)htab->base[i].data;
+	ep->callback = NULL;
+	ep->flags = 0;
+
+	return ep;
+}
+
+/* Check a change to base entry i as would be done for the hash table */
+static int hbase_change_ok(struct hsearch_data *htab, int i,
+			   const char *newval, enum env_op op, int flag)
+{
+	ENTRY e;
+
+	hbase_init_entry(htab, i, &e);
+
+	/* check for permission */
+	if (htab->change_ok != NULL &&
+	    htab->change_ok(&e, newval, op, flag)) {
+		debug("change_ok() rejected changing variable "
+			"%s, skipping it!\n", e.key);
+		__set_errno(EPERM);
+		return 0;
+	}
+
+	/* If there is a callback, call it */
+	if (e.callback && e.callback(e.key, newval, op, flag)) {
+		debug("callback() rejected changing variable "
+			"%s, skipping it!\n", e.key);
+		__set_errno(EINVAL);
+		return 0;
+	}
+
+	return 1;
+}
+
+int himport_base_r(struct hsearch_data *htab,
+		   const struct hsearch_base *base, unsigned int count,
+		   int flag)
+{
+	unsigned int i;
+
+	/* Test for correct arguments.  */
+	if (htab == NULL) {
+		__set_errno(EINVAL);
+		return 0;
+	}
+
+	if (htab->table)
+		hdestroy_r(htab);
+
+	/* the hash table only needs room for the changed entries */
+	if (hcreate_r(CONFIG_ENV_MIN_ENTRIES, htab) == 0)
+		return 0;
+
+	htab->base_hidden = calloc(count + 1, 1);
+	if (htab->base_hidden == NULL) {
+		hdestroy_r(htab);
+		__set_errno(ENOMEM);
+		return 0;
+	}
+	htab->base = base;
+	htab->base_count = count;
+
+	if (flag & H_HIDE_BASE) {
+		memset(htab->base_hidden, 1, count);
+		return 1;
+	}
+
+	/* check each entry as if it were entered by himport_r() */
+	for (i = 0; i < count; i++) {
+		if (!hbase_change_ok(htab, i, base[i].data, env_op_create,
+				     flag)) {
+			printf("himport_base_r: can't insert \"%s=%s\" into hash table\n",
+			       base[i].key, base[i].data);
+			htab->base_hidden[i] = 1;
+		}
+	}
+
+	return 1;
 }
 
 /*
@@ -206,7 +413,7 @@ int hmatch_r(const char *match, int last_idx, ENTRY ** retval,
 	unsigned int idx;
 	size_t key_len = strlen(match);
 
-	for (idx = last_idx + 1; idx < htab->size; ++idx) {
+	for (idx = last_idx + 1; idx <= htab->size; ++idx) {
 		if (htab->table[idx].used <= 0)
 			continue;
 		if (!strncmp(match, htab->table[idx].entry.key, key_len)) {
@@ -215,6 +422,18 @@ int hmatch_r(const char *match, int last_idx, ENTRY ** retval,
 		}
 	}
 
+	/* base entries follow the hash table */
+	for (; idx <= htab->size + htab->base_count; ++idx) {
+		int i = idx - htab->size - 1;
+
+		if (htab->base_hidden[i])
+			continue;
+		if (!strncmp(match, htab->base[i].key, key_len)) {
+			*retval = hbase_entry(htab, i);
+			return idx;
+		}
+	}
+
 	__set_errno(ESRCH);
 	*retval = NULL;
 	return 0;
@@ -270,31 +489,46 @@ static inline int _compare_and_overwrite_entry(ENTRY item, ACTION action,
 	return -1;
 }
 
-int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
-	      struct hsearch_data *htab, int flag)
+static int _hsearch_r(ENTRY item, ACTION action, ENTRY **retval,
+		      struct hsearch_data *htab, int flag)
 {
 	unsigned int hval;
-	unsigned int count;
-	unsigned int len = strlen(item.key);
 	unsigned int idx;
 	unsigned int first_deleted = 0;
+	int bidx = -1;
+	int copy = 0;
 	int ret;
 
-	/* Compute an value for the given string. Perhaps use a better method. */
-	hval = len;
-	count = len;
-	while (count-- > 0) {
-		hval <<= 4;
-		hval += item.key[count];
-	}
-
 	/*
-	 * First hash function:
-	 * simply take the modul but prevent zero.
+	 * A key which is shown in the base table is not in the hash table.
+	 * It is only copied there if its data is changed; check that change
+	 * as an overwrite before looking for a free slot.
 	 */
-	hval %= htab->size;
-	if (hval == 0)
-		++hval;
+	if (htab->base)
+		bidx = hbase_find(htab, item.key);
+	if (bidx >= 0 && !htab->base_hidden[bidx]) {
+		const char *data = htab->base[bidx].data;
+
+		if (action == FIND || item.data == NULL ||
+		    !strcmp(item.data, data)) {
+			if (action == ENTER &&
+			    !hbase_change_ok(htab, bidx, data,
+					     env_op_overwrite, flag)) {
+				*retval = NULL;
+				return 0;
+			}
+			*retval = hbase_entry(htab, bidx);
+			return htab->size + 1 + bidx;
+		}
+		if (!hbase_change_ok(htab, bidx, item.data, env_op_overwrite,
+				     flag)) {
+			*retval = NULL;
+			return 0;
+		}
+		copy = 1;
+	}
+
+	hval = hhash(item.key, htab->size);
 
 	/* The first index tried. */
 	idx = hval;
@@ -351,6 +585,22 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 		while (htab->table[idx].used != USED_FREE);
 	}
 
+	/*
+	 * Not in the hash table. If it is entered with the data of a hidden
+	 * base entry, show that instead of making a copy.
+	 */
+	if (bidx >= 0 && !copy && action == ENTER && item.data &&
+	    !strcmp(item.data, htab->base[bidx].data)) {
+		if (!hbase_change_ok(htab, bidx, item.data, env_op_create,
+				     flag)) {
+			*retval = NULL;
+			return 0;
+		}
+		htab->base_hidden[bidx] = 0;
+		*retval = hbase_entry(htab, bidx);
+		return htab->size + 1 + bidx;
+	}
+
 	/* An empty bucket has been found. */
 	if (action == ENTER) {
 		/*
@@ -363,6 +613,7 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 			return 0;
 		}
 
+
 		/*
 		 * Create new entry;
 		 * create copies of item.key and item.data
@@ -387,6 +638,13 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 		/* Also look for flags */
 		env_flags_init(&htab->table[idx].entry);
 
+		/* A changed base entry has already been checked */
+		if (copy) {
+			htab->base_hidden[bidx] = 1;
+			*retval = &htab->table[idx].entry;
+			return idx;
+		}
+
 		/* check for permission */
 		if (htab->change_ok != NULL && htab->change_ok(
 		    &htab->table[idx].entry, item.data, env_op_create, flag)) {
@@ -420,6 +678,27 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 	return 0;
 }
 
+int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
+	      struct hsearch_data *htab, int flag)
+{
+	int ret;
+
+	/*
+	 * Grow the table before it gets full, so that a free slot is found
+	 * quickly. A search made from a callback must not move the entries,
+	 * since the search which called it still refers to one by index.
+	 */
+	if (action == ENTER && htab->table && !htab->busy &&
+	    (htab->filled + 1) * 4 > htab->size * 3)
+		hresize(htab, htab->size * 2);
+
+	htab->busy++;
+	ret = _hsearch_r(item, action, retval, htab, flag);
+	htab->busy--;
+
+	return ret;
+}
+
 
 /*
  * hdelete()
@@ -449,6 +728,7 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
 {
 	ENTRY e, *ep;
 	int idx;
+	int ret;
 
 	debug("hdelete: DELETE key \"%s\"\n", key);
 
@@ -460,6 +740,16 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
 		return 0;	/* not found */
 	}
 
+	/* A base entry is only hidden */
+	if (idx > htab->size) {
+		idx -= htab->size + 1;
+		if (!hbase_change_ok(htab, idx, NULL, env_op_delete, flag))
+			return 0;
+		debug("hdelete: HIDING base key \"%s\"\n", key);
+		htab->base_hidden[idx] = 1;
+		return 1;
+	}
+
 	/* Check for permission */
 	if (htab->change_ok != NULL &&
 	    htab->change_ok(ep, NULL, env_op_delete, flag)) {
@@ -469,13 +759,18 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
 		return 0;
 	}
 
-	/* If there is a callback, call it */
-	if (htab->table[idx].entry.callback &&
-	    htab->table[idx].entry.callback(key, NULL, env_op_delete, flag)) {
-		debug("callback() rejected deleting variable "
-			"%s, skipping it!\n", key);
-		__set_errno(EINVAL);
-		return 0;
+	/* If there is a callback, call it; the table must not move meanwhile */
+	if (htab->table[idx].entry.callback) {
+		htab->busy++;
+		ret = htab->table[idx].entry.callback(key, NULL, env_op_delete,
+						      flag);
+		htab->busy--;
+		if (ret) {
+			debug("callback() rejected deleting variable "
+				"%s, skipping it!\n", key);
+			__set_errno(EINVAL);
+			return 0;
+		}
 	}
 
 	_hdelete(key, htab, ep, idx);
@@ -563,6 +858,50 @@ static int match_string(int flag, const char *str, const char *pat, void *priv)
 	return 0;
 }
 
+/* Return the number of bytes needed to export an entry */
+static size_t hexport_len(ENTRY *ep, const char sep)
+{
+	size_t totlen = strlen(ep->key);
+
+	if (sep == '\0') {
+		totlen += strlen(ep->data);
+	} else {	/* check if escapes are needed */
+		char *s = ep->data;
+
+		while (*s) {
+			++totlen;
+			/* add room for needed escape chars */
+			if ((*s == sep) || (*s == '\\'))
+				++totlen;
+			++s;
+		}
+	}
+
+	return totlen + 2;	/* for '=' and 'sep' char */
+}
+
+/* Export an entry at p, returning the position after it */
+static char *hexport_entry(char *p, ENTRY *ep, const char sep)
+{
+	const char *s;
+
+	s = ep->key;
+	while (*s)
+		*p++ = *s++;
+	*p++ = '=';
+
+	s = ep->data;
+
+	while (*s) {
+		if ((*s == sep) || (*s == '\\'))
+			*p++ = '\\';	/* escape */
+		*p++ = *s++;
+	}
+	*p++ = sep;
+
+	return p;
+}
+
 static int match_entry(ENTRY *ep, int flag,
 		 int argc, char * const argv[])
 {
@@ -597,9 +936,10 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		 int argc, char * const argv[])
 {
 	ENTRY *list[htab->size];
+	int base_list[htab->base_count + 1];
 	char *res, *p;
 	size_t totlen;
-	int i, n;
+	int i, j, n, nb;
 
 	/* Test for correct arguments.  */
 	if ((resp == NULL) || (htab == NULL)) {
@@ -628,23 +968,26 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 
 			list[n++] = ep;
 
-			totlen += strlen(ep->key);
+			totlen += hexport_len(ep, sep);
+		}
+	}
 
-			if (sep == '\0') {
-				totlen += strlen(ep->data);
-			} else {	/* check if escapes are needed */
-				char *s = ep->data;
+	/* The base entries are already sorted */
+	for (i = 0, nb = 0; i < htab->base_count; ++i) {
+		ENTRY *ep;
 
-				while (*s) {
-					++totlen;
-					/* add room for needed escape chars */
-					if ((*s == sep) || (*s == '\\'))
-						++totlen;
-					++s;
-				}
-			}
-			totlen += 2;	/* for '=' and 'sep' char */
-		}
+		if (htab->base_hidden[i])
+			continue;
+
+		ep = hbase_entry(htab, i);
+		if ((argc > 0) && !match_entry(ep, flag, argc, argv))
+			continue;
+
+		if ((flag & H_HIDE_DOT) && ep->key[0] == '.')
+			continue;
+
+		base_list[nb++] = i;
+		totlen += hexport_len(ep, sep);
 	}
 
 #ifdef DEBUG
@@ -686,24 +1029,15 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 	}
 	/*
 	 * Pass 2:
-	 * export sorted list of result data
+	 * export sorted list of result data, merged with the base entries
 	 */
-	for (i = 0, p = res; i < n; ++i) {
-		const char *s;
-
-		s = list[i]->key;
-		while (*s)
-			*p++ = *s++;
-		*p++ = '=';
-
-		s = list[i]->data;
-
-		while (*s) {
-			if ((*s == sep) || (*s == '\\'))
-				*p++ = '\\';	/* escape */
-			*p++ = *s++;
-		}
-		*p++ = sep;
+	for (i = 0, j = 0, p = res; i < n || j < nb;) {
+		if (j == nb || (i < n &&
+		    strcmp(list[i]->key, htab->base[base_list[j]].key) < 0))
+			p = hexport_entry(p, list[i++], sep);
+		else
+			p = hexport_entry(p, hbase_entry(htab, base_list[j++]),
+					  sep);
 	}
 	*p = '\0';		/* terminate result */
 
@@ -981,13 +1315,29 @@ int hwalk_r(struct hsearch_data *htab, int (*callback)(ENTRY *))
 	int i;
 	int retval;
 
+	htab->busy++;
 	for (i = 1; i <= htab->size; ++i) {
 		if (htab->table[i].used > 0) {
 			retval = callback(&htab->table[i].entry);
 			if (retval)
-				return retval;
+				goto out;
 		}
 	}
 
-	return 0;
+	/* Base entries are passed in a copy, with their callback and flags */
+	for (i = 0; i < htab->base_count; ++i) {
+		ENTRY e;
+
+		if (htab->base_hidden[i])
+			continue;
+		hbase_init_entry(htab, i, &e);
+		retval = callback(&e);
+		if (retval)
+			goto out;
+	}
+	retval = 0;
+out:
+	htab->busy--;
+
+	return retval;
 }
@@ -43,29 +43,465 @@
 #include <sparse_format.h>
 
 #include <linux/math64.h>
+#include <linux/sizes.h>
+
+/* Largest single write, so that progress can be reported regularly */
+#define SPARSE_MAX_WRITE_SIZE	SZ_8M
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+#define SPARSE_QUEUE_DEPTH	CONFIG_BLK_ASYNC_QUEUE_DEPTH
+#endif
+
+/**
+ * struct sparse_writer - state of a sparse image write
+ *
+ * When the storage can write asynchronously, small RAW and FILL chunks that
+ * are adjacent on the device are gathered into one of two staging buffers
+ * and written as a single multi-block transfer, while the CPU goes on to
+ * parse the next chunks into the other buffer. Large RAW chunks are queued
+ * straight from the image.
+ *
+ * @info:	Storage being written
+ * @buf:	Staging / fill buffers, allocated on first use
+ * @buf_seq:	Number of writes issued when each buffer was last used
+ * @buf_blks:	Size of each buffer in blocks
+ * @cur:	Index of the buffer being filled
+ * @stage_blk:	First block covered by the current buffer
+ * @stage_cnt:	Number of blocks gathered in the current buffer
+ * @max_blks:	Largest number of blocks in a single write
+ * @issued:	Number of asynchronous writes issued
+ * @done:	Number of asynchronous writes known to have completed
+ * @req:	Ring of asynchronous writes in flight
+ */
+struct sparse_writer {
+	struct sparse_storage *info;
+	void *buf[2];
+	ulong buf_seq[2];
+	lbaint_t buf_blks;
+	int cur;
+	lbaint_t stage_blk;
+	lbaint_t stage_cnt;
+	lbaint_t max_blks;
+	ulong issued;
+	ulong done;
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	struct blk_req req[SPARSE_QUEUE_DEPTH];
+#endif
+};
+
+static bool sparse_async(struct sparse_writer *w)
+{
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	return w->info->submit && w->info->wait;
+#else
+	return false;
+#endif
+}
+
+/* Wait until the first @seq asynchronous writes have completed */
+static int sparse_wait(struct sparse_writer *w, ulong seq)
+{
+	int ret = 0;
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	struct blk_req *req;
+
+	while (w->done < seq) {
+		req = &w->req[w->done % SPARSE_QUEUE_DEPTH];
+		w->done++;
+		if (w->info->wait(w->info, req) != req->blkcnt && !ret) {
+			printf("%s: %s" LBAFU " [" LBAFU "]\n", __func__,
+			       "Write failed, block #", req->start,
+			       req->blkcnt);
+			ret = -EIO;
+		}
+	}
+#endif
+
+	return ret;
+}
+
+/*
+ * Write @blkcnt blocks, returning the number of blocks the storage advanced
+ * by or 0 on error. Asynchronous writes are only queued, so @buffer must
+ * not change until they complete.
+ */
+static lbaint_t sparse_write(struct sparse_writer *w, lbaint_t blk,
+			     lbaint_t blkcnt, const void *buffer)
+{
+	struct sparse_storage *info = w->info;
+	lbaint_t blks;
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	struct blk_req *req;
+
+	if (sparse_async(w)) {
+		if (w->issued - w->done == SPARSE_QUEUE_DEPTH &&
+		    sparse_wait(w, w->done + 1))
+			return 0;
+
+		req = &w->req[w->issued % SPARSE_QUEUE_DEPTH];
+		req->start = blk;
+		req->blkcnt = blkcnt;
+		req->buffer = (void *)buffer;
+		req->write = true;
+		if (info->submit(info, req)) {
+			printf("%s: %s" LBAFU "\n", __func__,
+			       "Cannot queue write, block #", blk);
+			return 0;
+		}
+		w->issued++;
+
+		return blkcnt;
+	}
+#endif
+
+	blks = info->write(info, blk, blkcnt, buffer);
+	/* blks might be > blkcnt (eg. NAND bad-blocks) */
+	if (blks < blkcnt) {
+		printf("%s: %s" LBAFU " [" LBAFU "]\n", __func__,
+		       "Write failed, block #", blk, blks);
+		return 0;
+	}
+
+	return blks;
+}
+
+/* Get the current buffer, once the storage has finished reading it */
+static void *sparse_get_buf(struct sparse_writer *w)
+{
+	struct sparse_storage *info = w->info;
+
+	if (sparse_wait(w, w->buf_seq[w->cur]))
+		return NULL;
+
+	if (!w->buf[w->cur])
+		w->buf[w->cur] = memalign(ARCH_DMA_MINALIGN,
+					  ROUNDUP(info->blksz * w->buf_blks,
+						  ARCH_DMA_MINALIGN));
+	if (!w->buf[w->cur])
+		printf("%s: Malloc failed\n", __func__);
+
+	return w->buf[w->cur];
+}
+
+/* Hand the current buffer to the storage and move on to the other one */
+static void sparse_next_buf(struct sparse_writer *w)
+{
+	w->buf_seq[w->cur] = w->issued;
+	if (sparse_async(w))
+		w->cur ^= 1;
+}
+
+static void sparse_fill(void *buf, uint32_t fill_val, size_t size)
+{
+	uint32_t *p = buf;
+	size_t i;
+
+	for (i = 0; i < size / sizeof(fill_val); i++)
+		p[i] = fill_val;
+}
+
+static int sparse_flush(struct sparse_writer *w)
+{
+	lbaint_t blks;
+
+	if (!w->stage_cnt)
+		return 0;
+
+	blks = sparse_write(w, w->stage_blk, w->stage_cnt, w->buf[w->cur]);
+	if (blks < w->stage_cnt)
+		return -EIO;
+	sparse_next_buf(w);
+	w->stage_cnt = 0;
+
+	return 0;
+}
+
+/*
+ * Gather @blkcnt blocks copied from @data, or filled with @fill_val if @data
+ * is NULL, into the staging buffers
+ */
+static int sparse_stage(struct sparse_writer *w, lbaint_t blk,
+			lbaint_t blkcnt, const void *data, uint32_t fill_val)
+{
+	lbaint_t blksz = w->info->blksz;
+	lbaint_t n;
+	void *dst;
+	int ret;
+
+	if (w->stage_cnt && w->stage_blk + w->stage_cnt != blk) {
+		ret = sparse_flush(w);
+		if (ret)
+			return ret;
+	}
+
+	while (blkcnt) {
+		if (!w->stage_cnt) {
+			if (!sparse_get_buf(w))
+				return -ENOMEM;
+			w->stage_blk = blk;
+		}
+
+		n = min(blkcnt, w->buf_blks - w->stage_cnt);
+		dst = w->buf[w->cur] + w->stage_cnt * blksz;
+		if (data) {
+			memcpy(dst, data, n * blksz);
+			data += n * blksz;
+		} else {
+			sparse_fill(dst, fill_val, n * blksz);
+		}
+		w->stage_cnt += n;
+		blk += n;
+		blkcnt -= n;
+
+		if (w->stage_cnt == w->buf_blks) {
+			ret = sparse_flush(w);
+			if (ret)
+				return ret;
+		}
+	}
+
+	return 0;
+}
+
+static int sparse_write_raw(struct sparse_writer *w, lbaint_t *blk,
+			    lbaint_t blkcnt, const void *data)
+{
+	lbaint_t blks;
+	lbaint_t n;
+	int ret;
+
+	if (sparse_async(w) && blkcnt < w->buf_blks) {
+		ret = sparse_stage(w, *blk, blkcnt, data, 0);
+		if (!ret)
+			*blk += blkcnt;
+		return ret;
+	}
+
+	ret = sparse_flush(w);
+	if (ret)
+		return ret;
+
+	while (blkcnt) {
+		n = min(blkcnt, w->max_blks);
+		blks = sparse_write(w, *blk, n, data);
+		if (blks < n)
+			return -EIO;
+		*blk += blks;
+		data += n * w->info->blksz;
+		blkcnt -= n;
+	}
+
+	return 0;
+}
+
+static int sparse_fill_blocks(struct sparse_writer *w, lbaint_t *blk,
+			      lbaint_t blkcnt, uint32_t fill_val)
+{
+	lbaint_t blks;
+	lbaint_t n;
+	void *buf;
+	int ret;
+
+	if (!blkcnt)
+		return 0;
+
+	if (sparse_async(w) && blkcnt < w->buf_blks) {
+		ret = sparse_stage(w, *blk, blkcnt, NULL, fill_val);
+		if (!ret)
+			*blk += blkcnt;
+		return ret;
+	}
+
+	ret = sparse_flush(w);
+	if (ret)
+		return ret;
+
+	buf = sparse_get_buf(w);
+	if (!buf)
+		return -ENOMEM;
+	sparse_fill(buf, fill_val, w->info->blksz * w->buf_blks);
+
+	while (blkcnt) {
+		n = min(blkcnt, w->buf_blks);
+		blks = sparse_write(w, *blk, n, buf);
+		if (blks < n)
+			return -EIO;
+		*blk += blks;
+		blkcnt -= n;
+	}
+	sparse_next_buf(w);
+
+	return 0;
+}
+
+/*
+ * Write a FILL chunk. Runs of zeroes large enough to cover whole erase units
+ * are erased rather than written, if the storage reads back erased blocks as
+ * zero; only the unaligned head and tail are written.
+ */
+static int sparse_write_fill(struct sparse_writer *w, lbaint_t *blk,
+			     lbaint_t blkcnt, uint32_t fill_val)
+{
+	struct sparse_storage *info = w->info;
+	lbaint_t end = *blk + blkcnt;
+	lbaint_t first, last, erased;
+	uint32_t rem;
+	int ret;
+
+	if (fill_val || !info->erase || !info->erase_blks)
+		return sparse_fill_blocks(w, blk, blkcnt, fill_val);
+
+	div_u64_rem(*blk, info->erase_blks, &rem);
+	first = rem ? *blk + info->erase_blks - rem : *blk;
+	div_u64_rem(end, info->erase_blks, &rem);
+	last = end - rem;
+	if (last <= first || last - first < max(info->erase_blks, w->buf_blks))
+		return sparse_fill_blocks(w, blk, blkcnt, 0);
+
+	ret = sparse_fill_blocks(w, blk, first - *blk, 0);
+	if (ret)
+		return ret;
+
+	/* Writes still queued must not land after the erase */
+	ret = sparse_flush(w);
+	if (!ret)
+		ret = sparse_wait(w, w->issued);
+	if (ret)
+		return ret;
+
+	erased = info->erase(info, first, last - first);
+	if (erased != last - first) {
+		printf("%s: Erase failed, block #" LBAFU ", writing zeroes\n",
+		       __func__, first);
+		erased = 0;
+	}
+	*blk += erased;
+
+	return sparse_fill_blocks(w, blk, end - *blk, 0);
+}
 
 static void default_log(const char *ignored, char *response) {}
 
+static int sparse_check_header(struct sparse_storage *info,
+			       sparse_header_t *sparse_header, char *response)
+{
+	uint32_t offset;
+
+	debug("=== Sparse Image Header ===\n");
+	debug("magic: 0x%x\n", sparse_header->magic);
+	debug("major_version: 0x%x\n", sparse_header->major_version);
+	debug("minor_version: 0x%x\n", sparse_header->minor_version);
+	debug("file_hdr_sz: %d\n", sparse_header->file_hdr_sz);
+	debug("chunk_hdr_sz: %d\n", sparse_header->chunk_hdr_sz);
+	debug("blk_sz: %d\n", sparse_header->blk_sz);
+	debug("total_blks: %d\n", sparse_header->total_blks);
+	debug("total_chunks: %d\n", sparse_header->total_chunks);
+
+	if (sparse_header->file_hdr_sz < sizeof(sparse_header_t) ||
+	    sparse_header->chunk_hdr_sz < sizeof(chunk_header_t)) {
+		printf("%s: Sparse image header too short\n", __func__);
+		info->mssg("sparse image header issue", response);
+		return -1;
+	}
+
+	/*
+	 * Verify that the sparse block size is a multiple of our
+	 * storage backend block size
+	 */
+	div_u64_rem(sparse_header->blk_sz, info->blksz, &offset);
+	if (offset) {
+		printf("%s: Sparse image block size issue [%u]\n",
+		       __func__, sparse_header->blk_sz);
+		info->mssg("sparse image block size issue", response);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Check a chunk header against the image and the room left on the storage */
+static int sparse_check_chunk(struct sparse_storage *info,
+			      sparse_header_t *sparse_header,
+			      chunk_header_t *chunk_header, lbaint_t blk,
+			      char *response)
+{
+	unsigned int chunk_data_sz;
+	lbaint_t blkcnt;
+
+	if (chunk_header->chunk_type != CHUNK_TYPE_RAW) {
+		debug("=== Chunk Header ===\n");
+		debug("chunk_type: 0x%x\n", chunk_header->chunk_type);
+		debug("chunk_data_sz: 0x%x\n", chunk_header->chunk_sz);
+		debug("total_size: 0x%x\n", chunk_header->total_sz);
+	}
+
+	chunk_data_sz = sparse_header->blk_sz * chunk_header->chunk_sz;
+	blkcnt = chunk_data_sz / info->blksz;
+	switch (chunk_header->chunk_type) {
+	case CHUNK_TYPE_RAW:
+		if (chunk_header->total_sz !=
+		    (sparse_header->chunk_hdr_sz + chunk_data_sz)) {
+			info->mssg("Bogus chunk size for chunk type Raw",
+				   response);
+			return -1;
+		}
+		break;
+
+	case CHUNK_TYPE_FILL:
+		if (chunk_header->total_sz !=
+		    (sparse_header->chunk_hdr_sz + sizeof(uint32_t))) {
+			info->mssg("Bogus chunk size for chunk type FILL", response);
+			return -1;
+		}
+		break;
+
+	case CHUNK_TYPE_DONT_CARE:
+		return 0;
+
+	case CHUNK_TYPE_CRC32:
+		if (chunk_header->total_sz != sparse_header->chunk_hdr_sz) {
+			info->mssg("Bogus chunk size for chunk type Dont Care",
+				   response);
+			return -1;
+		}
+		return 0;
+
+	default:
+		printf("%s: Unknown chunk type: %x\n", __func__,
+		       chunk_header->chunk_type);
+		info->mssg("Unknown chunk type", response);
+		return -1;
+	}
+
+	if (blk + blkcnt > info->start + info->size) {
+		printf("%s: Request would exceed partition size!\n", __func__);
+		info->mssg("Request would exceed partition size!", response);
+		return -1;
+	}
+
+	return 0;
+}
+
 int write_sparse_image(struct sparse_storage *info,
 		       const char *part_name, void *data, char *response)
 {
+	struct sparse_writer writer = { .info = info };
+	struct sparse_writer *w = &writer;
 	lbaint_t blk;
 	lbaint_t blkcnt;
-	lbaint_t blks;
 	uint32_t bytes_written = 0;
 	unsigned int chunk;
-	unsigned int offset;
 	unsigned int chunk_data_sz;
-	uint32_t *fill_buf = NULL;
 	uint32_t fill_val;
 	sparse_header_t *sparse_header;
 	chunk_header_t *chunk_header;
 	uint32_t total_blocks = 0;
-	int fill_buf_num_blks;
-	int i;
-	int j;
+	int ret = -1;
+	int err;
 
-	fill_buf_num_blks = CONFIG_IMAGE_SPARSE_FILLBUF_SIZE / info->blksz;
+	w->buf_blks = CONFIG_IMAGE_SPARSE_FILLBUF_SIZE / info->blksz;
+	w->max_blks = max_t(lbaint_t, SPARSE_MAX_WRITE_SIZE / info->blksz,
+			    w->buf_blks);
 
 	/* Read and skip over sparse image header */
 	sparse_header = (sparse_header_t *)data;
@@ -82,27 +518,8 @@ int write_sparse_image(struct sparse_storage *info,
 	if (!info->mssg)
 		info->mssg = default_log;
 
-	debug("=== Sparse Image Header ===\n");
-	debug("magic: 0x%x\n", sparse_header->magic);
-	debug("major_version: 0x%x\n", sparse_header->major_version);
-	debug("minor_version: 0x%x\n", sparse_header->minor_version);
-	debug("file_hdr_sz: %d\n", sparse_header->file_hdr_sz);
-	debug("chunk_hdr_sz: %d\n", sparse_header->chunk_hdr_sz);
-	debug("blk_sz: %d\n", sparse_header->blk_sz);
-	debug("total_blks: %d\n", sparse_header->total_blks);
-	debug("total_chunks: %d\n", sparse_header->total_chunks);
-
-	/*
-	 * Verify that the sparse block size is a multiple of our
-	 * storage backend block size
-	 */
-	div_u64_rem(sparse_header->blk_sz, info->blksz, &offset);
-	if (offset) {
-		printf("%s: Sparse image block size issue [%u]\n",
-		       __func__, sparse_header->blk_sz);
-		info->mssg("sparse image block size issue", response);
+	if (sparse_check_header(info, sparse_header, response))
 		return -1;
-	}
 
 	puts("Flashing Sparse Image\n");
 
@@ -113,13 +530,6 @@ int write_sparse_image(struct sparse_storage *info,
 		chunk_header = (chunk_header_t *)data;
 		data += sizeof(chunk_header_t);
 
-		if (chunk_header->chunk_type != CHUNK_TYPE_RAW) {
-			debug("=== Chunk Header ===\n");
-			debug("chunk_type: 0x%x\n", chunk_header->chunk_type);
-			debug("chunk_data_sz: 0x%x\n", chunk_header->chunk_sz);
-			debug("total_size: 0x%x\n", chunk_header->total_sz);
-		}
-
 		if (sparse_header->chunk_hdr_sz > sizeof(chunk_header_t)) {
 			/*
 			 * Skip the remaining bytes in a header that is longer
@@ -129,99 +539,36 @@ int write_sparse_image(struct sparse_storage *info,
 				 sizeof(chunk_header_t));
 		}
 
+		if (sparse_check_chunk(info, sparse_header, chunk_header, blk,
+				       response))
+			goto out;
+
 		chunk_data_sz = sparse_header->blk_sz * chunk_header->chunk_sz;
 		blkcnt = chunk_data_sz / info->blksz;
 		switch (chunk_header->chunk_type) {
 		case CHUNK_TYPE_RAW:
-			if (chunk_header->total_sz !=
-			    (sparse_header->chunk_hdr_sz + chunk_data_sz)) {
-				info->mssg("Bogus chunk size for chunk type Raw",
-					   response);
-				return -1;
-			}
-
-			if (blk + blkcnt > info->start + info->size) {
-				printf(
-				    "%s: Request would exceed partition size!\n",
-				    __func__);
-				info->mssg("Request would exceed partition size!",
-					   response);
-				return -1;
-			}
-
-			blks = info->write(info, blk, blkcnt, data);
-			/* blks might be > blkcnt (eg. NAND bad-blocks) */
-			if (blks < blkcnt) {
-				printf("%s: %s" LBAFU " [" LBAFU "]\n",
-				       __func__, "Write failed, block #",
-				       blk, blks);
+			if (sparse_write_raw(w, &blk, blkcnt, data)) {
 				info->mssg("flash write failure", response);
-				return -1;
+				goto out;
 			}
-			blk += blks;
 			bytes_written += blkcnt * info->blksz;
 			total_blocks += chunk_header->chunk_sz;
 			data += chunk_data_sz;
 			break;
 
 		case CHUNK_TYPE_FILL:
-			if (chunk_header->total_sz !=
-			    (sparse_header->chunk_hdr_sz + sizeof(uint32_t))) {
-				info->mssg("Bogus chunk size for chunk type FILL", response);
-				return -1;
-			}
-
-			fill_buf = (uint32_t *)
-				   memalign(ARCH_DMA_MINALIGN,
-					    ROUNDUP(
-						info->blksz * fill_buf_num_blks,
-						ARCH_DMA_MINALIGN));
-			if (!fill_buf) {
-				info->mssg("Malloc failed for: CHUNK_TYPE_FILL",
-					   response);
-				return -1;
-			}
-
 			fill_val = *(uint32_t *)data;
 			data = (char *)data + sizeof(uint32_t);
 
-			for (i = 0;
-			     i < (info->blksz * fill_buf_num_blks /
-				  sizeof(fill_val));
-			     i++)
-				fill_buf[i] = fill_val;
-
-			if (blk + blkcnt > info->start + info->size) {
-				printf(
-				    "%s: Request would exceed partition size!\n",
-				    __func__);
-				info->mssg("Request would exceed partition size!",
-					   response);
-				return -1;
-			}
-
-			for (i = 0; i < blkcnt;) {
-				j = blkcnt - i;
-				if (j > fill_buf_num_blks)
-					j = fill_buf_num_blks;
-				blks = info->write(info, blk, j, fill_buf);
-				/* blks might be > j (eg. NAND bad-blocks) */
-				if (blks < j) {
-					printf("%s: %s " LBAFU " [%d]\n",
-					       __func__,
-					       "Write failed, block #",
-					       blk, j);
-					info->mssg("flash write failure",
-						   response);
-					free(fill_buf);
-					return -1;
-				}
-				blk += blks;
-				i += j;
+			err = sparse_write_fill(w, &blk, blkcnt, fill_val);
+			if (err) {
+				info->mssg(err == -ENOMEM ?
+					   "Malloc failed for: CHUNK_TYPE_FILL" :
+					   "flash write failure", response);
+				goto out;
 			}
 			bytes_written += blkcnt * info->blksz;
 			total_blocks += chunk_data_sz / sparse_header->blk_sz;
-			free(fill_buf);
 			break;
 
 		case CHUNK_TYPE_DONT_CARE:
@@ -230,32 +577,412 @@ int write_sparse_image(struct sparse_storage *info,
 			break;
 
 		case CHUNK_TYPE_CRC32:
-			if (chunk_header->total_sz !=
-			    sparse_header->chunk_hdr_sz) {
-				info->mssg("Bogus chunk size for chunk type Dont Care",
-					   response);
-				return -1;
-			}
 			total_blocks += chunk_header->chunk_sz;
 			data += chunk_data_sz;
 			break;
-
-		default:
-			printf("%s: Unknown chunk type: %x\n", __func__,
-			       chunk_header->chunk_type);
-			info->mssg("Unknown chunk type", response);
-			return -1;
 		}
 	}
 
+	if (sparse_flush(w) || sparse_wait(w, w->issued)) {
+		info->mssg("flash write failure", response);
+		goto out;
+	}
+
 	debug("Wrote %d blocks, expected to write %d blocks\n",
 	      total_blocks, sparse_header->total_blks);
 	printf("........ wrote %u bytes to '%s'\n", bytes_written, part_name);
 
 	if (total_blocks != sparse_header->total_blks) {
 		info->mssg("sparse image write failure", response);
-		return -1;
+		goto out;
+	}
+
+	ret = 0;
+out:
+	/* Nothing may be left reading the buffers once they are freed */
+	sparse_wait(w, w->issued);
+	free(w->buf[0]);
+	free(w->buf[1]);
+
+	return ret;
+}
+
+#if CONFIG_IS_ENABLED(IMAGE_SPARSE_STREAM)
+enum sparse_stream_state {
+	SPARSE_STREAM_FILE_HDR,
+	SPARSE_STREAM_CHUNK_HDR,
+	SPARSE_STREAM_RAW,
+	SPARSE_STREAM_FILL,
+	SPARSE_STREAM_DONE,
+};
+
+/**
+ * struct sparse_stream - state of an image written as it arrives
+ *
+ * Data is handed over in pieces of any size, so headers are gathered until
+ * they are complete and RAW data is copied into the writer's staging
+ * buffers, with a partial block held back until the rest of it arrives.
+ * An image that does not start with the sparse magic is written as is.
+ *
+ * @w:		Writer for the storage
+ * @part_name:	Name of the partition, for messages
+ * @state:	What the next bytes of the image hold
+ * @sparse_header: Sparse image header
+ * @chunk_header: Header of the current chunk
+ * @fill_val:	Fill value of the current FILL chunk
+ * @hdr_len:	Number of bytes gathered of the header or fill value
+ * @skip:	Number of bytes to drop before the next part of the image
+ * @remaining:	Number of bytes left in the current RAW chunk
+ * @blk:	Next block to write
+ * @part:	Partial block of RAW data
+ * @part_len:	Number of bytes held in @part
+ * @raw:	The image is not sparse
+ * @chunk:	Number of chunks handled
+ * @total_blocks: Number of sparse blocks handled
+ * @bytes_written: Number of bytes written to the storage
+ * @err:	First error seen, after which the rest of the image is dropped
+ */
+struct sparse_stream {
+	struct sparse_writer w;
+	const char *part_name;
+	enum sparse_stream_state state;
+	sparse_header_t sparse_header;
+	chunk_header_t chunk_header;
+	uint32_t fill_val;
+	size_t hdr_len;
+	size_t skip;
+	u64 remaining;
+	lbaint_t blk;
+	void *part;
+	size_t part_len;
+	bool raw;
+	unsigned int chunk;
+	uint32_t total_blocks;
+	u64 bytes_written;
+	int err;
+};
+
+struct sparse_stream *sparse_stream_start(struct sparse_storage *info,
+					  const char *part_name)
+{
+	struct sparse_stream *s;
+
+	s = calloc(1, sizeof(*s));
+	if (!s)
+		return NULL;
+
+	s->part = malloc(info->blksz);
+	if (!s->part) {
+		free(s);
+		return NULL;
+	}
+
+	if (!info->mssg)
+		info->mssg = default_log;
+
+	s->w.info = info;
+	s->w.buf_blks = CONFIG_IMAGE_SPARSE_FILLBUF_SIZE / info->blksz;
+	s->w.max_blks = max_t(lbaint_t, SPARSE_MAX_WRITE_SIZE / info->blksz,
+			      s->w.buf_blks);
+	s->part_name = part_name;
+	s->blk = info->start;
+
+	return s;
+}
+
+/* Gather part of a header or fill value, returning the bytes consumed */
+static size_t sparse_stream_gather(struct sparse_stream *s, void *dst,
+				   size_t size, const void *data, size_t len)
+{
+	size_t n = min(size - s->hdr_len, len);
+
+	memcpy(dst + s->hdr_len, data, n);
+	s->hdr_len += n;
+
+	return n;
+}
+
+/* Stage whole blocks of RAW data, keeping any partial block back */
+static int sparse_stream_raw(struct sparse_stream *s, const void *data,
+			     size_t len, char *response)
+{
+	struct sparse_storage *info = s->w.info;
+	lbaint_t blksz = info->blksz;
+	lbaint_t blkcnt;
+	size_t n;
+	int ret;
+
+	blkcnt = (s->part_len + len) / blksz;
+	if (s->blk + blkcnt > info->start + info->size) {
+		printf("%s: Request would exceed partition size!\n", __func__);
+		info->mssg("Request would exceed partition size!", response);
+		return -EFBIG;
+	}
+
+	if (s->part_len) {
+		n = min(blksz - s->part_len, len);
+		memcpy(s->part + s->part_len, data, n);
+		s->part_len += n;
+		data += n;
+		len -= n;
+		if (s->part_len < blksz)
+			return 0;
+
+		ret = sparse_stage(&s->w, s->blk, 1, s->part, 0);
+		if (ret)
+			goto err;
+		s->blk++;
+		s->part_len = 0;
+	}
+
+	blkcnt = len / blksz;
+	if (blkcnt) {
+		ret = sparse_stage(&s->w, s->blk, blkcnt, data, 0);
+		if (ret)
+			goto err;
+		s->blk += blkcnt;
+	}
+
+	s->part_len = len - blkcnt * blksz;
+	memcpy(s->part, data + blkcnt * blksz, s->part_len);
+
+	return 0;
+
+err:
+	info->mssg("flash write failure", response);
+	return ret;
+}
+
+/* Act on a complete chunk header */
+static int sparse_stream_chunk(struct sparse_stream *s, char *response)
+{
+	struct sparse_storage *info = s->w.info;
+	sparse_header_t *sparse_header = &s->sparse_header;
+	chunk_header_t *chunk_header = &s->chunk_header;
+	unsigned int chunk_data_sz;
+
+	if (sparse_check_chunk(info, sparse_header, chunk_header, s->blk,
+			       response))
+		return -EINVAL;
+
+	s->skip = sparse_header->chunk_hdr_sz - sizeof(chunk_header_t);
+	s->hdr_len = 0;
+	chunk_data_sz = sparse_header->blk_sz * chunk_header->chunk_sz;
+	switch (chunk_header->chunk_type) {
+	case CHUNK_TYPE_RAW:
+		/* No data will come to finish an empty chunk */
+		if (!chunk_data_sz)
+			break;
+		s->remaining = chunk_data_sz;
+		s->state = SPARSE_STREAM_RAW;
+		return 0;
+
+	case CHUNK_TYPE_FILL:
+		s->state = SPARSE_STREAM_FILL;
+		return 0;
+
+	case CHUNK_TYPE_DONT_CARE:
+		s->blk += info->reserve(info, s->blk,
+					chunk_data_sz / info->blksz);
+		break;
+
+	case CHUNK_TYPE_CRC32:
+		s->skip += chunk_data_sz;
+		break;
 	}
 
+	s->total_blocks += chunk_header->chunk_sz;
+	s->chunk++;
+	if (s->chunk == sparse_header->total_chunks)
+		s->state = SPARSE_STREAM_DONE;
+
 	return 0;
 }
+
+/* Finish the current RAW or FILL chunk */
+static void sparse_stream_next_chunk(struct sparse_stream *s)
+{
+	struct sparse_storage *info = s->w.info;
+	unsigned int chunk_data_sz;
+
+	chunk_data_sz = s->sparse_header.blk_sz * s->chunk_header.chunk_sz;
+	s->bytes_written += chunk_data_sz;
+	s->total_blocks += s->chunk_header.chunk_sz;
+	s->hdr_len = 0;
+	s->chunk++;
+	if (s->chunk == s->sparse_header.total_chunks)
+		s->state = SPARSE_STREAM_DONE;
+	else
+		s->state = SPARSE_STREAM_CHUNK_HDR;
+
+	debug("%s: chunk %u done, next block " LBAFU "\n", __func__,
+	      s->chunk, s->blk - info->start);
+}
+
+/* Start on the image once its first bytes are known */
+static int sparse_stream_begin(struct sparse_stream *s, char *response)
+{
+	sparse_header_t *sparse_header = &s->sparse_header;
+
+	if (!is_sparse_image(sparse_header)) {
+		s->raw = true;
+		s->state = SPARSE_STREAM_RAW;
+		printf("Flashing Raw Image\n");
+		return sparse_stream_raw(s, sparse_header, s->hdr_len,
+					 response);
+	}
+
+	if (sparse_check_header(s->w.info, sparse_header, response))
+		return -EINVAL;
+
+	puts("Flashing Sparse Image\n");
+	s->skip = sparse_header->file_hdr_sz - sizeof(sparse_header_t);
+	s->hdr_len = 0;
+	s->state = sparse_header->total_chunks ? SPARSE_STREAM_CHUNK_HDR :
+						 SPARSE_STREAM_DONE;
+
+	return 0;
+}
+
+int sparse_stream_write(struct sparse_stream *s, const void *data,
+			size_t len, char *response)
+{
+	size_t n;
+	int ret = 0;
+
+	if (s->err)
+		return s->err;
+
+	while (len && !ret) {
+		if (s->skip) {
+			n = min_t(size_t, s->skip, len);
+			s->skip -= n;
+			data += n;
+			len -= n;
+			continue;
+		}
+
+		switch (s->state) {
+		case SPARSE_STREAM_FILE_HDR:
+			n = sparse_stream_gather(s, &s->sparse_header,
+						 sizeof(sparse_header_t),
+						 data, len);
+			if (s->hdr_len == sizeof(sparse_header_t))
+				ret = sparse_stream_begin(s, response);
+			break;
+
+		case SPARSE_STREAM_CHUNK_HDR:
+			n = sparse_stream_gather(s, &s->chunk_header,
+						 sizeof(chunk_header_t),
+						 data, len);
+			if (s->hdr_len == sizeof(chunk_header_t))
+				ret = sparse_stream_chunk(s, response);
+			break;
+
+		case SPARSE_STREAM_RAW:
+			n = s->raw ? len : min_t(u64, s->remaining, len);
+			ret = sparse_stream_raw(s, data, n, response);
+			if (s->raw)
+				break;
+			s->remaining -= n;
+			if (!s->remaining)
+				sparse_stream_next_chunk(s);
+			break;
+
+		case SPARSE_STREAM_FILL:
+			n = sparse_stream_gather(s, &s->fill_val,
+						 sizeof(uint32_t), data, len);
+			if (s->hdr_len < sizeof(uint32_t))
+				break;
+
+			ret = sparse_write_fill(&s->w, &s->blk,
+						s->sparse_header.blk_sz *
+						s->chunk_header.chunk_sz /
+						s->w.info->blksz,
+						s->fill_val);
+			if (ret) {
+				s->w.info->mssg(ret == -ENOMEM ?
+						"Malloc failed for: CHUNK_TYPE_FILL" :
+						"flash write failure", response);
+				break;
+			}
+			sparse_stream_next_chunk(s);
+			break;
+
+		default:
+			/* Padding after the last chunk */
+			n = len;
+			break;
+		}
+		data += n;
+		len -= n;
+	}
+
+	s->err = ret;
+
+	return ret;
+}
+
+int sparse_stream_finish(struct sparse_stream *s, char *response)
+{
+	struct sparse_storage *info = s->w.info;
+	struct sparse_writer *w = &s->w;
+	int ret = s->err;
+
+	if (ret)
+		goto out;
+
+	/* An image shorter than a sparse header cannot be sparse */
+	if (s->state == SPARSE_STREAM_FILE_HDR && s->hdr_len) {
+		ret = sparse_stream_begin(s, response);
+		if (ret)
+			goto out;
+	}
+
+	if (s->raw && s->part_len) {
+		/* Pad the last block of a raw image */
+		memset(s->part + s->part_len, 0, info->blksz - s->part_len);
+		if (s->blk >= info->start + info->size) {
+			info->mssg("Request would exceed partition size!",
+				   response);
+			ret = -EFBIG;
+			goto out;
+		}
+		if (sparse_stage(w, s->blk++, 1, s->part, 0)) {
+			info->mssg("flash write failure", response);
+			ret = -EIO;
+			goto out;
+		}
+	}
+
+	if (sparse_flush(w) || sparse_wait(w, w->issued)) {
+		info->mssg("flash write failure", response);
+		ret = -EIO;
+		goto out;
+	}
+
+	if (s->raw) {
+		s->bytes_written = (u64)(s->blk - info->start) * info->blksz;
+	} else if (s->state != SPARSE_STREAM_DONE ||
+		   s->total_blocks != s->sparse_header.total_blks) {
+		debug("Wrote %d blocks, expected to write %d blocks\n",
+		      s->total_blocks, s->sparse_header.total_blks);
+		info->mssg("sparse image write failure", response);
+		ret = -EINVAL;
+		goto out;
+	}
+
+	printf("........ wrote %llu bytes to '%s'\n",
+	       (unsigned long long)s->bytes_written, s->part_name);
+
+out:
+	/* Nothing may be left reading the buffers once they are freed */
+	sparse_wait(w, w->issued);
+	free(w->buf[0]);
+	free(w->buf[1]);
+	free(s->part);
+	free(s);
+
+	return ret;
+}
+#endif
@@ -283,6 +283,28 @@ struct AvbOps {
                                         const char* name,
                                         size_t value_size,
                                         const uint8_t* value);
+
+  /* Starts reading |num_bytes| at offset |offset| from partition with
+   * name |partition| into |buffer|, like |read_from_partition|, but
+   * returns as soon as the transfer has been started. The read is
+   * completed by |finish_read_from_partition|, which stores the number
+   * of bytes read in |out_num_read|. libavb never has more than one
+   * such read outstanding and does not touch |buffer| until the read
+   * has been finished, so it can hash one chunk while the next one is
+   * being read.
+   *
+   * Both are optional. If either is NULL, |read_from_partition| is
+   * used instead. Errors are reported as for |read_from_partition|; if
+   * |start_read_from_partition| fails there is nothing to finish.
+   */
+  AvbIOResult (*start_read_from_partition)(AvbOps* ops,
+                                           const char* partition,
+                                           int64_t offset,
+                                           size_t num_bytes,
+                                           void* buffer);
+
+  AvbIOResult (*finish_read_from_partition)(AvbOps* ops,
+                                            size_t* out_num_read);
 };
 
 #ifdef __cplusplus
@@ -10,6 +10,10 @@
 
 #include "avb_sha.h"
 
+#ifdef CONFIG_SHA256
+#include <u-boot/sha256.h>
+#endif
+
 #define SHFR(x, n) (x >> n)
 #define ROTR(x, n) ((x >> n) | (x << ((sizeof(x) << 3) - n)))
 #define ROTL(x, n) ((x << n) | (x >> ((sizeof(x) << 3) - n)))
@@ -94,6 +98,22 @@ void avb_sha256_init(AvbSHA256Ctx* ctx) {
   ctx->tot_len = 0;
 }
 
+#ifdef CONFIG_SHA256
+/* Hand the blocks to U-Boot's SHA-256, which may use CPU instructions. */
+static void SHA256_transform(AvbSHA256Ctx* ctx,
+                             const uint8_t* message,
+                             unsigned int block_nb) {
+  sha256_context uctx;
+
+  if (block_nb == 0) {
+    return;
+  }
+
+  avb_memcpy(uctx.state, ctx->h, sizeof(uctx.state));
+  sha256_process(&uctx, message, block_nb);
+  avb_memcpy(ctx->h, uctx.state, sizeof(uctx.state));
+}
+#else
 static void SHA256_transform(AvbSHA256Ctx* ctx,
                              const uint8_t* message,
                              unsigned int block_nb) {
@@ -292,6 +312,7 @@ static void SHA256_transform(AvbSHA256Ctx* ctx,
 #endif /* !UNROLL_LOOPS */
   }
 }
+#endif /* CONFIG_SHA256 */
 
 void avb_sha256_update(AvbSHA256Ctx* ctx, const uint8_t* data, uint32_t len) {
   unsigned int block_nb;
@@ -24,6 +24,9 @@
 /* Maximum size of a vbmeta image - 64 KiB. */
 #define VBMETA_MAX_SIZE (64 * 1024)
 
+/* Size of the chunks a hash partition is read and hashed in - 1 MiB. */
+#define HASH_PARTITION_CHUNK_SIZE (1024 * 1024)
+
 /* Helper function to see if we should continue with verification in
  * allow_verification_error=true mode if something goes wrong. See the
  * comments for the avb_slot_verify() function for more information.
@@ -114,6 +117,190 @@ static AvbSlotVerifyResult load_full_partition(AvbOps* ops,
   return AVB_SLOT_VERIFY_RESULT_OK;
 }
 
+/* Size of the chunk at |offset| when reading |image_size| bytes. */
+static size_t hash_chunk_size(size_t image_size, size_t offset) {
+  size_t chunk_size = image_size - offset;
+
+  if (chunk_size > HASH_PARTITION_CHUNK_SIZE) {
+    chunk_size = HASH_PARTITION_CHUNK_SIZE;
+  }
+  return chunk_size;
+}
+
+/* Loads |image_size| bytes of |part_name| into a buffer returned in
+ * |out_image_buf| and feeds the first |hash_size| bytes of it into
+ * whichever of |sha256_ctx| or |sha512_ctx| is non-NULL.
+ *
+ * If |hash_only| is true the data is only streamed through the hash:
+ * a single chunk sized buffer is reused for every read and freed again,
+ * and |out_image_buf| is left NULL. Peak memory use then no longer
+ * depends on the size of the partition.
+ *
+ * Unless the partition is preloaded, it is read and hashed in chunks of
+ * HASH_PARTITION_CHUNK_SIZE bytes: each chunk is hashed right after it
+ * has been read, while it is still hot in the data cache, instead of
+ * making a second pass over the whole image once it has been loaded.
+ * This also keeps any bounce buffering done by read_from_partition()
+ * bounded by the chunk size rather than the image size.
+ *
+ * If |ops| can start reads without waiting for them, the next chunk is
+ * read while the current one is being hashed. In |hash_only| mode two
+ * chunk buffers are then used in turn.
+ */
+static AvbSlotVerifyResult load_and_hash_partition(AvbOps* ops,
+                                                   const char* part_name,
+                                                   uint64_t image_size,
+                                                   uint64_t hash_size,
+                                                   AvbSHA256Ctx* sha256_ctx,
+                                                   AvbSHA512Ctx* sha512_ctx,
+                                                   bool hash_only,
+                                                   uint8_t** out_image_buf,
+                                                   bool* out_image_preloaded) {
+  uint8_t* buf;
+  size_t buf_size;
+  size_t part_num_read;
+  size_t offset;
+  size_t chunk_size;
+  size_t to_hash;
+  size_t n;
+  bool async;
+  AvbIOResult io_ret = AVB_IO_RESULT_OK;
+  AvbSlotVerifyResult ret;
+
+  /* Make sure that we do not overwrite existing data. */
+  avb_assert(*out_image_buf == NULL);
+  avb_assert(!*out_image_preloaded);
+
+  if (image_size != (size_t)(image_size)) {
+    avb_errorv(part_name, ": Partition size too large to load.\n", NULL);
+    return AVB_SLOT_VERIFY_RESULT_ERROR_INVALID_METADATA;
+  }
+
+  /* The hashed region can never extend past the loaded image. */
+  if (hash_size > image_size) {
+    hash_size = image_size;
+  }
+
+  /* Preloaded partitions are already in memory, hash them in one go. */
+  if (!hash_only && ops->get_preloaded_partition != NULL) {
+    io_ret = ops->get_preloaded_partition(
+        ops, part_name, image_size, out_image_buf, &part_num_read);
+    if (io_ret == AVB_IO_RESULT_ERROR_OOM) {
+      return AVB_SLOT_VERIFY_RESULT_ERROR_OOM;
+    } else if (io_ret != AVB_IO_RESULT_OK) {
+      avb_errorv(part_name, ": Error loading data from partition.\n", NULL);
+      return AVB_SLOT_VERIFY_RESULT_ERROR_IO;
+    }
+
+    if (*out_image_buf != NULL) {
+      if (part_num_read != image_size) {
+        avb_errorv(part_name, ": Read incorrect number of bytes.\n", NULL);
+        return AVB_SLOT_VERIFY_RESULT_ERROR_IO;
+      }
+      *out_image_preloaded = true;
+      if (sha256_ctx != NULL) {
+        avb_sha256_update(sha256_ctx, *out_image_buf, hash_size);
+      } else {
+        avb_sha512_update(sha512_ctx, *out_image_buf, hash_size);
+      }
+      return AVB_SLOT_VERIFY_RESULT_OK;
+    }
+  }
+
+  async = ops->start_read_from_partition != NULL &&
+          ops->finish_read_from_partition != NULL;
+
+  if (hash_only) {
+    /* Nothing past the hashed region is needed. */
+    image_size = hash_size;
+    buf_size = image_size;
+    if (buf_size > HASH_PARTITION_CHUNK_SIZE) {
+      buf_size = async ? 2 * HASH_PARTITION_CHUNK_SIZE
+                       : HASH_PARTITION_CHUNK_SIZE;
+    }
+  } else {
+    buf_size = image_size;
+  }
+
+  buf = avb_malloc(buf_size ? buf_size : 1);
+  if (buf == NULL) {
+    return AVB_SLOT_VERIFY_RESULT_ERROR_OOM;
+  }
+  if (!hash_only) {
+    *out_image_buf = buf;
+  }
+
+  ret = AVB_SLOT_VERIFY_RESULT_OK;
+  if (async && image_size > 0) {
+    io_ret = ops->start_read_from_partition(
+        ops, part_name, 0, hash_chunk_size(image_size, 0), buf);
+  }
+  for (offset = 0, n = 0; offset < image_size; offset += chunk_size, n++) {
+    uint8_t* chunk = buf + offset;
+
+    if (hash_only) {
+      chunk = buf + (n % 2) * (async ? HASH_PARTITION_CHUNK_SIZE : 0);
+    }
+    chunk_size = hash_chunk_size(image_size, offset);
+
+    if (async) {
+      /* |io_ret| holds the result of starting this chunk. */
+      if (io_ret == AVB_IO_RESULT_OK) {
+        io_ret = ops->finish_read_from_partition(ops, &part_num_read);
+      }
+    } else {
+      io_ret = ops->read_from_partition(
+          ops, part_name, offset, chunk_size, chunk, &part_num_read);
+    }
+    if (io_ret == AVB_IO_RESULT_ERROR_OOM) {
+      ret = AVB_SLOT_VERIFY_RESULT_ERROR_OOM;
+      break;
+    } else if (io_ret != AVB_IO_RESULT_OK) {
+      avb_errorv(part_name, ": Error loading data from partition.\n", NULL);
+      ret = AVB_SLOT_VERIFY_RESULT_ERROR_IO;
+      break;
+    }
+    if (part_num_read != chunk_size) {
+      avb_errorv(part_name, ": Read incorrect number of bytes.\n", NULL);
+      ret = AVB_SLOT_VERIFY_RESULT_ERROR_IO;
+      break;
+    }
+
+    /* Get the next chunk going before hashing this one. */
+    if (async && offset + chunk_size < image_size) {
+      uint8_t* next = buf + offset + chunk_size;
+
+      if (hash_only) {
+        next = buf + ((n + 1) % 2) * HASH_PARTITION_CHUNK_SIZE;
+      }
+      io_ret = ops->start_read_from_partition(
+          ops,
+          part_name,
+          offset + chunk_size,
+          hash_chunk_size(image_size, offset + chunk_size),
+          next);
+    }
+
+    if (offset >= hash_size) {
+      continue;
+    }
+    to_hash = chunk_size;
+    if (to_hash > hash_size - offset) {
+      to_hash = hash_size - offset;
+    }
+    if (sha256_ctx != NULL) {
+      avb_sha256_update(sha256_ctx, chunk, to_hash);
+    } else {
+      avb_sha512_update(sha512_ctx, chunk, to_hash);
+    }
+  }
+
+  if (hash_only) {
+    avb_free(buf);
+  }
+  return ret;
+}
+
 static AvbSlotVerifyResult read_persistent_digest(AvbOps* ops,
                                                   const char* part_name,
                                                   size_t expected_digest_size,
@@ -160,6 +347,7 @@ static AvbSlotVerifyResult load_and_verify_hash_partition(
     const char* const* requested_partitions,
     const char* ab_suffix,
     bool allow_verification_error,
+    bool hash_only,
     const AvbDescriptor* descriptor,
     AvbSlotVerifyData* slot_data) {
   AvbHashDescriptor hash_desc;
@@ -178,6 +366,9 @@ static AvbSlotVerifyResult load_and_verify_hash_partition(
   size_t expected_digest_len = 0;
   uint8_t expected_digest_buf[AVB_SHA512_DIGEST_SIZE];
   const uint8_t* expected_digest = NULL;
+  AvbSHA256Ctx sha256_ctx;
+  AvbSHA512Ctx sha512_ctx;
+  bool is_sha256;
 
   if (!avb_hash_descriptor_validate_and_byteswap(
           (const AvbHashDescriptor*)descriptor, &hash_desc)) {
@@ -247,7 +438,7 @@ static AvbSlotVerifyResult load_and_verify_hash_partition(
    * since it's such a common workflow.
    */
   image_size = hash_desc.image_size;
-  if (allow_verification_error) {
+  if (allow_verification_error && !hash_only) {
     if (ops->get_size_of_partition == NULL) {
       avb_errorv(part_name,
                  ": The get_size_of_partition() operation is "
@@ -268,32 +459,41 @@ static AvbSlotVerifyResult load_and_verify_hash_partition(
     }
   }
 
-  ret = load_full_partition(
-      ops, part_name, image_size, &image_buf, &image_preloaded);
-  if (ret != AVB_SLOT_VERIFY_RESULT_OK) {
-    goto out;
-  }
-
   if (avb_strcmp((const char*)hash_desc.hash_algorithm, "sha256") == 0) {
-    AvbSHA256Ctx sha256_ctx;
+    is_sha256 = true;
     avb_sha256_init(&sha256_ctx);
     avb_sha256_update(&sha256_ctx, desc_salt, hash_desc.salt_len);
-    avb_sha256_update(&sha256_ctx, image_buf, hash_desc.image_size);
-    digest = avb_sha256_final(&sha256_ctx);
-    digest_len = AVB_SHA256_DIGEST_SIZE;
   } else if (avb_strcmp((const char*)hash_desc.hash_algorithm, "sha512") == 0) {
-    AvbSHA512Ctx sha512_ctx;
+    is_sha256 = false;
     avb_sha512_init(&sha512_ctx);
     avb_sha512_update(&sha512_ctx, desc_salt, hash_desc.salt_len);
-    avb_sha512_update(&sha512_ctx, image_buf, hash_desc.image_size);
-    digest = avb_sha512_final(&sha512_ctx);
-    digest_len = AVB_SHA512_DIGEST_SIZE;
   } else {
     avb_errorv(part_name, ": Unsupported hash algorithm.\n", NULL);
     ret = AVB_SLOT_VERIFY_RESULT_ERROR_INVALID_METADATA;
     goto out;
   }
 
+  ret = load_and_hash_partition(ops,
+                                part_name,
+                                image_size,
+                                hash_desc.image_size,
+                                is_sha256 ? &sha256_ctx : NULL,
+                                is_sha256 ? NULL : &sha512_ctx,
+                                hash_only,
+                                &image_buf,
+                                &image_preloaded);
+  if (ret != AVB_SLOT_VERIFY_RESULT_OK) {
+    goto out;
+  }
+
+  if (is_sha256) {
+    digest = avb_sha256_final(&sha256_ctx);
+    digest_len = AVB_SHA256_DIGEST_SIZE;
+  } else {
+    digest = avb_sha512_final(&sha512_ctx);
+    digest_len = AVB_SHA512_DIGEST_SIZE;
+  }
+
   if (hash_desc.digest_len == 0) {
     // Expect a match to a persistent digest.
     avb_debugv(part_name, ": No digest, using persistent digest.\n", NULL);
@@ -442,6 +642,7 @@ static AvbSlotVerifyResult load_and_verify_vbmeta(
     const char* const* requested_partitions,
     const char* ab_suffix,
     bool allow_verification_error,
+    bool hash_only,
     AvbVBMetaImageFlags toplevel_vbmeta_flags,
     int rollback_index_location,
     const char* partition_name,
@@ -579,6 +780,7 @@ static AvbSlotVerifyResult load_and_verify_vbmeta(
                                    requested_partitions,
                                    ab_suffix,
                                    allow_verification_error,
+                                   hash_only,
                                    0 /* toplevel_vbmeta_flags */,
                                    0 /* rollback_index_location */,
                                    "boot",
@@ -769,10 +971,12 @@ static AvbSlotVerifyResult load_and_verify_vbmeta(
      * than recoverable (e.g. one where result_should_continue()
      * returns true) and we want to convey that error.
      */
-    sub_ret = load_requested_partitions(
-        ops, requested_partitions, ab_suffix, slot_data);
-    if (sub_ret != AVB_SLOT_VERIFY_RESULT_OK) {
-      ret = sub_ret;
+    if (!hash_only) {
+      sub_ret = load_requested_partitions(
+          ops, requested_partitions, ab_suffix, slot_data);
+      if (sub_ret != AVB_SLOT_VERIFY_RESULT_OK) {
+        ret = sub_ret;
+      }
     }
     goto out;
   }
@@ -808,6 +1012,7 @@ static AvbSlotVerifyResult load_and_verify_vbmeta(
                                                  requested_partitions,
                                                  ab_suffix,
                                                  allow_verification_error,
+                                                 hash_only,
                                                  descriptors[n],
                                                  slot_data);
         if (sub_ret != AVB_SLOT_VERIFY_RESULT_OK) {
@@ -860,6 +1065,7 @@ static AvbSlotVerifyResult load_and_verify_vbmeta(
                                    requested_partitions,
                                    ab_suffix,
                                    allow_verification_error,
+                                   hash_only,
                                    toplevel_vbmeta_flags,
                                    chain_desc.rollback_index_location,
                                    (const char*)chain_partition_name,
@@ -1085,6 +1291,7 @@ AvbSlotVerifyResult avb_slot_verify(AvbOps* ops,
   AvbVBMetaImageHeader toplevel_vbmeta;
   bool allow_verification_error =
       (flags & AVB_SLOT_VERIFY_FLAGS_ALLOW_VERIFICATION_ERROR);
+  bool hash_only = (flags & AVB_SLOT_VERIFY_FLAGS_HASH_ONLY);
   AvbCmdlineSubstList* additional_cmdline_subst = NULL;
 
   /* Fail early if we're missing the AvbOps needed for slot verification.
@@ -1140,6 +1347,7 @@ AvbSlotVerifyResult avb_slot_verify(AvbOps* ops,
                                requested_partitions,
                                ab_suffix,
                                allow_verification_error,
+                               hash_only,
                                0 /* toplevel_vbmeta_flags */,
                                0 /* rollback_index_location */,
                                "vbmeta",
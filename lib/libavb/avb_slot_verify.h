@@ -80,10 +80,18 @@ typedef enum {
  * contents loaded from |requested_partition| will be the contents of
  * the entire partition instead of just the size specified in the hash
  * descriptor.
+ *
+ * If AVB_SLOT_VERIFY_FLAGS_HASH_ONLY is set, partitions with a hash
+ * descriptor are streamed through the digest in fixed size chunks
+ * instead of being loaded. Nothing is returned in |loaded_partitions|
+ * of |out_data| and the memory needed no longer grows with the size of
+ * the partitions. This is useful when only the verification result and
+ * the kernel command-line are of interest.
  */
 typedef enum {
   AVB_SLOT_VERIFY_FLAGS_NONE = 0,
-  AVB_SLOT_VERIFY_FLAGS_ALLOW_VERIFICATION_ERROR = (1 << 0)
+  AVB_SLOT_VERIFY_FLAGS_ALLOW_VERIFICATION_ERROR = (1 << 0),
+  AVB_SLOT_VERIFY_FLAGS_HASH_ONLY = (1 << 1)
 } AvbSlotVerifyFlags;
 
 /* Get a textual representation of |result|. */
@@ -61,22 +61,51 @@ struct lz4_block_header {
 	/* + u32 block_checksum iff has_block_checksum is set */
 } __packed;
 
+/* Skippable frames carry user data that is not part of the content */
+#define LZ4F_SKIPPABLE_MAGIC	0x184D2A50
+#define LZ4F_SKIPPABLE_MASK	0xfffffff0
+
+/*
+ * Return the offset of the next frame in the input, skipping any
+ * skippable frames, or 0 if the input does not continue with a frame.
+ */
+static size_t lz4_next_frame(const void *src, size_t srcn, size_t pos)
+{
+	u32 magic;
+
+	while (pos + 2 * sizeof(u32) <= srcn) {
+		magic = le32_to_cpu(*(u32 *)(src + pos));
+		if (magic == LZ4F_MAGIC)
+			return pos;
+		if ((magic & LZ4F_SKIPPABLE_MASK) != LZ4F_SKIPPABLE_MAGIC)
+			break;
+		pos += 2 * sizeof(u32) + le32_to_cpu(*(u32 *)(src + pos + 4));
+	}
+
+	return 0;
+}
+
 int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 {
 	const void *end = dst + *dstn;
 	const void *in = src;
 	void *out = dst;
-	int has_block_checksum;
+	int has_block_checksum, has_content_checksum;
+	size_t next;
 	int ret;
 	*dstn = 0;
 
+	/*
+	 * Concatenated frames (e.g. from 'cat a.lz4 b.lz4') are decoded one
+	 * after the other into consecutive parts of the output.
+	 */
+next_frame:
 	{ /* With in-place decompression the header may become invalid later. */
 		const struct lz4_frame_header *h = in;
 
-		if (srcn < sizeof(*h) + sizeof(u64) + sizeof(u8))
+		if (in - src + sizeof(*h) + sizeof(u64) + sizeof(u8) > srcn)
 			return -EINVAL;	/* input overrun */
 
-		/* We assume there's always only a single, standard frame. */
 		if (le32_to_cpu(h->magic) != LZ4F_MAGIC || h->version != 1)
 			return -EPROTONOSUPPORT;	/* unknown format */
 		if (h->reserved0 || h->reserved1 || h->reserved2)
@@ -84,6 +113,7 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 		if (!h->independent_blocks)
 			return -EPROTONOSUPPORT; /* we can't support this yet */
 		has_block_checksum = h->has_block_checksum;
+		has_content_checksum = h->has_content_checksum;
 
 		in += sizeof(*h);
 		if (h->has_content_size)
@@ -132,6 +162,16 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 			in += sizeof(u32);
 	}
 
+	if (!ret) {
+		if (has_content_checksum)
+			in += sizeof(u32);
+		next = lz4_next_frame(src, srcn, in - src);
+		if (next) {
+			in = src + next;
+			goto next_frame;
+		}
+	}
+
 	*dstn = out - dst;
 	return ret;
 }
@@ -329,6 +329,9 @@ int of_live_build(const void *fdt_blob, struct device_node **rootp)
 		debug("Failed to scan live tree aliases: err=%d\n", ret);
 		return ret;
 	}
+	/* Lookups still work without the index, only more slowly */
+	if (of_index_build(*rootp))
+		debug("Failed to index live tree\n");
 	debug("%s: stop\n", __func__);
 
 	return ret;
@@ -10,6 +10,9 @@
 #include <linux/string.h>
 #else
 #include <string.h>
+#ifndef __weak
+#define __weak
+#endif
 #endif /* USE_HOSTCC */
 #include <watchdog.h>
 #include <u-boot/sha256.h>
@@ -55,7 +58,7 @@ void sha256_starts(sha256_context * ctx)
 	ctx->state[7] = 0x5BE0CD19;
 }
 
-static void sha256_process(sha256_context *ctx, const uint8_t data[64])
+static void sha256_process_one(sha256_context *ctx, const uint8_t data[64])
 {
 	uint32_t temp1, temp2;
 	uint32_t W[64];
@@ -186,6 +189,25 @@ static void sha256_process(sha256_context *ctx, const uint8_t data[64])
 	ctx->state[7] += H;
 }
 
+void sha256_process_generic(sha256_context *ctx, const unsigned char *data,
+			    unsigned int blocks)
+{
+	while (blocks--) {
+		sha256_process_one(ctx, data);
+		data += 64;
+	}
+}
+
+/*
+ * Architectures with SHA-256 instructions provide their own version of this,
+ * falling back to sha256_process_generic() when the CPU lacks them.
+ */
+__weak void sha256_process(sha256_context *ctx, const unsigned char *data,
+			   unsigned int blocks)
+{
+	sha256_process_generic(ctx, data, blocks);
+}
+
 void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length)
 {
 	uint32_t left, fill;
@@ -204,16 +226,16 @@ void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length)
 
 	if (left && length >= fill) {
 		memcpy((void *) (ctx->buffer + left), (void *) input, fill);
-		sha256_process(ctx, ctx->buffer);
+		sha256_process(ctx, ctx->buffer, 1);
 		length -= fill;
 		input += fill;
 		left = 0;
 	}
 
-	while (length >= 64) {
-		sha256_process(ctx, input);
-		length -= 64;
-		input += 64;
+	if (length >= 64) {
+		sha256_process(ctx, input, length / 64);
+		input += length & ~63;
+		length &= 63;
 	}
 
 	if (length)
@@ -347,10 +347,39 @@ int eth_send(void *packet, int length)
 	return ret;
 }
 
+/* Take a whole batch from a driver which can hand over several packets */
+static int eth_rx_batch(struct udevice *current)
+{
+	struct eth_ops *ops = eth_get_ops(current);
+	uchar *packets[ETH_RX_BUDGET];
+	int lengths[ETH_RX_BUDGET];
+	int count;
+	int i;
+
+	count = ops->recv_batch(current, ETH_RECV_CHECK_DEVICE, packets,
+				lengths, ETH_RX_BUDGET);
+	if (count == -EAGAIN)
+		return 0;
+	if (count < 0) {
+		debug("%s: recv_batch() returned error %d\n", __func__, count);
+		return count;
+	}
+
+	/* Give each buffer back straight away so the driver can refill it */
+	for (i = 0; i < count; i++) {
+		net_process_received_packet(packets[i], lengths[i]);
+		if (ops->free_pkt)
+			ops->free_pkt(current, packets[i], lengths[i]);
+	}
+
+	return count;
+}
+
 int eth_rx(void)
 {
 	struct udevice *current;
 	uchar *packet;
+	int count = 0;
 	int flags;
 	int ret;
 	int i;
@@ -362,13 +391,18 @@ int eth_rx(void)
 	if (!eth_is_active(current))
 		return -EINVAL;
 
-	/* Process up to 32 packets at one time */
+	if (eth_get_ops(current)->recv_batch)
+		return eth_rx_batch(current);
+
+	/* Process up to ETH_RX_BUDGET packets at one time */
 	flags = ETH_RECV_CHECK_DEVICE;
-	for (i = 0; i < 32; i++) {
+	for (i = 0; i < ETH_RX_BUDGET; i++) {
 		ret = eth_get_ops(current)->recv(current, flags, &packet);
 		flags = 0;
-		if (ret > 0)
+		if (ret > 0) {
 			net_process_received_packet(packet, ret);
+			count++;
+		}
 		if (ret >= 0 && eth_get_ops(current)->free_pkt)
 			eth_get_ops(current)->free_pkt(current, packet, ret);
 		if (ret <= 0)
@@ -380,7 +414,7 @@ int eth_rx(void)
 		/* We cannot completely return the error at present */
 		debug("%s: recv() returned error %d\n", __func__, ret);
 	}
-	return ret;
+	return count ? count : ret;
 }
 
 int eth_initialize(void)
@@ -94,7 +94,9 @@
 #include <errno.h>
 #include <net.h>
 #include <net/fastboot.h>
+#include <net/tcp.h>
 #include <net/tftp.h>
+#include <net/wget.h>
 #if defined(CONFIG_LED_STATUS)
 #include <miiphy.h>
 #include <status_led.h>
@@ -203,6 +205,8 @@ static ulong	time_start;
 static ulong	time_delta;
 /* THE transmit packet */
 uchar *net_tx_packet;
+/* Receive batches taken in a row before the console and timers are polled */
+#define NET_RX_BUSY_ROUNDS	8
 
 static int net_check_prereq(enum proto_t protocol);
 
@@ -364,6 +368,9 @@ static void net_clear_handlers(void)
 static void net_cleanup_loop(void)
 {
 	net_clear_handlers();
+#if defined(CONFIG_PROT_TCP)
+	tcp_abort();
+#endif
 }
 
 void net_init(void)
@@ -401,6 +408,10 @@ int net_loop(enum proto_t protocol)
 {
 	int ret = -EINVAL;
 	enum net_loop_state prev_net_state = net_state;
+#ifdef CONFIG_DM_ETH
+	int rx_busy_rounds = 0;
+	int rx_count;
+#endif
 
 	net_restarted = 0;
 	net_dev_exists = 0;
@@ -497,6 +508,11 @@ restart:
 			nfs_start();
 			break;
 #endif
+#if defined(CONFIG_CMD_WGET)
+		case WGET:
+			wget_start();
+			break;
+#endif
 #if defined(CONFIG_CMD_CDP)
 		case CDP:
 			cdp_start();
@@ -569,7 +585,26 @@ restart:
 		 *	Most drivers return the most recent packet size, but not
 		 *	errors that may have happened.
 		 */
+#ifdef CONFIG_DM_ETH
+		rx_count = eth_rx();
+#else
 		eth_rx();
+#endif
+#if defined(CONFIG_PROT_TCP)
+		tcp_poll();
+#endif
+
+#ifdef CONFIG_DM_ETH
+		/*
+		 * While packets keep arriving, go straight back for more, for
+		 * a few rounds at most, rather than polling the console and
+		 * timers between each batch.
+		 */
+		if (rx_count > 0 && net_state == NETLOOP_CONTINUE &&
+		    ++rx_busy_rounds < NET_RX_BUSY_ROUNDS)
+			continue;
+		rx_busy_rounds = 0;
+#endif
 
 		/*
 		 *	Abort if ctrl-c was pressed.
@@ -842,6 +877,14 @@ int net_send_ip_packet(uchar *ether, struct in_addr dest, int dport, int sport,
 				   payload_len);
 		pkt_hdr_size = eth_hdr_size + IP_UDP_HDR_SIZE;
 		break;
+#if defined(CONFIG_PROT_TCP)
+	case IPPROTO_TCP:
+		pkt_hdr_size = eth_hdr_size +
+			tcp_set_tcp_header(pkt + eth_hdr_size, dest, dport,
+					   sport, payload_len, action,
+					   tcp_seq_num, tcp_ack_num);
+		break;
+#endif
 	default:
 		return -EINVAL;
 	}
@@ -1248,6 +1291,11 @@ void net_process_received_packet(uchar *in_packet, int len)
 		if (ip->ip_p == IPPROTO_ICMP) {
 			receive_icmp(ip, len, src_ip, et);
 			return;
+#if defined(CONFIG_PROT_TCP)
+		} else if (ip->ip_p == IPPROTO_TCP) {
+			tcp_receive((struct ip_tcp_hdr *)ip, len);
+			return;
+#endif
 		} else if (ip->ip_p != IPPROTO_UDP) {	/* Only UDP packets */
 			return;
 		}
@@ -1354,6 +1402,9 @@ static int net_check_prereq(enum proto_t protocol)
 #endif
 #if defined(CONFIG_CMD_NFS)
 	case NFS:
+#endif
+#if defined(CONFIG_CMD_WGET)
+	case WGET:
 #endif
 		/* Fall through */
 	case TFTPGET:
@@ -1558,7 +1609,8 @@ int net_parse_bootfile(struct in_addr *ipaddr, char *filename, int max_len)
 
 #if	defined(CONFIG_CMD_NFS)		|| \
 	defined(CONFIG_CMD_SNTP)	|| \
-	defined(CONFIG_CMD_DNS)
+	defined(CONFIG_CMD_DNS)		|| \
+	defined(CONFIG_PROT_TCP)
 /*
  * make port a little random (1024-17407)
  * This keeps the math somewhat trivial to compute, and seems to work with
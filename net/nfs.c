@@ -45,12 +45,33 @@
 #define NFS_RPC_ERR	1
 #define NFS_RPC_DROP	124
 
+/* Default and largest number of READ requests kept outstanding */
+#define NFS_PIPELINE		4
+#define NFS_PIPELINE_MAX	16
+#define NFS_HASH_SIZE		(10 * 512)	/* bytes per "loading" hash */
+/* Longest READ reply header: NFSv3 with attributes, count, eof and size */
+#define NFS_READ_HDR_MAX	offsetof(struct rpc_t, u.reply.data[4 + 22])
+
 static int fs_mounted;
 static unsigned long rpc_id;
 static int nfs_offset = -1;
 static int nfs_len;
 static ulong nfs_timeout = NFS_TIMEOUT;
 
+/* A READ request waiting for its reply */
+struct nfs_read {
+	unsigned long id;	/* RPC xid, 0 if the slot is free */
+	int offset;
+	int len;
+};
+
+static struct nfs_read nfs_reads[NFS_PIPELINE_MAX];
+static int nfs_pipeline;	/* number of READ requests kept outstanding */
+static int nfs_file_end;	/* size of the file, -1 until known */
+static int nfs_bytes_read;
+static int nfs_next_hash;
+static int nfs_hashes;
+
 static char dirfh[NFS_FHSIZE];	/* NFSv2 / NFSv3 file handle of directory */
 static char filefh[NFS3_FHSIZE]; /* NFSv2 / NFSv3 file handle */
 static int filefh3_length;	/* (variable) length of filefh when NFSv3 */
@@ -170,15 +191,14 @@ static uint32_t *rpc_add_credentials(uint32_t *p)
 /**************************************************************************
 RPC_LOOKUP - Lookup RPC Port numbers
 **************************************************************************/
-static void rpc_req(int rpc_prog, int rpc_proc, uint32_t *data, int datalen)
+static void rpc_req_id(unsigned long id, int rpc_prog, int rpc_proc,
+		       uint32_t *data, int datalen)
 {
 	struct rpc_t rpc_pkt;
-	unsigned long id;
 	uint32_t *p;
 	int pktlen;
 	int sport;
 
-	id = ++rpc_id;
 	rpc_pkt.u.call.id = htonl(id);
 	rpc_pkt.u.call.type = htonl(MSG_CALL);
 	rpc_pkt.u.call.rpcvers = htonl(2);	/* use RPC version 2 */
@@ -217,6 +237,11 @@ static void rpc_req(int rpc_prog, int rpc_proc, uint32_t *data, int datalen)
 			    nfs_our_port, pktlen);
 }
 
+static void rpc_req(int rpc_prog, int rpc_proc, uint32_t *data, int datalen)
+{
+	rpc_req_id(++rpc_id, rpc_prog, rpc_proc, data, datalen);
+}
+
 /**************************************************************************
 RPC_LOOKUP - Lookup RPC Port numbers
 **************************************************************************/
@@ -356,7 +381,7 @@ static void nfs_lookup_req(char *fname)
 /**************************************************************************
 NFS_READ - Read File on NFS Server
 **************************************************************************/
-static void nfs_read_req(int offset, int readlen)
+static void nfs_read_req(struct nfs_read *rd)
 {
 	uint32_t data[1024];
 	uint32_t *p;
@@ -368,22 +393,85 @@ static void nfs_read_req(int offset, int readlen)
 	if (supported_nfs_versions & NFSV2_FLAG) {
 		memcpy(p, filefh, NFS_FHSIZE);
 		p += (NFS_FHSIZE / 4);
-		*p++ = htonl(offset);
-		*p++ = htonl(readlen);
+		*p++ = htonl(rd->offset);
+		*p++ = htonl(rd->len);
 		*p++ = 0;
 	} else { /* NFSV3_FLAG */
 		*p++ = htonl(filefh3_length);
 		memcpy(p, filefh, filefh3_length);
 		p += (filefh3_length / 4);
 		*p++ = htonl(0); /* offset is 64-bit long, so fill with 0 */
-		*p++ = htonl(offset);
-		*p++ = htonl(readlen);
+		*p++ = htonl(rd->offset);
+		*p++ = htonl(rd->len);
 		*p++ = 0;
 	}
 
 	len = (uint32_t *)p - (uint32_t *)&(data[0]);
 
-	rpc_req(PROG_NFS, NFS_READ, data, len);
+	/* A retransmission keeps its xid, so that any reply will do */
+	rpc_req_id(rd->id, PROG_NFS, NFS_READ, data, len);
+}
+
+/*
+ * Keep nfs_pipeline READ requests outstanding, in file order, until the end
+ * of the file is known. Replies may come back in any order: each one is
+ * matched to its request by xid and stored at its own offset.
+ */
+static void nfs_read_fill(void)
+{
+	struct nfs_read *rd;
+	int i;
+
+	for (i = 0; i < nfs_pipeline; i++) {
+		rd = &nfs_reads[i];
+		if (rd->id)
+			continue;
+		if (nfs_file_end >= 0 && nfs_offset >= nfs_file_end)
+			break;
+		rd->id = ++rpc_id;
+		rd->offset = nfs_offset;
+		rd->len = nfs_len;
+		nfs_offset += nfs_len;
+		nfs_read_req(rd);
+	}
+}
+
+static void nfs_read_start(void)
+{
+	char *ep;
+
+	nfs_pipeline = NFS_PIPELINE;
+	ep = env_get("nfspipeline");
+	if (ep)
+		nfs_pipeline = simple_strtol(ep, NULL, 10);
+	nfs_pipeline = clamp(nfs_pipeline, 1, NFS_PIPELINE_MAX);
+
+	nfs_len = NFS_READ_SIZE;
+	if (supported_nfs_versions & NFSV2_FLAG)
+		nfs_len = min(nfs_len, NFS2_MAX_READ_SIZE);
+	debug("NFS read size = %d, pipeline = %d\n", nfs_len, nfs_pipeline);
+
+	memset(nfs_reads, 0, sizeof(nfs_reads));
+	nfs_offset = 0;
+	nfs_file_end = -1;
+	nfs_bytes_read = 0;
+	nfs_next_hash = 0;
+	nfs_hashes = 0;
+	nfs_read_fill();
+}
+
+/* True once every byte up to the end of the file has been stored */
+static int nfs_read_done(void)
+{
+	int i;
+
+	if (nfs_file_end < 0)
+		return 0;
+	for (i = 0; i < nfs_pipeline; i++)
+		if (nfs_reads[i].id && nfs_reads[i].offset < nfs_file_end)
+			return 0;
+
+	return 1;
 }
 
 /**************************************************************************
@@ -391,6 +479,8 @@ RPC request dispatcher
 **************************************************************************/
 static void nfs_send(void)
 {
+	int i;
+
 	debug("%s\n", __func__);
 
 	switch (nfs_state) {
@@ -416,7 +506,9 @@ static void nfs_send(void)
 		nfs_lookup_req(nfs_filename);
 		break;
 	case STATE_READ_REQ:
-		nfs_read_req(nfs_offset, nfs_len);
+		for (i = 0; i < nfs_pipeline; i++)
+			if (nfs_reads[i].id)
+				nfs_read_req(&nfs_reads[i]);
 		break;
 	case STATE_READLINK_REQ:
 		nfs_readlink_req();
@@ -655,16 +747,22 @@ static int nfs_readlink_reply(uchar *pkt, unsigned len)
 static int nfs_read_reply(uchar *pkt, unsigned len)
 {
 	struct rpc_t rpc_pkt;
-	int rlen;
-	uchar *data_ptr;
+	struct nfs_read *rd = NULL;
+	unsigned long id;
+	int rlen, data_offset, nfsv3_data_offset = 0, eof = 0;
+	int i;
 
 	debug("%s\n", __func__);
 
-	memcpy(&rpc_pkt.u.data[0], pkt, sizeof(rpc_pkt.u.reply));
+	/* Only the header is copied, the data is stored from the packet */
+	memcpy(&rpc_pkt.u.data[0], pkt, min_t(unsigned, len,
+					      NFS_READ_HDR_MAX));
 
-	if (ntohl(rpc_pkt.u.reply.id) > rpc_id)
-		return -NFS_RPC_ERR;
-	else if (ntohl(rpc_pkt.u.reply.id) < rpc_id)
+	id = ntohl(rpc_pkt.u.reply.id);
+	for (i = 0; i < nfs_pipeline; i++)
+		if (nfs_reads[i].id == id)
+			rd = &nfs_reads[i];
+	if (!rd)
 		return -NFS_RPC_DROP;
 
 	if (rpc_pkt.u.reply.rstatus  ||
@@ -678,31 +776,60 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 		return -ntohl(rpc_pkt.u.reply.data[0]);
 	}
 
-	if ((nfs_offset != 0) && !((nfs_offset) %
-			(NFS_READ_SIZE / 2 * 10 * HASHES_PER_LINE)))
-		puts("\n\t ");
-	if (!(nfs_offset % ((NFS_READ_SIZE / 2) * 10)))
-		putc('#');
+	if (len < offsetof(struct rpc_t, u.reply.data[2]))
+		return -9999;
 
 	if (supported_nfs_versions & NFSV2_FLAG) {
-		rlen = ntohl(rpc_pkt.u.reply.data[18]);
-		data_ptr = (uchar *)&(rpc_pkt.u.reply.data[19]);
+		data_offset = 19;
 	} else {  /* NFSV3_FLAG */
-		int nfsv3_data_offset =
+		nfsv3_data_offset =
 			nfs3_get_attributes_offset(rpc_pkt.u.reply.data);
 
-		/* count value */
-		rlen = ntohl(rpc_pkt.u.reply.data[1 + nfsv3_data_offset]);
 		/* Skip unused values :
-			EOF:		32 bits value,
 			data_size:	32 bits value,
 		*/
-		data_ptr = (uchar *)
-			&(rpc_pkt.u.reply.data[4 + nfsv3_data_offset]);
+		data_offset = 4 + nfsv3_data_offset;
 	}
+	data_offset = offsetof(struct rpc_t, u.reply.data) +
+		      data_offset * sizeof(uint32_t);
+	/* The count and eof words come just before the data */
+	if (data_offset > len)
+		return -9999;
 
-	if (store_block(data_ptr, nfs_offset, rlen))
-			return -9999;
+	if (supported_nfs_versions & NFSV2_FLAG) {
+		rlen = ntohl(rpc_pkt.u.reply.data[18]);
+	} else {  /* NFSV3_FLAG */
+		/* count value */
+		rlen = ntohl(rpc_pkt.u.reply.data[1 + nfsv3_data_offset]);
+		eof = ntohl(rpc_pkt.u.reply.data[2 + nfsv3_data_offset]);
+	}
+	if (rlen < 0 || rlen > rd->len || data_offset + rlen > len)
+		return -9999;
+
+	if (rlen && store_block(pkt + data_offset, rd->offset, rlen))
+		return -9999;
+
+	nfs_bytes_read += rlen;
+	while (nfs_bytes_read >= nfs_next_hash) {
+		putc('#');
+		if (++nfs_hashes % HASHES_PER_LINE == 0)
+			puts("\n\t ");
+		nfs_next_hash += NFS_HASH_SIZE;
+	}
+
+	if (eof || !rlen) {
+		if (nfs_file_end < 0 || rd->offset + rlen < nfs_file_end)
+			nfs_file_end = rd->offset + rlen;
+		rd->id = 0;
+	} else if (rlen < rd->len) {
+		/* Short read: ask for the rest */
+		rd->id = ++rpc_id;
+		rd->offset += rlen;
+		rd->len -= rlen;
+		nfs_read_req(rd);
+	} else {
+		rd->id = 0;
+	}
 
 	return rlen;
 }
@@ -735,6 +862,10 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 	if (dest != nfs_our_port)
 		return;
 
+	/* Late READ replies can be bigger than other messages */
+	if (nfs_state != STATE_READ_REQ && len > sizeof(struct rpc_t))
+		return;
+
 	switch (nfs_state) {
 	case STATE_PRCLOOKUP_PROG_MOUNT_REQ:
 		if (rpc_lookup_reply(PROG_MOUNT, pkt, len) == -NFS_RPC_DROP)
@@ -796,9 +927,7 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			nfs_send();
 		} else {
 			nfs_state = STATE_READ_REQ;
-			nfs_offset = 0;
-			nfs_len = NFS_READ_SIZE;
-			nfs_send();
+			nfs_read_start();
 		}
 		break;
 
@@ -825,18 +954,20 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		if (rlen == -NFS_RPC_DROP)
 			break;
 		net_set_timeout_handler(nfs_timeout, nfs_timeout_handler);
-		if (rlen > 0) {
-			nfs_offset += rlen;
+		if (rlen >= 0) {
+			if (!nfs_read_done()) {
+				nfs_read_fill();
+				break;
+			}
+			nfs_download_state = NETLOOP_SUCCESS;
+			nfs_state = STATE_UMOUNT_REQ;
 			nfs_send();
 		} else if ((rlen == -NFSERR_ISDIR) || (rlen == -NFSERR_INVAL)) {
 			/* symbolic link */
 			nfs_state = STATE_READLINK_REQ;
 			nfs_send();
 		} else {
-			if (!rlen)
-				nfs_download_state = NETLOOP_SUCCESS;
-			if (rlen < 0)
-				debug("NFS READ error (%d)\n", rlen);
+			debug("NFS READ error (%d)\n", rlen);
 			nfs_state = STATE_UMOUNT_REQ;
 			nfs_send();
 		}
@@ -41,9 +41,16 @@
  * However, if CONFIG_IP_DEFRAG is set, a bigger value could be used.  In any
  * case, most NFS servers are optimized for a power of 2.
  */
-#define NFS_READ_SIZE	1024	/* biggest power of two that fits Ether frame */
+#define NFS_READ_SIZE	CONFIG_NFS_READ_SIZE
+#define NFS2_MAX_READ_SIZE	8192	/* NFSv2 servers send no more */
 #define NFS_MAX_ATTRS	26
 
+/*
+ * Room for the data of any RPC message except READ replies, which are
+ * stored straight from the packet: file handles, names and paths.
+ */
+#define NFS_RPC_DATA_SIZE	1024
+
 /* Values for Accept State flag on RPC answers (See: rfc1831) */
 enum rpc_accept_stat {
 	NFS_RPC_SUCCESS = 0,	/* RPC executed successfully */
@@ -56,7 +63,7 @@ enum rpc_accept_stat {
 
 struct rpc_t {
 	union {
-		uint8_t data[NFS_READ_SIZE + (6 + NFS_MAX_ATTRS) *
+		uint8_t data[NFS_RPC_DATA_SIZE + (6 + NFS_MAX_ATTRS) *
 			sizeof(uint32_t)];
 		struct {
 			uint32_t id;
@@ -74,7 +81,7 @@ struct rpc_t {
 			uint32_t verifier;
 			uint32_t v2;
 			uint32_t astatus;
-			uint32_t data[NFS_READ_SIZE / sizeof(uint32_t) +
+			uint32_t data[NFS_RPC_DATA_SIZE / sizeof(uint32_t) +
 				NFS_MAX_ATTRS];
 		} reply;
 	} u;
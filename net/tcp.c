@@ -0,0 +1,393 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Minimal TCP client
+ *
+ * Connections are only opened actively and what we send is small (an HTTP
+ * request), so a single segment of ours is ever outstanding. Received data
+ * is accepted in sequence only; a segment that arrives out of order is
+ * dropped and answered at once with a duplicate ack, so that the peer
+ * retransmits the missing data without waiting for its timer.
+ *
+ * In-sequence data is acknowledged for every second segment, however the
+ * driver hands packets over. An ack still owed for a lone segment is sent
+ * by tcp_poll() once it has waited TCP_DELACK_MS, so a burst from the peer
+ * costs about half as many acks and nothing is held back for long.
+ *
+ * The receive window is CONFIG_TCP_RX_WINDOW bytes. Received data is stored
+ * straight away by the caller, so the window does not shrink; it is
+ * advertised with the window scale option (RFC 7323) when it does not fit
+ * in 16 bits and the peer supports it.
+ */
+
+#include <common.h>
+#include <net.h>
+#include <net/tcp.h>
+#include <asm/unaligned.h>
+
+/* Retransmission timeout, doubled for each retry */
+#define TCP_RTO_MS		1000
+#define TCP_MAX_RETRIES		6
+
+/* Longest time an ack is delayed, well within the 500ms of RFC 1122 */
+#define TCP_DELACK_MS		40
+
+#define TCP_RX_WINDOW		CONFIG_TCP_RX_WINDOW
+
+/* MSS option, then a no-op and the window scale option, sent with SYN */
+#define TCP_OPT_END		0
+#define TCP_OPT_NOP		1
+#define TCP_OPT_MSS		2
+#define TCP_OPT_WSCALE		3
+#define TCP_SYN_OPT_SIZE	8
+
+enum tcp_state {
+	TCP_CLOSED,
+	TCP_SYN_SENT,
+	TCP_ESTABLISHED,
+};
+
+static enum tcp_state tcp_state;
+static struct in_addr tcp_remote_ip;
+static uchar tcp_remote_ethaddr[ARP_HLEN];
+static int tcp_remote_port;
+static int tcp_our_port;
+static tcp_rx_hand_f *tcp_rx_handler;
+static tcp_event_hand_f *tcp_event_handler;
+
+/* Send side: [tcp_snd_una, tcp_snd_nxt) is unacknowledged */
+static u32 tcp_iss;
+static u32 tcp_snd_una;
+static u32 tcp_snd_nxt;
+static uchar tcp_tx_buf[TCP_MSS];
+static u32 tcp_tx_seq;			/* sequence number of tcp_tx_buf[0] */
+static ulong tcp_rto_start;
+static ulong tcp_rto;
+static int tcp_retries;
+
+/* Receive side */
+static u32 tcp_irs;
+static u32 tcp_rcv_nxt;
+static u8 tcp_our_wscale;		/* shift we offer in our SYN */
+static u8 tcp_rcv_wscale;		/* shift in use, 0 if the peer has none */
+static int tcp_ack_pending;		/* segments received but not acked */
+static ulong tcp_ack_start;		/* when tcp_ack_pending became set */
+
+static inline int tcp_seq_before(u32 a, u32 b)
+{
+	return (s32)(a - b) < 0;
+}
+
+static unsigned int tcp_checksum(struct ip_tcp_hdr *ip, int tcp_len)
+{
+	struct {
+		struct in_addr src;
+		struct in_addr dst;
+		u8 zero;
+		u8 proto;
+		u16 len;
+	} __packed pseudo;
+
+	pseudo.src = net_read_ip(&ip->ip_src);
+	pseudo.dst = net_read_ip(&ip->ip_dst);
+	pseudo.zero = 0;
+	pseudo.proto = IPPROTO_TCP;
+	pseudo.len = htons(tcp_len);
+
+	return add_ip_checksums(sizeof(pseudo),
+				compute_ip_checksum(&pseudo, sizeof(pseudo)),
+				compute_ip_checksum(&ip->tcp_src, tcp_len));
+}
+
+int tcp_set_tcp_header(uchar *pkt, struct in_addr dest, int dport, int sport,
+		       int payload_len, u8 action, u32 tcp_seq_num,
+		       u32 tcp_ack_num)
+{
+	struct ip_tcp_hdr *ip = (struct ip_tcp_hdr *)pkt;
+	uchar *opt = pkt + IP_TCP_HDR_SIZE;
+	int hdr_len = TCP_HDR_SIZE;
+	u32 window;
+
+	/*
+	 * The window in a SYN is never scaled. Options only go with SYN,
+	 * which carries no data, so nothing needs to be moved for them.
+	 */
+	if (action & TCP_SYN) {
+		opt[0] = TCP_OPT_MSS;
+		opt[1] = 4;
+		put_unaligned_be16(TCP_MSS, opt + 2);
+		opt[4] = TCP_OPT_NOP;
+		opt[5] = TCP_OPT_WSCALE;
+		opt[6] = 3;
+		opt[7] = tcp_our_wscale;
+		hdr_len += TCP_SYN_OPT_SIZE;
+		window = TCP_RX_WINDOW;
+	} else {
+		window = TCP_RX_WINDOW >> tcp_rcv_wscale;
+	}
+
+	net_set_ip_header(pkt, dest, net_ip, IP_HDR_SIZE + hdr_len + payload_len,
+			  IPPROTO_TCP);
+
+	ip->tcp_src = htons(sport);
+	ip->tcp_dst = htons(dport);
+	ip->tcp_seq = htonl(tcp_seq_num);
+	ip->tcp_ack = (action & TCP_ACK) ? htonl(tcp_ack_num) : 0;
+	ip->tcp_hlen = (hdr_len / 4) << 4;
+	ip->tcp_flags = action;
+	ip->tcp_win = htons(min_t(u32, window, 0xffff));
+	ip->tcp_urg = 0;
+	ip->tcp_xsum = 0;
+	ip->tcp_xsum = tcp_checksum(ip, hdr_len + payload_len);
+
+	return IP_HDR_SIZE + hdr_len;
+}
+
+static void tcp_output(u8 action, u32 seq, const uchar *data, int len)
+{
+	uchar *pkt = net_tx_packet + net_eth_hdr_size() + IP_TCP_HDR_SIZE;
+
+	if (len)
+		memcpy(pkt, data, len);
+	if (action & TCP_ACK)
+		tcp_ack_pending = 0;
+
+	net_send_ip_packet(tcp_remote_ethaddr, tcp_remote_ip, tcp_remote_port,
+			   tcp_our_port, len, IPPROTO_TCP, action, seq,
+			   tcp_rcv_nxt);
+}
+
+static void tcp_send_ack(void)
+{
+	tcp_output(TCP_ACK, tcp_snd_nxt, NULL, 0);
+}
+
+/* (Re)send whatever the peer has not acknowledged and restart the timer */
+static void tcp_transmit(void)
+{
+	if (tcp_state == TCP_SYN_SENT)
+		tcp_output(TCP_SYN, tcp_iss, NULL, 0);
+	else
+		tcp_output(TCP_ACK | TCP_PUSH, tcp_snd_una,
+			   tcp_tx_buf + (tcp_snd_una - tcp_tx_seq),
+			   tcp_snd_nxt - tcp_snd_una);
+	tcp_rto_start = get_timer(0);
+}
+
+static void tcp_restart_timer(void)
+{
+	tcp_rto = TCP_RTO_MS;
+	tcp_retries = 0;
+	tcp_rto_start = get_timer(0);
+}
+
+void tcp_connect(struct in_addr dest, int dport, tcp_rx_hand_f *rx,
+		 tcp_event_hand_f *event)
+{
+	tcp_remote_ip = dest;
+	/* A null address makes net_send_ip_packet() ARP for it */
+	memset(tcp_remote_ethaddr, 0, ARP_HLEN);
+	tcp_remote_port = dport;
+	tcp_our_port = random_port();
+	tcp_rx_handler = rx;
+	tcp_event_handler = event;
+
+	tcp_iss = get_ticks();
+	tcp_snd_una = tcp_iss;
+	tcp_snd_nxt = tcp_iss + 1;
+	tcp_tx_seq = tcp_snd_nxt;
+
+	tcp_rcv_nxt = 0;
+	for (tcp_our_wscale = 0; (TCP_RX_WINDOW >> tcp_our_wscale) > 0xffff;
+	     tcp_our_wscale++)
+		;
+	tcp_rcv_wscale = 0;
+	tcp_ack_pending = 0;
+
+	tcp_state = TCP_SYN_SENT;
+	tcp_restart_timer();
+	tcp_transmit();
+}
+
+int tcp_send(const void *data, int len)
+{
+	if (tcp_state != TCP_ESTABLISHED)
+		return -ENOTCONN;
+	if (tcp_snd_una != tcp_snd_nxt)
+		return -EBUSY;
+	if (len > TCP_MSS)
+		return -E2BIG;
+
+	memcpy(tcp_tx_buf, data, len);
+	tcp_tx_seq = tcp_snd_nxt;
+	tcp_snd_nxt += len;
+	tcp_restart_timer();
+	tcp_transmit();
+
+	return 0;
+}
+
+void tcp_close(void)
+{
+	if (tcp_state == TCP_ESTABLISHED)
+		tcp_output(TCP_FIN | TCP_ACK, tcp_snd_nxt, NULL, 0);
+	tcp_state = TCP_CLOSED;
+}
+
+void tcp_abort(void)
+{
+	tcp_state = TCP_CLOSED;
+}
+
+static void tcp_set_closed(enum tcp_event event)
+{
+	tcp_state = TCP_CLOSED;
+	tcp_event_handler(event);
+}
+
+/* Look for the window scale option in the peer's SYN */
+static void tcp_parse_options(uchar *opt, uchar *end)
+{
+	while (opt < end && *opt != TCP_OPT_END) {
+		if (*opt == TCP_OPT_NOP) {
+			opt++;
+			continue;
+		}
+		if (opt + 1 >= end || opt[1] < 2)
+			break;
+		if (opt[0] == TCP_OPT_WSCALE && opt[1] == 3)
+			tcp_rcv_wscale = tcp_our_wscale;
+		opt += opt[1];
+	}
+}
+
+static void tcp_receive_syn_ack(struct ip_tcp_hdr *ip, int hlen)
+{
+	u32 ack = ntohl(ip->tcp_ack);
+
+	if ((ip->tcp_flags & (TCP_SYN | TCP_ACK)) != (TCP_SYN | TCP_ACK) ||
+	    ack != tcp_snd_nxt)
+		return;
+
+	tcp_parse_options((uchar *)(ip + 1), (uchar *)&ip->tcp_src + hlen);
+	tcp_irs = ntohl(ip->tcp_seq);
+	tcp_rcv_nxt = tcp_irs + 1;
+	tcp_snd_una = ack;
+	tcp_state = TCP_ESTABLISHED;
+	debug_cond(DEBUG_DEV_PKT, "TCP: connected to %pI4:%d, wscale %d\n",
+		   &tcp_remote_ip, tcp_remote_port, tcp_rcv_wscale);
+
+	tcp_send_ack();
+	tcp_event_handler(TCP_CONNECTED);
+}
+
+void tcp_receive(struct ip_tcp_hdr *ip, int len)
+{
+	int tcp_len = len - IP_HDR_SIZE;
+	int hlen = (ip->tcp_hlen >> 4) * 4;
+	u8 flags = ip->tcp_flags;
+	int fin = flags & TCP_FIN ? 1 : 0;
+	unsigned int offset;
+	u32 seq, ack, skip;
+	uchar *data;
+	int dlen;
+
+	if (tcp_state == TCP_CLOSED)
+		return;
+	if (hlen < TCP_HDR_SIZE || hlen > tcp_len)
+		return;
+	if (net_read_ip(&ip->ip_src).s_addr != tcp_remote_ip.s_addr ||
+	    ntohs(ip->tcp_src) != tcp_remote_port ||
+	    ntohs(ip->tcp_dst) != tcp_our_port)
+		return;
+	if (tcp_checksum(ip, tcp_len) & 0xfffe) {
+		debug("TCP: bad checksum\n");
+		return;
+	}
+
+	if (flags & TCP_RST) {
+		tcp_set_closed(TCP_RESET);
+		return;
+	}
+
+	if (tcp_state == TCP_SYN_SENT) {
+		tcp_receive_syn_ack(ip, hlen);
+		return;
+	}
+
+	/* Our SYN-ACK ack was lost, the peer is trying again */
+	if (flags & TCP_SYN) {
+		tcp_send_ack();
+		return;
+	}
+
+	ack = ntohl(ip->tcp_ack);
+	if ((flags & TCP_ACK) && tcp_seq_before(tcp_snd_una, ack) &&
+	    !tcp_seq_before(tcp_snd_nxt, ack)) {
+		tcp_snd_una = ack;
+		tcp_restart_timer();
+	}
+
+	seq = ntohl(ip->tcp_seq);
+	data = (uchar *)&ip->tcp_src + hlen;
+	dlen = tcp_len - hlen;
+	if (!dlen && !fin)
+		return;
+
+	/* Drop what we already have, keeping anything new at the end */
+	if (tcp_seq_before(seq, tcp_rcv_nxt)) {
+		skip = tcp_rcv_nxt - seq;
+		if (skip >= dlen + fin) {
+			tcp_send_ack();
+			return;
+		}
+		data += skip;
+		dlen -= skip;
+		seq = tcp_rcv_nxt;
+	}
+
+	/* Out of order: tell the peer which data we are still missing */
+	if (seq != tcp_rcv_nxt) {
+		tcp_send_ack();
+		return;
+	}
+
+	if (dlen) {
+		offset = tcp_rcv_nxt - tcp_irs - 1;
+		tcp_rcv_nxt += dlen;
+		tcp_rx_handler(data, offset, dlen);
+		/* The handler may have closed the connection */
+		if (tcp_state == TCP_CLOSED)
+			return;
+		if (!tcp_ack_pending++)
+			tcp_ack_start = get_timer(0);
+		else
+			tcp_send_ack();
+	}
+
+	if (fin) {
+		tcp_rcv_nxt++;
+		tcp_send_ack();
+		tcp_set_closed(TCP_PEER_CLOSED);
+	}
+}
+
+void tcp_poll(void)
+{
+	if (tcp_state == TCP_CLOSED)
+		return;
+
+	if (tcp_ack_pending && get_timer(tcp_ack_start) >= TCP_DELACK_MS)
+		tcp_send_ack();
+
+	if (tcp_snd_una == tcp_snd_nxt ||
+	    get_timer(tcp_rto_start) < tcp_rto)
+		return;
+
+	if (++tcp_retries > TCP_MAX_RETRIES) {
+		tcp_set_closed(TCP_TIMEDOUT);
+		return;
+	}
+	debug_cond(DEBUG_DEV_PKT, "TCP: retransmit %u\n", tcp_retries);
+	tcp_rto *= 2;
+	tcp_transmit();
+}
@@ -140,6 +140,30 @@ static char tftp_filename[MAX_LEN];
 static unsigned short tftp_block_size = TFTP_BLOCK_SIZE;
 static unsigned short tftp_block_size_option = TFTP_MTU_BLOCKSIZE;
 
+/*
+ * RFC 7440 lets the server send a window of several blocks per ack. Blocks
+ * that arrive ahead of a lost or overtaken one are stored straight away and
+ * remembered in tftp_window_map, so that their retransmission is skipped.
+ */
+#ifdef CONFIG_TFTP_WINDOWSIZE
+#define TFTP_WINDOWSIZE CONFIG_TFTP_WINDOWSIZE
+#else
+#define TFTP_WINDOWSIZE 1
+#endif
+/* One bit per block in tftp_window_map */
+#define TFTP_WINDOWSIZE_MAX 64
+
+static unsigned short tftp_window_size = 1;
+static unsigned short tftp_window_size_option = TFTP_WINDOWSIZE;
+/* block whose arrival completes the window and is acked */
+static ulong	tftp_next_ack;
+/* last block acked because a block was missing after it */
+static ulong	tftp_last_nack;
+/* blocks received beyond tftp_prev_block, bit (block % 64) */
+static u64	tftp_window_map;
+/* the final (short) block, once it has been received */
+static ulong	tftp_final_block;
+
 static inline int store_block(int block, uchar *src, unsigned int len)
 {
 	ulong offset = block * tftp_block_size + tftp_block_wrap_offset;
@@ -194,6 +218,10 @@ static void new_transfer(void)
 	tftp_prev_block = 0;
 	tftp_block_wrap = 0;
 	tftp_block_wrap_offset = 0;
+	tftp_next_ack = tftp_window_size;
+	tftp_last_nack = TFTP_SEQUENCE_SIZE;	/* not a block number */
+	tftp_window_map = 0;
+	tftp_final_block = TFTP_SEQUENCE_SIZE;
 #ifdef CONFIG_CMD_TFTPPUT
 	tftp_put_final_block_sent = 0;
 #endif
@@ -346,6 +374,10 @@ static void tftp_send(void)
 		/* try for more effic. blk size */
 		pkt += sprintf((char *)pkt, "blksize%c%d%c",
 				0, tftp_block_size_option, 0);
+		/* and for more than one block per ack */
+		if (tftp_state == STATE_SEND_RRQ && tftp_window_size_option > 1)
+			pkt += sprintf((char *)pkt, "windowsize%c%d%c",
+					0, tftp_window_size_option, 0);
 		len = pkt - xp;
 		break;
 
@@ -416,6 +448,7 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 {
 	__be16 proto;
 	__be16 *s;
+	ulong block, offset, ahead;
 	int i;
 
 	if (dest != tftp_our_port) {
@@ -490,6 +523,18 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 				debug("Blocksize ack: %s, %d\n",
 				      (char *)pkt + i + 8, tftp_block_size);
 			}
+			if (strcmp((char *)pkt + i, "windowsize") == 0) {
+				tftp_window_size = (unsigned short)
+					simple_strtoul((char *)pkt + i + 11,
+						       NULL, 10);
+				debug("Windowsize ack: %s, %d\n",
+				      (char *)pkt + i + 11, tftp_window_size);
+				/* The server may only lower what we asked for */
+				if (!tftp_window_size ||
+				    tftp_window_size > tftp_window_size_option)
+					tftp_window_size =
+						tftp_window_size_option;
+			}
 #ifdef CONFIG_TFTP_TSIZE
 			if (strcmp((char *)pkt+i, "tsize") == 0) {
 				tftp_tsize = simple_strtoul((char *)pkt + i + 6,
@@ -512,9 +557,7 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		if (len < 2)
 			return;
 		len -= 2;
-		tftp_cur_block = ntohs(*(__be16 *)pkt);
-
-		update_block_number();
+		block = ntohs(*(__be16 *)pkt);
 
 		if (tftp_state == STATE_SEND_RRQ)
 			debug("Server did not acknowledge timeout option!\n");
@@ -526,39 +569,76 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			tftp_remote_port = src;
 			new_transfer();
 
-			if (tftp_cur_block != 1) {	/* Assertion */
+			/*
+			 * With a window, block 1 may have been lost or
+			 * overtaken by the ones after it
+			 */
+			if (!block || block > tftp_window_size) {
 				puts("\nTFTP error: ");
 				printf("First block is not block 1 (%ld)\n",
-				       tftp_cur_block);
+				       block);
 				puts("Starting again\n\n");
 				net_start_again();
 				break;
 			}
 		}
 
-		if (tftp_cur_block == tftp_prev_block) {
-			/* Same block again; ignore it. */
+		/* How far past the last block received in sequence is it? */
+		offset = (block - tftp_prev_block) % TFTP_SEQUENCE_SIZE;
+		if (!offset || offset > tftp_window_size ||
+		    tftp_window_map & BIT_ULL(block % TFTP_WINDOWSIZE_MAX)) {
+			/* Same block again, or outside the window; ignore it */
 			break;
 		}
 
-		tftp_prev_block = tftp_cur_block;
 		timeout_count_max = tftp_timeout_count_max;
 		net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
 
-		if (store_block(tftp_cur_block - 1, pkt + 2, len)) {
+		if (store_block(tftp_prev_block + offset - 1, pkt + 2, len)) {
 			eth_halt();
 			net_set_state(NETLOOP_FAIL);
 			break;
 		}
+		tftp_window_map |= BIT_ULL(block % TFTP_WINDOWSIZE_MAX);
+		if (len < tftp_block_size)
+			tftp_final_block = block;
+
+		/* Move past every block we now hold in sequence */
+		while (tftp_window_map &
+		       BIT_ULL((tftp_prev_block + 1) % TFTP_WINDOWSIZE_MAX)) {
+			tftp_cur_block = (tftp_prev_block + 1) %
+					 TFTP_SEQUENCE_SIZE;
+			tftp_window_map &= ~BIT_ULL(tftp_cur_block %
+						    TFTP_WINDOWSIZE_MAX);
+			update_block_number();
+			tftp_prev_block = tftp_cur_block;
+		}
+		tftp_cur_block = tftp_prev_block;
 
 		/*
-		 *	Acknowledge the block just received, which will prompt
-		 *	the remote for the next one.
+		 *	Acknowledge the last block received in sequence once
+		 *	the window is complete, which will prompt the remote
+		 *	for the next one. If blocks are held beyond a missing
+		 *	one, ack straight away so that the remote starts
+		 *	again from the gap rather than waiting to time out.
 		 */
-		tftp_send();
-
-		if (len < tftp_block_size)
+		if (tftp_cur_block == tftp_final_block) {
+			tftp_send();
 			tftp_complete();
+			break;
+		}
+
+		ahead = (tftp_next_ack - tftp_cur_block) % TFTP_SEQUENCE_SIZE;
+		if (!ahead || ahead > tftp_window_size) {
+			tftp_send();
+		} else if (tftp_window_map && tftp_last_nack != tftp_cur_block) {
+			tftp_send();
+			tftp_last_nack = tftp_cur_block;
+		} else {
+			break;
+		}
+		tftp_next_ack = (tftp_cur_block + tftp_window_size) %
+				TFTP_SEQUENCE_SIZE;
 		break;
 
 	case TFTP_ERROR:
@@ -632,6 +712,18 @@ void tftp_start(enum proto_t protocol)
 	if (ep != NULL)
 		tftp_block_size_option = simple_strtol(ep, NULL, 10);
 
+	ep = env_get("tftpwindowsize");
+	if (ep != NULL)
+		tftp_window_size_option = simple_strtol(ep, NULL, 10);
+
+	if (tftp_window_size_option < 1)
+		tftp_window_size_option = 1;
+	if (tftp_window_size_option > TFTP_WINDOWSIZE_MAX) {
+		printf("TFTP window size (%d) too large, set max = %d\n",
+		       tftp_window_size_option, TFTP_WINDOWSIZE_MAX);
+		tftp_window_size_option = TFTP_WINDOWSIZE_MAX;
+	}
+
 	ep = env_get("tftptimeout");
 	if (ep != NULL)
 		timeout_ms = simple_strtol(ep, NULL, 10);
@@ -653,8 +745,8 @@ void tftp_start(enum proto_t protocol)
 	}
 #endif
 
-	debug("TFTP blocksize = %i, timeout = %ld ms\n",
-	      tftp_block_size_option, timeout_ms);
+	debug("TFTP blocksize = %i, windowsize = %i, timeout = %ld ms\n",
+	      tftp_block_size_option, tftp_window_size_option, timeout_ms);
 
 	tftp_remote_ip = net_server_ip;
 	if (!net_parse_bootfile(&tftp_remote_ip, tftp_filename, MAX_LEN)) {
@@ -753,8 +845,9 @@ void tftp_start(enum proto_t protocol)
 
 	/* zero out server ether in case the server ip has changed */
 	memset(net_server_ethaddr, 0, 6);
-	/* Revert tftp_block_size to dflt */
+	/* Revert tftp_block_size and tftp_window_size to dflt */
 	tftp_block_size = TFTP_BLOCK_SIZE;
+	tftp_window_size = 1;
 #ifdef CONFIG_TFTP_TSIZE
 	tftp_tsize = 0;
 	tftp_tsize_num_hash = 0;
@@ -785,8 +878,9 @@ void tftp_start_server(void)
 	timeout_ms = TIMEOUT;
 	net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
 
-	/* Revert tftp_block_size to dflt */
+	/* Revert tftp_block_size and tftp_window_size to dflt */
 	tftp_block_size = TFTP_BLOCK_SIZE;
+	tftp_window_size = 1;
 	tftp_cur_block = 0;
 	tftp_our_port = WELL_KNOWN_PORT;
 
@@ -0,0 +1,285 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * HTTP download over TCP
+ *
+ * One HTTP/1.0 GET request is sent, so the server closes the connection
+ * after the body. The body is stored at load_addr as it arrives; its size is
+ * taken from Content-Length when the server gives one, and otherwise the
+ * end of the connection marks the end of the file.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <mapmem.h>
+#include <net.h>
+#include <net/tcp.h>
+#include <net/wget.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define WGET_PORT		80
+#define WGET_TIMEOUT		10000UL	/* ms without progress before giving up */
+#define WGET_MAX_PATH		256
+#define WGET_MAX_HEADER		1024
+#define WGET_HASH_SIZE		(64 * 1024)
+#define HASHES_PER_LINE		65
+
+static struct in_addr wget_server_ip;
+static int wget_server_port;
+static char wget_filename[WGET_MAX_PATH];
+static ulong wget_load_addr;
+#ifdef CONFIG_LMB
+static ulong wget_load_size;
+#endif
+static ulong time_start;
+
+/* Response header, kept until the blank line that ends it */
+static char wget_header[WGET_MAX_HEADER + 1];
+static unsigned int wget_header_len;
+/* Stream offset of the first byte of the body, 0 until it is known */
+static unsigned int wget_body_start;
+/* Size from Content-Length, or -1 if the server did not give it */
+static long wget_content_length;
+static ulong wget_next_hash;
+static int wget_hashes;
+
+static int wget_init_load_addr(void)
+{
+#ifdef CONFIG_LMB
+	struct lmb lmb;
+	phys_size_t max_size;
+
+	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
+
+	max_size = lmb_get_free_size(&lmb, load_addr);
+	if (!max_size)
+		return -1;
+
+	wget_load_size = max_size;
+#endif
+	wget_load_addr = load_addr;
+	return 0;
+}
+
+static void wget_fail(const char *msg)
+{
+	tcp_close();
+	printf("\nwget error: %s\n", msg);
+	net_set_state(NETLOOP_FAIL);
+}
+
+static void wget_complete(void)
+{
+	time_start = get_timer(time_start);
+	if (time_start > 0) {
+		puts("\n\t ");	/* Line up with "Loading: " */
+		print_size(net_boot_file_size / time_start * 1000, "/s");
+	}
+	puts("\ndone\n");
+	net_set_state(NETLOOP_SUCCESS);
+}
+
+static void wget_timeout_handler(void)
+{
+	tcp_abort();
+	puts("\nwget error: timed out\n");
+	net_set_state(NETLOOP_FAIL);
+}
+
+static void wget_send_request(void)
+{
+	char req[TCP_MSS];
+	int len;
+
+	len = snprintf(req, sizeof(req),
+		       "GET %s%s HTTP/1.0\r\nHost: %pI4\r\n"
+		       "Connection: close\r\n\r\n",
+		       wget_filename[0] == '/' ? "" : "/", wget_filename,
+		       &wget_server_ip);
+	if (len >= sizeof(req) || tcp_send(req, len))
+		wget_fail("cannot send request");
+}
+
+/* Check the status line and look for the size of the body */
+static int wget_parse_header(void)
+{
+	char *line, *p;
+	int status;
+
+	if (strncmp(wget_header, "HTTP/", 5))
+		return -EPROTO;
+	p = strchr(wget_header, ' ');
+	if (!p)
+		return -EPROTO;
+	status = simple_strtoul(p + 1, NULL, 10);
+	if (status != 200) {
+		p = strchr(wget_header, '\r');
+		printf("\nwget error: %.*s\n", (int)(p - wget_header),
+		       wget_header);
+		return -ENOENT;
+	}
+
+	wget_content_length = -1;
+	for (line = strstr(wget_header, "\r\n"); line;
+	     line = strstr(line, "\r\n")) {
+		line += 2;
+		if (!strncasecmp(line, "Content-Length:", 15)) {
+			wget_content_length = simple_strtoul(line + 15, NULL,
+							     10);
+			break;
+		}
+	}
+
+	return 0;
+}
+
+/* Collect the response header; returns 0 once the body has started */
+static int wget_receive_header(uchar *data, unsigned int len)
+{
+	unsigned int n = min(len, WGET_MAX_HEADER - wget_header_len);
+	char *end;
+	int ret;
+
+	memcpy(wget_header + wget_header_len, data, n);
+	wget_header_len += n;
+	wget_header[wget_header_len] = '\0';
+
+	end = strstr(wget_header, "\r\n\r\n");
+	if (!end) {
+		if (wget_header_len == WGET_MAX_HEADER)
+			wget_fail("response header too long");
+		return -EAGAIN;
+	}
+	end[2] = '\0';
+	wget_body_start = end + 4 - wget_header;
+
+	ret = wget_parse_header();
+	if (ret) {
+		if (ret == -EPROTO)
+			wget_fail("bad response");
+		else
+			wget_fail("file not loaded");
+		return ret;
+	}
+
+	return 0;
+}
+
+static int wget_store(ulong offset, uchar *src, unsigned int len)
+{
+	void *ptr;
+
+#ifdef CONFIG_LMB
+	if (offset + len > wget_load_size) {
+		wget_fail("trying to overwrite reserved memory...");
+		return -1;
+	}
+#endif
+	ptr = map_sysmem(wget_load_addr + offset, len);
+	memcpy(ptr, src, len);
+	unmap_sysmem(ptr);
+
+	net_boot_file_size = offset + len;
+	while (net_boot_file_size >= wget_next_hash) {
+		putc('#');
+		if (++wget_hashes % HASHES_PER_LINE == 0)
+			puts("\n\t ");
+		wget_next_hash += WGET_HASH_SIZE;
+	}
+
+	return 0;
+}
+
+static void wget_rx(uchar *data, unsigned int offset, unsigned int len)
+{
+	unsigned int skip;
+
+	net_set_timeout_handler(WGET_TIMEOUT, wget_timeout_handler);
+
+	if (!wget_body_start && wget_receive_header(data, len))
+		return;
+
+	if (offset < wget_body_start) {
+		skip = min(len, wget_body_start - offset);
+		data += skip;
+		len -= skip;
+		offset += skip;
+	}
+	/* Ignore anything the server sends past Content-Length */
+	if (wget_content_length >= 0 &&
+	    offset - wget_body_start + len > wget_content_length)
+		len = max(0L, wget_content_length -
+			  (long)(offset - wget_body_start));
+	if (len && wget_store(offset - wget_body_start, data, len))
+		return;
+
+	/* Checked even without body data, for Content-Length: 0 */
+	if (wget_content_length >= 0 &&
+	    net_boot_file_size >= wget_content_length) {
+		tcp_close();
+		wget_complete();
+	}
+}
+
+static void wget_event(enum tcp_event event)
+{
+	switch (event) {
+	case TCP_CONNECTED:
+		net_set_timeout_handler(WGET_TIMEOUT, wget_timeout_handler);
+		wget_send_request();
+		break;
+	case TCP_PEER_CLOSED:
+		if (!wget_body_start)
+			wget_fail("no response");
+		else if (wget_content_length >= 0 &&
+			 net_boot_file_size < wget_content_length)
+			wget_fail("connection closed early");
+		else
+			wget_complete();
+		break;
+	case TCP_RESET:
+		wget_fail("connection reset");
+		break;
+	case TCP_TIMEDOUT:
+		wget_fail("no reply from server");
+		break;
+	}
+}
+
+void wget_start(void)
+{
+	wget_server_ip = net_server_ip;
+	if (!net_parse_bootfile(&wget_server_ip, wget_filename,
+				sizeof(wget_filename))) {
+		puts("\nwget error: no file name\n");
+		net_set_state(NETLOOP_FAIL);
+		return;
+	}
+	wget_server_port = env_get_ulong("httpdstp", 10, WGET_PORT);
+
+	printf("Using %s device\n", eth_get_name());
+	printf("HTTP from server %pI4:%d; our IP address is %pI4\n",
+	       &wget_server_ip, wget_server_port, &net_ip);
+	printf("Filename '%s'.\n", wget_filename);
+
+	if (wget_init_load_addr()) {
+		eth_halt();
+		net_set_state(NETLOOP_FAIL);
+		puts("\nwget error: trying to overwrite reserved memory...\n");
+		return;
+	}
+	printf("Load address: 0x%lx\n", wget_load_addr);
+	puts("Loading: *\b");
+
+	wget_header_len = 0;
+	wget_body_start = 0;
+	wget_content_length = -1;
+	wget_next_hash = WGET_HASH_SIZE;
+	wget_hashes = 0;
+	time_start = get_timer(0);
+	net_boot_file_size = 0;
+
+	/* Give up on a dead server long before the SYN retries run out */
+	net_set_timeout_handler(WGET_TIMEOUT, wget_timeout_handler);
+	tcp_connect(wget_server_ip, wget_server_port, wget_rx, wget_event);
+}
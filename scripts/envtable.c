@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Convert a default environment on stdin to a C table on stdout
+ *
+ * The input is the default_environment[] array as built into U-Boot, i.e.
+ * "name=value" strings each ended by '\0', with an empty string at the end.
+ * It is parsed as himport_r() would, and the variables are written out as a
+ * table of struct hsearch_base sorted by name, so that U-Boot can look them
+ * up in place instead of importing them at each boot.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct var {
+	char *name;
+	char *value;
+};
+
+static struct var *vars;
+static int nvars;
+
+static int var_cmp(const void *p1, const void *p2)
+{
+	const struct var *v1 = p1, *v2 = p2;
+
+	return strcmp(v1->name, v2->name);
+}
+
+static struct var *var_find(const char *name)
+{
+	int i;
+
+	for (i = 0; i < nvars; i++) {
+		if (!strcmp(vars[i].name, name))
+			return &vars[i];
+	}
+
+	return NULL;
+}
+
+/* Add a variable, or remove it if value is NULL; the last setting wins */
+static void var_set(char *name, char *value)
+{
+	struct var *var = var_find(name);
+
+	if (!value) {
+		if (var)
+			*var = vars[--nvars];
+		return;
+	}
+	if (!var) {
+		vars = realloc(vars, (nvars + 1) * sizeof(*vars));
+		if (!vars) {
+			perror("envtable");
+			exit(1);
+		}
+		var = &vars[nvars++];
+	}
+	var->name = name;
+	var->value = value;
+}
+
+static void put_string(const char *s)
+{
+	putchar('"');
+	for (; *s; s++) {
+		unsigned char ch = *s;
+
+		if (ch == '"' || ch == '\\' || ch == '?')
+			printf("\\%c", ch);
+		else if (ch < ' ' || ch > '~')
+			printf("\\%03o", ch);
+		else
+			putchar(ch);
+	}
+	putchar('"');
+}
+
+int main(void)
+{
+	char *data = NULL, *end, *dp, *sp, *name, *value;
+	size_t size = 0, alloc = 0, len;
+	int i;
+
+	do {
+		alloc += 4096;
+		data = realloc(data, alloc + 1);
+		if (!data) {
+			perror("envtable");
+			return 1;
+		}
+		len = fread(data + size, 1, alloc - size, stdin);
+		size += len;
+	} while (size == alloc);
+	data[size] = '\0';
+	end = data + size;
+
+	/* The same rules as himport_r() with a '\0' separator */
+	for (dp = data; dp < end && *dp;) {
+		while (*dp == ' ' || *dp == '\t')
+			++dp;
+
+		/* comment */
+		if (*dp == '#') {
+			dp += strlen(dp) + 1;
+			continue;
+		}
+
+		for (name = dp; *dp != '=' && *dp; ++dp)
+			;
+
+		/* "name" and "name=" delete the variable */
+		if (*dp == '\0' || dp[1] == '\0') {
+			if (*dp == '=')
+				*dp++ = '\0';
+			++dp;
+			var_set(name, NULL);
+			continue;
+		}
+		*dp++ = '\0';
+
+		/* the value, without its escapes */
+		for (value = sp = dp; *dp; ++dp) {
+			if (*dp == '\\' && dp[1])
+				++dp;
+			*sp++ = *dp;
+		}
+		*sp = '\0';
+		++dp;
+
+		if (*name == '\0') {
+			fprintf(stderr, "envtable: empty variable name\n");
+			return 1;
+		}
+		var_set(name, value);
+	}
+
+	qsort(vars, nvars, sizeof(*vars), var_cmp);
+
+	printf("/* Generated by scripts/envtable - do not edit */\n\n");
+	printf("#include <common.h>\n");
+	printf("#include <environment.h>\n\n");
+	printf("const struct hsearch_base env_default_table[] = {\n");
+	for (i = 0; i < nvars; i++) {
+		printf("\t{ ");
+		put_string(vars[i].name);
+		printf(", ");
+		put_string(vars[i].value);
+		printf(" },\n");
+	}
+	printf("};\n\n");
+	printf("const unsigned int env_default_count = %d;\n", nvars);
+
+	return 0;
+}
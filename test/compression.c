@@ -18,6 +18,7 @@
 #include <lzma/LzmaTools.h>
 
 #include <linux/lzo.h>
+#include <linux/zstd.h>
 #include <test/compression.h>
 #include <test/suites.h>
 #include <test/ut.h>
@@ -117,6 +118,29 @@ static const char lz4_compressed[] =
 	"\x9d\x12\x8c\x9d";
 static const unsigned long lz4_compressed_size = 276;
 
+/*
+ * Two frames, as produced by parallel compressors such as pzstd:
+ * head -c 120 /tmp/plain.txt | zstd -19 > /tmp/plain.zst
+ * tail -c +121 /tmp/plain.txt | zstd -19 >> /tmp/plain.zst
+ */
+static const char zstd_compressed[] =
+	"\x28\xb5\x2f\xfd\x24\x78\x8d\x01\x00\x94\x02\x49\x20\x61\x6d\x20"
+	"\x61\x20\x68\x69\x67\x68\x6c\x79\x20\x63\x6f\x6d\x70\x72\x65\x73"
+	"\x73\x61\x62\x6c\x65\x20\x62\x69\x74\x20\x6f\x66\x20\x74\x65\x78"
+	"\x74\x2e\x0a\x49\x01\x00\xe1\x85\xaa\x32\x32\x1c\x96\x9a\x28\xb5"
+	"\x2f\xfd\x24\xe6\xed\x04\x00\x52\xcc\x21\x17\x90\x3b\x07\x40\x5b"
+	"\x13\x8b\xa7\x65\x34\x12\x21\x4b\x60\x73\x76\x5d\xd1\x75\x93\x9b"
+	"\xbd\x04\x49\xd0\x27\xa9\x7a\x97\xf6\xf9\x1a\x81\xbe\x4a\xa8\x45"
+	"\x08\x17\xbf\xc9\x75\xc3\x70\xad\x31\xbf\x2c\xe9\xa5\xd8\x72\x52"
+	"\x00\xa5\x13\xc0\xa8\x79\x2d\x73\xbc\x9a\x6f\xde\xc1\xc2\x55\xb6"
+	"\xc5\xab\x91\x21\x7e\xcc\x77\x4e\x1e\x53\x7d\x5c\x1c\x54\xe9\x31"
+	"\x5f\xdf\xd5\x4b\x31\xce\x37\xbc\xc0\x3b\x1a\x03\x9d\x75\x10\xbf"
+	"\x11\x2e\x35\xf4\x1c\x13\x46\x88\x24\xfc\x31\x67\x65\xfe\x83\x56"
+	"\xb6\xd6\xcb\x18\x0e\xee\x7c\x85\x35\x43\x2f\x9d\x1f\xd3\x8f\x5f"
+	"\x45\x06\x00\x18\x1b\x65\x51\xd4\x83\x19\xe2\xcd\x45\x89\xe0\xfb"
+	"\x54\x5b\x05\x05\x2f\xcd\xb1\x6e";
+static const unsigned long zstd_compressed_size = 232;
+
 
 #define TEST_BUFFER_SIZE	512
 
@@ -292,6 +316,48 @@ static int uncompress_using_lz4(struct unit_test_state *uts,
 	return (ret != 0);
 }
 
+static int compress_using_zstd(struct unit_test_state *uts,
+			       void *in, unsigned long in_size,
+			       void *out, unsigned long out_max,
+			       unsigned long *out_size)
+{
+	/* There is no zstd compression in u-boot, so fake it. */
+	ut_asserteq(in_size, strlen(plain));
+	ut_asserteq(0, memcmp(plain, in, in_size));
+
+	if (zstd_compressed_size > out_max)
+		return -1;
+
+	memcpy(out, zstd_compressed, zstd_compressed_size);
+	if (out_size)
+		*out_size = zstd_compressed_size;
+
+	return 0;
+}
+
+static int uncompress_using_zstd(struct unit_test_state *uts,
+				 void *in, unsigned long in_size,
+				 void *out, unsigned long out_max,
+				 unsigned long *out_size)
+{
+	size_t wsize = ZSTD_DCtxWorkspaceBound();
+	ZSTD_DCtx *dctx;
+	void *workspace;
+	size_t ret;
+
+	workspace = malloc(wsize);
+	ut_assertnonnull(workspace);
+	dctx = ZSTD_initDCtx(workspace, wsize);
+	ret = ZSTD_decompressDCtx(dctx, out, out_max, in, in_size);
+	free(workspace);
+	if (ZSTD_isError(ret))
+		return 1;
+	if (out_size)
+		*out_size = ret;
+
+	return 0;
+}
+
 #define errcheck(statement) if (!(statement)) { \
 	fprintf(stderr, "\tFailed: %s\n", #statement); \
 	ret = 1; \
@@ -436,6 +502,69 @@ static int compression_test_lz4(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_lz4, 0);
 
+static int compression_test_zstd(struct unit_test_state *uts)
+{
+	return run_test(uts, "zstd", compress_using_zstd,
+			uncompress_using_zstd);
+}
+COMPRESSION_TEST(compression_test_zstd, 0);
+
+/*
+ * Decompress @count copies of @in_size bytes of compressed data placed one
+ * after the other and check that the copies of plain[] come out in order
+ */
+static int run_concat_test(struct unit_test_state *uts, mutate_func uncompress,
+			   const void *in, ulong in_size, int count)
+{
+	ulong plain_size = strlen(plain);
+	ulong out_size;
+	char *src, *dst;
+	int i;
+
+	src = malloc(in_size * count);
+	ut_assertnonnull(src);
+	dst = malloc(plain_size * count + 1);
+	ut_assertnonnull(dst);
+	for (i = 0; i < count; i++)
+		memcpy(src + i * in_size, in, in_size);
+
+	memset(dst, 'A', plain_size * count + 1);
+	ut_assertok(uncompress(uts, src, in_size * count, dst,
+			       plain_size * count, &out_size));
+	ut_asserteq(plain_size * count, out_size);
+	for (i = 0; i < count; i++)
+		ut_assertok(memcmp(plain, dst + i * plain_size, plain_size));
+	ut_asserteq('A', dst[plain_size * count]);
+
+	/* the last copy does not fit */
+	ut_assert(uncompress(uts, src, in_size * count, dst,
+			     plain_size * count - 1, NULL));
+
+	free(dst);
+	free(src);
+
+	return 0;
+}
+
+static int compression_test_gzip_multi(struct unit_test_state *uts)
+{
+	char buf[TEST_BUFFER_SIZE];
+	ulong size;
+
+	ut_assertok(compress_using_gzip(uts, (void *)plain, strlen(plain), buf,
+					sizeof(buf), &size));
+
+	return run_concat_test(uts, uncompress_using_gzip, buf, size, 3);
+}
+COMPRESSION_TEST(compression_test_gzip_multi, 0);
+
+static int compression_test_lz4_multi(struct unit_test_state *uts)
+{
+	return run_concat_test(uts, uncompress_using_lz4, lz4_compressed,
+			       lz4_compressed_size, 3);
+}
+COMPRESSION_TEST(compression_test_lz4_multi, 0);
+
 static int compress_using_none(struct unit_test_state *uts,
 			       void *in, unsigned long in_size,
 			       void *out, unsigned long out_max,
@@ -526,6 +655,12 @@ static int compression_test_bootm_lz4(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_bootm_lz4, 0);
 
+static int compression_test_bootm_zstd(struct unit_test_state *uts)
+{
+	return run_bootm_test(uts, IH_COMP_ZSTD, compress_using_zstd);
+}
+COMPRESSION_TEST(compression_test_bootm_zstd, 0);
+
 static int compression_test_bootm_none(struct unit_test_state *uts)
 {
 	return run_bootm_test(uts, IH_COMP_NONE, compress_using_none);
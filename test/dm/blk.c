@@ -162,3 +162,99 @@ static int dm_test_blk_get_from_parent(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_blk_get_from_parent, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(BLOCK_CACHE)
+/* Test that the block cache serves overlapping and sequential reads */
+static int dm_test_blk_cache(struct unit_test_state *uts)
+{
+	struct block_cache_stats stats;
+	struct blk_desc *desc;
+	struct udevice *dev;
+	char buf[4 * 512];
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	ut_assertok(blk_get_device_by_str("mmc", "0", &desc));
+	blkcache_invalidate(desc->if_type, desc->devnum);
+	blkcache_stats(&stats);
+
+	/* Any read whose blocks were all read before is a hit */
+	ut_asserteq(4, blk_dread(desc, 20, 4, buf));
+	ut_asserteq(2, blk_dread(desc, 21, 2, buf));
+	ut_asserteq(1, blk_dread(desc, 23, 1, buf));
+	blkcache_stats(&stats);
+	ut_asserteq(2, stats.hits);
+	ut_asserteq(1, stats.misses);
+	ut_asserteq(4, stats.entries);
+
+	/* A read following on from the last miss also reads ahead */
+	ut_asserteq(1, blk_dread(desc, 24, 1, buf));
+	ut_asserteq(1, blk_dread(desc, 25, 1, buf));
+	ut_asserteq(1, blk_dread(desc, 26, 1, buf));
+	blkcache_stats(&stats);
+	ut_asserteq(2, stats.hits);
+	ut_asserteq(1, stats.misses);
+	ut_asserteq(7, stats.entries);
+
+	blkcache_invalidate(desc->if_type, desc->devnum);
+	blkcache_stats(&stats);
+	ut_asserteq(0, stats.entries);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_cache, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#if IS_ENABLED(CONFIG_BLOCK_CACHE_WRITEBACK)
+/* Test that the block cache holds back writes and flushes them */
+static int dm_test_blk_cache_writeback(struct unit_test_state *uts)
+{
+	struct block_cache_stats stats;
+	struct blk_desc *desc;
+	struct udevice *dev;
+	char buf[2 * 512], out[2 * 512];
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	ut_assertok(blk_get_device_by_str("mmc", "0", &desc));
+	blkcache_invalidate(desc->if_type, desc->devnum);
+
+	/* Without write-back, writes go straight to the device */
+	memset(out, 0xa5, sizeof(out));
+	ut_asserteq(2, blk_dwrite(desc, 40, 2, out));
+	blkcache_stats(&stats);
+	ut_asserteq(0, stats.dirty);
+
+	ut_assertok(blkcache_writeback(desc->if_type, desc->devnum, true));
+	ut_asserteq(2, blk_dwrite(desc, 40, 2, out));
+	ut_asserteq(1, blk_dwrite(desc, 43, 1, out));
+	blkcache_stats(&stats);
+	ut_asserteq(3, stats.dirty);
+
+	/* Dirty blocks are read back from the cache */
+	ut_asserteq(2, blk_dread(desc, 40, 2, buf));
+	ut_assertok(memcmp(out, buf, sizeof(buf)));
+	blkcache_stats(&stats);
+	ut_asserteq(1, stats.hits);
+
+	/* A read that must go to the device writes them back first */
+	ut_asserteq(2, blk_dread(desc, 42, 2, buf));
+	blkcache_stats(&stats);
+	ut_asserteq(0, stats.dirty);
+
+	ut_asserteq(1, blk_dwrite(desc, 41, 1, out));
+	blkcache_stats(&stats);
+	ut_asserteq(1, stats.dirty);
+	ut_assertok(blkcache_writeback(desc->if_type, desc->devnum, false));
+	blkcache_stats(&stats);
+	ut_asserteq(0, stats.dirty);
+
+	/* Write-back is off again */
+	ut_asserteq(1, blk_dwrite(desc, 41, 1, out));
+	blkcache_stats(&stats);
+	ut_asserteq(0, stats.dirty);
+
+	blkcache_invalidate(desc->if_type, desc->devnum);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_cache_writeback, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+#endif
+#endif
@@ -70,6 +70,11 @@ static struct driver_info driver_info_act_dma = {
 	.name = "test_act_dma_drv",
 };
 
+static struct driver_info driver_info_async = {
+	.name = "test_async_drv",
+	.platdata = &test_pdata_manual,
+};
+
 void dm_leak_check_start(struct unit_test_state *uts)
 {
 	uts->start = mallinfo();
@@ -721,6 +726,73 @@ static int dm_test_remove_active_dma(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_remove_active_dma, 0);
 
+/* Test that a device can finish probing in the background */
+static int dm_test_probe_async(struct unit_test_state *uts)
+{
+	struct dm_test_state *dms = uts->priv;
+	struct dm_test_priv *priv;
+	struct udevice *dev;
+
+	ut_assertok(device_bind_by_name(dms->root, false, &driver_info_async,
+					&dev));
+	ut_assertok(device_probe_async(dev));
+	priv = dev_get_priv(dev);
+	ut_assert(priv);
+	if (CONFIG_IS_ENABLED(DM_PROBE_ASYNC)) {
+		ut_assert(dev->flags & DM_FLAG_PROBE_PENDING);
+		ut_assert(!device_active(dev));
+		ut_asserteq(DM_TEST_ASYNC_STEPS, priv->probe_steps);
+		ut_asserteq(0, dm_testdrv_op_count[DM_TEST_OP_POST_PROBE]);
+
+		/* Polling lets it progress without finishing */
+		dm_probe_poll();
+		ut_asserteq(DM_TEST_ASYNC_STEPS - 1, priv->probe_steps);
+		ut_assert(dev->flags & DM_FLAG_PROBE_PENDING);
+
+		/* Using the device waits for it */
+		ut_assertok(device_probe(dev));
+	}
+	ut_assert(!(dev->flags & DM_FLAG_PROBE_PENDING));
+	ut_assert(device_active(dev));
+	ut_asserteq(0, priv->probe_steps);
+	ut_asserteq(DM_TEST_START_TOTAL, priv->ping_total);
+	ut_asserteq(1, dm_testdrv_op_count[DM_TEST_OP_POST_PROBE]);
+
+	/* Removing it while it is being probed waits for the probe first */
+	ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+	ut_assertok(device_probe_async(dev));
+	ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+	ut_assert(!device_active(dev));
+	ut_asserteq(2, dm_testdrv_op_count[DM_TEST_OP_POST_PROBE]);
+	ut_asserteq(2, dm_testdrv_op_count[DM_TEST_OP_REMOVE]);
+
+	return 0;
+}
+DM_TEST(dm_test_probe_async, 0);
+
+/* Test that unbinding a device drops a probe still in progress */
+static int dm_test_probe_async_unbind(struct unit_test_state *uts)
+{
+	struct dm_test_state *dms = uts->priv;
+	struct udevice *dev;
+
+	ut_assertok(device_bind_by_name(dms->root, false, &driver_info_async,
+					&dev));
+	ut_assertok(device_probe_async(dev));
+	if (!CONFIG_IS_ENABLED(DM_PROBE_ASYNC))
+		return 0;
+	ut_assert(dev->flags & DM_FLAG_PROBE_PENDING);
+	ut_assertok(device_unbind(dev));
+
+	/* Nothing is left for polling to finish */
+	dm_probe_poll();
+	ut_asserteq(0, dm_testdrv_op_count[DM_TEST_OP_POST_PROBE]);
+	ut_asserteq(0, dm_testdrv_op_count[DM_TEST_OP_REMOVE]);
+
+	return 0;
+}
+DM_TEST(dm_test_probe_async_unbind, 0);
+
 static int dm_test_uclass_before_ready(struct unit_test_state *uts)
 {
 	struct uclass *uc;
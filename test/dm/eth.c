@@ -10,11 +10,14 @@
 #include <dm.h>
 #include <fdtdec.h>
 #include <malloc.h>
+#include <mapmem.h>
 #include <net.h>
+#include <net/tcp.h>
 #include <dm/test.h>
 #include <dm/device-internal.h>
 #include <dm/uclass-internal.h>
 #include <asm/eth.h>
+#include <asm/unaligned.h>
 #include <test/ut.h>
 
 #define DM_TEST_ETH_NUM		4
@@ -428,3 +431,683 @@ static int dm_test_eth_async_ping_reply(struct unit_test_state *uts)
 }
 
 DM_TEST(dm_test_eth_async_ping_reply, DM_TESTF_SCAN_FDT);
+
+/* Packets waiting in the driver are handed over a whole ring at a time */
+static int dm_test_eth_rx_batch(struct unit_test_state *uts)
+{
+	struct eth_sandbox_priv *priv;
+	struct udevice *dev;
+	int i;
+
+	net_init();
+	env_set("ethact", "eth@10002000");
+	ut_assertok(eth_init());
+	dev = eth_get_dev();
+	priv = dev_get_priv(dev);
+
+	for (i = 0; i < SANDBOX_ETH_RX_RING + 2; i++)
+		ut_assertok(sandbox_eth_recv_arp_req(dev));
+	ut_asserteq(SANDBOX_ETH_RX_RING, eth_rx());
+	ut_asserteq(2, priv->recv_packets);
+	ut_asserteq(2, eth_rx());
+	ut_asserteq(0, priv->recv_packets);
+	ut_asserteq(0, eth_rx());
+
+	eth_halt();
+
+	return 0;
+}
+
+DM_TEST(dm_test_eth_rx_batch, DM_TESTF_SCAN_FDT);
+
+/* What a lossy link does to a packet matching its pattern */
+enum sb_link_mode {
+	SB_LINK_DROP,
+	SB_LINK_HOLD,
+};
+
+/**
+ * struct sb_lossy_link - link from a fake server to the client which loses
+ * or delays the first copy of some packets
+ *
+ * The server numbers its packets (blocks, segments...). The first copy of
+ * every packet whose number is @phase modulo @period is dropped or, with
+ * SB_LINK_HOLD, held back and delivered after the next packet.
+ *
+ * @mode: what happens to a matching packet
+ * @period: period of the pattern
+ * @phase: number of the first matching packet
+ * @seen: packets already passed through the link, bit per packet
+ * @hits: number of packets dropped or held back
+ * @held: packet held back
+ * @held_len: size of @held in bytes, 0 if nothing is held
+ */
+struct sb_lossy_link {
+	enum sb_link_mode mode;
+	int period;
+	int phase;
+	u64 seen;
+	int hits;
+	u8 held[PKTSIZE];
+	int held_len;
+};
+
+/*
+ * Pass the packet the server has just queued for the client, numbered @num,
+ * through @link. A packet with @keep set is always delivered, so that the
+ * client can see a gap without waiting for a timeout.
+ */
+static void sb_link_pass(struct udevice *dev, struct sb_lossy_link *link,
+			 int num, bool keep)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	int last = priv->recv_packets - 1;
+	bool first = !(link->seen & BIT_ULL(num));
+
+	link->seen |= BIT_ULL(num);
+	if (first && !keep && num % link->period == link->phase &&
+	    !link->held_len) {
+		link->hits++;
+		if (link->mode == SB_LINK_HOLD) {
+			link->held_len = priv->recv_packet_length[last];
+			memcpy(link->held, priv->recv_packet_buffer[last],
+			       link->held_len);
+		}
+		priv->recv_packets--;
+		return;
+	}
+
+	/* A packet held back follows this one */
+	if (link->held_len && priv->recv_packets < PKTBUFSRX) {
+		memcpy(priv->recv_packet_buffer[priv->recv_packets],
+		       link->held, link->held_len);
+		priv->recv_packet_length[priv->recv_packets] = link->held_len;
+		++priv->recv_packets;
+		link->held_len = 0;
+	}
+}
+
+/* TFTP opcodes, see RFC 1350 */
+#define SB_TFTP_RRQ		1
+#define SB_TFTP_DATA		3
+#define SB_TFTP_ACK		4
+#define SB_TFTP_OACK		6
+
+#define SB_TFTP_PORT		1069
+#define SB_TFTP_BLKSIZE		512
+#define SB_TFTP_WINDOW		4
+#define SB_TFTP_SIZE		(37 * SB_TFTP_BLKSIZE + 100)
+#define SB_TFTP_BLOCKS		(SB_TFTP_SIZE / SB_TFTP_BLKSIZE + 1)
+#define SB_TFTP_LOAD_ADDR	0x1000000
+
+/**
+ * struct sb_tftp_server - fake TFTP server with a lossy link
+ *
+ * @data: file being served
+ * @window_asked: true if the read request had a windowsize option
+ * @link: link to the client, losing blocks
+ * @data_sent: number of DATA packets sent, including retransmissions
+ * @acks: number of ACK packets received
+ */
+struct sb_tftp_server {
+	const u8 *data;
+	bool window_asked;
+	struct sb_lossy_link link;
+	int data_sent;
+	int acks;
+};
+
+static int sb_udp_reply(struct udevice *dev, void *request, int sport,
+			const void *msg, int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct ethernet_hdr *eth = request;
+	struct ip_udp_hdr *ip = request + ETHER_HDR_SIZE;
+	struct ethernet_hdr *eth_recv;
+	struct ip_udp_hdr *ipr;
+
+	/* Anything which does not fit in the receive queue is lost */
+	if (priv->recv_packets >= PKTBUFSRX)
+		return -ENOBUFS;
+
+	eth_recv = (void *)priv->recv_packet_buffer[priv->recv_packets];
+	memcpy(eth_recv->et_dest, eth->et_src, ARP_HLEN);
+	memcpy(eth_recv->et_src, priv->fake_host_hwaddr, ARP_HLEN);
+	eth_recv->et_protlen = htons(PROT_IP);
+
+	ipr = (void *)eth_recv + ETHER_HDR_SIZE;
+	memcpy((void *)ipr + IP_UDP_HDR_SIZE, msg, len);
+	net_set_ip_header((uchar *)ipr, net_ip, priv->fake_host_ipaddr,
+			  IP_UDP_HDR_SIZE + len, IPPROTO_UDP);
+	ipr->udp_src = htons(sport);
+	ipr->udp_dst = ip->udp_src;
+	ipr->udp_len = htons(UDP_HDR_SIZE + len);
+	ipr->udp_xsum = 0;
+
+	priv->recv_packet_length[priv->recv_packets] =
+		ETHER_HDR_SIZE + IP_UDP_HDR_SIZE + len;
+	++priv->recv_packets;
+
+	return 0;
+}
+
+static void sb_tftp_send_data(struct udevice *dev, void *request,
+			      struct sb_tftp_server *srv, int block, bool keep)
+{
+	u8 msg[4 + SB_TFTP_BLKSIZE];
+	__be16 *hdr = (__be16 *)msg;
+	int offset = (block - 1) * SB_TFTP_BLKSIZE;
+	int len = min(SB_TFTP_SIZE - offset, SB_TFTP_BLKSIZE);
+
+	hdr[0] = htons(SB_TFTP_DATA);
+	hdr[1] = htons(block);
+	memcpy(msg + 4, srv->data + offset, len);
+	if (!sb_udp_reply(dev, request, SB_TFTP_PORT, msg, 4 + len))
+		sb_link_pass(dev, &srv->link, block, keep);
+	srv->data_sent++;
+}
+
+/*
+ * Serve the file a window at a time. The link loses the first copy of every
+ * block whose number is 2 modulo 5, and swaps the first two blocks of every
+ * window starting on a multiple of 3. The last block of a window is never
+ * lost, so that the client can always see the gap without timing out.
+ */
+static int sb_tftp_handler(struct udevice *dev, void *packet,
+			   unsigned int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct sb_tftp_server *srv = priv->priv;
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	__be16 *req = (void *)ip + IP_UDP_HDR_SIZE;
+	char *opt, *end;
+	u8 msg[32];
+	int order[SB_TFTP_WINDOW];
+	int block, count, i;
+
+	if (!sandbox_eth_arp_req_to_reply(dev, packet, len))
+		return 0;
+	if (ntohs(eth->et_protlen) != PROT_IP || ip->ip_p != IPPROTO_UDP)
+		return 0;
+
+	switch (ntohs(req[0])) {
+	case SB_TFTP_RRQ:
+		end = (char *)req + ntohs(ip->udp_len) - UDP_HDR_SIZE;
+		for (opt = (char *)(req + 1); opt < end; opt += strlen(opt) + 1)
+			if (!strcmp(opt, "windowsize"))
+				srv->window_asked = true;
+
+		/* Agree to the window, keep the default block size */
+		*(__be16 *)msg = htons(SB_TFTP_OACK);
+		count = sprintf((char *)msg + 2, "windowsize%c%d", 0,
+				SB_TFTP_WINDOW);
+		sb_udp_reply(dev, packet, SB_TFTP_PORT, msg, 2 + count + 1);
+		break;
+	case SB_TFTP_ACK:
+		srv->acks++;
+		block = ntohs(req[1]);
+		count = min(SB_TFTP_BLOCKS - block, SB_TFTP_WINDOW);
+		for (i = 0; i < count; i++)
+			order[i] = block + 1 + i;
+		if (count > 1 && order[0] % 3 == 0)
+			swap(order[0], order[1]);
+
+		for (i = 0; i < count; i++)
+			sb_tftp_send_data(dev, packet, srv, order[i],
+					  i == count - 1);
+		break;
+	}
+
+	return 0;
+}
+
+static int dm_test_eth_tftp_window(struct unit_test_state *uts)
+{
+	struct sb_tftp_server srv = {
+		.link = { .mode = SB_LINK_DROP, .period = 5, .phase = 2 },
+	};
+	u8 *data, *buf;
+	int ret, i;
+
+	data = malloc(SB_TFTP_SIZE);
+	ut_assertnonnull(data);
+	for (i = 0; i < SB_TFTP_SIZE; i++)
+		data[i] = i * 7 + (i / SB_TFTP_BLKSIZE);
+	srv.data = data;
+
+	sandbox_eth_set_tx_handler(0, sb_tftp_handler);
+	sandbox_eth_set_priv(0, &srv);
+	env_set("ethact", "eth@10002000");
+	env_set("serverip", "1.1.2.2");
+	env_set("tftpwindowsize", "4");
+	load_addr = SB_TFTP_LOAD_ADDR;
+	copy_filename(net_boot_file_name, "window.bin",
+		      sizeof(net_boot_file_name));
+
+	ret = net_loop(TFTPGET);
+
+	env_set("tftpwindowsize", NULL);
+	env_set("serverip", NULL);
+	sandbox_eth_set_tx_handler(0, NULL);
+
+	ut_asserteq(SB_TFTP_SIZE, ret);
+	buf = map_sysmem(SB_TFTP_LOAD_ADDR, SB_TFTP_SIZE);
+	ut_assertok(memcmp(buf, data, SB_TFTP_SIZE));
+	unmap_sysmem(buf);
+	free(data);
+
+	/* Blocks were acked a window at a time, and lost ones sent again */
+	ut_assert(srv.window_asked);
+	ut_assert(srv.acks < SB_TFTP_BLOCKS);
+	ut_assert(srv.data_sent > SB_TFTP_BLOCKS);
+
+	return 0;
+}
+
+DM_TEST(dm_test_eth_tftp_window, DM_TESTF_SCAN_FDT);
+
+#ifdef CONFIG_CMD_NFS
+#define SB_NFS_PORT		2049
+#define SB_NFS_BLKSIZE		CONFIG_NFS_READ_SIZE
+#define SB_NFS_SIZE		(23 * SB_NFS_BLKSIZE + 500)
+#define SB_NFS_BLOCKS		(SB_NFS_SIZE / SB_NFS_BLKSIZE + 1)
+#define SB_NFS_LOAD_ADDR	0x1000000
+/* RPC reply header, then READ status, attributes and count (NFSv2) */
+#define SB_NFS_READ_HDR		(6 + 1 + 17 + 1)
+
+/**
+ * struct sb_nfs_server - fake NFSv2 server which answers reads out of order
+ *
+ * @data: file being served
+ * @link: link to the client, holding READ replies back
+ * @reads: number of READ requests received
+ * @max_queued: most packets in the receive queue when a READ arrived
+ */
+struct sb_nfs_server {
+	const u8 *data;
+	struct sb_lossy_link link;
+	int reads;
+	int max_queued;
+};
+
+/*
+ * Answer a READ. The reply for every block whose number is 1 modulo 5 is
+ * held back and sent after the reply to the next request, unless the end of
+ * the file is near, so that the client always has a next request to make.
+ */
+static void sb_nfs_read(struct udevice *dev, void *packet,
+			struct sb_nfs_server *srv, __be32 *args, u32 *msg)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	/* Skip the credentials and the file handle */
+	int offset = ntohl(args[9 + 8]);
+	int count = ntohl(args[9 + 8 + 1]);
+	int block = offset / SB_NFS_BLKSIZE;
+	int len;
+
+	count = max(0, min(count, SB_NFS_SIZE - offset));
+	memset(msg + 6, 0, (1 + 17) * 4);
+	msg[SB_NFS_READ_HDR - 1] = htonl(count);
+	memcpy(msg + SB_NFS_READ_HDR, srv->data + offset, count);
+	len = SB_NFS_READ_HDR * 4 + ALIGN(count, 4);
+
+	srv->reads++;
+	srv->max_queued = max(srv->max_queued, (int)priv->recv_packets);
+
+	if (!sb_udp_reply(dev, packet, SB_NFS_PORT, msg, len))
+		sb_link_pass(dev, &srv->link, block,
+			     block + 5 >= SB_NFS_BLOCKS);
+}
+
+static int sb_nfs_handler(struct udevice *dev, void *packet,
+			  unsigned int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct sb_nfs_server *srv = priv->priv;
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	__be32 *call = (void *)ip + IP_UDP_HDR_SIZE;
+	u32 msg[SB_NFS_READ_HDR + SB_NFS_BLKSIZE / 4];
+	int words = 6;
+
+	if (!sandbox_eth_arp_req_to_reply(dev, packet, len))
+		return 0;
+	if (ntohs(eth->et_protlen) != PROT_IP || ip->ip_p != IPPROTO_UDP)
+		return 0;
+
+	/* xid, REPLY, accepted, AUTH_NONE verifier, success */
+	memset(msg, 0, 6 * 4);
+	msg[0] = call[0];
+	msg[1] = htonl(1);
+
+	switch (ntohl(call[3])) {
+	case 100000:		/* portmap GETPORT */
+		msg[words++] = htonl(SB_NFS_PORT);
+		break;
+	case 100005:		/* mount */
+		if (ntohl(call[5]) == 1) {
+			/* Status and a directory handle */
+			memset(msg + words, 0, 9 * 4);
+			words += 9;
+		}
+		break;
+	case 100003:		/* NFS */
+		if (ntohl(call[5]) == 6) {
+			sb_nfs_read(dev, packet, srv, call + 6, msg);
+			return 0;
+		}
+		/* LOOKUP: status, file handle and attributes */
+		memset(msg + words, 0, (1 + 8 + 17) * 4);
+		words += 1 + 8 + 17;
+		break;
+	}
+	sb_udp_reply(dev, packet, SB_NFS_PORT, msg, words * 4);
+
+	return 0;
+}
+
+static int dm_test_eth_nfs_pipeline(struct unit_test_state *uts)
+{
+	struct sb_nfs_server srv = {
+		.link = { .mode = SB_LINK_HOLD, .period = 5, .phase = 1 },
+	};
+	u8 *data, *buf;
+	int ret, i;
+
+	data = malloc(SB_NFS_SIZE);
+	ut_assertnonnull(data);
+	for (i = 0; i < SB_NFS_SIZE; i++)
+		data[i] = i * 11 + (i / SB_NFS_BLKSIZE);
+	srv.data = data;
+
+	sandbox_eth_set_tx_handler(0, sb_nfs_handler);
+	sandbox_eth_set_priv(0, &srv);
+	env_set("ethact", "eth@10002000");
+	env_set("serverip", "1.1.2.2");
+	env_set("nfspipeline", "4");
+	load_addr = SB_NFS_LOAD_ADDR;
+	copy_filename(net_boot_file_name, "/export/pipeline.bin",
+		      sizeof(net_boot_file_name));
+
+	ret = net_loop(NFS);
+
+	env_set("nfspipeline", NULL);
+	env_set("serverip", NULL);
+	sandbox_eth_set_tx_handler(0, NULL);
+
+	ut_asserteq(SB_NFS_SIZE, ret);
+	buf = map_sysmem(SB_NFS_LOAD_ADDR, SB_NFS_SIZE);
+	ut_assertok(memcmp(buf, data, SB_NFS_SIZE));
+	unmap_sysmem(buf);
+	free(data);
+
+	/* Several reads were outstanding, and replies came out of order */
+	ut_assert(srv.max_queued > 2);
+	ut_assert(srv.link.hits > 0);
+	ut_assert(srv.reads >= SB_NFS_BLOCKS);
+
+	return 0;
+}
+
+DM_TEST(dm_test_eth_nfs_pipeline, DM_TESTF_SCAN_FDT);
+#endif
+
+#ifdef CONFIG_CMD_WGET
+#define SB_HTTP_PORT		80
+#define SB_HTTP_ISS		0x10000
+#define SB_HTTP_MSS		1000
+#define SB_HTTP_WINDOW		(6 * SB_HTTP_MSS)
+#define SB_HTTP_SIZE		(40 * SB_HTTP_MSS + 321)
+#define SB_HTTP_LOAD_ADDR	0x1000000
+
+/**
+ * struct sb_http_server - fake web server with a lossy link
+ *
+ * Offsets count bytes of the response, from 0 for the first byte of the
+ * status line.
+ *
+ * @stream: response, header then file
+ * @stream_len: number of bytes in @stream
+ * @irs: sequence number of the client's SYN
+ * @req_len: size of the request, 0 until it has been received
+ * @snd_una: offset of the first byte not acked
+ * @snd_nxt: offset of the next byte to send
+ * @went_back: @snd_una when lost data was last sent again
+ * @link: link to the client, losing segments
+ * @wscale: window scale offered by the client
+ * @window: receive window last advertised by the client
+ * @request_ok: true if the request was for the expected file
+ * @acks: number of acks received for the response
+ * @segs_sent: number of segments sent, including lost ones and retransmissions
+ */
+struct sb_http_server {
+	u8 *stream;
+	int stream_len;
+	u32 irs;
+	int req_len;
+	int snd_una;
+	int snd_nxt;
+	int went_back;
+	struct sb_lossy_link link;
+	int wscale;
+	u32 window;
+	bool request_ok;
+	int acks;
+	int segs_sent;
+};
+
+static u16 sb_tcp_checksum(struct ip_tcp_hdr *ip, int tcp_len)
+{
+	u8 pseudo[12];
+
+	memcpy(pseudo, &ip->ip_src, 8);
+	pseudo[8] = 0;
+	pseudo[9] = IPPROTO_TCP;
+	put_unaligned_be16(tcp_len, pseudo + 10);
+
+	return add_ip_checksums(sizeof(pseudo),
+				compute_ip_checksum(pseudo, sizeof(pseudo)),
+				compute_ip_checksum(&ip->tcp_src, tcp_len));
+}
+
+static int sb_http_reply(struct udevice *dev, void *request, u8 flags,
+			 u32 seq, u32 ack, const void *data, int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct ethernet_hdr *eth = request;
+	struct ip_tcp_hdr *ip = request + ETHER_HDR_SIZE;
+	struct ethernet_hdr *eth_recv;
+	struct ip_tcp_hdr *ipr;
+	int hlen = TCP_HDR_SIZE;
+	u8 *opt;
+
+	if (priv->recv_packets >= PKTBUFSRX)
+		return -ENOBUFS;
+
+	eth_recv = (void *)priv->recv_packet_buffer[priv->recv_packets];
+	memcpy(eth_recv->et_dest, eth->et_src, ARP_HLEN);
+	memcpy(eth_recv->et_src, priv->fake_host_hwaddr, ARP_HLEN);
+	eth_recv->et_protlen = htons(PROT_IP);
+
+	/* MSS, then a no-op and the window scale option, with a shift of 0 */
+	ipr = (void *)eth_recv + ETHER_HDR_SIZE;
+	if (flags & TCP_SYN) {
+		opt = (u8 *)(ipr + 1);
+		opt[0] = 2;
+		opt[1] = 4;
+		put_unaligned_be16(SB_HTTP_MSS, opt + 2);
+		opt[4] = 1;
+		opt[5] = 3;
+		opt[6] = 3;
+		opt[7] = 0;
+		hlen += 8;
+	}
+	memcpy((void *)ipr + IP_HDR_SIZE + hlen, data, len);
+	net_set_ip_header((uchar *)ipr, net_ip, priv->fake_host_ipaddr,
+			  IP_HDR_SIZE + hlen + len, IPPROTO_TCP);
+	ipr->tcp_src = htons(SB_HTTP_PORT);
+	ipr->tcp_dst = ip->tcp_src;
+	ipr->tcp_seq = htonl(seq);
+	ipr->tcp_ack = htonl(ack);
+	ipr->tcp_hlen = (hlen / 4) << 4;
+	ipr->tcp_flags = flags;
+	ipr->tcp_win = htons(0xffff);
+	ipr->tcp_urg = 0;
+	ipr->tcp_xsum = 0;
+	ipr->tcp_xsum = sb_tcp_checksum(ipr, hlen + len);
+
+	priv->recv_packet_length[priv->recv_packets] =
+		ETHER_HDR_SIZE + IP_HDR_SIZE + hlen + len;
+	++priv->recv_packets;
+
+	return 0;
+}
+
+/*
+ * Send the response from snd_nxt, as far as the window and the receive
+ * queue allow. The link loses the first copy of every segment whose number
+ * is 2 modulo 5, unless it is the last one of a burst, so that the client
+ * always sees the gap.
+ */
+static void sb_http_send(struct udevice *dev, void *request,
+			 struct sb_http_server *srv)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	int off, len, seg;
+	bool last;
+	u8 flags;
+
+	while (srv->snd_nxt < srv->stream_len &&
+	       srv->snd_nxt < srv->snd_una + SB_HTTP_WINDOW &&
+	       priv->recv_packets < PKTBUFSRX) {
+		off = srv->snd_nxt;
+		len = min(srv->stream_len - off, SB_HTTP_MSS);
+		seg = off / SB_HTTP_MSS;
+		srv->snd_nxt += len;
+
+		last = srv->snd_nxt == srv->stream_len ||
+		       srv->snd_nxt >= srv->snd_una + SB_HTTP_WINDOW ||
+		       priv->recv_packets + 1 >= PKTBUFSRX;
+
+		flags = TCP_ACK | TCP_PUSH;
+		if (srv->snd_nxt == srv->stream_len)
+			flags |= TCP_FIN;
+		if (!sb_http_reply(dev, request, flags, SB_HTTP_ISS + 1 + off,
+				   srv->irs + 1 + srv->req_len,
+				   srv->stream + off, len))
+			sb_link_pass(dev, &srv->link, seg, last);
+		srv->segs_sent++;
+	}
+}
+
+static int sb_http_handler(struct udevice *dev, void *packet,
+			   unsigned int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct sb_http_server *srv = priv->priv;
+	struct ethernet_hdr *eth = packet;
+	struct ip_tcp_hdr *ip = packet + ETHER_HDR_SIZE;
+	u8 *opt = (u8 *)(ip + 1);
+	int hlen, dlen, off;
+	char *data;
+
+	if (!sandbox_eth_arp_req_to_reply(dev, packet, len))
+		return 0;
+	if (ntohs(eth->et_protlen) != PROT_IP || ip->ip_p != IPPROTO_TCP)
+		return 0;
+
+	hlen = (ip->tcp_hlen >> 4) * 4;
+	data = (char *)&ip->tcp_src + hlen;
+	dlen = ntohs(ip->ip_len) - IP_HDR_SIZE - hlen;
+
+	if (ip->tcp_flags & TCP_SYN) {
+		srv->irs = ntohl(ip->tcp_seq);
+		if (hlen == TCP_HDR_SIZE + 8 && opt[5] == 3)
+			srv->wscale = opt[7];
+		sb_http_reply(dev, packet, TCP_SYN | TCP_ACK, SB_HTTP_ISS,
+			      srv->irs + 1, NULL, 0);
+		return 0;
+	}
+	/* The client closes once it has the whole file */
+	if (ip->tcp_flags & TCP_FIN)
+		return 0;
+
+	srv->window = ntohs(ip->tcp_win) << srv->wscale;
+	if (dlen) {
+		srv->request_ok = !strncmp(data, "GET /wget.bin HTTP/1.0\r\n",
+					   24);
+		srv->req_len = dlen;
+		sb_http_send(dev, packet, srv);
+		return 0;
+	}
+	if (!srv->req_len)
+		return 0;
+
+	/* An ack which does not move means that data was lost */
+	srv->acks++;
+	off = min_t(int, ntohl(ip->tcp_ack) - SB_HTTP_ISS - 1,
+		    srv->stream_len);
+	if (off > srv->snd_una) {
+		srv->snd_una = off;
+	} else if (srv->went_back != srv->snd_una) {
+		srv->went_back = srv->snd_una;
+		srv->snd_nxt = srv->snd_una;
+	}
+	sb_http_send(dev, packet, srv);
+
+	return 0;
+}
+
+static int dm_test_eth_wget(struct unit_test_state *uts)
+{
+	struct sb_http_server srv = {
+		.link = { .mode = SB_LINK_DROP, .period = 5, .phase = 2 },
+	};
+	u8 *data, *buf;
+	int hdr_len, ret, i;
+
+	srv.stream = malloc(SB_HTTP_SIZE + 100);
+	ut_assertnonnull(srv.stream);
+	hdr_len = sprintf((char *)srv.stream,
+			  "HTTP/1.0 200 OK\r\nContent-Length: %d\r\n\r\n",
+			  SB_HTTP_SIZE);
+	data = srv.stream + hdr_len;
+	for (i = 0; i < SB_HTTP_SIZE; i++)
+		data[i] = i * 13 + (i / SB_HTTP_MSS);
+	srv.stream_len = hdr_len + SB_HTTP_SIZE;
+	srv.went_back = -1;
+
+	sandbox_eth_set_tx_handler(0, sb_http_handler);
+	sandbox_eth_set_priv(0, &srv);
+	env_set("ethact", "eth@10002000");
+	env_set("serverip", "1.1.2.2");
+	load_addr = SB_HTTP_LOAD_ADDR;
+	copy_filename(net_boot_file_name, "wget.bin",
+		      sizeof(net_boot_file_name));
+
+	ret = net_loop(WGET);
+
+	env_set("serverip", NULL);
+	sandbox_eth_set_tx_handler(0, NULL);
+
+	ut_asserteq(SB_HTTP_SIZE, ret);
+	buf = map_sysmem(SB_HTTP_LOAD_ADDR, SB_HTTP_SIZE);
+	ut_assertok(memcmp(buf, data, SB_HTTP_SIZE));
+	unmap_sysmem(buf);
+	free(srv.stream);
+
+	ut_assert(srv.request_ok);
+	/* The receive window does not fit in 16 bits without scaling */
+	ut_assert(srv.wscale > 0);
+	ut_asserteq(CONFIG_TCP_RX_WINDOW >> srv.wscale << srv.wscale,
+		    srv.window);
+	/* Acks were delayed, and lost segments sent again */
+	ut_assert(srv.acks < srv.segs_sent);
+	ut_assert(srv.segs_sent > srv.stream_len / SB_HTTP_MSS + 1);
+
+	return 0;
+}
+
+DM_TEST(dm_test_eth_wget, DM_TESTF_SCAN_FDT);
+#endif
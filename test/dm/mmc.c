@@ -6,6 +6,7 @@
 #include <common.h>
 #include <dm.h>
 #include <mmc.h>
+#include <asm/test.h>
 #include <dm/test.h>
 #include <test/ut.h>
 
@@ -41,3 +42,104 @@ static int dm_test_mmc_blk(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_mmc_blk, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+static int dm_test_mmc_blk_async(struct unit_test_state *uts)
+{
+	struct blk_req req[2];
+	struct blk_desc *dev_desc;
+	struct udevice *dev;
+	char multi[1024], single[512], cmp[1024];
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	ut_assertok(blk_get_device_by_str("mmc", "0", &dev_desc));
+
+	/* Make sure the requests reach the driver */
+	blkcache_invalidate(dev_desc->if_type, dev_desc->devnum);
+
+	memset(multi, '\0', sizeof(multi));
+	memset(single, 0xff, sizeof(single));
+	req[0].start = 0;
+	req[0].blkcnt = 2;
+	req[0].buffer = multi;
+	req[0].write = false;
+	req[1].start = 4;
+	req[1].blkcnt = 1;
+	req[1].buffer = single;
+	req[1].write = false;
+	ut_assertok(blk_submit(dev_desc, &req[0]));
+	ut_assertok(blk_submit(dev_desc, &req[1]));
+	ut_asserteq(-EINPROGRESS, req[0].result);
+	ut_asserteq(-EINPROGRESS, req[1].result);
+
+	/* Waiting for the second request completes the first as well */
+	ut_asserteq(1, blk_wait(dev_desc, &req[1]));
+	ut_assertok(blk_poll(dev_desc, &req[0]));
+	ut_asserteq(2, req[0].result);
+	ut_assertok(strcmp(multi, "this is a test"));
+	memset(cmp, '\0', sizeof(single));
+	ut_assertok(memcmp(single, cmp, sizeof(single)));
+
+	/* A synchronous read must not overtake queued requests */
+	memset(multi, '\0', sizeof(multi));
+	blkcache_invalidate(dev_desc->if_type, dev_desc->devnum);
+	ut_assertok(blk_submit(dev_desc, &req[0]));
+	ut_asserteq(-EBUSY, blk_poll(dev_desc, &req[0]));
+	ut_asserteq(2, blk_dread(dev_desc, 2, 2, cmp));
+	ut_asserteq(2, req[0].result);
+	ut_assertok(strcmp(multi, "this is a test"));
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_blk_async, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+#endif
+
+#if CONFIG_IS_ENABLED(MMC_WRITE)
+static int dm_test_mmc_discard(struct unit_test_state *uts)
+{
+	struct blk_desc *dev_desc;
+	struct udevice *dev;
+	struct mmc *mmc;
+	uint version, grp_size, arg;
+	int count;
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	ut_assertok(blk_get_device_by_str("mmc", "0", &dev_desc));
+	mmc = mmc_get_mmc_dev(dev);
+
+	/* The SD card reads back erased blocks as zero, and has no TRIM */
+	ut_asserteq(1, mmc_erase_zero_blks(mmc));
+	count = sandbox_mmc_get_erase(dev, &arg);
+	ut_asserteq(1, blk_derase(dev_desc, 8, 1));
+	ut_asserteq(count + 1, sandbox_mmc_get_erase(dev, &arg));
+	ut_asserteq(MMC_ERASE_ARG, arg);
+	ut_asserteq(1, mmc_bdiscard(dev_desc, 8, 1));
+	ut_asserteq(count + 2, sandbox_mmc_get_erase(dev, &arg));
+	ut_asserteq(MMC_ERASE_ARG, arg);
+
+	/*
+	 * Pretend to be an eMMC part with TRIM. Only a discard may use it;
+	 * a plain erase still erases whole erase groups.
+	 */
+	version = mmc->version;
+	grp_size = mmc->erase_grp_size;
+	mmc->version = MMC_VERSION_5_0;
+	mmc->erase_grp_size = 1024;
+	ut_asserteq(1024, mmc_erase_zero_blks(mmc));
+	mmc->trim_supported = true;
+	ut_asserteq(1, mmc_erase_zero_blks(mmc));
+	ut_asserteq(4, mmc_bdiscard(dev_desc, 8, 4));
+	ut_asserteq(count + 3, sandbox_mmc_get_erase(dev, &arg));
+	ut_asserteq(MMC_TRIM_ARG, arg);
+	ut_asserteq(1024, blk_derase(dev_desc, 1024, 1024));
+	ut_asserteq(count + 4, sandbox_mmc_get_erase(dev, &arg));
+	ut_asserteq(MMC_ERASE_ARG, arg);
+
+	mmc->version = version;
+	mmc->erase_grp_size = grp_size;
+	mmc->trim_supported = false;
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_discard, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+#endif
@@ -44,6 +44,41 @@ static int dm_test_ofnode_by_prop_value(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_ofnode_by_prop_value, DM_TESTF_SCAN_FDT);
 
+static int dm_test_ofnode_by_compatible(struct unit_test_state *uts)
+{
+	const char compat[] = "denx,u-boot-fdt-test";
+	ofnode node;
+	int count = 0;
+
+	for (node = ofnode_by_compatible(ofnode_null(), compat);
+	     ofnode_valid(node);
+	     node = ofnode_by_compatible(node, compat)) {
+		ut_assert(ofnode_device_is_compatible(node, compat));
+		count++;
+	}
+	ut_asserteq(8, count);
+
+	node = ofnode_by_compatible(ofnode_null(), "denx,u-boot-fdt-tes");
+	ut_assert(!ofnode_valid(node));
+
+	return 0;
+}
+DM_TEST(dm_test_ofnode_by_compatible, DM_TESTF_SCAN_FDT);
+
+static int dm_test_ofnode_get_by_phandle(struct unit_test_state *uts)
+{
+	ofnode node = ofnode_path("/base-gpios");
+	u32 phandle;
+
+	ut_assert(ofnode_valid(node));
+	ut_assertok(ofnode_read_u32(node, "phandle", &phandle));
+	ut_assert(ofnode_equal(node, ofnode_get_by_phandle(phandle)));
+	ut_assert(!ofnode_valid(ofnode_get_by_phandle(0xfffffff0)));
+
+	return 0;
+}
+DM_TEST(dm_test_ofnode_get_by_phandle, DM_TESTF_SCAN_FDT);
+
 static int dm_test_ofnode_fmap(struct unit_test_state *uts)
 {
 	struct fmap_entry entry;
@@ -167,3 +167,35 @@ U_BOOT_DRIVER(test_act_dma_drv) = {
 	.unbind	= test_manual_unbind,
 	.flags	= DM_FLAG_ACTIVE_DMA,
 };
+
+static int test_async_probe(struct udevice *dev)
+{
+	struct dm_test_priv *priv = dev_get_priv(dev);
+
+	dm_testdrv_op_count[DM_TEST_OP_PROBE]++;
+	priv->probe_steps = DM_TEST_ASYNC_STEPS;
+
+	return -EINPROGRESS;
+}
+
+static int test_async_probe_poll(struct udevice *dev)
+{
+	struct dm_test_priv *priv = dev_get_priv(dev);
+
+	if (--priv->probe_steps)
+		return -EINPROGRESS;
+	priv->ping_total += DM_TEST_START_TOTAL;
+
+	return 0;
+}
+
+U_BOOT_DRIVER(test_async_drv) = {
+	.name	= "test_async_drv",
+	.id	= UCLASS_TEST,
+	.ops	= &test_ops,
+	.probe	= test_async_probe,
+	.probe_poll = test_async_probe_poll,
+	.remove	= test_remove,
+	.priv_auto_alloc_size = sizeof(struct dm_test_priv),
+	.flags	= DM_FLAG_PROBE_ASYNC,
+};
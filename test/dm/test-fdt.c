@@ -319,6 +319,56 @@ static int dm_test_fdt_uclass_seq(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_fdt_uclass_seq, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
 
+/* Test that lookups follow changes to a device's sequence number and node */
+static int dm_test_fdt_uclass_find_update(struct unit_test_state *uts)
+{
+	struct udevice *dev, *found;
+	ofnode node, other;
+	int req_seq;
+
+	/* f-test only gets a sequence number when probed */
+	ut_assertok(uclass_get_device(UCLASS_TEST_FDT, 4, &dev));
+	ut_asserteq_str("f-test", dev->name);
+	ut_assertok(uclass_find_device_by_seq(UCLASS_TEST_FDT, 1, false,
+					      &found));
+	ut_asserteq_ptr(dev, found);
+	ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+	ut_asserteq(-ENODEV, uclass_find_device_by_seq(UCLASS_TEST_FDT, 1,
+						       false, &found));
+
+	/* Move it to another node and back */
+	node = dev_ofnode(dev);
+	other = ofnode_path("/some-bus");
+	ut_assert(ofnode_valid(other));
+	dev_set_ofnode(dev, other);
+	ut_asserteq(-ENODEV, uclass_find_device_by_ofnode(UCLASS_TEST_FDT, node,
+							  &found));
+	ut_assertok(uclass_find_device_by_ofnode(UCLASS_TEST_FDT, other,
+						 &found));
+	ut_asserteq_ptr(dev, found);
+	dev_set_ofnode(dev, node);
+	ut_assertok(uclass_find_device_by_ofnode(UCLASS_TEST_FDT, node,
+						 &found));
+	ut_asserteq_ptr(dev, found);
+
+	/* A driver may change req_seq without telling the uclass */
+	req_seq = dev->req_seq;
+	dev->req_seq = 17;
+	ut_assertok(uclass_find_device_by_seq(UCLASS_TEST_FDT, 17, true,
+					      &found));
+	ut_asserteq_ptr(dev, found);
+	dev->req_seq = req_seq;
+
+	/* Once unbound it cannot be found */
+	ut_assertok(device_unbind(dev));
+	ut_asserteq(-ENODEV, uclass_find_device_by_ofnode(UCLASS_TEST_FDT, node,
+							  &found));
+
+	return 0;
+}
+DM_TEST(dm_test_fdt_uclass_find_update,
+	DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
 /* Test that we can find a device by device tree offset */
 static int dm_test_fdt_offset(struct unit_test_state *uts)
 {
@@ -123,3 +123,131 @@ static int env_test_htab_deletes(struct unit_test_state *uts)
 }
 
 ENV_TEST(env_test_htab_deletes, 0);
+
+/* Keep adding elements and check that the table grows to hold them */
+static int env_test_htab_grow(struct unit_test_state *uts)
+{
+	struct hsearch_data htab;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, hcreate_r(SIZE, &htab));
+
+	ut_assertok(htab_fill(uts, &htab, SIZE * 8));
+	ut_assertok(htab_check_fill(uts, &htab, SIZE * 8));
+	ut_asserteq(SIZE * 8, htab.filled);
+	ut_assert(htab.size > SIZE * 8);
+
+	hdestroy_r(&htab);
+	return 0;
+}
+
+ENV_TEST(env_test_htab_grow, 0);
+
+static const struct hsearch_base htab_base[] = {
+	{ "a", "1" },
+	{ "b", "2" },
+	{ "c", "3" },
+};
+
+static ENTRY *htab_find(struct hsearch_data *htab, const char *key)
+{
+	ENTRY item, *ritem;
+
+	item.key = key;
+	item.data = NULL;
+	hsearch_r(item, FIND, &ritem, htab, 0);
+
+	return ritem;
+}
+
+static int htab_enter(struct hsearch_data *htab, const char *key,
+		      const char *data)
+{
+	ENTRY item, *ritem;
+
+	item.callback = NULL;
+	item.flags = 0;
+	item.key = key;
+	item.data = (char *)data;
+
+	return hsearch_r(item, ENTER, &ritem, htab, 0);
+}
+
+/* Check that base entries are only copied into the table when changed */
+static int env_test_htab_base(struct unit_test_state *uts)
+{
+	struct hsearch_data htab;
+	char *res = NULL;
+	ENTRY *ritem;
+	int idx;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, himport_base_r(&htab, htab_base, ARRAY_SIZE(htab_base),
+				      0));
+
+	/* found in place */
+	ritem = htab_find(&htab, "b");
+	ut_assertnonnull(ritem);
+	ut_asserteq_ptr(htab_base[1].data, ritem->data);
+	ut_assertnull(htab_find(&htab, "d"));
+
+	/* setting the same data does not copy */
+	ut_assert(htab_enter(&htab, "b", "2"));
+	ut_asserteq(0, htab.filled);
+
+	ut_assert(htab_enter(&htab, "b", "5"));
+	ut_asserteq(1, htab.filled);
+	ut_asserteq_str("5", htab_find(&htab, "b")->data);
+
+	/* a deleted base entry is shown again when set to its data */
+	ut_asserteq(1, hdelete_r("a", &htab, 0));
+	ut_assertnull(htab_find(&htab, "a"));
+	ut_assert(htab_enter(&htab, "a", "1"));
+	ut_asserteq(1, htab.filled);
+	ut_asserteq_ptr(htab_base[0].data, htab_find(&htab, "a")->data);
+
+	ut_assert(hexport_r(&htab, '\n', 0, &res, 0, 0, NULL) > 0);
+	ut_asserteq_str("a=1\nb=5\nc=3\n", res);
+	free(res);
+
+	/* the copy hides the base entry for good */
+	ut_asserteq(1, hdelete_r("b", &htab, 0));
+	ut_assertnull(htab_find(&htab, "b"));
+
+	idx = hmatch_r("", 0, &ritem, &htab);
+	ut_assert(idx);
+	ut_asserteq_str("a", ritem->key);
+	idx = hmatch_r("", idx, &ritem, &htab);
+	ut_assert(idx);
+	ut_asserteq_str("c", ritem->key);
+	ut_asserteq(0, hmatch_r("", idx, &ritem, &htab));
+
+	hdestroy_r(&htab);
+	return 0;
+}
+
+ENV_TEST(env_test_htab_base, 0);
+
+/* Import over a hidden base, as done for a saved environment */
+static int env_test_htab_base_hidden(struct unit_test_state *uts)
+{
+	static const char env[] = "a=1\0c=4\0";
+	struct hsearch_data htab;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, himport_base_r(&htab, htab_base, ARRAY_SIZE(htab_base),
+				      H_HIDE_BASE));
+	ut_assertnull(htab_find(&htab, "a"));
+
+	ut_asserteq(1, himport_r(&htab, env, sizeof(env), '\0', H_NOCLEAR,
+				 0, 0, NULL));
+	ut_asserteq(1, htab.filled);
+	ut_asserteq_ptr(htab_base[0].data, htab_find(&htab, "a")->data);
+	ut_assertnull(htab_find(&htab, "b"));
+	ut_asserteq_str("4", htab_find(&htab, "c")->data);
+
+	hdestroy_r(&htab);
+	return 0;
+}
+
+ENV_TEST(env_test_htab_base_hidden, 0);
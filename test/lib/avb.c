@@ -0,0 +1,364 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for reading and hashing partitions in libavb
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <linux/sizes.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <../lib/libavb/libavb.h>
+
+/*
+ * vbmeta image signed with a throwaway SHA256_RSA2048 key. It holds one
+ * hash descriptor for "boot": AVB_TEST_IMAGE_SIZE bytes as produced by
+ * avb_test_pattern(), salted with the bytes 0x40..0x4f.
+ */
+static const u8 avb_test_vbmeta[] = {
+	0x41, 0x56, 0x42, 0x30, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x40, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x02, 0xc0, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xb8,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x08, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0xb8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x61, 0x76, 0x62, 0x74,
+	0x6f, 0x6f, 0x6c, 0x20, 0x31, 0x2e, 0x31, 0x2e, 0x30, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0xbf, 0xa4, 0x3a, 0x25, 0xe1, 0x4b, 0x40, 0x0d,
+	0xc1, 0x35, 0x99, 0x25, 0xd6, 0x9a, 0xa8, 0xa6, 0xb6, 0xca, 0x0d, 0x02,
+	0x6d, 0x53, 0xac, 0xd4, 0x3b, 0xe6, 0xe6, 0x73, 0x11, 0x81, 0xd4, 0x6b,
+	0x9c, 0x0f, 0x12, 0xf2, 0x04, 0x0a, 0xb5, 0xde, 0x82, 0xdf, 0xc7, 0x86,
+	0x2e, 0xec, 0xb8, 0x33, 0x7e, 0xcd, 0xef, 0xe8, 0x6b, 0x54, 0x19, 0xdd,
+	0x20, 0x61, 0x19, 0x24, 0x66, 0x53, 0xe8, 0x82, 0x35, 0xee, 0x9d, 0xd6,
+	0xc0, 0xed, 0xb6, 0xfe, 0x00, 0x28, 0x4b, 0x56, 0xb3, 0x05, 0xe1, 0xe1,
+	0xdb, 0x37, 0xe2, 0xc9, 0x4f, 0xdb, 0xdf, 0x80, 0xff, 0xf2, 0x04, 0xba,
+	0xd7, 0xb4, 0xac, 0x85, 0xfa, 0x06, 0x4c, 0xf9, 0xa7, 0xfa, 0xac, 0x96,
+	0xde, 0x40, 0xd2, 0xcc, 0x07, 0xfd, 0x59, 0x65, 0xc3, 0x01, 0x5b, 0xd0,
+	0x79, 0x6b, 0x25, 0xaf, 0x20, 0xbe, 0x99, 0x06, 0x54, 0x2f, 0xe5, 0xe4,
+	0x86, 0x28, 0x92, 0x93, 0xaa, 0xdd, 0xd1, 0xc2, 0x82, 0x44, 0x3a, 0xd1,
+	0x93, 0x3a, 0xc1, 0xf9, 0x65, 0xe0, 0x61, 0x81, 0x4c, 0x5d, 0x5f, 0x37,
+	0x33, 0x3f, 0x00, 0x6f, 0x5b, 0x8c, 0xb7, 0xe0, 0x44, 0x3a, 0xc1, 0x23,
+	0x93, 0x3a, 0xc7, 0x67, 0x37, 0x60, 0x6b, 0xe7, 0x77, 0xd2, 0xfc, 0x5d,
+	0xac, 0x9e, 0x5c, 0x6a, 0x65, 0xb6, 0x86, 0x5a, 0xc1, 0xf6, 0x17, 0x11,
+	0xd1, 0x0a, 0xec, 0x2f, 0x7d, 0xca, 0xdc, 0xc6, 0xe7, 0xd4, 0xc3, 0xa2,
+	0x13, 0x19, 0x3c, 0x70, 0x64, 0x66, 0x22, 0x16, 0xa1, 0xec, 0xde, 0xd9,
+	0x4b, 0x14, 0x35, 0x00, 0x53, 0x22, 0x64, 0x1c, 0xb9, 0xdd, 0x73, 0x90,
+	0xc5, 0xca, 0x0f, 0xb1, 0xa9, 0xea, 0x50, 0x3a, 0xe5, 0xd7, 0x8e, 0xf8,
+	0xc7, 0xb8, 0x31, 0x0e, 0x6d, 0x6d, 0x80, 0x29, 0x0b, 0x6a, 0x1d, 0x2e,
+	0xd7, 0x4c, 0x89, 0x1b, 0x51, 0xf8, 0xba, 0x91, 0x33, 0x77, 0x24, 0xb8,
+	0x20, 0x5a, 0xad, 0x92, 0x48, 0x45, 0xef, 0xf0, 0xd1, 0xdb, 0xd0, 0x64,
+	0x2b, 0x11, 0x80, 0x1c, 0xb4, 0xc2, 0x38, 0x2f, 0xfd, 0xeb, 0xfa, 0x58,
+	0x83, 0x53, 0x78, 0x66, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0xa8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x28, 0x03, 0xe8,
+	0x73, 0x68, 0x61, 0x32, 0x35, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04,
+	0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x62, 0x6f, 0x6f, 0x74, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47,
+	0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f, 0xc6, 0x16, 0x6a, 0x64,
+	0x33, 0x26, 0x5b, 0x12, 0xaf, 0x80, 0xab, 0x06, 0xff, 0x2f, 0x2b, 0xde,
+	0xad, 0x0b, 0x83, 0x3e, 0x83, 0x1f, 0xed, 0xca, 0x53, 0x98, 0xcd, 0x46,
+	0xb9, 0x46, 0x42, 0x85, 0x00, 0x00, 0x08, 0x00, 0x7a, 0x62, 0xcc, 0xd5,
+	0xc9, 0x8f, 0xc2, 0xe3, 0x01, 0x3a, 0x87, 0x0e, 0x23, 0xe3, 0x04, 0x79,
+	0xb7, 0x36, 0x65, 0x27, 0xb2, 0xa3, 0xcf, 0x27, 0x37, 0xf2, 0xe8, 0x0a,
+	0x2d, 0xaf, 0x80, 0x53, 0x7e, 0x56, 0x62, 0x93, 0xf3, 0x74, 0x67, 0x44,
+	0x52, 0x36, 0xe4, 0xcc, 0xf9, 0x77, 0xb7, 0x9f, 0x47, 0x3d, 0x77, 0xbc,
+	0x3c, 0xf7, 0xf3, 0x13, 0x72, 0xf0, 0x49, 0x12, 0x27, 0x32, 0x55, 0x99,
+	0xe7, 0x8f, 0x93, 0x3f, 0x09, 0x1d, 0x1a, 0x96, 0xd6, 0x12, 0xdd, 0x95,
+	0x33, 0x5e, 0xac, 0xf7, 0xb2, 0x44, 0x76, 0x69, 0xcf, 0xbe, 0xa5, 0x45,
+	0x28, 0x49, 0x6b, 0x8d, 0x0c, 0x39, 0x9e, 0x4f, 0x2f, 0x27, 0x77, 0x16,
+	0x2b, 0x41, 0x6d, 0xde, 0x6d, 0xc8, 0x0b, 0xd4, 0xcd, 0xdc, 0x5f, 0xdc,
+	0x13, 0xcf, 0x91, 0x36, 0x5a, 0x60, 0x4c, 0xe5, 0xd6, 0xe7, 0xcd, 0x10,
+	0x81, 0x83, 0xba, 0x09, 0x07, 0x39, 0x1f, 0x39, 0xf9, 0x8f, 0xd5, 0x3d,
+	0xa9, 0x19, 0x0a, 0x85, 0x07, 0x86, 0x8b, 0x53, 0x67, 0x93, 0xe4, 0x75,
+	0x3f, 0x38, 0x2e, 0xb0, 0x2d, 0x6d, 0x4e, 0x0d, 0x91, 0x1e, 0xad, 0xf4,
+	0x41, 0xec, 0x4f, 0x8b, 0x6d, 0x95, 0x3a, 0x27, 0x89, 0x9d, 0xd9, 0x9d,
+	0x61, 0x54, 0x72, 0x3d, 0x4f, 0x93, 0xf3, 0x15, 0xb6, 0x19, 0x8f, 0x24,
+	0x78, 0x0b, 0x32, 0xaf, 0xdb, 0x6f, 0xdb, 0x07, 0xd8, 0x5e, 0xc4, 0x85,
+	0x7c, 0x57, 0xc1, 0xd9, 0x5b, 0x27, 0xb9, 0x82, 0x07, 0x30, 0x86, 0x82,
+	0xb4, 0xdb, 0xee, 0x21, 0xfa, 0x7a, 0x5f, 0xc7, 0xd1, 0x6f, 0x24, 0xc9,
+	0xe9, 0xbb, 0x0b, 0x60, 0x58, 0x7d, 0x48, 0xf8, 0xc2, 0xbb, 0x68, 0xe0,
+	0xd4, 0xa0, 0x30, 0x3e, 0xa0, 0x75, 0x7a, 0x4a, 0xcc, 0x67, 0x4e, 0x81,
+	0x92, 0xbb, 0x8c, 0x46, 0xe4, 0xa0, 0x06, 0x49, 0x2a, 0x98, 0x27, 0x38,
+	0xe0, 0x77, 0xf3, 0x83, 0x7b, 0xaa, 0x0b, 0xb5, 0x58, 0x6f, 0xcb, 0xe1,
+	0xdc, 0x7e, 0x91, 0x8b, 0x56, 0x29, 0x51, 0x8b, 0x98, 0x6a, 0x26, 0x7d,
+	0xff, 0x00, 0xd3, 0x9b, 0xd2, 0x7d, 0x57, 0x33, 0x16, 0x27, 0x2e, 0x54,
+	0x28, 0x68, 0x67, 0x08, 0x0e, 0xf1, 0xa1, 0xe7, 0xf4, 0xe7, 0x62, 0xd7,
+	0x46, 0x94, 0xdc, 0x65, 0x67, 0x15, 0x15, 0x53, 0xbb, 0x7d, 0xd9, 0x4a,
+	0x11, 0xdc, 0xd6, 0x84, 0xdd, 0x98, 0xdc, 0x05, 0x64, 0xe4, 0x8a, 0x49,
+	0x4a, 0x33, 0x3d, 0xd8, 0x44, 0x23, 0xb6, 0xf3, 0xf5, 0x9d, 0xd6, 0xce,
+	0x37, 0x28, 0xf2, 0x05, 0x48, 0x30, 0x79, 0xba, 0xea, 0x38, 0xee, 0x59,
+	0x65, 0xce, 0xcf, 0xd8, 0x37, 0xa4, 0x1d, 0x86, 0xd0, 0xdd, 0xdd, 0x1a,
+	0x1b, 0xcc, 0x04, 0x01, 0xa6, 0xcb, 0x95, 0xf8, 0xb7, 0x84, 0x4b, 0x3b,
+	0xba, 0x7c, 0x7f, 0xec, 0x8e, 0x86, 0xb4, 0xe6, 0xce, 0x71, 0xeb, 0x6a,
+	0x3f, 0x19, 0xdb, 0x6c, 0x2e, 0x93, 0x5b, 0xed, 0xc3, 0x56, 0xac, 0x37,
+	0xf5, 0xce, 0x4d, 0x65, 0xfa, 0xcc, 0xb9, 0x82, 0xde, 0x59, 0x40, 0xb0,
+	0x20, 0xf7, 0x61, 0x3d, 0x65, 0x60, 0x9d, 0x33, 0xad, 0xd1, 0x70, 0xdb,
+	0xc6, 0xf6, 0x54, 0x00, 0xf5, 0xb3, 0xea, 0x17, 0x16, 0x83, 0x60, 0x18,
+	0x1a, 0xf8, 0x06, 0x40, 0xdb, 0xd6, 0x65, 0x5f, 0xec, 0x51, 0x87, 0x00,
+	0x03, 0x1f, 0x6b, 0x3d, 0xc6, 0xbf, 0x2a, 0x76, 0x96, 0x83, 0xc8, 0x14,
+	0x0d, 0x74, 0xd2, 0xa7, 0x5b, 0x7f, 0xb2, 0x46, 0x32, 0xcf, 0x54, 0x94,
+	0xbb, 0x46, 0xfc, 0x77, 0xe8, 0xf5, 0xf0, 0x2f, 0xe1, 0x4f, 0x73, 0x7b,
+	0x83, 0xbc, 0x06, 0xca, 0xa3, 0x3a, 0xf1, 0x4e, 0x3b, 0xa1, 0xeb, 0x13,
+	0x60, 0x0d, 0x3b, 0x4e, 0xaa, 0xaf, 0x48, 0xd3, 0x20, 0x73, 0xe4, 0x18,
+	0x5e, 0xa3, 0x7e, 0x7a, 0xf5, 0x20, 0xd1, 0x87,
+};
+
+/* More than two 1 MiB chunks, with a partial block at the end */
+#define AVB_TEST_IMAGE_SIZE	(0x280000 + 1000)
+#define AVB_TEST_PART_SIZE	0x300000
+#define AVB_TEST_CHUNKS		3
+
+struct avb_test {
+	AvbOps ops;
+	u8 *boot;
+	/* the read started by avb_test_start_read() */
+	bool pending;
+	const char *partition;
+	int64_t offset;
+	size_t num_bytes;
+	u8 *buffer;
+	int starts;
+	size_t max_read;
+	bool failed;
+};
+
+static u8 avb_test_pattern(ulong i)
+{
+	return (i ^ (i >> 8) ^ (i >> 16)) * 31 + 7;
+}
+
+static AvbIOResult avb_test_read(AvbOps *ops, const char *partition,
+				 int64_t offset, size_t num_bytes, void *buffer,
+				 size_t *out_num_read)
+{
+	struct avb_test *test = ops->user_data;
+	const u8 *data;
+	size_t size;
+
+	if (!strcmp(partition, "vbmeta")) {
+		data = avb_test_vbmeta;
+		size = sizeof(avb_test_vbmeta);
+	} else if (!strcmp(partition, "boot")) {
+		data = test->boot;
+		size = AVB_TEST_PART_SIZE;
+		test->max_read = max(test->max_read, num_bytes);
+	} else {
+		return AVB_IO_RESULT_ERROR_NO_SUCH_PARTITION;
+	}
+
+	if (offset < 0)
+		offset += size;
+	if (offset < 0 || offset > size)
+		return AVB_IO_RESULT_ERROR_RANGE_OUTSIDE_PARTITION;
+
+	*out_num_read = min(num_bytes, size - (size_t)offset);
+	memcpy(buffer, data + offset, *out_num_read);
+
+	return AVB_IO_RESULT_OK;
+}
+
+/*
+ * Pretend that the controller is still busy moving data: the buffer is
+ * filled with junk until the read is finished, so anything hashed from
+ * it too early gives the wrong digest.
+ */
+static AvbIOResult avb_test_start_read(AvbOps *ops, const char *partition,
+				       int64_t offset, size_t num_bytes,
+				       void *buffer)
+{
+	struct avb_test *test = ops->user_data;
+
+	if (test->pending)
+		test->failed = true;
+
+	test->pending = true;
+	test->partition = partition;
+	test->offset = offset;
+	test->num_bytes = num_bytes;
+	test->buffer = buffer;
+	test->starts++;
+	memset(buffer, 0xa5, num_bytes);
+
+	return AVB_IO_RESULT_OK;
+}
+
+static AvbIOResult avb_test_finish_read(AvbOps *ops, size_t *out_num_read)
+{
+	struct avb_test *test = ops->user_data;
+
+	if (!test->pending) {
+		test->failed = true;
+		return AVB_IO_RESULT_ERROR_IO;
+	}
+	test->pending = false;
+
+	return avb_test_read(ops, test->partition, test->offset,
+			     test->num_bytes, test->buffer, out_num_read);
+}
+
+static AvbIOResult avb_test_validate_key(AvbOps *ops, const u8 *key,
+					 size_t key_len, const u8 *metadata,
+					 size_t metadata_len, bool *out_trusted)
+{
+	*out_trusted = true;
+
+	return AVB_IO_RESULT_OK;
+}
+
+static AvbIOResult avb_test_rollback_index(AvbOps *ops, size_t location,
+					   u64 *out_index)
+{
+	*out_index = 0;
+
+	return AVB_IO_RESULT_OK;
+}
+
+static AvbIOResult avb_test_unlocked(AvbOps *ops, bool *out_unlocked)
+{
+	*out_unlocked = false;
+
+	return AVB_IO_RESULT_OK;
+}
+
+static AvbIOResult avb_test_guid(AvbOps *ops, const char *partition,
+				 char *guid_buf, size_t guid_buf_size)
+{
+	strlcpy(guid_buf, "00000000-0000-0000-0000-000000000000",
+		guid_buf_size);
+
+	return AVB_IO_RESULT_OK;
+}
+
+static int avb_test_init(struct avb_test *test, bool async)
+{
+	ulong i;
+
+	memset(test, 0, sizeof(*test));
+	test->boot = malloc(AVB_TEST_PART_SIZE);
+	if (!test->boot)
+		return -ENOMEM;
+	for (i = 0; i < AVB_TEST_PART_SIZE; i++)
+		test->boot[i] = avb_test_pattern(i);
+
+	test->ops.user_data = test;
+	test->ops.read_from_partition = avb_test_read;
+	test->ops.validate_vbmeta_public_key = avb_test_validate_key;
+	test->ops.read_rollback_index = avb_test_rollback_index;
+	test->ops.read_is_device_unlocked = avb_test_unlocked;
+	test->ops.get_unique_guid_for_partition = avb_test_guid;
+	if (async) {
+		test->ops.start_read_from_partition = avb_test_start_read;
+		test->ops.finish_read_from_partition = avb_test_finish_read;
+	}
+
+	return 0;
+}
+
+static const char * const avb_test_partitions[] = { "boot", NULL };
+
+/* Test that the next chunk is read while the previous one is hashed */
+static int lib_test_avb_async_read(struct unit_test_state *uts)
+{
+	AvbSlotVerifyData *data = NULL;
+	struct avb_test test;
+	ulong i;
+
+	ut_assertok(avb_test_init(&test, true));
+
+	ut_asserteq(AVB_SLOT_VERIFY_RESULT_OK,
+		    avb_slot_verify(&test.ops, avb_test_partitions, "", 0,
+				    AVB_HASHTREE_ERROR_MODE_RESTART_AND_INVALIDATE,
+				    &data));
+	ut_assert(!test.failed);
+	ut_assert(!test.pending);
+	ut_asserteq(AVB_TEST_CHUNKS, test.starts);
+
+	ut_asserteq(1, data->num_loaded_partitions);
+	ut_asserteq(AVB_TEST_IMAGE_SIZE, data->loaded_partitions[0].data_size);
+	for (i = 0; i < AVB_TEST_IMAGE_SIZE; i++) {
+		if (data->loaded_partitions[0].data[i] != avb_test_pattern(i))
+			break;
+	}
+	ut_asserteq(AVB_TEST_IMAGE_SIZE, i);
+	avb_slot_verify_data_free(data);
+
+	/* a corrupted image must still be caught */
+	test.boot[AVB_TEST_IMAGE_SIZE - 1] ^= 1;
+	test.starts = 0;
+	ut_asserteq(AVB_SLOT_VERIFY_RESULT_ERROR_VERIFICATION,
+		    avb_slot_verify(&test.ops, avb_test_partitions, "", 0,
+				    AVB_HASHTREE_ERROR_MODE_RESTART_AND_INVALIDATE,
+				    &data));
+	ut_assert(!test.failed);
+	ut_asserteq(AVB_TEST_CHUNKS, test.starts);
+	free(test.boot);
+
+	return 0;
+}
+LIB_TEST(lib_test_avb_async_read, 0);
+
+/*
+ * Test that verify-only mode streams a partition larger than one chunk
+ * through the hash without loading it
+ */
+static int avb_test_hash_only(struct unit_test_state *uts, bool async)
+{
+	AvbSlotVerifyData *data = NULL;
+	struct avb_test test;
+
+	ut_assertok(avb_test_init(&test, async));
+
+	ut_asserteq(AVB_SLOT_VERIFY_RESULT_OK,
+		    avb_slot_verify(&test.ops, avb_test_partitions, "",
+				    AVB_SLOT_VERIFY_FLAGS_HASH_ONLY,
+				    AVB_HASHTREE_ERROR_MODE_RESTART_AND_INVALIDATE,
+				    &data));
+	ut_assert(!test.failed);
+	ut_asserteq(0, data->num_loaded_partitions);
+	ut_asserteq(async ? AVB_TEST_CHUNKS : 0, test.starts);
+	ut_assert(test.max_read <= SZ_1M);
+	avb_slot_verify_data_free(data);
+
+	/* the last byte is in the final, partial chunk */
+	test.boot[AVB_TEST_IMAGE_SIZE - 1] ^= 1;
+	ut_asserteq(AVB_SLOT_VERIFY_RESULT_ERROR_VERIFICATION,
+		    avb_slot_verify(&test.ops, avb_test_partitions, "",
+				    AVB_SLOT_VERIFY_FLAGS_HASH_ONLY,
+				    AVB_HASHTREE_ERROR_MODE_RESTART_AND_INVALIDATE,
+				    &data));
+	free(test.boot);
+
+	return 0;
+}
+
+static int lib_test_avb_hash_only(struct unit_test_state *uts)
+{
+	ut_assertok(avb_test_hash_only(uts, false));
+	ut_assertok(avb_test_hash_only(uts, true));
+
+	return 0;
+}
+LIB_TEST(lib_test_avb_hash_only, 0);
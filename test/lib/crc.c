@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the CRC-32 and CRC-32C routines
+ */
+
+#include <common.h>
+#include <u-boot/crc.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define CRC_TEST_LEN	300
+
+static const char crc_check[] = "123456789";
+
+/* Bit-at-a-time reference, independent of any table or instruction */
+static uint32_t crc_test_ref(uint32_t crc, const u8 *p, int len, uint32_t poly)
+{
+	int k;
+
+	while (len--) {
+		crc ^= *p++;
+		for (k = 0; k < 8; k++)
+			crc = (crc >> 1) ^ (crc & 1 ? poly : 0);
+	}
+
+	return crc;
+}
+
+static void crc_test_fill(u8 *buf, int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = (i * 131 + 7) ^ (i >> 5);
+}
+
+static int lib_test_crc32(struct unit_test_state *uts)
+{
+	u8 buf[CRC_TEST_LEN + 8];
+	int off, len;
+
+	ut_asserteq(0xcbf43926, crc32(0, (const u8 *)crc_check, 9));
+	ut_asserteq(0, crc32(0, NULL, 0));
+
+	/* Every alignment and tail length of the word and 8-byte loops */
+	crc_test_fill(buf, sizeof(buf));
+	for (off = 0; off < 8; off++) {
+		for (len = 0; len <= CRC_TEST_LEN; len++) {
+			ut_asserteq(crc_test_ref(0x12345678, buf + off, len,
+						 0xedb88320),
+				    crc32_no_comp(0x12345678, buf + off, len));
+		}
+	}
+
+	return 0;
+}
+
+LIB_TEST(lib_test_crc32, 0);
+
+#ifdef CONFIG_CRC32C
+static int lib_test_crc32c(struct unit_test_state *uts)
+{
+	uint32_t table[256];
+	u8 buf[CRC_TEST_LEN + 8];
+	int off, len;
+
+	crc32c_init(table, CRC32C_POLY_LE);
+	ut_asserteq(0xe3069283, ~crc32c_cal(~0, crc_check, 9, table));
+
+	crc_test_fill(buf, sizeof(buf));
+	for (off = 0; off < 8; off++) {
+		for (len = 0; len <= CRC_TEST_LEN; len++) {
+			ut_asserteq(crc_test_ref(~0, buf + off, len,
+						 CRC32C_POLY_LE),
+				    crc32c_cal(~0, (const char *)buf + off, len,
+					       table));
+		}
+	}
+
+	return 0;
+}
+
+LIB_TEST(lib_test_crc32c, 0);
+#endif
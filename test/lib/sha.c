@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the SHA-1 and SHA-256 block processing paths
+ */
+
+#include <common.h>
+#include <hexdump.h>
+#include <image.h>
+#include <u-boot/sha1.h>
+#include <u-boot/sha256.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define SHA_TEST_LEN	1000
+
+/* Split points mixing partial-block, single-block and multi-block updates */
+static const uint sha_test_chunks[] = { 1, 63, 65, 128, 3, 300, 440 };
+
+static const u8 sha256_expect[SHA256_SUM_LEN] = {
+	0x1e, 0x9b, 0xc3, 0x8c, 0xbf, 0x86, 0x0b, 0x9e,
+	0xc3, 0x19, 0x18, 0xb0, 0x65, 0xf9, 0xb5, 0x24,
+	0x76, 0xc5, 0x49, 0xa7, 0x82, 0xe0, 0xe7, 0x99,
+	0x0b, 0xed, 0x8c, 0xe3, 0x86, 0x8d, 0x23, 0x71,
+};
+
+static void sha_test_fill(u8 *buf)
+{
+	int i;
+
+	for (i = 0; i < SHA_TEST_LEN; i++)
+		buf[i] = i * 7 + 3;
+}
+
+#ifdef CONFIG_SHA1
+static const u8 sha1_expect[SHA1_SUM_LEN] = {
+	0x42, 0x31, 0xa8, 0xa5, 0x0a, 0x10, 0xfa, 0x97, 0x58, 0xdb,
+	0x8e, 0xc7, 0x1f, 0xde, 0xf8, 0x55, 0xb7, 0x51, 0x04, 0x8a,
+};
+
+static int lib_test_sha1_update(struct unit_test_state *uts)
+{
+	u8 buf[SHA_TEST_LEN];
+	u8 out[SHA1_SUM_LEN];
+	sha1_context ctx;
+	uint pos = 0;
+	int i;
+
+	sha_test_fill(buf);
+
+	sha1_csum_wd(buf, SHA_TEST_LEN, out, CHUNKSZ_SHA1);
+	ut_asserteq_mem(sha1_expect, out, SHA1_SUM_LEN);
+
+	sha1_starts(&ctx);
+	for (i = 0; i < ARRAY_SIZE(sha_test_chunks); i++) {
+		sha1_update(&ctx, buf + pos, sha_test_chunks[i]);
+		pos += sha_test_chunks[i];
+	}
+	ut_asserteq(SHA_TEST_LEN, pos);
+	sha1_finish(&ctx, out);
+	ut_asserteq_mem(sha1_expect, out, SHA1_SUM_LEN);
+
+	return 0;
+}
+
+LIB_TEST(lib_test_sha1_update, 0);
+#endif
+
+static int lib_test_sha256_update(struct unit_test_state *uts)
+{
+	u8 buf[SHA_TEST_LEN];
+	u8 out[SHA256_SUM_LEN];
+	sha256_context ctx;
+	uint pos = 0;
+	int i;
+
+	sha_test_fill(buf);
+
+	sha256_csum_wd(buf, SHA_TEST_LEN, out, CHUNKSZ_SHA256);
+	ut_asserteq_mem(sha256_expect, out, SHA256_SUM_LEN);
+
+	sha256_starts(&ctx);
+	for (i = 0; i < ARRAY_SIZE(sha_test_chunks); i++) {
+		sha256_update(&ctx, buf + pos, sha_test_chunks[i]);
+		pos += sha_test_chunks[i];
+	}
+	ut_asserteq(SHA_TEST_LEN, pos);
+	sha256_finish(&ctx, out);
+	ut_asserteq_mem(sha256_expect, out, SHA256_SUM_LEN);
+
+	return 0;
+}
+
+LIB_TEST(lib_test_sha256_update, 0);
@@ -0,0 +1,486 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for writing Android sparse images
+ */
+
+#include <common.h>
+#include <image-sparse.h>
+#include <malloc.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define SPARSE_TEST_BLKSZ	512
+#define SPARSE_TEST_IMG_BLKSZ	4096
+#define SPARSE_TEST_START	16
+#define SPARSE_TEST_SIZE	4096
+#define SPARSE_TEST_BACKGROUND	0x5a
+
+struct sparse_test_chunk {
+	u16 type;
+	u32 blocks;
+	u32 fill;
+};
+
+/*
+ * The first three chunks are small and adjacent, so they are gathered into
+ * one write; the DONT_CARE gap then forces a new write. The last RAW and
+ * FILL chunks are larger than the staging buffer.
+ */
+static const struct sparse_test_chunk sparse_test_chunks[] = {
+	{ CHUNK_TYPE_RAW, 1 },
+	{ CHUNK_TYPE_RAW, 2 },
+	{ CHUNK_TYPE_FILL, 3, 0x12345678 },
+	{ CHUNK_TYPE_DONT_CARE, 2 },
+	{ CHUNK_TYPE_RAW, 160 },
+	{ CHUNK_TYPE_CRC32, 0 },
+	{ CHUNK_TYPE_FILL, 200, 0 },
+	{ CHUNK_TYPE_DONT_CARE, 4 },
+};
+
+/**
+ * struct sparse_test - memory-backed storage for write_sparse_image()
+ *
+ * @info:	Storage handed to the writer
+ * @disk:	Contents of the storage
+ * @expect:	What the storage should hold once the image is written
+ * @image:	Sparse image
+ * @image_size:	Size of @image in bytes
+ * @writes:	Number of write() and submit() calls
+ * @done:	Number of writes completed
+ * @max_queued:	Largest number of submitted writes not yet waited for
+ * @erases:	Number of erase() calls
+ * @erased:	Number of blocks erased
+ * @erase_fail:	Make erase() fail
+ * @failed:	Set if a request went outside the storage, was not queued, or
+ *		an erase was unaligned or overtook a queued write
+ */
+struct sparse_test {
+	struct sparse_storage info;
+	u8 *disk;
+	u8 *expect;
+	u8 *image;
+	size_t image_size;
+	int writes;
+	int done;
+	int max_queued;
+	int erases;
+	lbaint_t erased;
+	bool erase_fail;
+	bool failed;
+};
+
+static u8 *sparse_test_blk(struct sparse_test *test, lbaint_t blk,
+			   lbaint_t blkcnt)
+{
+	if (blk < test->info.start ||
+	    blk + blkcnt > test->info.start + test->info.size) {
+		test->failed = true;
+		return NULL;
+	}
+
+	return test->disk + blk * SPARSE_TEST_BLKSZ;
+}
+
+static lbaint_t sparse_test_write(struct sparse_storage *info, lbaint_t blk,
+				  lbaint_t blkcnt, const void *buffer)
+{
+	struct sparse_test *test = info->priv;
+	u8 *dst = sparse_test_blk(test, blk, blkcnt);
+
+	test->writes++;
+	test->done++;
+	if (!dst)
+		return 0;
+	memcpy(dst, buffer, blkcnt * SPARSE_TEST_BLKSZ);
+
+	return blkcnt;
+}
+
+static lbaint_t sparse_test_reserve(struct sparse_storage *info, lbaint_t blk,
+				    lbaint_t blkcnt)
+{
+	return blkcnt;
+}
+
+/* Erased blocks read back as zero */
+static lbaint_t sparse_test_erase(struct sparse_storage *info, lbaint_t blk,
+				  lbaint_t blkcnt)
+{
+	struct sparse_test *test = info->priv;
+	u8 *dst = sparse_test_blk(test, blk, blkcnt);
+
+	test->erases++;
+	if (blk % info->erase_blks || blkcnt % info->erase_blks ||
+	    test->writes != test->done)
+		test->failed = true;
+	if (!dst || test->erase_fail)
+		return 0;
+	memset(dst, '\0', blkcnt * SPARSE_TEST_BLKSZ);
+	test->erased += blkcnt;
+
+	return blkcnt;
+}
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+/* The data is only read at wait(), as a DMA engine might read it late */
+static int sparse_test_submit(struct sparse_storage *info,
+			      struct blk_req *req)
+{
+	struct sparse_test *test = info->priv;
+
+	if (!req->write) {
+		test->failed = true;
+		return -EINVAL;
+	}
+	test->writes++;
+	test->max_queued = max(test->max_queued, test->writes - test->done);
+
+	return 0;
+}
+
+static long sparse_test_wait(struct sparse_storage *info, struct blk_req *req)
+{
+	struct sparse_test *test = info->priv;
+	u8 *dst = sparse_test_blk(test, req->start, req->blkcnt);
+
+	test->done++;
+	if (!dst)
+		return -EIO;
+	memcpy(dst, req->buffer, req->blkcnt * SPARSE_TEST_BLKSZ);
+
+	return req->blkcnt;
+}
+#endif
+
+static u8 sparse_test_pattern(size_t pos)
+{
+	return (pos ^ (pos >> 8) ^ (pos >> 16)) * 13 + 1;
+}
+
+/* Build the sparse image and the storage contents it should produce */
+static int sparse_test_init(struct sparse_test *test, bool async)
+{
+	const struct sparse_test_chunk *c;
+	sparse_header_t *hdr;
+	chunk_header_t *chdr;
+	size_t disk_size, bytes, i;
+	u8 *p, *dst;
+	u32 total_blks = 0;
+	int n;
+
+	memset(test, '\0', sizeof(*test));
+	test->info.blksz = SPARSE_TEST_BLKSZ;
+	test->info.start = SPARSE_TEST_START;
+	test->info.size = SPARSE_TEST_SIZE;
+	test->info.priv = test;
+	test->info.write = sparse_test_write;
+	test->info.reserve = sparse_test_reserve;
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	if (async) {
+		test->info.submit = sparse_test_submit;
+		test->info.wait = sparse_test_wait;
+	}
+#endif
+
+	test->image_size = sizeof(*hdr);
+	for (n = 0; n < ARRAY_SIZE(sparse_test_chunks); n++) {
+		c = &sparse_test_chunks[n];
+		test->image_size += sizeof(*chdr);
+		if (c->type == CHUNK_TYPE_RAW)
+			test->image_size += c->blocks * SPARSE_TEST_IMG_BLKSZ;
+		else if (c->type == CHUNK_TYPE_FILL)
+			test->image_size += sizeof(u32);
+	}
+
+	disk_size = (SPARSE_TEST_START + SPARSE_TEST_SIZE) * SPARSE_TEST_BLKSZ;
+	test->disk = malloc(disk_size);
+	test->expect = malloc(disk_size);
+	test->image = malloc(test->image_size);
+	if (!test->disk || !test->expect || !test->image)
+		return -ENOMEM;
+	memset(test->disk, SPARSE_TEST_BACKGROUND, disk_size);
+	memset(test->expect, SPARSE_TEST_BACKGROUND, disk_size);
+
+	p = test->image + sizeof(*hdr);
+	dst = test->expect + SPARSE_TEST_START * SPARSE_TEST_BLKSZ;
+	for (n = 0; n < ARRAY_SIZE(sparse_test_chunks); n++) {
+		c = &sparse_test_chunks[n];
+		bytes = c->blocks * SPARSE_TEST_IMG_BLKSZ;
+		chdr = (chunk_header_t *)p;
+		chdr->chunk_type = c->type;
+		chdr->reserved1 = 0;
+		chdr->chunk_sz = c->blocks;
+		chdr->total_sz = sizeof(*chdr);
+		p += sizeof(*chdr);
+
+		switch (c->type) {
+		case CHUNK_TYPE_RAW:
+			for (i = 0; i < bytes; i++)
+				p[i] = sparse_test_pattern(p - test->image + i);
+			memcpy(dst, p, bytes);
+			chdr->total_sz += bytes;
+			p += bytes;
+			break;
+		case CHUNK_TYPE_FILL:
+			memcpy(p, &c->fill, sizeof(u32));
+			for (i = 0; i < bytes; i += sizeof(u32))
+				memcpy(dst + i, &c->fill, sizeof(u32));
+			chdr->total_sz += sizeof(u32);
+			p += sizeof(u32);
+			break;
+		}
+		dst += bytes;
+		total_blks += c->blocks;
+	}
+
+	hdr = (sparse_header_t *)test->image;
+	hdr->magic = SPARSE_HEADER_MAGIC;
+	hdr->major_version = 1;
+	hdr->minor_version = 0;
+	hdr->file_hdr_sz = sizeof(*hdr);
+	hdr->chunk_hdr_sz = sizeof(*chdr);
+	hdr->blk_sz = SPARSE_TEST_IMG_BLKSZ;
+	hdr->total_blks = total_blks;
+	hdr->total_chunks = ARRAY_SIZE(sparse_test_chunks);
+	hdr->image_checksum = 0;
+
+	return 0;
+}
+
+static void sparse_test_free(struct sparse_test *test)
+{
+	free(test->disk);
+	free(test->expect);
+	free(test->image);
+}
+
+static int sparse_test_write_image(struct unit_test_state *uts, bool async)
+{
+	size_t disk_size = (SPARSE_TEST_START + SPARSE_TEST_SIZE) *
+			   SPARSE_TEST_BLKSZ;
+	struct sparse_test test;
+	char response[64] = "";
+
+	ut_assertok(sparse_test_init(&test, async));
+	ut_assert(is_sparse_image(test.image));
+	ut_assertok(write_sparse_image(&test.info, "test", test.image,
+				       response));
+	ut_assert(!test.failed);
+	ut_asserteq_str("", response);
+	ut_assertok(memcmp(test.expect, test.disk, disk_size));
+
+	if (async) {
+		/*
+		 * The small chunks, the large RAW chunk and the large FILL
+		 * chunk, which is written from a 1024-block buffer
+		 */
+		ut_asserteq(4, test.writes);
+		ut_asserteq(test.writes, test.done);
+		ut_assert(test.max_queued > 1);
+	} else {
+		ut_asserteq(6, test.writes);
+	}
+	sparse_test_free(&test);
+
+	return 0;
+}
+
+static int lib_test_sparse_write(struct unit_test_state *uts)
+{
+	ut_assertok(sparse_test_write_image(uts, false));
+	if (CONFIG_IS_ENABLED(BLK_ASYNC))
+		ut_assertok(sparse_test_write_image(uts, true));
+
+	return 0;
+}
+LIB_TEST(lib_test_sparse_write, 0);
+
+/* A chunk that runs past the end of the storage is refused */
+static int lib_test_sparse_too_big(struct unit_test_state *uts)
+{
+	struct sparse_test test;
+	char response[64] = "";
+
+	ut_assertok(sparse_test_init(&test, false));
+	test.info.size = 8;
+	ut_asserteq(-1, write_sparse_image(&test.info, "test", test.image,
+					   response));
+	ut_assert(!test.failed);
+	sparse_test_free(&test);
+
+	return 0;
+}
+LIB_TEST(lib_test_sparse_too_big, 0);
+
+/*
+ * The aligned middle of the large zero FILL chunk is erased, once queued
+ * writes have completed; the rest is written. If the erase fails, zeroes
+ * are written instead.
+ */
+static int sparse_test_erase_image(struct unit_test_state *uts, bool async,
+				   bool fail)
+{
+	size_t disk_size = (SPARSE_TEST_START + SPARSE_TEST_SIZE) *
+			   SPARSE_TEST_BLKSZ;
+	struct sparse_test test;
+	char response[64] = "";
+
+	ut_assertok(sparse_test_init(&test, async));
+	test.info.erase = sparse_test_erase;
+	test.info.erase_blks = 64;
+	test.erase_fail = fail;
+	ut_assertok(write_sparse_image(&test.info, "test", test.image,
+				       response));
+	ut_assert(!test.failed);
+	ut_assertok(memcmp(test.expect, test.disk, disk_size));
+	ut_asserteq(1, test.erases);
+	ut_asserteq(fail ? 0 : 1536, test.erased);
+	sparse_test_free(&test);
+
+	return 0;
+}
+
+static int lib_test_sparse_erase(struct unit_test_state *uts)
+{
+	ut_assertok(sparse_test_erase_image(uts, false, false));
+	ut_assertok(sparse_test_erase_image(uts, false, true));
+	if (CONFIG_IS_ENABLED(BLK_ASYNC)) {
+		ut_assertok(sparse_test_erase_image(uts, true, false));
+		ut_assertok(sparse_test_erase_image(uts, true, true));
+	}
+
+	return 0;
+}
+LIB_TEST(lib_test_sparse_erase, 0);
+
+#if CONFIG_IS_ENABLED(IMAGE_SPARSE_STREAM)
+/*
+ * Write @len bytes of @data to a stream in pieces of awkward sizes. Each
+ * piece goes through a buffer which is overwritten as soon as the stream
+ * has taken it, as a download buffer would be.
+ */
+static int sparse_test_stream(struct sparse_test *test, const u8 *data,
+			      size_t len)
+{
+	static const size_t sizes[] = { 1, 11, 512, 4099, 65537 };
+	struct sparse_stream *s;
+	char response[64] = "";
+	size_t n, i;
+	u8 *piece;
+	int ret = 0;
+
+	piece = malloc(65537);
+	s = sparse_stream_start(&test->info, "test");
+	if (!piece || !s) {
+		free(piece);
+		return -ENOMEM;
+	}
+
+	for (i = 0; len && !ret; i++) {
+		n = min(len, sizes[i % ARRAY_SIZE(sizes)]);
+		memcpy(piece, data, n);
+		ret = sparse_stream_write(s, piece, n, response);
+		memset(piece, 0xee, n);
+		data += n;
+		len -= n;
+	}
+	if (!ret)
+		ret = sparse_stream_finish(s, response);
+	else
+		sparse_stream_finish(s, response);
+	free(piece);
+
+	return ret;
+}
+
+static int sparse_test_stream_image(struct unit_test_state *uts, bool async)
+{
+	size_t disk_size = (SPARSE_TEST_START + SPARSE_TEST_SIZE) *
+			   SPARSE_TEST_BLKSZ;
+	struct sparse_test test;
+
+	ut_assertok(sparse_test_init(&test, async));
+	ut_assertok(sparse_test_stream(&test, test.image, test.image_size));
+	ut_assert(!test.failed);
+	ut_assertok(memcmp(test.expect, test.disk, disk_size));
+
+	/* A truncated image is reported; starting again from scratch works */
+	memset(test.disk, SPARSE_TEST_BACKGROUND, disk_size);
+	ut_assert(sparse_test_stream(&test, test.image,
+				     test.image_size / 2) < 0);
+	ut_assertok(sparse_test_stream(&test, test.image, test.image_size));
+	ut_assert(!test.failed);
+	ut_assertok(memcmp(test.expect, test.disk, disk_size));
+	sparse_test_free(&test);
+
+	return 0;
+}
+
+static int lib_test_sparse_stream(struct unit_test_state *uts)
+{
+	ut_assertok(sparse_test_stream_image(uts, false));
+	if (CONFIG_IS_ENABLED(BLK_ASYNC))
+		ut_assertok(sparse_test_stream_image(uts, true));
+
+	return 0;
+}
+LIB_TEST(lib_test_sparse_stream, 0);
+
+/* An image without the sparse magic is written as is, padded with zeroes */
+static int lib_test_sparse_stream_raw(struct unit_test_state *uts)
+{
+	size_t disk_size = (SPARSE_TEST_START + SPARSE_TEST_SIZE) *
+			   SPARSE_TEST_BLKSZ;
+	size_t len = 100000;
+	struct sparse_test test;
+	u8 *dst;
+
+	ut_assertok(sparse_test_init(&test, true));
+	memset(test.expect, SPARSE_TEST_BACKGROUND, disk_size);
+	dst = test.expect + SPARSE_TEST_START * SPARSE_TEST_BLKSZ;
+	memcpy(dst, test.image + sizeof(sparse_header_t), len);
+	memset(dst + len, '\0', ROUNDUP(len, SPARSE_TEST_BLKSZ) - len);
+	ut_assertok(sparse_test_stream(&test,
+				       test.image + sizeof(sparse_header_t),
+				       len));
+	ut_assert(!test.failed);
+	ut_assertok(memcmp(test.expect, test.disk, disk_size));
+	sparse_test_free(&test);
+
+	return 0;
+}
+LIB_TEST(lib_test_sparse_stream_raw, 0);
+
+/* An empty RAW chunk may end the image, with nothing after its header */
+static int lib_test_sparse_stream_empty_raw(struct unit_test_state *uts)
+{
+	size_t disk_size = (SPARSE_TEST_START + SPARSE_TEST_SIZE) *
+			   SPARSE_TEST_BLKSZ;
+	struct sparse_test test;
+	sparse_header_t *hdr;
+	chunk_header_t *chdr;
+	u8 *image;
+
+	ut_assertok(sparse_test_init(&test, false));
+	image = malloc(test.image_size + sizeof(*chdr));
+	ut_assertnonnull(image);
+	memcpy(image, test.image, test.image_size);
+	hdr = (sparse_header_t *)image;
+	hdr->total_chunks++;
+	chdr = (chunk_header_t *)(image + test.image_size);
+	chdr->chunk_type = CHUNK_TYPE_RAW;
+	chdr->reserved1 = 0;
+	chdr->chunk_sz = 0;
+	chdr->total_sz = sizeof(*chdr);
+	ut_assertok(sparse_test_stream(&test, image,
+				       test.image_size + sizeof(*chdr)));
+	ut_assert(!test.failed);
+	ut_assertok(memcmp(test.expect, test.disk, disk_size));
+	free(image);
+	sparse_test_free(&test);
+
+	return 0;
+}
+LIB_TEST(lib_test_sparse_stream_empty_raw, 0);
+#endif
@@ -14,9 +14,11 @@ static data.
 import collections
 import copy
 import sys
+import zlib
 
 import fdt
 import fdt_util
+import src_scan
 
 # When we see these properties we ignore them - i.e. do not create a structure member
 PROP_IGNORE_LIST = [
@@ -546,8 +548,83 @@ class DtbPlatdata(object):
             self.output_node(node)
             nodes_to_output.remove(node)
 
+    def generate_bind_table(self, drivers):
+        """Generate a table of the driver to bind to each node
 
-def run_steps(args, dtb_file, include_disabled, output):
+        This works out which drivers lists_bind_fdt() would find for each
+        compatible string of each valid node, in the order it would try
+        them: the linker list of drivers is sorted by symbol name. Since
+        not every driver is built, all candidates are listed and U-Boot uses
+        the first one it has.
+
+        The table names every driver with an of_match table, including
+        those whose compatible strings are not known, so that U-Boot can
+        ignore the table if a driver built in is missing from it or unknown.
+
+        Args:
+            drivers: Dict of src_scan.Driver objects, keyed by driver name
+        """
+        by_sym = sorted([drv for drv in drivers.values() if drv.compats],
+                        key=lambda drv: drv.sym)
+        cands = []
+        for node in self._valid_nodes:
+            compats = node.props['compatible'].value
+            if not isinstance(compats, list):
+                compats = [compats]
+            if len(compats) > 255:
+                raise ValueError("Node '%s' has too many compatible strings" %
+                                 node.path)
+            for compat_idx, compat in enumerate(compats):
+                for drv in by_sym:
+                    if compat in drv.compats:
+                        cands.append((node, compat_idx, compat, drv))
+
+        names = sorted([drv.name for drv in drivers.values()
+                        if drv.compats != []])
+        if len(names) > 65535:
+            raise ValueError('Too many drivers: %d' % len(names))
+        index = dict([(name, i) for i, name in enumerate(names)])
+
+        self.out_header()
+        self.out('#include <common.h>\n')
+        self.out('#include <dm.h>\n')
+        self.out('#include <dm/lists.h>\n')
+        self.out('\n')
+        self.out('static const char *const dm_bind_driver_names[] = {\n')
+        for name in names:
+            self.out('\t"%s",\n' % name)
+        self.out('};\n')
+        self.out('\n')
+        self.out('static const bool dm_bind_driver_unknown[] = {\n')
+        for name in names:
+            self.out('\t%s,\n' %
+                     ('true' if drivers[name].compats is None else 'false'))
+        self.out('};\n')
+        self.out('\n')
+        self.out('static const struct dm_bind_entry dm_bind_entries[] = {\n')
+        for node, compat_idx, compat, drv in cands:
+            self.out('\t{ %#x, %d, %d, %d },\t/* %s: %s */\n' %
+                     (node.Offset(), compat_idx,
+                      drv.compats.index(compat), index[drv.name],
+                      node.path, drv.name))
+        self.out('};\n')
+        self.out('\n')
+
+        fdt_obj = self._fdt.GetFdtObj()
+        size = fdt_obj.totalsize()
+        crc = zlib.crc32(bytes(self._fdt.GetContents()[:size])) & 0xffffffff
+        self.out('const struct dm_bind_table dm_bind_table = {\n')
+        self.out('\t.fdt_size\t= %#x,\n' % size)
+        self.out('\t.fdt_crc\t= %#x,\n' % crc)
+        self.out('\t.drivers\t= dm_bind_driver_names,\n')
+        self.out('\t.unknown\t= dm_bind_driver_unknown,\n')
+        self.out('\t.driver_count\t= ARRAY_SIZE(dm_bind_driver_names),\n')
+        self.out('\t.entries\t= dm_bind_entries,\n')
+        self.out('\t.entry_count\t= ARRAY_SIZE(dm_bind_entries),\n')
+        self.out('};\n')
+
+
+def run_steps(args, dtb_file, include_disabled, output, src_dir=None):
     """Run all the steps of the dtoc tool
 
     Args:
@@ -555,23 +632,31 @@ def run_steps(args, dtb_file, include_disabled, output):
         dtb_file: Filename of dtb file to process
         include_disabled: True to include disabled nodes
         output: Name of output file
+        src_dir: Top of the source tree to scan for drivers, for 'bind'
     """
     if not args:
-        raise ValueError('Please specify a command: struct, platdata')
+        raise ValueError('Please specify a command: struct, platdata, bind')
 
     plat = DtbPlatdata(dtb_file, include_disabled)
     plat.scan_dtb()
     plat.scan_tree()
-    plat.scan_reg_sizes()
     plat.setup_output(output)
-    structs = plat.scan_structs()
-    plat.scan_phandles()
+    cmds = args[0].split(',')
+    if 'struct' in cmds or 'platdata' in cmds:
+        plat.scan_reg_sizes()
+        structs = plat.scan_structs()
+        plat.scan_phandles()
 
-    for cmd in args[0].split(','):
+    for cmd in cmds:
         if cmd == 'struct':
             plat.generate_structs(structs)
         elif cmd == 'platdata':
             plat.generate_tables()
+        elif cmd == 'bind':
+            if not src_dir:
+                raise ValueError("Please specify the source directory (-s) "
+                                 "for 'bind'")
+            plat.generate_bind_table(src_scan.scan_drivers(src_dir))
         else:
-            raise ValueError("Unknown command '%s': (use: struct, platdata)" %
-                             cmd)
+            raise ValueError("Unknown command '%s': (use: struct, platdata, "
+                             "bind)" % cmd)
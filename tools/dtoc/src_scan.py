@@ -0,0 +1,122 @@
+#!/usr/bin/python
+# SPDX-License-Identifier: GPL-2.0+
+
+"""Scan the U-Boot sources for drivers and their compatible strings
+
+This finds each U_BOOT_DRIVER() declaration along with the name of the driver
+and the compatible strings in its of_match table. It is used to work out at
+build time which driver binds to each device-tree node.
+
+The scan works on the source text without running the preprocessor, so it
+cannot follow everything. Where a driver's compatible strings cannot be
+worked out reliably (the table is built with macros or #ifdefs, for example)
+the driver is marked as unknown. Code using the result must not rely on it
+when such a driver is built in.
+"""
+
+import collections
+import os
+import re
+
+# Information about a driver
+#
+# sym: Name of the driver's linker-list symbol, i.e. U_BOOT_DRIVER(sym)
+# name: Driver name, as in its .name member (None if not a string literal or
+#     a #define of one)
+# compats: List of compatible strings in its of_match table, in order, or
+#     None if unknown. This is empty if the driver has no of_match table.
+Driver = collections.namedtuple('Driver', ['sym', 'name', 'compats'])
+
+RE_DRIVER = re.compile(r'U_BOOT_DRIVER\((\w+)\)\s*=\s*{(.*?)\n};', re.S)
+RE_OF_MATCH_TABLE = re.compile(
+    r'struct\s+udevice_id\s+(\w+)\s*\[\s*\]\s*=\s*{(.*?)}\s*;', re.S)
+RE_NAME = re.compile(r'\.name\s*=\s*(?:"([^"]*)"|(\w+))')
+RE_DEFINE_STR = re.compile(r'^#define\s+(\w+)\s+"([^"]*)"', re.M)
+RE_OF_MATCH = re.compile(r'\.of_match\s*=\s*(?:of_match_ptr\s*\(\s*)?(\w+)')
+RE_COMPAT = re.compile(r'\.compatible\s*=\s*"([^"]*)"|^\s*{\s*"([^"]*)"')
+RE_COMPAT_END = re.compile(r'\.compatible\s*=\s*(NULL|0)\b')
+RE_COMMENT = re.compile(r'/\*.*?\*/|//[^\n]*', re.S)
+
+def parse_of_match_table(body):
+    """Get the compatible strings from the body of a udevice_id table
+
+    Args:
+        body: Text between the braces of the table
+
+    Returns:
+        List of compatible strings, or None if they cannot be worked out
+    """
+    if '#' in body:
+        return None
+    entries = [entry for entry in re.split(r'}\s*,?', body)
+               if entry.strip().lstrip('{').strip()]
+    compats = []
+    for entry in entries:
+        if RE_COMPAT_END.search(entry):
+            break
+        match = RE_COMPAT.search(entry)
+        if not match:
+            return None
+        compats.append(match.group(1) if match.group(1) is not None
+                       else match.group(2))
+    return compats
+
+def scan_file(fname):
+    """Scan a C file for drivers
+
+    Args:
+        fname: Filename to scan
+
+    Returns:
+        List of Driver objects
+    """
+    with open(fname) as fd:
+        data = fd.read()
+    if 'U_BOOT_DRIVER' not in data:
+        return []
+    data = RE_COMMENT.sub('', data)
+
+    defines = dict(RE_DEFINE_STR.findall(data))
+    tables = {}
+    for match in RE_OF_MATCH_TABLE.finditer(data):
+        tables[match.group(1)] = parse_of_match_table(match.group(2))
+
+    drivers = []
+    for match in RE_DRIVER.finditer(data):
+        sym, body = match.groups()
+        name = RE_NAME.search(body)
+        if name:
+            name = name.group(1) or defines.get(name.group(2))
+        of_match = RE_OF_MATCH.search(body)
+        if not of_match:
+            compats = [] if '.of_match' not in body else None
+        else:
+            compats = tables.get(of_match.group(1))
+        drivers.append(Driver(sym, name, compats))
+    return drivers
+
+def scan_drivers(srcdir):
+    """Scan a source tree for drivers
+
+    Args:
+        srcdir: Top of the source tree
+
+    Returns:
+        Dict of Driver objects, keyed by driver name. Where several drivers
+        have the same name but a different of_match table, the entry is
+        unknown (compats is None).
+    """
+    drivers = {}
+    for dirpath, dirnames, fnames in os.walk(srcdir):
+        dirnames[:] = [d for d in dirnames if not d.startswith('.')]
+        for fname in fnames:
+            if not fname.endswith('.c'):
+                continue
+            for drv in scan_file(os.path.join(dirpath, fname)):
+                if not drv.name:
+                    continue
+                old = drivers.get(drv.name)
+                if old and old.compats != drv.compats:
+                    drv = drv._replace(compats=None)
+                drivers[drv.name] = drv
+    return drivers
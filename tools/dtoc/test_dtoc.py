@@ -687,6 +687,93 @@ U_BOOT_DEVICE(spl_test2) = {
 
 ''', data)
 
+    def test_bind(self):
+        """Test output of the table of drivers to bind"""
+        src_dir = tools.GetOutputFilename('src')
+        os.mkdir(src_dir)
+        with open(os.path.join(src_dir, 'drivers.c'), 'w') as fd:
+            fd.write('''
+static const struct udevice_id spl_test_ids[] = {
+	{ .compatible = "sandbox,spl-test" },
+	{ .compatible = "sandbox,spl-test.2", .data = 2 },
+	{ }
+};
+
+U_BOOT_DRIVER(sandbox_spl_test) = {
+	.name	= "sandbox_spl_test",
+	.of_match = spl_test_ids,
+};
+
+static const struct udevice_id i2c_ids[] = {
+	{ "sandbox,i2c-test", 0 },
+	{ }
+};
+
+U_BOOT_DRIVER(i2c_test) = {
+	.name	= "sandbox_i2c_test",
+	.of_match = i2c_ids,
+};
+
+/* The compatible string is hidden by a macro, so this is unknown */
+static const struct udevice_id pmic_ids[] = {
+	PMIC_ID("sandbox,pmic-test"),
+	{ }
+};
+
+U_BOOT_DRIVER(pmic_test) = {
+	.name	= "pmic_test",
+	.of_match = pmic_ids,
+};
+
+U_BOOT_DRIVER(no_of_match) = {
+	.name	= "no_of_match",
+};
+
+/* No node uses this, but it is listed so U-Boot knows it is covered */
+static const struct udevice_id unused_ids[] = {
+	{ .compatible = "sandbox,unused" },
+	{ }
+};
+
+U_BOOT_DRIVER(unused) = {
+	.name	= "unused_test",
+	.of_match = unused_ids,
+};
+''')
+        dtb_file = get_dtb_file('dtoc_test_simple.dts')
+        output = tools.GetOutputFilename('output')
+        dtb_platdata.run_steps(['bind'], dtb_file, False, output, src_dir)
+        with open(output) as infile:
+            data = infile.read()
+        self.assertIn('''static const char *const dm_bind_driver_names[] = {
+\t"pmic_test",
+\t"sandbox_i2c_test",
+\t"sandbox_spl_test",
+\t"unused_test",
+};
+
+static const bool dm_bind_driver_unknown[] = {
+\ttrue,
+\tfalse,
+\tfalse,
+\tfalse,
+};
+''', data)
+        self.assertIn(', 0, 0, 2 },\t/* /spl-test: sandbox_spl_test */', data)
+        self.assertIn(', 0, 1, 2 },\t/* /spl-test4: sandbox_spl_test */', data)
+        self.assertIn(', 0, 0, 1 },\t/* /i2c@0: sandbox_i2c_test */', data)
+        self.assertNotIn('/i2c@0/pmic@9', data)
+        self.assertNotIn('no_of_match', data)
+
+    def testBindNoSrcDir(self):
+        """Test running dtoc bind without a source directory"""
+        dtb_file = get_dtb_file('dtoc_test_simple.dts')
+        output = tools.GetOutputFilename('output')
+        with self.assertRaises(ValueError) as e:
+            dtb_platdata.run_steps(['bind'], dtb_file, False, output)
+        self.assertIn("Please specify the source directory (-s) for 'bind'",
+                      str(e.exception))
+
     def testStdout(self):
         """Test output to stdout"""
         dtb_file = get_dtb_file('dtoc_test_simple.dts')
@@ -706,5 +793,5 @@ U_BOOT_DEVICE(spl_test2) = {
         output = tools.GetOutputFilename('output')
         with self.assertRaises(ValueError) as e:
             dtb_platdata.run_steps(['invalid-cmd'], dtb_file, False, output)
-        self.assertIn("Unknown command 'invalid-cmd': (use: struct, platdata)",
-                      str(e.exception))
+        self.assertIn("Unknown command 'invalid-cmd': (use: struct, platdata, "
+                      "bind)", str(e.exception))